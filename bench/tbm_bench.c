@@ -0,0 +1,135 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#include "config.h"
+
+#include <time.h>
+#include <getopt.h>
+#include "tbm_bench.h"
+
+#define DEFAULT_ITERATIONS	100
+
+static tbm_bench_case bench_cases[] = {
+	{ "surface_create", "create a swapchain of 3 to 8 surfaces one by one and in a batch", tbm_bench_surface_create },
+	{ "convert", "convert 1080p between ARGB8888 and the YUV formats (TBM_CPU_FEATURES=0 for C)", tbm_bench_convert },
+	{ "copy", "copy 1080p and 4K surfaces to default and WC memory (TBM_WORKERS=0 for 1 thread)", tbm_bench_copy },
+	{ "scale", "scale 4K surfaces down to thumbnails with each filter", tbm_bench_scale },
+	{ "rotate", "rotate 1080p and 4K surfaces, the blocked kernels against a naive per-pixel loop", tbm_bench_rotate },
+	{ "fill", "clear 1080p and 4K surfaces to black, tbm_surface_internal_fill against map and memset", tbm_bench_fill },
+	{ "hash", "hash 4K surfaces as a whole and by tiles, with and without damage (TBM_CPU_FEATURES=0 for C)", tbm_bench_hash },
+	{ "png", "capture a 4K surface to png with the default and the fast compressions", tbm_bench_png },
+	{ "arena", "make the scratch surfaces of a frame, create and destroy against a surface arena", tbm_bench_arena },
+};
+
+#define NUM_BENCH_CASES	(sizeof(bench_cases) / sizeof(bench_cases[0]))
+
+double
+tbm_bench_get_time(void)
+{
+	struct timespec tp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tp);
+
+	return (tp.tv_sec * 1000.0) + (tp.tv_nsec / 1000000.0);
+}
+
+void
+tbm_bench_report(const char *name, int iterations, double elapsed, double bytes)
+{
+	double per_iter = elapsed / iterations;
+
+	if (bytes > 0 && per_iter > 0)
+		printf("%-48s %12.4f ms/iter %10.1f MB/s\n", name, per_iter,
+		       bytes / (1024.0 * 1024.0) / (per_iter / 1000.0));
+	else
+		printf("%-48s %12.4f ms/iter\n", name, per_iter);
+}
+
+static void
+_usage(const char *prog)
+{
+	unsigned int i;
+
+	printf("usage: %s [-i iterations] [case ...]\n\n", prog);
+	printf("cases:\n");
+	for (i = 0; i < NUM_BENCH_CASES; i++)
+		printf("  %-20s %s\n", bench_cases[i].name, bench_cases[i].desc);
+}
+
+int
+main(int argc, char *argv[])
+{
+	int iterations = DEFAULT_ITERATIONS;
+	tbm_bufmgr bufmgr;
+	unsigned int i;
+	int opt, j, ran;
+
+	while ((opt = getopt(argc, argv, "i:h")) != -1) {
+		switch (opt) {
+		case 'i':
+			iterations = atoi(optarg);
+			break;
+		case 'h':
+		default:
+			_usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (iterations <= 0) {
+		_usage(argv[0]);
+		return 1;
+	}
+
+	/* keep the bufmgr alive between the iterations */
+	bufmgr = tbm_bufmgr_init(-1);
+	if (!bufmgr) {
+		fprintf(stderr, "fail to init tbm_bufmgr\n");
+		return 1;
+	}
+
+	for (i = 0; i < NUM_BENCH_CASES; i++) {
+		ran = (optind == argc);
+
+		for (j = optind; j < argc; j++) {
+			if (!strcmp(argv[j], bench_cases[i].name))
+				ran = 1;
+		}
+
+		if (ran)
+			bench_cases[i].run(iterations);
+	}
+
+	tbm_bufmgr_deinit(bufmgr);
+
+	return 0;
+}
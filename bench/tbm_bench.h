@@ -0,0 +1,68 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#ifndef _TBM_BENCH_H_
+#define _TBM_BENCH_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tbm_bufmgr.h>
+#include <tbm_surface.h>
+#include <tbm_surface_internal.h>
+
+typedef struct _tbm_bench_case {
+	const char *name;
+	const char *desc;
+	void (*run)(int iterations);
+} tbm_bench_case;
+
+/* the monotonic time in milliseconds */
+double tbm_bench_get_time(void);
+
+/* print one result line. bytes is the amount of data processed by one
+ * iteration, 0 if the throughput doesn't make sense.
+ */
+void tbm_bench_report(const char *name, int iterations, double elapsed, double bytes);
+
+/* bench cases */
+void tbm_bench_surface_create(int iterations);
+void tbm_bench_convert(int iterations);
+void tbm_bench_copy(int iterations);
+void tbm_bench_scale(int iterations);
+void tbm_bench_rotate(int iterations);
+void tbm_bench_fill(int iterations);
+void tbm_bench_hash(int iterations);
+void tbm_bench_png(int iterations);
+void tbm_bench_arena(int iterations);
+
+#endif							/* _TBM_BENCH_H_ */
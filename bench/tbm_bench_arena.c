@@ -0,0 +1,103 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#include "config.h"
+
+#include <tbm_surface_arena.h>
+#include "tbm_bench.h"
+
+/* the scratch surfaces of a frame: a blur chain from 1080p down to
+ * 1/16 and back, and a few conversion temporaries.
+ */
+static const struct {
+	int width, height;
+	tbm_format format;
+} scratch[] = {
+	{ 960, 540, TBM_FORMAT_ARGB8888 },
+	{ 480, 270, TBM_FORMAT_ARGB8888 },
+	{ 240, 135, TBM_FORMAT_ARGB8888 },
+	{ 120, 68, TBM_FORMAT_ARGB8888 },
+	{ 240, 135, TBM_FORMAT_ARGB8888 },
+	{ 480, 270, TBM_FORMAT_ARGB8888 },
+	{ 960, 540, TBM_FORMAT_ARGB8888 },
+	{ 256, 256, TBM_FORMAT_XRGB8888 },
+	{ 128, 128, TBM_FORMAT_XRGB8888 },
+	{ 64, 64, TBM_FORMAT_ARGB8888 },
+};
+
+#define NUM_SCRATCH	(int)(sizeof(scratch) / sizeof(scratch[0]))
+#define ARENA_BUDGET	(8 * 1024 * 1024)
+
+void
+tbm_bench_arena(int iterations)
+{
+	tbm_surface_h surfaces[NUM_SCRATCH];
+	tbm_surface_arena_h arena;
+	char name[64];
+	double start;
+	int i, j;
+
+	start = tbm_bench_get_time();
+	for (i = 0; i < iterations; i++) {
+		for (j = 0; j < NUM_SCRATCH; j++)
+			surfaces[j] = tbm_surface_internal_create_with_flags(scratch[j].width, scratch[j].height,
+									     scratch[j].format, TBM_BO_DEFAULT);
+		for (j = 0; j < NUM_SCRATCH; j++)
+			tbm_surface_destroy(surfaces[j]);
+	}
+	snprintf(name, sizeof(name), "create_with_flags+destroy x%d", NUM_SCRATCH);
+	tbm_bench_report(name, iterations, tbm_bench_get_time() - start, 0);
+
+	arena = tbm_surface_arena_create(ARENA_BUDGET, TBM_BO_DEFAULT);
+	if (!arena) {
+		fprintf(stderr, "fail to create tbm_surface_arena\n");
+		return;
+	}
+
+	start = tbm_bench_get_time();
+	for (i = 0; i < iterations; i++) {
+		for (j = 0; j < NUM_SCRATCH; j++) {
+			if (!tbm_surface_arena_alloc(arena, scratch[j].width, scratch[j].height,
+						     scratch[j].format)) {
+				fprintf(stderr, "fail to alloc %dx%d from tbm_surface_arena\n",
+					scratch[j].width, scratch[j].height);
+				tbm_surface_arena_destroy(arena);
+				return;
+			}
+		}
+		tbm_surface_arena_reset(arena);
+	}
+	snprintf(name, sizeof(name), "arena_alloc+reset x%d", NUM_SCRATCH);
+	tbm_bench_report(name, iterations, tbm_bench_get_time() - start, 0);
+
+	tbm_surface_arena_destroy(arena);
+}
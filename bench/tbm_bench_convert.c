@@ -0,0 +1,112 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+
+#include "config.h"
+
+#include "tbm_bench.h"
+
+#define CONVERT_WIDTH	1920
+#define CONVERT_HEIGHT	1080
+
+static const struct {
+	tbm_format format;
+	const char *name;
+} convert_formats[] = {
+	{ TBM_FORMAT_NV12, "NV12" },
+	{ TBM_FORMAT_NV21, "NV21" },
+	{ TBM_FORMAT_YUV420, "YUV420" },
+	{ TBM_FORMAT_YVU420, "YVU420" },
+	{ TBM_FORMAT_YUYV, "YUYV" },
+	{ TBM_FORMAT_UYVY, "UYVY" },
+};
+
+static int
+_bench_convert(tbm_surface_h src, tbm_surface_h dst, const char *name, int iterations)
+{
+	double start;
+	int i;
+
+	start = tbm_bench_get_time();
+	for (i = 0; i < iterations; i++) {
+		if (!tbm_surface_internal_convert(src, dst)) {
+			fprintf(stderr, "fail to convert %s\n", name);
+			return 0;
+		}
+	}
+
+	/* throughput in argb bytes */
+	tbm_bench_report(name, iterations, tbm_bench_get_time() - start,
+			 CONVERT_WIDTH * CONVERT_HEIGHT * 4.0);
+
+	return 1;
+}
+
+void
+tbm_bench_convert(int iterations)
+{
+	tbm_surface_h argb, yuv;
+	tbm_surface_info_s info;
+	char name[64];
+	unsigned int i;
+
+	argb = tbm_surface_create(CONVERT_WIDTH, CONVERT_HEIGHT, TBM_FORMAT_ARGB8888);
+	if (!argb) {
+		fprintf(stderr, "fail to create the argb surface\n");
+		return;
+	}
+
+	/* something else than a flat color */
+	if (tbm_surface_map(argb, TBM_SURF_OPTION_WRITE, &info) == TBM_SURFACE_ERROR_NONE) {
+		for (i = 0; i < info.planes[0].size; i++)
+			info.planes[0].ptr[i] = i * 7 + (i >> 12);
+		tbm_surface_unmap(argb);
+	}
+
+	for (i = 0; i < sizeof(convert_formats) / sizeof(convert_formats[0]); i++) {
+		yuv = tbm_surface_create(CONVERT_WIDTH, CONVERT_HEIGHT, convert_formats[i].format);
+		if (!yuv) {
+			fprintf(stderr, "fail to create the %s surface\n", convert_formats[i].name);
+			continue;
+		}
+
+		snprintf(name, sizeof(name), "ARGB8888 -> %s", convert_formats[i].name);
+		if (_bench_convert(argb, yuv, name, iterations)) {
+			snprintf(name, sizeof(name), "%s -> ARGB8888", convert_formats[i].name);
+			_bench_convert(yuv, argb, name, iterations);
+		}
+
+		tbm_surface_destroy(yuv);
+	}
+
+	tbm_surface_destroy(argb);
+}
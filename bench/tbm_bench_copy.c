@@ -0,0 +1,115 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+
+#include "config.h"
+
+#include "tbm_bench.h"
+
+static const struct {
+	int width;
+	int height;
+	const char *name;
+} copy_sizes[] = {
+	{ 1920, 1080, "1080p" },
+	{ 3840, 2160, "4K" },
+};
+
+static const struct {
+	tbm_format format;
+	const char *name;
+} copy_formats[] = {
+	{ TBM_FORMAT_ARGB8888, "ARGB8888" },
+	{ TBM_FORMAT_NV12, "NV12" },
+};
+
+static const struct {
+	int flags;
+	const char *name;
+} copy_flags[] = {
+	{ TBM_BO_DEFAULT, "default" },
+	{ TBM_BO_WC, "wc" },
+};
+
+static void
+_bench_copy(int width, int height, tbm_format format, int flags, const char *name,
+	    int iterations)
+{
+	tbm_surface_h src, dst;
+	tbm_surface_info_s info;
+	double start;
+	int i;
+
+	src = tbm_surface_internal_create_with_flags(width, height, format, TBM_BO_DEFAULT);
+	dst = tbm_surface_internal_create_with_flags(width, height, format, flags);
+	if (!src || !dst) {
+		fprintf(stderr, "fail to create the surfaces of %s\n", name);
+		goto done;
+	}
+
+	tbm_surface_get_info(src, &info);
+
+	start = tbm_bench_get_time();
+	for (i = 0; i < iterations; i++) {
+		if (!tbm_surface_internal_copy(src, dst, NULL)) {
+			fprintf(stderr, "fail to copy %s\n", name);
+			goto done;
+		}
+	}
+
+	tbm_bench_report(name, iterations, tbm_bench_get_time() - start, info.size);
+
+done:
+	if (dst)
+		tbm_surface_destroy(dst);
+	if (src)
+		tbm_surface_destroy(src);
+}
+
+void
+tbm_bench_copy(int iterations)
+{
+	unsigned int s, f, fl;
+	char name[64];
+
+	for (s = 0; s < sizeof(copy_sizes) / sizeof(copy_sizes[0]); s++) {
+		for (f = 0; f < sizeof(copy_formats) / sizeof(copy_formats[0]); f++) {
+			for (fl = 0; fl < sizeof(copy_flags) / sizeof(copy_flags[0]); fl++) {
+				snprintf(name, sizeof(name), "copy %s %s %s", copy_sizes[s].name,
+					 copy_formats[f].name, copy_flags[fl].name);
+				_bench_copy(copy_sizes[s].width, copy_sizes[s].height,
+					    copy_formats[f].format, copy_flags[fl].flags,
+					    name, iterations);
+			}
+		}
+	}
+}
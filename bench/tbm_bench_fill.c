@@ -0,0 +1,142 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#include "tbm_bench.h"
+
+static const struct {
+	int width;
+	int height;
+	const char *name;
+} fill_sizes[] = {
+	{ 1920, 1080, "1080p" },
+	{ 3840, 2160, "4K" },
+};
+
+static const struct {
+	tbm_format format;
+	const char *name;
+} fill_formats[] = {
+	{ TBM_FORMAT_ARGB8888, "ARGB8888" },
+	{ TBM_FORMAT_NV12, "NV12" },
+};
+
+static const struct {
+	int flags;
+	const char *name;
+} fill_flags[] = {
+	{ TBM_BO_DEFAULT, "default" },
+	{ TBM_BO_WC, "wc" },
+};
+
+/* the usual way to clear a surface: map it and memset every row of every plane */
+static int
+_bench_fill_memset(tbm_surface_h surface)
+{
+	tbm_surface_info_s info;
+	unsigned int i, row, rows;
+
+	if (tbm_surface_map(surface, TBM_SURF_OPTION_WRITE, &info) != TBM_SURFACE_ERROR_NONE)
+		return 0;
+
+	for (i = 0; i < info.num_planes; i++) {
+		rows = info.planes[i].size / info.planes[i].stride;
+		for (row = 0; row < rows; row++)
+			memset(info.planes[i].ptr + row * info.planes[i].stride, 0,
+			       info.planes[i].stride);
+	}
+
+	tbm_surface_unmap(surface);
+
+	return 1;
+}
+
+static void
+_bench_fill(int width, int height, tbm_format format, int flags, const char *name,
+	    int iterations)
+{
+	tbm_surface_h surface;
+	tbm_surface_info_s info;
+	char memset_name[80];
+	double start;
+	int i;
+
+	surface = tbm_surface_internal_create_with_flags(width, height, format, flags);
+	if (!surface) {
+		fprintf(stderr, "fail to create the surface of %s\n", name);
+		return;
+	}
+
+	tbm_surface_get_info(surface, &info);
+
+	start = tbm_bench_get_time();
+	for (i = 0; i < iterations; i++) {
+		if (!_bench_fill_memset(surface)) {
+			fprintf(stderr, "fail to map %s\n", name);
+			goto done;
+		}
+	}
+
+	snprintf(memset_name, sizeof(memset_name), "%s memset", name);
+	tbm_bench_report(memset_name, iterations, tbm_bench_get_time() - start, info.size);
+
+	start = tbm_bench_get_time();
+	for (i = 0; i < iterations; i++) {
+		if (!tbm_surface_internal_fill(surface, NULL, 0xff000000)) {
+			fprintf(stderr, "fail to fill %s\n", name);
+			goto done;
+		}
+	}
+
+	tbm_bench_report(name, iterations, tbm_bench_get_time() - start, info.size);
+
+done:
+	tbm_surface_destroy(surface);
+}
+
+void
+tbm_bench_fill(int iterations)
+{
+	unsigned int s, f, fl;
+	char name[64];
+
+	for (s = 0; s < sizeof(fill_sizes) / sizeof(fill_sizes[0]); s++) {
+		for (f = 0; f < sizeof(fill_formats) / sizeof(fill_formats[0]); f++) {
+			for (fl = 0; fl < sizeof(fill_flags) / sizeof(fill_flags[0]); fl++) {
+				snprintf(name, sizeof(name), "fill %s %s %s", fill_sizes[s].name,
+					 fill_formats[f].name, fill_flags[fl].name);
+				_bench_fill(fill_sizes[s].width, fill_sizes[s].height,
+					    fill_formats[f].format, fill_flags[fl].flags,
+					    name, iterations);
+			}
+		}
+	}
+}
@@ -0,0 +1,106 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#include "tbm_bench.h"
+
+static const struct {
+	tbm_format format;
+	const char *name;
+} hash_formats[] = {
+	{ TBM_FORMAT_ARGB8888, "ARGB8888" },
+	{ TBM_FORMAT_NV12, "NV12" },
+};
+
+static void
+_bench_hash(tbm_format format, const char *format_name, int iterations)
+{
+	tbm_surface_rect_s damage = { 1800, 1000, 256, 128 };
+	tbm_surface_h surface;
+	tbm_surface_info_s info;
+	uint64_t hash;
+	char name[64];
+	double start;
+	int i;
+
+	surface = tbm_surface_internal_create_with_flags(3840, 2160, format, TBM_BO_DEFAULT);
+	if (!surface) {
+		fprintf(stderr, "fail to create the surface of %s\n", format_name);
+		return;
+	}
+
+	tbm_surface_get_info(surface, &info);
+
+	snprintf(name, sizeof(name), "hash 4K %s", format_name);
+	start = tbm_bench_get_time();
+	for (i = 0; i < iterations; i++) {
+		if (!tbm_surface_internal_hash(surface, NULL, &hash)) {
+			fprintf(stderr, "fail to hash %s\n", name);
+			goto done;
+		}
+	}
+	tbm_bench_report(name, iterations, tbm_bench_get_time() - start, info.size);
+
+	/* no damage, all the tiles */
+	snprintf(name, sizeof(name), "hash 4K %s tiles", format_name);
+	start = tbm_bench_get_time();
+	for (i = 0; i < iterations; i++) {
+		if (!tbm_surface_internal_hash_incremental(surface, &hash)) {
+			fprintf(stderr, "fail to hash %s\n", name);
+			goto done;
+		}
+	}
+	tbm_bench_report(name, iterations, tbm_bench_get_time() - start, info.size);
+
+	/* a cursor sized damage */
+	tbm_surface_internal_add_damage(surface, &damage);
+	snprintf(name, sizeof(name), "hash 4K %s damaged tiles", format_name);
+	start = tbm_bench_get_time();
+	for (i = 0; i < iterations; i++) {
+		if (!tbm_surface_internal_hash_incremental(surface, &hash)) {
+			fprintf(stderr, "fail to hash %s\n", name);
+			goto done;
+		}
+	}
+	tbm_bench_report(name, iterations, tbm_bench_get_time() - start, 0);
+
+done:
+	tbm_surface_destroy(surface);
+}
+
+void
+tbm_bench_hash(int iterations)
+{
+	unsigned int f;
+
+	for (f = 0; f < sizeof(hash_formats) / sizeof(hash_formats[0]); f++)
+		_bench_hash(hash_formats[f].format, hash_formats[f].name, iterations);
+}
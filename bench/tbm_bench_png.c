@@ -0,0 +1,97 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#include <unistd.h>
+
+#include "tbm_bench.h"
+
+static const struct {
+	int level;
+	tbm_surface_png_filter_e filter;
+	const char *name;
+} png_settings[] = {
+	{ -1, TBM_SURFACE_PNG_FILTER_DEFAULT, "default" },
+	{ 1, TBM_SURFACE_PNG_FILTER_UP, "level 1 up" },
+	{ 1, TBM_SURFACE_PNG_FILTER_NONE, "level 1 none" },
+};
+
+void
+tbm_bench_png(int iterations)
+{
+	tbm_surface_h surface;
+	tbm_surface_info_s info;
+	char name[64];
+	double start;
+	unsigned int s;
+	int i, x, y;
+
+	surface = tbm_surface_internal_create_with_flags(3840, 2160, TBM_FORMAT_ARGB8888,
+							 TBM_BO_DEFAULT);
+	if (!surface) {
+		fprintf(stderr, "fail to create the surface\n");
+		return;
+	}
+
+	/* gradients, closer to a screen than noise or a flat color */
+	if (tbm_surface_map(surface, TBM_SURF_OPTION_WRITE, &info) != TBM_SURFACE_ERROR_NONE) {
+		fprintf(stderr, "fail to map the surface\n");
+		tbm_surface_destroy(surface);
+		return;
+	}
+	for (y = 0; y < (int)info.height; y++) {
+		uint32_t *row = (uint32_t *)(info.planes[0].ptr + y * info.planes[0].stride);
+
+		for (x = 0; x < (int)info.width; x++)
+			row[x] = 0xff000000 | ((x >> 4) & 0xff) << 16 | ((y >> 3) & 0xff) << 8 | ((x ^ y) & 0x3f);
+	}
+	tbm_surface_unmap(surface);
+
+	for (s = 0; s < sizeof(png_settings) / sizeof(png_settings[0]); s++) {
+		tbm_surface_internal_dump_set_png_compression(png_settings[s].level, png_settings[s].filter);
+
+		snprintf(name, sizeof(name), "capture 4K png %s", png_settings[s].name);
+		start = tbm_bench_get_time();
+		for (i = 0; i < iterations; i++) {
+			if (!tbm_surface_internal_capture_buffer(surface, "/tmp", "tbm-bench", "png")) {
+				fprintf(stderr, "fail to capture %s\n", name);
+				goto done;
+			}
+			/* the capture doesn't overwrite */
+			unlink("/tmp/tbm-bench.png");
+		}
+		tbm_bench_report(name, iterations, tbm_bench_get_time() - start, info.size);
+	}
+
+done:
+	tbm_surface_internal_dump_set_png_compression(-1, TBM_SURFACE_PNG_FILTER_DEFAULT);
+	tbm_surface_destroy(surface);
+}
@@ -0,0 +1,194 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+
+#include "config.h"
+
+#include "tbm_bench.h"
+
+static const struct {
+	int width;
+	int height;
+	const char *name;
+} rotate_sizes[] = {
+	{ 1920, 1080, "1080p" },
+	{ 3840, 2160, "4K" },
+};
+
+static const struct {
+	tbm_format format;
+	const char *name;
+} rotate_formats[] = {
+	{ TBM_FORMAT_ARGB8888, "ARGB8888" },
+	{ TBM_FORMAT_NV12, "NV12" },
+};
+
+static const struct {
+	tbm_surface_transform_e transform;
+	const char *name;
+} rotate_transforms[] = {
+	{ TBM_SURFACE_TRANSFORM_90, "90" },
+	{ TBM_SURFACE_TRANSFORM_180, "180" },
+	{ TBM_SURFACE_TRANSFORM_270, "270" },
+	{ TBM_SURFACE_TRANSFORM_FLIPPED, "flipped" },
+};
+
+/* the src pixel of each dst pixel, the way it used to be done */
+static void
+_bench_rotate_naive_plane(tbm_surface_plane_s *src, tbm_surface_plane_s *dst,
+			  int w, int h, int cpp, tbm_surface_transform_e transform)
+{
+	int dw = (transform & 1) ? h : w, dh = (transform & 1) ? w : h;
+	int dx, dy, sx, sy;
+
+	for (dy = 0; dy < dh; dy++) {
+		for (dx = 0; dx < dw; dx++) {
+			switch (transform) {
+			case TBM_SURFACE_TRANSFORM_90:
+				sx = dy;
+				sy = h - 1 - dx;
+				break;
+			case TBM_SURFACE_TRANSFORM_180:
+				sx = w - 1 - dx;
+				sy = h - 1 - dy;
+				break;
+			case TBM_SURFACE_TRANSFORM_270:
+				sx = w - 1 - dy;
+				sy = dx;
+				break;
+			default:
+				sx = w - 1 - dx;
+				sy = dy;
+				break;
+			}
+
+			memcpy(dst->ptr + dy * dst->stride + dx * cpp,
+			       src->ptr + sy * src->stride + sx * cpp, cpp);
+		}
+	}
+}
+
+static int
+_bench_rotate_naive(tbm_surface_h src, tbm_surface_h dst, tbm_surface_transform_e transform)
+{
+	tbm_surface_info_s src_info, dst_info;
+	int i;
+
+	if (tbm_surface_map(src, TBM_SURF_OPTION_READ, &src_info) != TBM_SURFACE_ERROR_NONE)
+		return 0;
+
+	if (tbm_surface_map(dst, TBM_SURF_OPTION_WRITE, &dst_info) != TBM_SURFACE_ERROR_NONE) {
+		tbm_surface_unmap(src);
+		return 0;
+	}
+
+	/* ARGB8888 or NV12 */
+	if (src_info.num_planes == 1) {
+		_bench_rotate_naive_plane(&src_info.planes[0], &dst_info.planes[0],
+					  src_info.width, src_info.height, 4, transform);
+	} else {
+		for (i = 0; i < 2; i++)
+			_bench_rotate_naive_plane(&src_info.planes[i], &dst_info.planes[i],
+						  src_info.width >> i, src_info.height >> i,
+						  i + 1, transform);
+	}
+
+	tbm_surface_unmap(dst);
+	tbm_surface_unmap(src);
+
+	return 1;
+}
+
+static void
+_bench_rotate(int width, int height, tbm_format format, tbm_surface_transform_e transform,
+	      int naive, const char *name, int iterations)
+{
+	tbm_surface_h src, dst;
+	tbm_surface_info_s info;
+	double start;
+	int i, ret;
+
+	src = tbm_surface_create(width, height, format);
+	if (transform & 1)
+		dst = tbm_surface_create(height, width, format);
+	else
+		dst = tbm_surface_create(width, height, format);
+	if (!src || !dst) {
+		fprintf(stderr, "fail to create the surfaces of %s\n", name);
+		goto done;
+	}
+
+	tbm_surface_get_info(src, &info);
+
+	start = tbm_bench_get_time();
+	for (i = 0; i < iterations; i++) {
+		if (naive)
+			ret = _bench_rotate_naive(src, dst, transform);
+		else
+			ret = tbm_surface_internal_rotate(src, dst, transform);
+		if (!ret) {
+			fprintf(stderr, "fail to rotate %s\n", name);
+			goto done;
+		}
+	}
+
+	tbm_bench_report(name, iterations, tbm_bench_get_time() - start, info.size);
+
+done:
+	if (dst)
+		tbm_surface_destroy(dst);
+	if (src)
+		tbm_surface_destroy(src);
+}
+
+void
+tbm_bench_rotate(int iterations)
+{
+	unsigned int s, f, t;
+	int naive;
+	char name[64];
+
+	for (s = 0; s < sizeof(rotate_sizes) / sizeof(rotate_sizes[0]); s++) {
+		for (f = 0; f < sizeof(rotate_formats) / sizeof(rotate_formats[0]); f++) {
+			for (t = 0; t < sizeof(rotate_transforms) / sizeof(rotate_transforms[0]); t++) {
+				for (naive = 1; naive >= 0; naive--) {
+					snprintf(name, sizeof(name), "rotate %s %s %s %s", rotate_sizes[s].name,
+						 rotate_formats[f].name, rotate_transforms[t].name,
+						 naive ? "naive" : "blocked");
+					_bench_rotate(rotate_sizes[s].width, rotate_sizes[s].height,
+						      rotate_formats[f].format, rotate_transforms[t].transform,
+						      naive, name, iterations);
+				}
+			}
+		}
+	}
+}
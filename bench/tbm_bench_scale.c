@@ -0,0 +1,123 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+
+#include "config.h"
+
+#include "tbm_bench.h"
+
+static const struct {
+	int width;
+	int height;
+	const char *name;
+} scale_sizes[] = {
+	{ 960, 540, "960x540" },
+	{ 480, 270, "480x270" },
+	{ 320, 180, "320x180" },
+};
+
+static const struct {
+	tbm_format format;
+	const char *name;
+} scale_formats[] = {
+	{ TBM_FORMAT_ARGB8888, "ARGB8888" },
+	{ TBM_FORMAT_NV12, "NV12" },
+};
+
+static const struct {
+	tbm_surface_scale_filter_e filter;
+	const char *name;
+} scale_filters[] = {
+	{ TBM_SURFACE_SCALE_FILTER_NEAREST, "nearest" },
+	{ TBM_SURFACE_SCALE_FILTER_BILINEAR, "bilinear" },
+	{ TBM_SURFACE_SCALE_FILTER_BOX, "box" },
+};
+
+static void
+_bench_scale(tbm_surface_h src, int width, int height, tbm_format format,
+	     tbm_surface_scale_filter_e filter, const char *name, int iterations)
+{
+	tbm_surface_h dst;
+	tbm_surface_info_s info;
+	double start;
+	int i;
+
+	dst = tbm_surface_create(width, height, format);
+	if (!dst) {
+		fprintf(stderr, "fail to create the surface of %s\n", name);
+		return;
+	}
+
+	tbm_surface_get_info(src, &info);
+
+	start = tbm_bench_get_time();
+	for (i = 0; i < iterations; i++) {
+		if (!tbm_surface_internal_scale(src, NULL, dst, NULL, filter)) {
+			fprintf(stderr, "fail to scale %s\n", name);
+			break;
+		}
+	}
+
+	/* the throughput is of the 4K src, which is what a downscale reads */
+	if (i == iterations)
+		tbm_bench_report(name, iterations, tbm_bench_get_time() - start, info.size);
+
+	tbm_surface_destroy(dst);
+}
+
+void
+tbm_bench_scale(int iterations)
+{
+	unsigned int s, f, fl;
+	tbm_surface_h src;
+	char name[64];
+
+	for (f = 0; f < sizeof(scale_formats) / sizeof(scale_formats[0]); f++) {
+		src = tbm_surface_create(3840, 2160, scale_formats[f].format);
+		if (!src) {
+			fprintf(stderr, "fail to create the 4K %s surface\n", scale_formats[f].name);
+			continue;
+		}
+
+		for (s = 0; s < sizeof(scale_sizes) / sizeof(scale_sizes[0]); s++) {
+			for (fl = 0; fl < sizeof(scale_filters) / sizeof(scale_filters[0]); fl++) {
+				snprintf(name, sizeof(name), "scale 4K->%s %s %s", scale_sizes[s].name,
+					 scale_formats[f].name, scale_filters[fl].name);
+				_bench_scale(src, scale_sizes[s].width, scale_sizes[s].height,
+					     scale_formats[f].format, scale_filters[fl].filter,
+					     name, iterations);
+			}
+		}
+
+		tbm_surface_destroy(src);
+	}
+}
@@ -0,0 +1,76 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#include "config.h"
+
+#include "tbm_bench.h"
+
+#define SWAPCHAIN_MIN	3
+#define SWAPCHAIN_MAX	8
+#define SWAPCHAIN_WIDTH	720
+#define SWAPCHAIN_HEIGHT	1280
+
+void
+tbm_bench_surface_create(int iterations)
+{
+	tbm_surface_h surfaces[SWAPCHAIN_MAX];
+	char name[64];
+	double start;
+	int count, i, j;
+
+	for (count = SWAPCHAIN_MIN; count <= SWAPCHAIN_MAX; count++) {
+		start = tbm_bench_get_time();
+		for (i = 0; i < iterations; i++) {
+			for (j = 0; j < count; j++)
+				surfaces[j] = tbm_surface_internal_create_with_flags(SWAPCHAIN_WIDTH, SWAPCHAIN_HEIGHT,
+										     TBM_FORMAT_ARGB8888, TBM_BO_DEFAULT);
+			for (j = 0; j < count; j++)
+				tbm_surface_destroy(surfaces[j]);
+		}
+		snprintf(name, sizeof(name), "create_with_flags x%d", count);
+		tbm_bench_report(name, iterations, tbm_bench_get_time() - start, 0);
+
+		start = tbm_bench_get_time();
+		for (i = 0; i < iterations; i++) {
+			if (!tbm_surface_internal_create_multi(SWAPCHAIN_WIDTH, SWAPCHAIN_HEIGHT,
+							       TBM_FORMAT_ARGB8888, TBM_BO_DEFAULT,
+							       count, surfaces)) {
+				fprintf(stderr, "fail to create %d surfaces\n", count);
+				return;
+			}
+			for (j = 0; j < count; j++)
+				tbm_surface_destroy(surfaces[j]);
+		}
+		snprintf(name, sizeof(name), "create_multi x%d", count);
+		tbm_bench_report(name, iterations, tbm_bench_get_time() - start, 0);
+	}
+}
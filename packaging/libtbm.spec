@@ -1,6 +1,7 @@
 %bcond_with x
 %bcond_with wayland
 %bcond_with utest
+%bcond_with bench
 
 Name:           libtbm
 Version:        2.0.16
@@ -16,6 +17,7 @@ BuildRequires:  pkgconfig(wayland-server)
 BuildRequires:  pkgconfig(wayland-client)
 BuildRequires:  pkgconfig(capi-base-common)
 BuildRequires:  pkgconfig(libpng)
+BuildRequires:  pkgconfig(zlib)
 BuildRequires:  pkgconfig(dlog)
 
 %if %{with utest}
@@ -44,16 +46,21 @@ cp %{SOURCE1001} .
 
 %build
 UTEST="no"
+BENCH="no"
 
 %if %{with utest}
 UTEST="yes"
 %endif
 
+%if %{with bench}
+BENCH="yes"
+%endif
+
 %if %{with wayland}
-%reconfigure --prefix=%{_prefix} --with-tbm-platform=WAYLAND  --with-utest=${UTEST} \
+%reconfigure --prefix=%{_prefix} --with-tbm-platform=WAYLAND  --with-utest=${UTEST} --with-bench=${BENCH} \
             CFLAGS="${CFLAGS} -Wall -Werror" LDFLAGS="${LDFLAGS} -Wl,--hash-style=both -Wl,--as-needed"
 %else
-%reconfigure --prefix=%{_prefix} --with-tbm-platform=X11  --with-utest=${UTEST} \
+%reconfigure --prefix=%{_prefix} --with-tbm-platform=X11  --with-utest=${UTEST} --with-bench=${BENCH} \
             CFLAGS="${CFLAGS} -Wall -Werror" LDFLAGS="${LDFLAGS} -Wl,--hash-style=both -Wl,--as-needed"
 %endif
 
@@ -103,6 +110,9 @@ rm -f %{_unitdir_user}/basic.target.wants/tbm-drm-auth-user.path
 %if %{with utest}
 %{_bindir}/ut
 %endif
+%if %{with bench}
+%{_bindir}/tbm-bench
+%endif
 
 %files devel
 %manifest %{name}.manifest
@@ -112,6 +122,9 @@ rm -f %{_unitdir_user}/basic.target.wants/tbm-drm-auth-user.path
 %{_includedir}/tbm_surface.h
 %{_includedir}/tbm_surface_internal.h
 %{_includedir}/tbm_surface_queue.h
+%{_includedir}/tbm_surface_pool.h
+%{_includedir}/tbm_surface_atlas.h
+%{_includedir}/tbm_surface_arena.h
 %{_includedir}/tbm_bufmgr_backend.h
 %{_includedir}/tbm_type.h
 %{_includedir}/tbm_drm_helper.h
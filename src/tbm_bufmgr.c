@@ -761,6 +761,7 @@ tbm_bufmgr_deinit(tbm_bufmgr bufmgr)
 	if (bufmgr->fd > 0)
 		close(bufmgr->fd);
 
+	free(bufmgr->formats);
 	free(bufmgr);
 	gBufMgr = NULL;
 
@@ -906,6 +907,80 @@ tbm_bo_alloc(tbm_bufmgr bufmgr, int size, int flags)
 	return bo;
 }
 
+/* allocate count bos of the same size and flags in one critical section.
+ * either all bos are allocated or none of them.
+ */
+int
+_tbm_bo_alloc_multi(tbm_bufmgr bufmgr, int size, int flags, int count, tbm_bo *bos)
+{
+	void *bo_priv;
+	tbm_bo bo;
+	int i;
+
+	_tbm_bufmgr_mutex_lock();
+
+	TBM_BUFMGR_RETURN_VAL_IF_FAIL(TBM_BUFMGR_IS_VALID(bufmgr), 0);
+	TBM_BUFMGR_RETURN_VAL_IF_FAIL(bufmgr == gBufMgr, 0);
+	TBM_BUFMGR_RETURN_VAL_IF_FAIL(size > 0, 0);
+	TBM_BUFMGR_RETURN_VAL_IF_FAIL(count > 0, 0);
+	TBM_BUFMGR_RETURN_VAL_IF_FAIL(bos, 0);
+
+	for (i = 0; i < count; i++) {
+		bo = calloc(1, sizeof(struct _tbm_bo));
+		if (!bo) {
+			TBM_LOG_E("error: fail to create of tbm_bo size(%d) flag(%s)\n",
+					size, _tbm_flag_to_str(flags));
+			_tbm_set_last_result(TBM_BO_ERROR_HEAP_ALLOC_FAILED);
+			goto fail;
+		}
+
+		bo->bufmgr = bufmgr;
+
+		bo_priv = bufmgr->backend->bo_alloc(bo, size, flags);
+		if (!bo_priv) {
+			TBM_LOG_E("error: fail to create of tbm_bo size(%d) flag(%s)\n",
+					size, _tbm_flag_to_str(flags));
+			_tbm_set_last_result(TBM_BO_ERROR_BO_ALLOC_FAILED);
+			free(bo);
+			goto fail;
+		}
+
+		bufmgr->bo_cnt++;
+
+		bo->ref_cnt = 1;
+		bo->flags = flags;
+		bo->priv = bo_priv;
+
+		LIST_INITHEAD(&bo->user_data_list);
+
+		LIST_ADD(&bo->item_link, &bufmgr->bo_list);
+
+		bos[i] = bo;
+	}
+
+	_tbm_util_check_bo_cnt(bufmgr);
+
+	TBM_TRACE("bo_cnt(%d) size(%d) flag(%s)\n", count, size, _tbm_flag_to_str(flags));
+
+	_tbm_bufmgr_mutex_unlock();
+
+	return 1;
+
+fail:
+	while (--i >= 0) {
+		bufmgr->backend->bo_free(bos[i]);
+		LIST_DEL(&bos[i]->item_link);
+		free(bos[i]);
+		bos[i] = NULL;
+
+		bufmgr->bo_cnt--;
+	}
+
+	_tbm_bufmgr_mutex_unlock();
+
+	return 0;
+}
+
 tbm_bo
 tbm_bo_import(tbm_bufmgr bufmgr, unsigned int key)
 {
@@ -1210,6 +1285,92 @@ tbm_bo_unmap(tbm_bo bo)
 	return ret;
 }
 
+/* lock and map bos in one critical section. the caller holds references
+ * of the bos, a surface does for its bos, so they are not validated by
+ * walking the bo_list again. either all bos are mapped or none of them.
+ */
+int
+_tbm_bo_map_multi(tbm_bo *bos, int num, int device, int opt, tbm_bo_handle *bo_handles)
+{
+	tbm_bufmgr bufmgr = gBufMgr;
+	int i;
+
+	_tbm_bufmgr_mutex_lock();
+
+	TBM_BUFMGR_RETURN_VAL_IF_FAIL(TBM_BUFMGR_IS_VALID(gBufMgr), 0);
+	TBM_BUFMGR_RETURN_VAL_IF_FAIL(bos, 0);
+	TBM_BUFMGR_RETURN_VAL_IF_FAIL(bo_handles, 0);
+
+	for (i = 0; i < num; i++) {
+		if (!_tbm_bo_lock(bos[i], device, opt)) {
+			_tbm_set_last_result(TBM_BO_ERROR_LOCK_FAILED);
+			TBM_LOG_E("error: fail to lock bo:%p)\n", bos[i]);
+			goto fail;
+		}
+
+		bo_handles[i] = bufmgr->backend->bo_map(bos[i], device, opt);
+		if (bo_handles[i].ptr == NULL) {
+			_tbm_set_last_result(TBM_BO_ERROR_MAP_FAILED);
+			TBM_LOG_E("error: fail to map bo:%p\n", bos[i]);
+			_tbm_bo_unlock(bos[i]);
+			goto fail;
+		}
+
+		/* increase the map_count */
+		bos[i]->map_cnt++;
+
+		TBM_TRACE("bo(%p) map_cnt(%d)\n", bos[i], bos[i]->map_cnt);
+	}
+
+	_tbm_bufmgr_mutex_unlock();
+
+	return 1;
+
+fail:
+	while (--i >= 0) {
+		bufmgr->backend->bo_unmap(bos[i]);
+		bos[i]->map_cnt--;
+		_tbm_bo_unlock(bos[i]);
+		bo_handles[i].ptr = NULL;
+	}
+
+	_tbm_bufmgr_mutex_unlock();
+
+	return 0;
+}
+
+int
+_tbm_bo_unmap_multi(tbm_bo *bos, int num)
+{
+	tbm_bufmgr bufmgr = gBufMgr;
+	int i, ret = 1;
+
+	_tbm_bufmgr_mutex_lock();
+
+	TBM_BUFMGR_RETURN_VAL_IF_FAIL(TBM_BUFMGR_IS_VALID(gBufMgr), 0);
+	TBM_BUFMGR_RETURN_VAL_IF_FAIL(bos, 0);
+
+	for (i = 0; i < num; i++) {
+		if (!bufmgr->backend->bo_unmap(bos[i])) {
+			TBM_LOG_E("error: bo(%p) map_cnt(%d)\n", bos[i], bos[i]->map_cnt);
+			_tbm_set_last_result(TBM_BO_ERROR_UNMAP_FAILED);
+			ret = 0;
+			continue;
+		}
+
+		/* decrease the map_count */
+		bos[i]->map_cnt--;
+
+		TBM_TRACE("bo(%p) map_cnt(%d)\n", bos[i], bos[i]->map_cnt);
+
+		_tbm_bo_unlock(bos[i]);
+	}
+
+	_tbm_bufmgr_mutex_unlock();
+
+	return ret;
+}
+
 int
 tbm_bo_swap(tbm_bo bo1, tbm_bo bo2)
 {
@@ -1618,36 +1779,104 @@ tbm_bufmgr_debug_queue_dump(char *path, int count, int onoff)
 	return 1;
 }
 
-int
-tbm_bufmgr_debug_dump_all(char *path)
+static int
+_tbm_bufmgr_debug_queue_dump_async(char *path, int count, int onoff,
+				   tbm_surface_dump_mode_e mode)
 {
-	int w, h, count = 0;
-	tbm_surface_h surface = NULL;
+	if (onoff == 0) {
+		TBM_LOG_D("count=%d onoff=%d\n", count, onoff);
 
-	TBM_RETURN_VAL_IF_FAIL(path != NULL, 0);
-	TBM_LOG_D("path=%s\n", path);
+		pthread_mutex_lock(&gLock);
+		b_dump_queue = 0;
+		pthread_mutex_unlock(&gLock);
+
+		/* the writer maps the staging bos, so it isn't waited under gLock */
+		tbm_surface_internal_dump_async_end();
+		return 1;
+	}
+
+	if (path == NULL) {
+		TBM_LOG_E("path is null");
+		return 0;
+	}
+	TBM_LOG_D("path=%s count=%d onoff=%d\n", path, count, onoff);
+
+	if (!tbm_surface_internal_dump_async_start_with_mode(path, count, mode)) {
+		TBM_LOG_E("Fail to start the asynchronous dump.\n");
+		return 0;
+	}
 
 	pthread_mutex_lock(&gLock);
+	b_dump_queue = 1;
+	pthread_mutex_unlock(&gLock);
+
+	return 1;
+}
 
-	count = _tbm_util_get_max_surface_size(&w, &h);
-	if (count == 0) {
-		TBM_LOG_E("No tbm_surface.\n");
+int
+tbm_bufmgr_debug_queue_dump_async(char *path, int count, int onoff)
+{
+	return _tbm_bufmgr_debug_queue_dump_async(path, count, onoff, TBM_SURFACE_DUMP_MODE_FILES);
+}
+
+int
+tbm_bufmgr_debug_queue_dump_stream(char *file, int count, int onoff)
+{
+	return _tbm_bufmgr_debug_queue_dump_async(file, count, onoff, TBM_SURFACE_DUMP_MODE_STREAM);
+}
+
+int
+tbm_bufmgr_debug_queue_dump_y4m(char *file, int count, int onoff)
+{
+	return _tbm_bufmgr_debug_queue_dump_async(file, count, onoff, TBM_SURFACE_DUMP_MODE_Y4M);
+}
+
+int
+tbm_bufmgr_debug_queue_dump_ring(char *path, int size, int onoff)
+{
+	if (onoff == 0) {
+		TBM_LOG_D("size=%d onoff=%d\n", size, onoff);
+
+		pthread_mutex_lock(&gLock);
+		b_dump_queue = 0;
 		pthread_mutex_unlock(&gLock);
+
+		/* the files are written at the end, not under gLock */
+		tbm_surface_internal_dump_end();
 		return 1;
 	}
 
-	tbm_surface_internal_dump_start(path, w, h, count);
-
-	LIST_FOR_EACH_ENTRY(surface, &gBufMgr->surf_list, item_link)
-		tbm_surface_internal_dump_buffer(surface, "dump_all");
+	if (path == NULL) {
+		TBM_LOG_E("path is null");
+		return 0;
+	}
+	TBM_LOG_D("path=%s size=%d onoff=%d\n", path, size, onoff);
 
-	tbm_surface_internal_dump_end();
+	if (!tbm_surface_internal_dump_ring_start(path, size)) {
+		TBM_LOG_E("Fail to start the dump ring.\n");
+		return 0;
+	}
 
+	pthread_mutex_lock(&gLock);
+	b_dump_queue = 1;
 	pthread_mutex_unlock(&gLock);
 
 	return 1;
 }
 
+int
+tbm_bufmgr_debug_dump_all(char *path)
+{
+	TBM_RETURN_VAL_IF_FAIL(path != NULL, 0);
+	TBM_LOG_D("path=%s\n", path);
+
+	/* the surfaces are referenced under the surface lock and dumped
+	 * without any lock, so the other threads keep allocating */
+	_tbm_surface_internal_dump_all(path);
+
+	return 1;
+}
+
 /* internal function */
 tbm_bufmgr
 _tbm_bufmgr_get_bufmgr(void)
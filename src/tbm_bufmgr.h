@@ -1053,6 +1053,56 @@ int tbm_bufmgr_debug_dump_all(char *path);
  */
 int tbm_bufmgr_debug_queue_dump(char *path, int count, int onoff);
 
+/**
+ * @brief Start the asynchronous dump debugging for queue.
+ * @details
+ * The frames are copied into count staging surfaces and written by a
+ * writer thread, the frames coming while the writer is behind are dropped.
+ * @param[in] path : the given dump path
+ * @param[in] count : the number of the staging surfaces
+ * @param[in] onoff : 1 is on, and 0 is off, if onoff==0 path and count are ignored
+ * @return 1 if this function succeeds, otherwise 0.
+ * @see #tbm_surface_internal_dump_async_start()
+ */
+int tbm_bufmgr_debug_queue_dump_async(char *path, int count, int onoff);
+
+/**
+ * @brief Start the dump debugging for queue into one stream file.
+ * @details
+ * Like tbm_bufmgr_debug_queue_dump_async(), but all the frames are appended
+ * to file with their headers and an index, see tbm_surface_internal_dump_stream_open().
+ * @param[in] file : the given stream file
+ * @param[in] count : the number of the staging surfaces
+ * @param[in] onoff : 1 is on, and 0 is off, if onoff==0 file and count are ignored
+ * @return 1 if this function succeeds, otherwise 0.
+ */
+int tbm_bufmgr_debug_queue_dump_stream(char *file, int count, int onoff);
+
+/**
+ * @brief Start the dump debugging for queue into one y4m file.
+ * @details
+ * Like tbm_bufmgr_debug_queue_dump_async(), but the YUV frames are appended
+ * to file as a YUV4MPEG2 stream of I420 frames.
+ * @param[in] file : the given y4m file
+ * @param[in] count : the number of the staging surfaces
+ * @param[in] onoff : 1 is on, and 0 is off, if onoff==0 file and count are ignored
+ * @return 1 if this function succeeds, otherwise 0.
+ */
+int tbm_bufmgr_debug_queue_dump_y4m(char *file, int count, int onoff);
+
+/**
+ * @brief Start the dump debugging for queue into a compressed memory ring.
+ * @details
+ * The frames are kept compressed in a ring of size bytes, the oldest ones
+ * evicted, and their files are written when it is turned off.
+ * @param[in] path : the given dump path
+ * @param[in] size : the size of the ring in bytes
+ * @param[in] onoff : 1 is on, and 0 is off, if onoff==0 path and size are ignored
+ * @return 1 if this function succeeds, otherwise 0.
+ * @see #tbm_surface_internal_dump_ring_start()
+ */
+int tbm_bufmgr_debug_queue_dump_ring(char *path, int size, int onoff);
+
 int tbm_bufmgr_bind_native_display(tbm_bufmgr bufmgr, void *NativeDisplay);
 
 #ifdef __cplusplus
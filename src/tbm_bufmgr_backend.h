@@ -37,6 +37,7 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define _TBM_BUFMGR_BACKEND_H_
 
 #include <tbm_bufmgr.h>
+#include <tbm_surface.h>
 #include <pthread.h>
 
 /**
@@ -61,10 +62,23 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define SET_ABI_VERSION(maj, min) \
 		((((maj) << 16) & ABI_MAJOR_MASK) | ((min) & ABI_MINOR_MASK))
 
-#define TBM_ABI_VERSION	SET_ABI_VERSION(1, 1) /**< current abi vertion  */
+#define TBM_ABI_VERSION	SET_ABI_VERSION(1, 3) /**< current abi vertion  */
 
 typedef struct _tbm_bufmgr_backend *tbm_bufmgr_backend;
 
+/**
+ * @brief the layout of all the planes of a surface.
+ * @remarks Available since the ABI version 1.3.
+ */
+typedef struct _tbm_surface_layout {
+	uint32_t size[TBM_SURF_PLANE_MAX];   /**< the size of each plane */
+	uint32_t offset[TBM_SURF_PLANE_MAX]; /**< the offset of each plane in its bo */
+	uint32_t pitch[TBM_SURF_PLANE_MAX];  /**< the pitch of each plane */
+	int bo_idx[TBM_SURF_PLANE_MAX];      /**< the bo index of each plane */
+	uint64_t modifier;                   /**< the preferred modifier, 0 for linear */
+	uint32_t align;                      /**< the preferred alignment of the bos, 0 for none */
+} tbm_surface_layout_s;
+
 /**
  * @brief TBM backend functions
  *  the set of function pointers for the backend module of TBM.
@@ -236,9 +250,41 @@ struct _tbm_bufmgr_backend {
 	*/
 	void * (*surface_bo_alloc)(tbm_bo bo, int width, int height, int format, int flags, int bo_idx);
 
+	/**
+	* @brief fill an area of the surface with a color by the hardware.
+	* @remarks This function pointer could be null, the surface is filled
+	*          by the cpu then. Available since the ABI version 1.2.
+	* @remarks It is called without any lock of libtbm held, so it may get
+	*          the bos and the planes of the surface with
+	*          tbm_surface_internal_get_bo(), tbm_surface_internal_get_info()
+	*          or tbm_surface_internal_get_plane_data(), and map the bos.
+	* @param[in] surface : the tbm surface
+	* @param[in] x : the x of the area
+	* @param[in] y : the y of the area
+	* @param[in] width : the width of the area
+	* @param[in] height : the height of the area
+	* @param[in] color : the color as a TBM_FORMAT_ARGB8888 value, the YUV
+	*                    formats take it in BT.601 limited range
+	* @return 1 if this function fills the area, 0 to let the cpu fill it.
+	*/
+	int (*surface_fill)(tbm_surface_h surface, int x, int y, int width, int height,
+			    uint32_t color);
+
+	/**
+	* @brief get the layout of all the planes of the surface at once.
+	* @remarks This function pointer could be null, surface_get_plane_data
+	*          is called for each plane then. Available since the ABI
+	*          version 1.3.
+	* @param[in] width : the width of the surface
+	* @param[in] height : the height of the surface
+	* @param[in] format : the format of the surface
+	* @param[out] layout : the layout of the planes, zeroed by the caller
+	* @return 1 if this function succeeds, otherwise 0.
+	*/
+	int (*surface_get_layout)(int width, int height, tbm_format format,
+				  tbm_surface_layout_s *layout);
+
 	/* Padding for future extension */
-	void (*reserved1)(void);
-	void (*reserved2)(void);
 	void (*reserved3)(void);
 	void (*reserved4)(void);
 	void (*reserved5)(void);
@@ -196,6 +196,23 @@ extern int bDlog;
 				   surf->item_link.next && \
 				   surf->item_link.next->prev == &surf->item_link)
 
+/* simd kernels compiled into the library, see _tbm_cpu_get_features() */
+#if defined(__SSE2__)
+#define TBM_SIMD_SSE2
+#endif
+#if defined(TBM_SIMD_SSE2) && (__GNUC__ >= 5 || defined(__clang__))
+#define TBM_SIMD_AVX2
+#define TBM_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define TBM_SIMD_NEON
+#endif
+
+/* cpu features */
+#define TBM_CPU_SSE2	(1 << 0)
+#define TBM_CPU_AVX2	(1 << 1)
+#define TBM_CPU_NEON	(1 << 2)
+
 struct list_head {
 	struct list_head *prev;
 	struct list_head *next;
@@ -224,6 +241,11 @@ struct _tbm_bo {
 	unsigned int map_cnt;		/* device map count */
 };
 
+/* the words of the bitmap of the supported formats, a bit for each format
+ * of the format descs in tbm_surface_internal.c.
+ */
+#define TBM_FORMAT_BITS_WORDS	4
+
 /**
  * @brief tbm_bufmgr : structure for tizen buffer manager
  *
@@ -252,6 +274,12 @@ struct _tbm_bufmgr {
 	void *module_data;
 
 	tbm_bufmgr_backend backend;	/* bufmgr backend */
+
+	uint32_t *formats;          /* formats of the backend, cached on the first query */
+
+	uint32_t num_formats;       /* number of the cached formats */
+
+	uint32_t format_bits[TBM_FORMAT_BITS_WORDS]; /* a bit for each cached format by its desc */
 };
 
 /**
@@ -275,6 +303,8 @@ struct _tbm_surface {
 
 	int refcnt;
 
+	struct _tbm_surface *parent;	/* referenced while this is a view of it */
+
 	unsigned int debug_pid;
 
 	struct list_head item_link; /* link of surface */
@@ -282,6 +312,10 @@ struct _tbm_surface {
 	struct list_head user_data_list;	/* list of the user_date in surface */
 
 	struct list_head debug_data_list;	/* list of debug data */
+
+	int num_damage;				/* 0 if the whole surface is dirty */
+
+	tbm_surface_rect_s damage[TBM_SURFACE_DAMAGE_MAX];
 };
 
 typedef struct {
@@ -303,7 +337,53 @@ typedef struct {
 
 tbm_bufmgr _tbm_bufmgr_get_bufmgr(void);
 int _tbm_bo_set_surface(tbm_bo bo, tbm_surface_h surface);
+int _tbm_bo_alloc_multi(tbm_bufmgr bufmgr, int size, int flags, int count, tbm_bo *bos);
+int _tbm_bo_map_multi(tbm_bo *bos, int num, int device, int opt, tbm_bo_handle *bo_handles);
+int _tbm_bo_unmap_multi(tbm_bo *bos, int num);
 int _tbm_surface_is_valid(tbm_surface_h surface);
+unsigned int _tbm_cpu_get_features(void);
+int _tbm_surface_internal_fill_by_backend(tbm_surface_h surface, tbm_surface_rect_s *rect,
+					  uint32_t color);
+int _tbm_surface_internal_plane_is_wc(tbm_surface_h surface, int plane_idx);
+int _tbm_format_check_rect(const tbm_format_desc_s *desc, const tbm_surface_rect_s *rect,
+			   int width, int height);
+void _tbm_format_plane_rect(const tbm_format_desc_s *desc, int plane_idx,
+			    const tbm_surface_rect_s *rect, tbm_surface_rect_s *plane_rect);
+int _tbm_surface_internal_get_damage_bounds(tbm_surface_h surface, tbm_surface_rect_s *bounds);
+void _tbm_surface_internal_add_written_damage(tbm_surface_h surface, tbm_surface_rect_s *rect);
+void _tbm_surface_internal_dump_file_raw(const char *file, void *data1, int size1,
+					 void *data2, int size2, void *data3, int size3);
+void _tbm_surface_internal_dump_file_png(const char *file, const void *data, int width, int height);
+int _tbm_surface_internal_dump_file_png_format(const char *file, const void *data, int width,
+					       int height, int stride, tbm_format format);
+int _tbm_surface_internal_dump_file(const char *file, tbm_surface_info_s *info);
+int _tbm_surface_internal_dump_async_buffer(tbm_surface_h surface, tbm_surface_queue_h queue,
+					    const char *type);
+int _tbm_surface_internal_y4m_get_frame_size(int width, int height);
+int _tbm_surface_internal_y4m_convert(tbm_surface_info_s *info, uint8_t *frame);
+int _tbm_surface_internal_detile_nv12mt(tbm_surface_info_s *info,
+					unsigned char *dst_y, uint32_t y_stride,
+					unsigned char *dst_uv, uint32_t uv_stride);
+
+int _tbm_surface_internal_dump_ring_buffer(tbm_surface_h surface, const char *type);
+int _tbm_surface_internal_dump_ring_shm_buffer(void *ptr, int w, int h, int stride,
+					       const char *type);
+int _tbm_surface_internal_dump_ring_end(void);
+
+tbm_surface_h *_tbm_surface_internal_get_surfaces(int *num);
+int _tbm_surface_internal_dump_all(const char *path);
+
+/* the LZ4 block format, table has 1 << TBM_LZ4_HASH_LOG entries */
+#define TBM_LZ4_HASH_LOG	12
+int _tbm_lz4_compress_bound(int size);
+int _tbm_lz4_compress(const uint8_t *src, int size, uint8_t *dst, int capacity, uint32_t *table);
+int _tbm_lz4_decompress(const uint8_t *src, int src_size, uint8_t *dst, int size);
+
+/* worker threads, func is called once for every idx in [0, count) */
+typedef void (*tbm_worker_func)(void *data, int idx);
+int _tbm_worker_get_count(void);
+int _tbm_worker_get_bands(uint64_t bytes);
+void _tbm_worker_run(tbm_worker_func func, void *data, int count);
 
 /* functions for mutex */
 int tbm_surface_internal_get_info(tbm_surface_h surface, int opt,
@@ -313,6 +393,9 @@ unsigned int tbm_surface_internal_get_width(tbm_surface_h surface);
 unsigned int tbm_surface_internal_get_height(tbm_surface_h surface);
 tbm_format tbm_surface_internal_get_format(tbm_surface_h surface);
 unsigned int _tbm_surface_internal_get_debug_pid(tbm_surface_h surface);
+int _tbm_surface_internal_get_refcnt(tbm_surface_h surface);
+int _tbm_surface_internal_get_layout(tbm_bufmgr bufmgr, int width, int height, int format,
+				     tbm_surface_info_s *info);
 char *_tbm_surface_internal_format_to_str(tbm_format format);
 char * _tbm_surface_internal_get_debug_data(tbm_surface_h surface, char *key);
 
@@ -0,0 +1,75 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#include "config.h"
+
+#include "tbm_bufmgr_int.h"
+
+static pthread_once_t tbm_cpu_once = PTHREAD_ONCE_INIT;
+static unsigned int tbm_cpu_features;
+
+static void
+_tbm_cpu_init(void)
+{
+	unsigned int features = 0;
+	const char *env;
+
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse2"))
+		features |= TBM_CPU_SSE2;
+	if (__builtin_cpu_supports("avx2"))
+		features |= TBM_CPU_AVX2;
+#endif
+
+#ifdef TBM_SIMD_NEON
+	/* the whole library is built for neon in this case */
+	features |= TBM_CPU_NEON;
+#endif
+
+	/* TBM_CPU_FEATURES masks the detected features, 0 forces the C paths */
+	env = getenv("TBM_CPU_FEATURES");
+	if (env)
+		features &= strtoul(env, NULL, 0);
+
+	tbm_cpu_features = features;
+
+	TBM_DBG("cpu features: 0x%x\n", tbm_cpu_features);
+}
+
+unsigned int
+_tbm_cpu_get_features(void)
+{
+	pthread_once(&tbm_cpu_once, _tbm_cpu_init);
+
+	return tbm_cpu_features;
+}
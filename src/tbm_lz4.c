@@ -0,0 +1,259 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#include "config.h"
+
+#include <stdint.h>
+#include "tbm_bufmgr_int.h"
+
+/* The block format of LZ4: sequences of a token, the literals and a match
+ * of 16 bit offset. The compressor is greedy with one hash table of 4 byte
+ * sequences, fast enough to keep the frames of a queue compressed as they
+ * come, and the last 5 bytes are always literals like the format wants.
+ */
+#define TBM_LZ4_MIN_MATCH	4
+#define TBM_LZ4_LAST_LITERALS	5
+#define TBM_LZ4_MF_LIMIT	12		/* a match starts this far from the end at least */
+#define TBM_LZ4_MAX_OFFSET	65535
+#define TBM_LZ4_SKIP_TRIGGER	6		/* skip faster on data which doesn't compress */
+
+static inline uint32_t
+_tbm_lz4_read32(const uint8_t *p)
+{
+	uint32_t v;
+
+	memcpy(&v, p, sizeof(v));
+
+	return v;
+}
+
+static inline uint64_t
+_tbm_lz4_read64(const uint8_t *p)
+{
+	uint64_t v;
+
+	memcpy(&v, p, sizeof(v));
+
+	return v;
+}
+
+static inline uint32_t
+_tbm_lz4_hash(uint32_t seq)
+{
+	return (seq * 2654435761U) >> (32 - TBM_LZ4_HASH_LOG);
+}
+
+/* the length of the match of a and b, b + len stays below limit */
+static inline int
+_tbm_lz4_match_length(const uint8_t *a, const uint8_t *b, const uint8_t *limit)
+{
+	const uint8_t *start = b;
+
+	while (b + 8 <= limit) {
+		uint64_t diff = _tbm_lz4_read64(a) ^ _tbm_lz4_read64(b);
+
+		if (diff)
+			return b - start + (__builtin_ctzll(diff) >> 3);
+		a += 8;
+		b += 8;
+	}
+
+	while (b < limit && *a == *b) {
+		a++;
+		b++;
+	}
+
+	return b - start;
+}
+
+static inline uint8_t *
+_tbm_lz4_write_length(uint8_t *op, int len)
+{
+	for (; len >= 255; len -= 255)
+		*op++ = 255;
+	*op++ = len;
+
+	return op;
+}
+
+int
+_tbm_lz4_compress_bound(int size)
+{
+	return size + size / 255 + 16;
+}
+
+int
+_tbm_lz4_compress(const uint8_t *src, int size, uint8_t *dst, int capacity, uint32_t *table)
+{
+	const uint8_t *ip = src, *anchor = src;
+	const uint8_t *end = src + size;
+	const uint8_t *mf_limit = end - TBM_LZ4_MF_LIMIT;
+	const uint8_t *match_limit = end - TBM_LZ4_LAST_LITERALS;
+	uint8_t *op = dst;
+	int literals;
+
+	if (capacity < _tbm_lz4_compress_bound(size))
+		return 0;
+
+	/* 0 is no position, the positions are stored + 1 */
+	memset(table, 0, sizeof(uint32_t) << TBM_LZ4_HASH_LOG);
+
+	if (size < TBM_LZ4_MF_LIMIT + 1)
+		goto last_literals;
+
+	while (ip < mf_limit) {
+		uint32_t seq = _tbm_lz4_read32(ip);
+		uint32_t h = _tbm_lz4_hash(seq);
+		uint32_t ref_pos = table[h];
+		const uint8_t *ref = src + ref_pos - 1;
+		uint8_t *token;
+		int len;
+
+		table[h] = ip - src + 1;
+
+		if (!ref_pos || ip - ref > TBM_LZ4_MAX_OFFSET || _tbm_lz4_read32(ref) != seq) {
+			ip += 1 + ((ip - anchor) >> TBM_LZ4_SKIP_TRIGGER);
+			continue;
+		}
+
+		/* the match goes back over the literals which match too */
+		while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+			ip--;
+			ref--;
+		}
+
+		len = TBM_LZ4_MIN_MATCH +
+		      _tbm_lz4_match_length(ref + TBM_LZ4_MIN_MATCH, ip + TBM_LZ4_MIN_MATCH, match_limit);
+
+		literals = ip - anchor;
+		token = op++;
+		*token = (literals >= 15 ? 15 : literals) << 4;
+		if (literals >= 15)
+			op = _tbm_lz4_write_length(op, literals - 15);
+		memcpy(op, anchor, literals);
+		op += literals;
+
+		*op++ = (ip - ref) & 0xff;
+		*op++ = (ip - ref) >> 8;
+
+		*token |= (len - TBM_LZ4_MIN_MATCH >= 15) ? 15 : len - TBM_LZ4_MIN_MATCH;
+		if (len - TBM_LZ4_MIN_MATCH >= 15)
+			op = _tbm_lz4_write_length(op, len - TBM_LZ4_MIN_MATCH - 15);
+
+		ip += len;
+		anchor = ip;
+
+		/* the position inside the match helps the next one */
+		if (ip - 2 < mf_limit)
+			table[_tbm_lz4_hash(_tbm_lz4_read32(ip - 2))] = ip - 2 - src + 1;
+	}
+
+last_literals:
+	literals = end - anchor;
+	*op++ = (literals >= 15 ? 15 : literals) << 4;
+	if (literals >= 15)
+		op = _tbm_lz4_write_length(op, literals - 15);
+	memcpy(op, anchor, literals);
+	op += literals;
+
+	return op - dst;
+}
+
+/* 1 when src decompresses to exactly size bytes */
+int
+_tbm_lz4_decompress(const uint8_t *src, int src_size, uint8_t *dst, int size)
+{
+	const uint8_t *ip = src, *ip_end = src + src_size;
+	uint8_t *op = dst, *op_end = dst + size;
+
+	while (ip < ip_end) {
+		int token = *ip++;
+		int literals = token >> 4, len = token & 15;
+		const uint8_t *ref;
+		int offset, i;
+
+		if (literals == 15) {
+			int b;
+
+			do {
+				if (ip >= ip_end)
+					return 0;
+				b = *ip++;
+				literals += b;
+			} while (b == 255);
+		}
+
+		if (literals > ip_end - ip || literals > op_end - op)
+			return 0;
+		memcpy(op, ip, literals);
+		ip += literals;
+		op += literals;
+
+		/* the last sequence has no match */
+		if (ip == ip_end)
+			break;
+
+		if (ip_end - ip < 2)
+			return 0;
+		offset = ip[0] | ip[1] << 8;
+		ip += 2;
+		ref = op - offset;
+		if (!offset || ref < dst)
+			return 0;
+
+		if (len == 15) {
+			int b;
+
+			do {
+				if (ip >= ip_end)
+					return 0;
+				b = *ip++;
+				len += b;
+			} while (b == 255);
+		}
+		len += TBM_LZ4_MIN_MATCH;
+
+		if (len > op_end - op)
+			return 0;
+
+		/* the match can overlap the bytes it makes */
+		if (offset >= len) {
+			memcpy(op, ref, len);
+			op += len;
+		} else {
+			for (i = 0; i < len; i++)
+				*op++ = ref[i];
+		}
+	}
+
+	return op == op_end;
+}
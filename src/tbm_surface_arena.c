@@ -0,0 +1,385 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#include "config.h"
+
+#include "tbm_bufmgr_int.h"
+#include "tbm_surface_arena.h"
+#include "list.h"
+
+/* the budget is spread over this many bos, a bigger surface takes a bo of
+ * its own size.
+ */
+#define TBM_SURFACE_ARENA_NUM_BOS	4
+#define TBM_SURFACE_ARENA_ALIGN	256
+#define TBM_SURFACE_ARENA_PAGE_SIZE	4096
+
+typedef struct {
+	tbm_bo bo;
+	unsigned int size;
+
+	/* the bump pointer of the current frame */
+	unsigned int used;
+
+	/* link of bo_list */
+	struct list_head item_link;
+} tbm_surface_arena_bo;
+
+typedef struct {
+	tbm_surface_h surface;
+	tbm_surface_arena_bo *abo;
+
+	/* its range in the bo */
+	unsigned int offset;
+	unsigned int size;
+} tbm_surface_arena_item;
+
+struct _tbm_surface_arena {
+	pthread_mutex_t lock;
+
+	tbm_bufmgr bufmgr;
+	unsigned int bo_size;
+	int flags;
+
+	struct list_head bo_list;
+
+	/* the bo which is filled now, the ones before it are full */
+	tbm_surface_arena_bo *cur;
+
+	/* the surfaces of the current frame and the ones of the earlier frames
+	 * which are still referenced
+	 */
+	tbm_surface_arena_item *items;
+	int max_items;
+
+	tbm_surface_arena_stats_s stats;
+};
+
+static tbm_surface_arena_bo *
+_tbm_surface_arena_add_bo(tbm_surface_arena_h arena, unsigned int size)
+{
+	tbm_surface_arena_bo *abo;
+
+	if (size < arena->bo_size)
+		size = arena->bo_size;
+
+	/* the last bo takes the rest of the budget */
+	if (size > arena->stats.budget - arena->stats.bo_size)
+		size = arena->stats.budget - arena->stats.bo_size;
+
+	abo = calloc(1, sizeof(tbm_surface_arena_bo));
+	if (!abo) {
+		TBM_LOG_E("fail to alloc the bo of tbm_surface_arena(%p)\n", arena);
+		return NULL;
+	}
+
+	abo->bo = tbm_bo_alloc(arena->bufmgr, size, arena->flags);
+	if (!abo->bo) {
+		TBM_LOG_E("fail to alloc the bo of tbm_surface_arena(%p) size(%u)\n", arena, size);
+		free(abo);
+		return NULL;
+	}
+
+	abo->size = size;
+	LIST_ADDTAIL(&abo->item_link, &arena->bo_list);
+
+	arena->stats.num_bos++;
+	arena->stats.bo_size += size;
+
+	return abo;
+}
+
+/* bumps the range of size in the current bo, or in the next one which has
+ * room. must be called with the arena locked.
+ */
+static tbm_surface_arena_bo *
+_tbm_surface_arena_reserve(tbm_surface_arena_h arena, unsigned int size, unsigned int *offset)
+{
+	tbm_surface_arena_bo *abo = arena->cur;
+
+	while (abo) {
+		if (abo->size - abo->used >= size)
+			break;
+
+		if (abo->item_link.next == &arena->bo_list)
+			abo = NULL;
+		else
+			abo = LIST_ENTRY(tbm_surface_arena_bo, abo->item_link.next, item_link);
+	}
+
+	if (!abo) {
+		if (size > arena->stats.budget - arena->stats.bo_size) {
+			TBM_LOG_E("the budget of tbm_surface_arena(%p) is used up (%u, %u)\n",
+				  arena, size, arena->stats.budget - arena->stats.bo_size);
+			return NULL;
+		}
+
+		abo = _tbm_surface_arena_add_bo(arena, size);
+		if (!abo)
+			return NULL;
+	}
+
+	*offset = abo->used;
+	abo->used += size;
+	arena->cur = abo;
+
+	return abo;
+}
+
+static int
+_tbm_surface_arena_grow(tbm_surface_arena_h arena)
+{
+	tbm_surface_arena_item *items;
+	int max_items;
+
+	if (arena->stats.num_surfaces < (unsigned int)arena->max_items)
+		return 1;
+
+	max_items = arena->max_items ? arena->max_items * 2 : 16;
+
+	items = calloc(max_items, sizeof(tbm_surface_arena_item));
+	if (!items) {
+		TBM_LOG_E("fail to alloc the surfaces of tbm_surface_arena(%p)\n", arena);
+		return 0;
+	}
+
+	if (arena->items) {
+		memcpy(items, arena->items, arena->stats.num_surfaces * sizeof(tbm_surface_arena_item));
+		free(arena->items);
+	}
+
+	arena->items = items;
+	arena->max_items = max_items;
+
+	return 1;
+}
+
+/* must be called with the arena locked */
+static void
+_tbm_surface_arena_reset(tbm_surface_arena_h arena)
+{
+	tbm_surface_arena_bo *abo = NULL;
+	tbm_surface_arena_item *item;
+	unsigned int i, num = 0, used_size = 0;
+
+	LIST_FOR_EACH_ENTRY(abo, &arena->bo_list, item_link)
+		abo->used = 0;
+
+	for (i = 0; i < arena->stats.num_surfaces; i++) {
+		item = &arena->items[i];
+
+		/* still used by someone, the next frames are placed after its
+		 * range until a later reset finds it released
+		 */
+		if (_tbm_surface_internal_get_refcnt(item->surface) > 1) {
+			TBM_DBG("tbm_surface(%p) of tbm_surface_arena(%p) is still referenced\n",
+				item->surface, arena);
+
+			if (item->abo->used < item->offset + item->size)
+				item->abo->used = item->offset + item->size;
+			used_size += item->size;
+			arena->items[num++] = *item;
+			continue;
+		}
+
+		tbm_surface_internal_unref(item->surface);
+	}
+
+	if (LIST_IS_EMPTY(&arena->bo_list))
+		arena->cur = NULL;
+	else
+		arena->cur = LIST_ENTRY(tbm_surface_arena_bo, arena->bo_list.next, item_link);
+
+	arena->stats.num_surfaces = num;
+	arena->stats.used_size = used_size;
+}
+
+tbm_surface_arena_h
+tbm_surface_arena_create(unsigned int budget, int flags)
+{
+	tbm_surface_arena_h arena;
+
+	TBM_RETURN_VAL_IF_FAIL(budget > 0, NULL);
+
+	arena = calloc(1, sizeof(struct _tbm_surface_arena));
+	if (!arena) {
+		TBM_LOG_E("fail to alloc surface arena\n");
+		return NULL;
+	}
+
+	if (pthread_mutex_init(&arena->lock, NULL)) {
+		TBM_LOG_E("fail: pthread_mutex_init for surface arena\n");
+		free(arena);
+		return NULL;
+	}
+
+	arena->bufmgr = tbm_bufmgr_init(-1);
+	if (!arena->bufmgr) {
+		TBM_LOG_E("fail to init the bufmgr for surface arena\n");
+		pthread_mutex_destroy(&arena->lock);
+		free(arena);
+		return NULL;
+	}
+
+	arena->bo_size = budget / TBM_SURFACE_ARENA_NUM_BOS;
+	arena->bo_size = (arena->bo_size + TBM_SURFACE_ARENA_PAGE_SIZE - 1) &
+			 ~(TBM_SURFACE_ARENA_PAGE_SIZE - 1);
+	arena->flags = flags;
+	arena->stats.budget = budget;
+
+	LIST_INITHEAD(&arena->bo_list);
+
+	TBM_TRACE("tbm_surface_arena(%p) budget(%u) flags(%d)\n", arena, budget, flags);
+
+	return arena;
+}
+
+void
+tbm_surface_arena_destroy(tbm_surface_arena_h arena)
+{
+	tbm_surface_arena_bo *abo = NULL, *tmp = NULL;
+	unsigned int i;
+
+	TBM_RETURN_IF_FAIL(arena);
+
+	TBM_TRACE("tbm_surface_arena(%p)\n", arena);
+
+	/* the surfaces still referenced keep their bo by themselves */
+	pthread_mutex_lock(&arena->lock);
+	for (i = 0; i < arena->stats.num_surfaces; i++)
+		tbm_surface_internal_unref(arena->items[i].surface);
+	pthread_mutex_unlock(&arena->lock);
+
+	LIST_FOR_EACH_ENTRY_SAFE(abo, tmp, &arena->bo_list, item_link) {
+		LIST_DEL(&abo->item_link);
+		tbm_bo_unref(abo->bo);
+		free(abo);
+	}
+
+	free(arena->items);
+	pthread_mutex_destroy(&arena->lock);
+	tbm_bufmgr_deinit(arena->bufmgr);
+	free(arena);
+}
+
+tbm_surface_h
+tbm_surface_arena_alloc(tbm_surface_arena_h arena, int width, int height, int format)
+{
+	tbm_surface_arena_bo *abo;
+	tbm_surface_info_s info;
+	tbm_surface_h surface;
+	unsigned int size, offset;
+	int i;
+
+	TBM_RETURN_VAL_IF_FAIL(arena, NULL);
+	TBM_RETURN_VAL_IF_FAIL(width > 0, NULL);
+	TBM_RETURN_VAL_IF_FAIL(height > 0, NULL);
+
+	pthread_mutex_lock(&arena->lock);
+
+	/* all the planes have to be in the bo */
+	if (_tbm_surface_internal_get_layout(arena->bufmgr, width, height, format, &info) != 1) {
+		TBM_LOG_E("can't put format(%s) in tbm_surface_arena(%p)\n",
+			  _tbm_surface_internal_format_to_str(format), arena);
+		goto fail;
+	}
+
+	if (!_tbm_surface_arena_grow(arena))
+		goto fail;
+
+	size = (info.size + TBM_SURFACE_ARENA_ALIGN - 1) & ~(TBM_SURFACE_ARENA_ALIGN - 1);
+
+	abo = _tbm_surface_arena_reserve(arena, size, &offset);
+	if (!abo)
+		goto fail;
+
+	for (i = 0; i < (int)info.num_planes; i++)
+		info.planes[i].offset += offset;
+
+	surface = tbm_surface_internal_create_with_bos(&info, &abo->bo, 1);
+	if (!surface) {
+		/* nothing is placed after it yet */
+		abo->used = offset;
+		goto fail;
+	}
+
+	arena->items[arena->stats.num_surfaces].surface = surface;
+	arena->items[arena->stats.num_surfaces].abo = abo;
+	arena->items[arena->stats.num_surfaces].offset = offset;
+	arena->items[arena->stats.num_surfaces].size = size;
+	arena->stats.num_surfaces++;
+	arena->stats.used_size += size;
+	if (arena->stats.peak_size < arena->stats.used_size)
+		arena->stats.peak_size = arena->stats.used_size;
+	arena->stats.allocs++;
+
+	pthread_mutex_unlock(&arena->lock);
+
+	TBM_TRACE("tbm_surface_arena(%p) tbm_surface(%p) offset(%u) size(%u)\n",
+		  arena, surface, offset, size);
+
+	return surface;
+
+fail:
+	arena->stats.failures++;
+	pthread_mutex_unlock(&arena->lock);
+
+	return NULL;
+}
+
+void
+tbm_surface_arena_reset(tbm_surface_arena_h arena)
+{
+	TBM_RETURN_IF_FAIL(arena);
+
+	pthread_mutex_lock(&arena->lock);
+
+	_tbm_surface_arena_reset(arena);
+	arena->stats.resets++;
+
+	pthread_mutex_unlock(&arena->lock);
+
+	TBM_TRACE("tbm_surface_arena(%p)\n", arena);
+}
+
+int
+tbm_surface_arena_get_stats(tbm_surface_arena_h arena, tbm_surface_arena_stats_s *stats)
+{
+	TBM_RETURN_VAL_IF_FAIL(arena, 0);
+	TBM_RETURN_VAL_IF_FAIL(stats, 0);
+
+	pthread_mutex_lock(&arena->lock);
+	*stats = arena->stats;
+	pthread_mutex_unlock(&arena->lock);
+
+	return 1;
+}
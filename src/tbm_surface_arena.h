@@ -0,0 +1,135 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#ifndef _TBM_SURFACE_ARENA_H_
+#define _TBM_SURFACE_ARENA_H_
+
+#include <tbm_surface.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct _tbm_surface_arena *tbm_surface_arena_h;
+
+/**
+ * @brief Definition for the statistics of a surface arena.
+ */
+typedef struct _tbm_surface_arena_stats {
+	unsigned int budget;        /**< the bytes the bos of the arena may take */
+	unsigned int num_bos;       /**< the number of the bos of the arena */
+	unsigned int bo_size;       /**< the bytes of the bos of the arena */
+	unsigned int num_surfaces;  /**< the number of surfaces of the current frame and the held ones */
+	unsigned int used_size;     /**< the bytes given to the surfaces of the current frame and the held ones */
+	unsigned int peak_size;     /**< the most bytes given in a frame */
+	unsigned int allocs;        /**< the surfaces made by the arena */
+	unsigned int failures;      /**< the surfaces which the arena couldn't make */
+	unsigned int resets;        /**< the number of the resets */
+} tbm_surface_arena_stats_s;
+
+/**
+ * @brief Creates a surface arena.
+ * @details
+ * A surface arena makes the scratch surfaces which live for one frame, the
+ * intermediates of a blur or the temporaries of a format conversion. The
+ * surfaces are placed one after another in a few large bos and are all
+ * released at once by tbm_surface_arena_reset(). The bos are kept for the
+ * next frame, so the render loop doesn't allocate or free any bo.
+ * @param[in] budget : the bytes the bos of the arena may take
+ * @param[in] flags  : the flags of memory type of the bos
+ * @return a surface arena if this function succeeds, otherwise NULL
+ * @par Example
+   @code
+   #include <tbm_surface_arena.h>
+
+   tbm_surface_arena_h arena;
+   tbm_surface_h blur;
+
+   arena = tbm_surface_arena_create (32 * 1024 * 1024, TBM_BO_DEFAULT);
+
+   while (rendering) {
+       blur = tbm_surface_arena_alloc (arena, 480, 270, TBM_FORMAT_ARGB8888);
+
+       ...
+
+       tbm_surface_arena_reset (arena);
+   }
+
+   tbm_surface_arena_destroy (arena);
+   @endcode
+ */
+tbm_surface_arena_h tbm_surface_arena_create(unsigned int budget, int flags);
+
+/**
+ * @brief Destroys a surface arena and the surfaces of the current frame.
+ * @param[in] arena : the surface arena
+ */
+void tbm_surface_arena_destroy(tbm_surface_arena_h arena);
+
+/**
+ * @brief Makes a surface of the current frame in a surface arena.
+ * @details
+ * The surface belongs to the arena, it must not be destroyed by the caller
+ * and must not be used after the next tbm_surface_arena_reset(). The planes
+ * of the format have to be in one bo.
+ * @param[in] arena  : the surface arena
+ * @param[in] width  : the width of surface
+ * @param[in] height : the height of surface
+ * @param[in] format : the format of surface
+ * @return a tbm_surface_h if this function succeeds, otherwise NULL when the
+ * budget of the arena is used up
+ */
+tbm_surface_h tbm_surface_arena_alloc(tbm_surface_arena_h arena, int width, int height,
+				      int format);
+
+/**
+ * @brief Releases all the surfaces of the current frame of a surface arena.
+ * @details The bos of the arena are kept and filled again from the start.
+ * A surface which is still referenced, ex) by tbm_surface_internal_ref(),
+ * is held: its range isn't given to the next frames until a later reset
+ * finds it released.
+ * @param[in] arena : the surface arena
+ */
+void tbm_surface_arena_reset(tbm_surface_arena_h arena);
+
+/**
+ * @brief Gets the statistics of a surface arena.
+ * @param[in] arena : the surface arena
+ * @param[out] stats : the statistics
+ * @return 1 if this function succeeds, otherwise 0
+ */
+int tbm_surface_arena_get_stats(tbm_surface_arena_h arena, tbm_surface_arena_stats_s *stats);
+
+#ifdef __cplusplus
+}
+#endif
+#endif							/* _TBM_SURFACE_ARENA_H_ */
@@ -0,0 +1,491 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#include "config.h"
+
+#include "tbm_bufmgr_int.h"
+#include "tbm_surface_atlas.h"
+#include "list.h"
+
+/* the start of a surface in a shared bo, enough for the planes of the
+ * hardware which reads the surfaces.
+ */
+#define TBM_SURFACE_ATLAS_ALIGN	256
+
+/* a free range of a shared bo */
+typedef struct {
+	unsigned int offset;
+	unsigned int size;
+
+	/* link of free_list, in the order of the offsets */
+	struct list_head item_link;
+} tbm_surface_atlas_range;
+
+typedef struct {
+	tbm_bo bo;
+	unsigned int used;
+	unsigned int num_surfaces;
+
+	struct list_head free_list;
+
+	/* link of bo_list */
+	struct list_head item_link;
+} tbm_surface_atlas_bo;
+
+/* the user data of a surface of the atlas */
+typedef struct {
+	tbm_surface_atlas_h atlas;
+	tbm_surface_atlas_bo *abo;
+	unsigned int offset;
+	unsigned int size;
+} tbm_surface_atlas_block;
+
+struct _tbm_surface_atlas {
+	pthread_mutex_t lock;
+
+	tbm_bufmgr bufmgr;
+	unsigned int bo_size;
+	int flags;
+
+	/* the atlas itself and every surface alive */
+	int refcnt;
+	int destroyed;
+
+	struct list_head bo_list;
+
+	tbm_surface_atlas_stats_s stats;
+};
+
+static unsigned long tbm_surface_atlas_key;
+
+static void
+_tbm_surface_atlas_free_bo(tbm_surface_atlas_bo *abo)
+{
+	tbm_surface_atlas_range *range = NULL, *tmp = NULL;
+
+	LIST_FOR_EACH_ENTRY_SAFE(range, tmp, &abo->free_list, item_link) {
+		LIST_DEL(&range->item_link);
+		free(range);
+	}
+
+	tbm_bo_unref(abo->bo);
+	free(abo);
+}
+
+static void
+_tbm_surface_atlas_free(tbm_surface_atlas_h atlas)
+{
+	pthread_mutex_destroy(&atlas->lock);
+	tbm_bufmgr_deinit(atlas->bufmgr);
+	free(atlas);
+}
+
+static tbm_surface_atlas_bo *
+_tbm_surface_atlas_add_bo(tbm_surface_atlas_h atlas)
+{
+	tbm_surface_atlas_range *range;
+	tbm_surface_atlas_bo *abo;
+
+	abo = calloc(1, sizeof(tbm_surface_atlas_bo));
+	range = calloc(1, sizeof(tbm_surface_atlas_range));
+	if (!abo || !range) {
+		TBM_LOG_E("fail to alloc the shared bo of tbm_surface_atlas(%p)\n", atlas);
+		free(abo);
+		free(range);
+		return NULL;
+	}
+
+	abo->bo = tbm_bo_alloc(atlas->bufmgr, atlas->bo_size, atlas->flags);
+	if (!abo->bo) {
+		TBM_LOG_E("fail to alloc the shared bo of tbm_surface_atlas(%p)\n", atlas);
+		free(abo);
+		free(range);
+		return NULL;
+	}
+
+	range->size = atlas->bo_size;
+	LIST_INITHEAD(&abo->free_list);
+	LIST_ADDTAIL(&range->item_link, &abo->free_list);
+
+	LIST_ADDTAIL(&abo->item_link, &atlas->bo_list);
+	atlas->stats.num_bos++;
+	atlas->stats.bo_size += atlas->bo_size;
+
+	return abo;
+}
+
+/* the best fitting range of the fullest bo which has room, or a new bo.
+ * must be called with the atlas locked.
+ */
+static int
+_tbm_surface_atlas_reserve(tbm_surface_atlas_h atlas, unsigned int size,
+			   tbm_surface_atlas_block *block)
+{
+	tbm_surface_atlas_range *range = NULL, *best = NULL;
+	tbm_surface_atlas_bo *abo = NULL, *best_abo = NULL;
+
+	LIST_FOR_EACH_ENTRY(abo, &atlas->bo_list, item_link) {
+		if (best_abo && abo->used <= best_abo->used)
+			continue;
+
+		LIST_FOR_EACH_ENTRY(range, &abo->free_list, item_link) {
+			if (range->size < size)
+				continue;
+
+			if (best_abo != abo || range->size < best->size) {
+				best = range;
+				best_abo = abo;
+			}
+		}
+	}
+
+	if (!best) {
+		best_abo = _tbm_surface_atlas_add_bo(atlas);
+		if (!best_abo)
+			return 0;
+
+		best = LIST_ENTRY(tbm_surface_atlas_range, best_abo->free_list.next, item_link);
+	}
+
+	block->atlas = atlas;
+	block->abo = best_abo;
+	block->offset = best->offset;
+	block->size = size;
+
+	best->offset += size;
+	best->size -= size;
+	if (!best->size) {
+		LIST_DEL(&best->item_link);
+		free(best);
+	}
+
+	best_abo->used += size;
+	best_abo->num_surfaces++;
+
+	atlas->stats.num_surfaces++;
+	atlas->stats.used_size += size;
+
+	return 1;
+}
+
+/* gives the range of block back and merges it with its neighbours.
+ * must be called with the atlas locked.
+ */
+static void
+_tbm_surface_atlas_unreserve(tbm_surface_atlas_h atlas, tbm_surface_atlas_block *block)
+{
+	tbm_surface_atlas_bo *abo = block->abo;
+	tbm_surface_atlas_range *range = NULL, *prev = NULL, *next = NULL;
+
+	LIST_FOR_EACH_ENTRY(range, &abo->free_list, item_link) {
+		if (range->offset > block->offset) {
+			next = range;
+			break;
+		}
+		prev = range;
+	}
+
+	if (prev && prev->offset + prev->size == block->offset) {
+		prev->size += block->size;
+		if (next && prev->offset + prev->size == next->offset) {
+			prev->size += next->size;
+			LIST_DEL(&next->item_link);
+			free(next);
+		}
+	} else if (next && block->offset + block->size == next->offset) {
+		next->offset = block->offset;
+		next->size += block->size;
+	} else {
+		range = calloc(1, sizeof(tbm_surface_atlas_range));
+		if (!range) {
+			/* the range is lost until the atlas is destroyed */
+			TBM_LOG_E("fail to alloc the free range of tbm_surface_atlas(%p)\n", atlas);
+		} else {
+			range->offset = block->offset;
+			range->size = block->size;
+			if (next)
+				LIST_ADDTAIL(&range->item_link, &next->item_link);
+			else
+				LIST_ADDTAIL(&range->item_link, &abo->free_list);
+		}
+	}
+
+	abo->used -= block->size;
+	abo->num_surfaces--;
+
+	atlas->stats.num_surfaces--;
+	atlas->stats.used_size -= block->size;
+}
+
+/* the free function of the user data, the surface is being destroyed */
+static void
+_tbm_surface_atlas_release(void *data)
+{
+	tbm_surface_atlas_block *block = data;
+	tbm_surface_atlas_h atlas = block->atlas;
+	int refcnt;
+
+	pthread_mutex_lock(&atlas->lock);
+
+	/* the bos of a destroyed atlas are gone with their ranges */
+	if (!atlas->destroyed)
+		_tbm_surface_atlas_unreserve(atlas, block);
+
+	refcnt = --atlas->refcnt;
+
+	pthread_mutex_unlock(&atlas->lock);
+
+	free(block);
+
+	if (!refcnt)
+		_tbm_surface_atlas_free(atlas);
+}
+
+tbm_surface_atlas_h
+tbm_surface_atlas_create(unsigned int bo_size, int flags)
+{
+	tbm_surface_atlas_h atlas;
+
+	TBM_RETURN_VAL_IF_FAIL(bo_size > 0, NULL);
+
+	atlas = calloc(1, sizeof(struct _tbm_surface_atlas));
+	if (!atlas) {
+		TBM_LOG_E("fail to alloc surface atlas\n");
+		return NULL;
+	}
+
+	if (pthread_mutex_init(&atlas->lock, NULL)) {
+		TBM_LOG_E("fail: pthread_mutex_init for surface atlas\n");
+		free(atlas);
+		return NULL;
+	}
+
+	atlas->bufmgr = tbm_bufmgr_init(-1);
+	if (!atlas->bufmgr) {
+		TBM_LOG_E("fail to init the bufmgr for surface atlas\n");
+		pthread_mutex_destroy(&atlas->lock);
+		free(atlas);
+		return NULL;
+	}
+
+	atlas->bo_size = (bo_size + TBM_SURFACE_ATLAS_ALIGN - 1) & ~(TBM_SURFACE_ATLAS_ALIGN - 1);
+	atlas->flags = flags;
+	atlas->refcnt = 1;
+
+	LIST_INITHEAD(&atlas->bo_list);
+
+	TBM_TRACE("tbm_surface_atlas(%p) bo_size(%u) flags(%d)\n", atlas, atlas->bo_size, flags);
+
+	return atlas;
+}
+
+void
+tbm_surface_atlas_destroy(tbm_surface_atlas_h atlas)
+{
+	tbm_surface_atlas_bo *abo = NULL, *tmp = NULL;
+	struct list_head bo_list;
+	int refcnt;
+
+	TBM_RETURN_IF_FAIL(atlas);
+
+	TBM_TRACE("tbm_surface_atlas(%p)\n", atlas);
+
+	LIST_INITHEAD(&bo_list);
+
+	pthread_mutex_lock(&atlas->lock);
+
+	/* the surfaces alive keep their own references of the bos */
+	LIST_FOR_EACH_ENTRY_SAFE(abo, tmp, &atlas->bo_list, item_link) {
+		LIST_DEL(&abo->item_link);
+		LIST_ADDTAIL(&abo->item_link, &bo_list);
+	}
+
+	atlas->destroyed = 1;
+	refcnt = --atlas->refcnt;
+
+	pthread_mutex_unlock(&atlas->lock);
+
+	LIST_FOR_EACH_ENTRY_SAFE(abo, tmp, &bo_list, item_link) {
+		LIST_DEL(&abo->item_link);
+		_tbm_surface_atlas_free_bo(abo);
+	}
+
+	if (!refcnt)
+		_tbm_surface_atlas_free(atlas);
+}
+
+tbm_surface_h
+tbm_surface_atlas_alloc(tbm_surface_atlas_h atlas, int width, int height, int format)
+{
+	tbm_surface_atlas_block *block;
+	tbm_surface_info_s info;
+	tbm_surface_h surface;
+	unsigned int size;
+	tbm_bo bo;
+	int i;
+
+	TBM_RETURN_VAL_IF_FAIL(atlas, NULL);
+	TBM_RETURN_VAL_IF_FAIL(width > 0, NULL);
+	TBM_RETURN_VAL_IF_FAIL(height > 0, NULL);
+
+	/* all the planes have to be in the shared bo */
+	if (_tbm_surface_internal_get_layout(atlas->bufmgr, width, height, format, &info) != 1) {
+		TBM_LOG_E("can't put format(%s) in tbm_surface_atlas(%p)\n",
+			  _tbm_surface_internal_format_to_str(format), atlas);
+		goto fail;
+	}
+
+	size = (info.size + TBM_SURFACE_ATLAS_ALIGN - 1) & ~(TBM_SURFACE_ATLAS_ALIGN - 1);
+	if (size > atlas->bo_size) {
+		TBM_LOG_E("%dx%d is over the bo size of tbm_surface_atlas(%p) (%u, %u)\n",
+			  width, height, atlas, size, atlas->bo_size);
+		goto fail;
+	}
+
+	block = calloc(1, sizeof(tbm_surface_atlas_block));
+	if (!block) {
+		TBM_LOG_E("fail to alloc the block of tbm_surface_atlas(%p)\n", atlas);
+		goto fail;
+	}
+
+	pthread_mutex_lock(&atlas->lock);
+
+	if (!_tbm_surface_atlas_reserve(atlas, size, block)) {
+		pthread_mutex_unlock(&atlas->lock);
+		free(block);
+		goto fail;
+	}
+
+	atlas->refcnt++;
+	bo = block->abo->bo;
+
+	pthread_mutex_unlock(&atlas->lock);
+
+	for (i = 0; i < (int)info.num_planes; i++)
+		info.planes[i].offset += block->offset;
+
+	surface = tbm_surface_internal_create_with_bos(&info, &bo, 1);
+	if (!surface) {
+		_tbm_surface_atlas_release(block);
+		goto fail;
+	}
+
+	if (!tbm_surface_internal_add_user_data(surface, (unsigned long)&tbm_surface_atlas_key,
+						_tbm_surface_atlas_release) ||
+	    !tbm_surface_internal_set_user_data(surface, (unsigned long)&tbm_surface_atlas_key,
+						block)) {
+		TBM_LOG_E("fail to set the user data of tbm_surface(%p)\n", surface);
+		tbm_surface_internal_unref(surface);
+		_tbm_surface_atlas_release(block);
+		goto fail;
+	}
+
+	pthread_mutex_lock(&atlas->lock);
+	atlas->stats.allocs++;
+	pthread_mutex_unlock(&atlas->lock);
+
+	TBM_TRACE("tbm_surface_atlas(%p) tbm_surface(%p) offset(%u) size(%u)\n",
+		  atlas, surface, block->offset, size);
+
+	return surface;
+
+fail:
+	pthread_mutex_lock(&atlas->lock);
+	atlas->stats.failures++;
+	pthread_mutex_unlock(&atlas->lock);
+
+	return NULL;
+}
+
+int
+tbm_surface_atlas_compact(tbm_surface_atlas_h atlas)
+{
+	tbm_surface_atlas_bo *abo = NULL, *tmp = NULL;
+	struct list_head empty_list;
+	int count = 0;
+
+	TBM_RETURN_VAL_IF_FAIL(atlas, 0);
+
+	LIST_INITHEAD(&empty_list);
+
+	pthread_mutex_lock(&atlas->lock);
+
+	LIST_FOR_EACH_ENTRY_SAFE(abo, tmp, &atlas->bo_list, item_link) {
+		if (abo->num_surfaces)
+			continue;
+
+		LIST_DEL(&abo->item_link);
+		LIST_ADDTAIL(&abo->item_link, &empty_list);
+
+		atlas->stats.num_bos--;
+		atlas->stats.bo_size -= atlas->bo_size;
+		atlas->stats.compacted++;
+		count++;
+	}
+
+	pthread_mutex_unlock(&atlas->lock);
+
+	LIST_FOR_EACH_ENTRY_SAFE(abo, tmp, &empty_list, item_link) {
+		LIST_DEL(&abo->item_link);
+		_tbm_surface_atlas_free_bo(abo);
+	}
+
+	TBM_TRACE("tbm_surface_atlas(%p) released(%d)\n", atlas, count);
+
+	return count;
+}
+
+int
+tbm_surface_atlas_get_stats(tbm_surface_atlas_h atlas, tbm_surface_atlas_stats_s *stats)
+{
+	tbm_surface_atlas_range *range = NULL;
+	tbm_surface_atlas_bo *abo = NULL;
+
+	TBM_RETURN_VAL_IF_FAIL(atlas, 0);
+	TBM_RETURN_VAL_IF_FAIL(stats, 0);
+
+	pthread_mutex_lock(&atlas->lock);
+
+	*stats = atlas->stats;
+	stats->largest_free = 0;
+
+	LIST_FOR_EACH_ENTRY(abo, &atlas->bo_list, item_link) {
+		LIST_FOR_EACH_ENTRY(range, &abo->free_list, item_link) {
+			if (stats->largest_free < range->size)
+				stats->largest_free = range->size;
+		}
+	}
+
+	pthread_mutex_unlock(&atlas->lock);
+
+	return 1;
+}
@@ -0,0 +1,131 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#ifndef _TBM_SURFACE_ATLAS_H_
+#define _TBM_SURFACE_ATLAS_H_
+
+#include <tbm_surface.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct _tbm_surface_atlas *tbm_surface_atlas_h;
+
+/**
+ * @brief Definition for the statistics of a surface atlas.
+ */
+typedef struct _tbm_surface_atlas_stats {
+	unsigned int num_bos;       /**< the number of the shared bos */
+	unsigned int bo_size;       /**< the bytes of the shared bos */
+	unsigned int num_surfaces;  /**< the number of surfaces alive in the shared bos */
+	unsigned int used_size;     /**< the bytes given to the surfaces */
+	unsigned int largest_free;  /**< the largest free range, a bigger surface takes a new bo */
+	unsigned int allocs;        /**< the surfaces made by the atlas */
+	unsigned int failures;      /**< the surfaces which the atlas couldn't make */
+	unsigned int compacted;     /**< the empty bos released by the compaction */
+} tbm_surface_atlas_stats_s;
+
+/**
+ * @brief Creates a surface atlas.
+ * @details
+ * A surface atlas carves small surfaces out of large shared bos, so many
+ * icons or glyph caches don't take a bo, a mapping and a rounded up page
+ * each. A new shared bo is allocated when no free range of the shared bos
+ * fits a surface.
+ * @param[in] bo_size : the bytes of a shared bo, the largest surface of the atlas
+ * @param[in] flags  : the flags of memory type of the shared bos
+ * @return a surface atlas if this function succeeds, otherwise NULL
+ * @par Example
+   @code
+   #include <tbm_surface_atlas.h>
+
+   tbm_surface_atlas_h atlas;
+   tbm_surface_h icon;
+
+   atlas = tbm_surface_atlas_create (4 * 1024 * 1024, TBM_BO_DEFAULT);
+   icon = tbm_surface_atlas_alloc (atlas, 64, 64, TBM_FORMAT_ARGB8888);
+
+   ...
+
+   tbm_surface_destroy (icon);
+   tbm_surface_atlas_destroy (atlas);
+   @endcode
+ */
+tbm_surface_atlas_h tbm_surface_atlas_create(unsigned int bo_size, int flags);
+
+/**
+ * @brief Destroys a surface atlas.
+ * @remarks The surfaces of the atlas which are alive are not destroyed, they
+ * keep their part of the shared bos until they are destroyed.
+ * @param[in] atlas : the surface atlas
+ */
+void tbm_surface_atlas_destroy(tbm_surface_atlas_h atlas);
+
+/**
+ * @brief Makes a surface in the shared bos of a surface atlas.
+ * @details
+ * The surface is a tbm_surface_h like any other one, it is destroyed with
+ * tbm_surface_destroy() and its range goes back to the atlas then. The
+ * planes of the format have to be in one bo.
+ * @param[in] atlas : the surface atlas
+ * @param[in] width  : the width of surface
+ * @param[in] height : the height of surface
+ * @param[in] format : the format of surface
+ * @return a tbm_surface_h if this function succeeds, otherwise NULL
+ */
+tbm_surface_h tbm_surface_atlas_alloc(tbm_surface_atlas_h atlas, int width, int height,
+				      int format);
+
+/**
+ * @brief Releases the shared bos of a surface atlas which have no surface.
+ * @details
+ * The surfaces alive are not moved, they may be mapped or used by the
+ * hardware. The atlas puts a new surface in the fullest bo which has room
+ * for it, so the bos of the short lived surfaces empty out to be released.
+ * @param[in] atlas : the surface atlas
+ * @return the number of the released bos
+ */
+int tbm_surface_atlas_compact(tbm_surface_atlas_h atlas);
+
+/**
+ * @brief Gets the statistics of a surface atlas.
+ * @param[in] atlas : the surface atlas
+ * @param[out] stats : the statistics
+ * @return 1 if this function succeeds, otherwise 0
+ */
+int tbm_surface_atlas_get_stats(tbm_surface_atlas_h atlas, tbm_surface_atlas_stats_s *stats);
+
+#ifdef __cplusplus
+}
+#endif
+#endif							/* _TBM_SURFACE_ATLAS_H_ */
@@ -0,0 +1,997 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#include "config.h"
+
+#include <stdint.h>
+#include "tbm_bufmgr_int.h"
+
+#ifdef TBM_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef TBM_SIMD_AVX2
+#include <immintrin.h>
+#endif
+#ifdef TBM_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+/* All kernels implement exactly the same integer arithmetic, so every
+ * simd path gives the same bytes as the C path.
+ *
+ * yuv to rgb, Q6:
+ *   y' = (Y - y_off) * y_mul + 32, u' = U - 128, v' = V - 128
+ *   R = sat16(y' + r_v * v') >> 6
+ *   G = sat16(sat16(y' - g_u * u') - g_v * v') >> 6
+ *   B = sat16(y' + b_u * u') >> 6
+ * every term fits in int16, only the sums may saturate and those are
+ * clamped to 255 anyway.
+ *
+ * rgb to yuv, Q8, chroma of the 2x2 (or 2x1) block averaged with
+ * avg(a, b) = (a + b + 1) >> 1, first vertically then horizontally:
+ *   Y = ((y_r * R + y_g * G + y_b * B + 128) >> 8) + y_off
+ *   U = ((u_r * R + u_g * G + u_b * B + 128) >> 8) + 128
+ *   V = ((v_r * R + v_g * G + v_b * B + 128) >> 8) + 128
+ */
+typedef struct {
+	int16_t y_off;
+
+	/* yuv to rgb */
+	int16_t y_mul;
+	int16_t r_v;
+	int16_t g_u;
+	int16_t g_v;
+	int16_t b_u;
+
+	/* rgb to yuv */
+	int16_t y_r, y_g, y_b;
+	int16_t u_r, u_g, u_b;
+	int16_t v_r, v_g, v_b;
+} tbm_convert_coef;
+
+/* in the order of tbm_surface_colorspace_e */
+static const tbm_convert_coef convert_coefs[] = {
+	{ 16, 75, 102, 25, 52, 129,  66, 129,  25,  -38,  -74, 112,  112,  -94, -18 },
+	{  0, 64,  90, 22, 46, 113,  77, 150,  29,  -43,  -85, 128,  128, -107, -21 },
+	{ 16, 75, 115, 14, 34, 135,  47, 157,  16,  -26,  -86, 112,  112, -102, -10 },
+	{  0, 64, 101, 12, 30, 119,  54, 183,  19,  -29,  -99, 128,  128, -116, -12 },
+};
+
+#define NUM_CONVERT_COEFS (sizeof(convert_coefs) / sizeof(convert_coefs[0]))
+
+/* row kernels. argb rows are in the memory order of TBM_FORMAT_ARGB8888,
+ * b, g, r, a. the chroma rows have (width + 1) / 2 samples.
+ */
+typedef struct {
+	void (*yuv_to_argb)(const uint8_t *y, const uint8_t *u, const uint8_t *v,
+			    uint8_t *argb, int width, const tbm_convert_coef *c);
+	void (*argb_to_y)(const uint8_t *argb, uint8_t *y, int width,
+			  const tbm_convert_coef *c);
+	void (*argb_to_uv)(const uint8_t *argb0, const uint8_t *argb1,
+			   uint8_t *u, uint8_t *v, int width, const tbm_convert_coef *c);
+	/* even/odd bytes of src to 2 rows of n bytes and back */
+	void (*split)(const uint8_t *src, uint8_t *even, uint8_t *odd, int n);
+	void (*merge)(const uint8_t *even, const uint8_t *odd, uint8_t *dst, int n);
+} tbm_convert_kernels;
+
+static inline int16_t
+_sat16(int v)
+{
+	return v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : v);
+}
+
+static inline uint8_t
+_clamp8(int v)
+{
+	return v > 255 ? 255 : (v < 0 ? 0 : v);
+}
+
+static inline int
+_avg8(int a, int b)
+{
+	return (a + b + 1) >> 1;
+}
+
+static void
+_convert_yuv_to_argb_c(const uint8_t *y, const uint8_t *u, const uint8_t *v,
+		       uint8_t *argb, int width, const tbm_convert_coef *c)
+{
+	int x;
+
+	for (x = 0; x < width; x++) {
+		int yy = (y[x] - c->y_off) * c->y_mul + 32;
+		int uu = u[x >> 1] - 128;
+		int vv = v[x >> 1] - 128;
+
+		argb[0] = _clamp8(_sat16(yy + c->b_u * uu) >> 6);
+		argb[1] = _clamp8(_sat16(_sat16(yy - c->g_u * uu) - c->g_v * vv) >> 6);
+		argb[2] = _clamp8(_sat16(yy + c->r_v * vv) >> 6);
+		argb[3] = 0xff;
+		argb += 4;
+	}
+}
+
+static void
+_convert_argb_to_y_c(const uint8_t *argb, uint8_t *y, int width,
+		     const tbm_convert_coef *c)
+{
+	int x;
+
+	for (x = 0; x < width; x++) {
+		int sum = c->y_b * argb[0] + c->y_g * argb[1] + c->y_r * argb[2] + 128;
+
+		y[x] = _clamp8((sum >> 8) + c->y_off);
+		argb += 4;
+	}
+}
+
+static void
+_convert_argb_to_uv_c(const uint8_t *argb0, const uint8_t *argb1,
+		      uint8_t *u, uint8_t *v, int width, const tbm_convert_coef *c)
+{
+	int x;
+
+	for (x = 0; x < width; x += 2) {
+		/* the last column of an odd width is paired with itself */
+		int next = (x + 1 < width) ? 4 : 0;
+		int b = _avg8(_avg8(argb0[0], argb1[0]), _avg8(argb0[next + 0], argb1[next + 0]));
+		int g = _avg8(_avg8(argb0[1], argb1[1]), _avg8(argb0[next + 1], argb1[next + 1]));
+		int r = _avg8(_avg8(argb0[2], argb1[2]), _avg8(argb0[next + 2], argb1[next + 2]));
+
+		u[x >> 1] = _clamp8(((c->u_b * b + c->u_g * g + c->u_r * r + 128) >> 8) + 128);
+		v[x >> 1] = _clamp8(((c->v_b * b + c->v_g * g + c->v_r * r + 128) >> 8) + 128);
+		argb0 += 8;
+		argb1 += 8;
+	}
+}
+
+static void
+_convert_split_c(const uint8_t *src, uint8_t *even, uint8_t *odd, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		even[i] = src[2 * i];
+		odd[i] = src[2 * i + 1];
+	}
+}
+
+static void
+_convert_merge_c(const uint8_t *even, const uint8_t *odd, uint8_t *dst, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		dst[2 * i] = even[i];
+		dst[2 * i + 1] = odd[i];
+	}
+}
+
+static const tbm_convert_kernels convert_kernels_c = {
+	_convert_yuv_to_argb_c,
+	_convert_argb_to_y_c,
+	_convert_argb_to_uv_c,
+	_convert_split_c,
+	_convert_merge_c,
+};
+
+#ifdef TBM_SIMD_SSE2
+/* 8 pixels of 16-bit y, u, v to argb */
+static inline void
+_convert_yuv_to_argb_8_sse2(__m128i y, __m128i u, __m128i v, uint8_t *argb,
+			    const tbm_convert_coef *c)
+{
+	__m128i yy, uu, vv, r, g, b, bg, ra;
+
+	yy = _mm_add_epi16(_mm_mullo_epi16(_mm_sub_epi16(y, _mm_set1_epi16(c->y_off)),
+					   _mm_set1_epi16(c->y_mul)), _mm_set1_epi16(32));
+	uu = _mm_sub_epi16(u, _mm_set1_epi16(128));
+	vv = _mm_sub_epi16(v, _mm_set1_epi16(128));
+
+	b = _mm_srai_epi16(_mm_adds_epi16(yy, _mm_mullo_epi16(uu, _mm_set1_epi16(c->b_u))), 6);
+	g = _mm_subs_epi16(yy, _mm_mullo_epi16(uu, _mm_set1_epi16(c->g_u)));
+	g = _mm_srai_epi16(_mm_subs_epi16(g, _mm_mullo_epi16(vv, _mm_set1_epi16(c->g_v))), 6);
+	r = _mm_srai_epi16(_mm_adds_epi16(yy, _mm_mullo_epi16(vv, _mm_set1_epi16(c->r_v))), 6);
+
+	b = _mm_packus_epi16(b, b);
+	g = _mm_packus_epi16(g, g);
+	r = _mm_packus_epi16(r, r);
+
+	bg = _mm_unpacklo_epi8(b, g);
+	ra = _mm_unpacklo_epi8(r, _mm_set1_epi8((char)0xff));
+
+	_mm_storeu_si128((__m128i *)argb, _mm_unpacklo_epi16(bg, ra));
+	_mm_storeu_si128((__m128i *)(argb + 16), _mm_unpackhi_epi16(bg, ra));
+}
+
+static void
+_convert_yuv_to_argb_sse2(const uint8_t *y, const uint8_t *u, const uint8_t *v,
+			  uint8_t *argb, int width, const tbm_convert_coef *c)
+{
+	const __m128i zero = _mm_setzero_si128();
+	int x;
+
+	for (x = 0; x + 16 <= width; x += 16) {
+		__m128i yv = _mm_loadu_si128((const __m128i *)(y + x));
+		__m128i uv = _mm_loadl_epi64((const __m128i *)(u + x / 2));
+		__m128i vv = _mm_loadl_epi64((const __m128i *)(v + x / 2));
+
+		/* each chroma sample covers 2 pixels */
+		uv = _mm_unpacklo_epi8(uv, uv);
+		vv = _mm_unpacklo_epi8(vv, vv);
+
+		_convert_yuv_to_argb_8_sse2(_mm_unpacklo_epi8(yv, zero),
+					    _mm_unpacklo_epi8(uv, zero),
+					    _mm_unpacklo_epi8(vv, zero),
+					    argb + x * 4, c);
+		_convert_yuv_to_argb_8_sse2(_mm_unpackhi_epi8(yv, zero),
+					    _mm_unpackhi_epi8(uv, zero),
+					    _mm_unpackhi_epi8(vv, zero),
+					    argb + (x + 8) * 4, c);
+	}
+
+	if (x < width)
+		_convert_yuv_to_argb_c(y + x, u + x / 2, v + x / 2, argb + x * 4, width - x, c);
+}
+
+/* weighted sum of 4 argb pixels in 32-bit lanes, rounded and shifted */
+static inline __m128i
+_convert_dot_4_sse2(__m128i argb, int16_t cb, int16_t cg, int16_t cr)
+{
+	/* (b, r) and (g, 1) pairs for pmaddwd */
+	__m128i br = _mm_and_si128(argb, _mm_set1_epi32(0x00ff00ff));
+	__m128i g1 = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(argb, 8), _mm_set1_epi32(0xff)),
+				  _mm_set1_epi32(0x10000));
+	__m128i sum;
+
+	sum = _mm_add_epi32(_mm_madd_epi16(br, _mm_setr_epi16(cb, cr, cb, cr, cb, cr, cb, cr)),
+			    _mm_madd_epi16(g1, _mm_setr_epi16(cg, 128, cg, 128, cg, 128, cg, 128)));
+
+	return _mm_srai_epi32(sum, 8);
+}
+
+static void
+_convert_argb_to_y_sse2(const uint8_t *argb, uint8_t *y, int width,
+			const tbm_convert_coef *c)
+{
+	const __m128i off = _mm_set1_epi16(c->y_off);
+	int x;
+
+	for (x = 0; x + 16 <= width; x += 16) {
+		const uint8_t *p = argb + x * 4;
+		__m128i y0, y1, y2, y3;
+
+		y0 = _convert_dot_4_sse2(_mm_loadu_si128((const __m128i *)p), c->y_b, c->y_g, c->y_r);
+		y1 = _convert_dot_4_sse2(_mm_loadu_si128((const __m128i *)(p + 16)), c->y_b, c->y_g, c->y_r);
+		y2 = _convert_dot_4_sse2(_mm_loadu_si128((const __m128i *)(p + 32)), c->y_b, c->y_g, c->y_r);
+		y3 = _convert_dot_4_sse2(_mm_loadu_si128((const __m128i *)(p + 48)), c->y_b, c->y_g, c->y_r);
+
+		y0 = _mm_add_epi16(_mm_packs_epi32(y0, y1), off);
+		y2 = _mm_add_epi16(_mm_packs_epi32(y2, y3), off);
+
+		_mm_storeu_si128((__m128i *)(y + x), _mm_packus_epi16(y0, y2));
+	}
+
+	if (x < width)
+		_convert_argb_to_y_c(argb + x * 4, y + x, width - x, c);
+}
+
+/* the averaged color of 4 2x2 blocks from 8 pixels of 2 rows */
+static inline __m128i
+_convert_avg_2x2_sse2(const uint8_t *argb0, const uint8_t *argb1)
+{
+	__m128i a = _mm_avg_epu8(_mm_loadu_si128((const __m128i *)argb0),
+				 _mm_loadu_si128((const __m128i *)argb1));
+	__m128i b = _mm_avg_epu8(_mm_loadu_si128((const __m128i *)(argb0 + 16)),
+				 _mm_loadu_si128((const __m128i *)(argb1 + 16)));
+	__m128i even = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b),
+						       _MM_SHUFFLE(2, 0, 2, 0)));
+	__m128i odd = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(a), _mm_castsi128_ps(b),
+						      _MM_SHUFFLE(3, 1, 3, 1)));
+
+	return _mm_avg_epu8(even, odd);
+}
+
+static void
+_convert_argb_to_uv_sse2(const uint8_t *argb0, const uint8_t *argb1,
+			 uint8_t *u, uint8_t *v, int width, const tbm_convert_coef *c)
+{
+	const __m128i off = _mm_set1_epi16(128);
+	int x;
+
+	for (x = 0; x + 16 <= width; x += 16) {
+		__m128i m0 = _convert_avg_2x2_sse2(argb0 + x * 4, argb1 + x * 4);
+		__m128i m1 = _convert_avg_2x2_sse2(argb0 + x * 4 + 32, argb1 + x * 4 + 32);
+		__m128i uu, vv;
+
+		uu = _mm_packs_epi32(_convert_dot_4_sse2(m0, c->u_b, c->u_g, c->u_r),
+				     _convert_dot_4_sse2(m1, c->u_b, c->u_g, c->u_r));
+		vv = _mm_packs_epi32(_convert_dot_4_sse2(m0, c->v_b, c->v_g, c->v_r),
+				     _convert_dot_4_sse2(m1, c->v_b, c->v_g, c->v_r));
+		uu = _mm_add_epi16(uu, off);
+		vv = _mm_add_epi16(vv, off);
+
+		_mm_storel_epi64((__m128i *)(u + x / 2), _mm_packus_epi16(uu, uu));
+		_mm_storel_epi64((__m128i *)(v + x / 2), _mm_packus_epi16(vv, vv));
+	}
+
+	if (x < width)
+		_convert_argb_to_uv_c(argb0 + x * 4, argb1 + x * 4, u + x / 2, v + x / 2, width - x, c);
+}
+
+static void
+_convert_split_sse2(const uint8_t *src, uint8_t *even, uint8_t *odd, int n)
+{
+	const __m128i mask = _mm_set1_epi16(0xff);
+	int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(src + 2 * i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(src + 2 * i + 16));
+
+		_mm_storeu_si128((__m128i *)(even + i),
+				 _mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask)));
+		_mm_storeu_si128((__m128i *)(odd + i),
+				 _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+	}
+
+	if (i < n)
+		_convert_split_c(src + 2 * i, even + i, odd + i, n - i);
+}
+
+static void
+_convert_merge_sse2(const uint8_t *even, const uint8_t *odd, uint8_t *dst, int n)
+{
+	int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(even + i));
+		__m128i b = _mm_loadu_si128((const __m128i *)(odd + i));
+
+		_mm_storeu_si128((__m128i *)(dst + 2 * i), _mm_unpacklo_epi8(a, b));
+		_mm_storeu_si128((__m128i *)(dst + 2 * i + 16), _mm_unpackhi_epi8(a, b));
+	}
+
+	if (i < n)
+		_convert_merge_c(even + i, odd + i, dst + 2 * i, n - i);
+}
+
+static const tbm_convert_kernels convert_kernels_sse2 = {
+	_convert_yuv_to_argb_sse2,
+	_convert_argb_to_y_sse2,
+	_convert_argb_to_uv_sse2,
+	_convert_split_sse2,
+	_convert_merge_sse2,
+};
+#endif
+
+#ifdef TBM_SIMD_AVX2
+/* 16 pixels, y, u and v given as 16 bytes each */
+static inline TBM_TARGET_AVX2 void
+_convert_yuv_to_argb_16_avx2(__m128i y8, __m128i u8, __m128i v8, uint8_t *argb,
+			     const tbm_convert_coef *c)
+{
+	__m256i y = _mm256_cvtepu8_epi16(y8);
+	__m256i u = _mm256_cvtepu8_epi16(u8);
+	__m256i v = _mm256_cvtepu8_epi16(v8);
+	__m256i yy, uu, vv, r, g, b, br, ga;
+	__m128i b8, g8, r8, a8, bg, ra;
+
+	yy = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_sub_epi16(y, _mm256_set1_epi16(c->y_off)),
+						 _mm256_set1_epi16(c->y_mul)), _mm256_set1_epi16(32));
+	uu = _mm256_sub_epi16(u, _mm256_set1_epi16(128));
+	vv = _mm256_sub_epi16(v, _mm256_set1_epi16(128));
+
+	b = _mm256_srai_epi16(_mm256_adds_epi16(yy, _mm256_mullo_epi16(uu, _mm256_set1_epi16(c->b_u))), 6);
+	g = _mm256_subs_epi16(yy, _mm256_mullo_epi16(uu, _mm256_set1_epi16(c->g_u)));
+	g = _mm256_srai_epi16(_mm256_subs_epi16(g, _mm256_mullo_epi16(vv, _mm256_set1_epi16(c->g_v))), 6);
+	r = _mm256_srai_epi16(_mm256_adds_epi16(yy, _mm256_mullo_epi16(vv, _mm256_set1_epi16(c->r_v))), 6);
+
+	/* packus works within 128-bit lanes, reorder to b | r and g | a */
+	br = _mm256_permute4x64_epi64(_mm256_packus_epi16(b, r), 0xd8);
+	ga = _mm256_permute4x64_epi64(_mm256_packus_epi16(g, _mm256_set1_epi16(0xff)), 0xd8);
+
+	b8 = _mm256_castsi256_si128(br);
+	r8 = _mm256_extracti128_si256(br, 1);
+	g8 = _mm256_castsi256_si128(ga);
+	a8 = _mm256_extracti128_si256(ga, 1);
+
+	bg = _mm_unpacklo_epi8(b8, g8);
+	ra = _mm_unpacklo_epi8(r8, a8);
+	_mm_storeu_si128((__m128i *)argb, _mm_unpacklo_epi16(bg, ra));
+	_mm_storeu_si128((__m128i *)(argb + 16), _mm_unpackhi_epi16(bg, ra));
+
+	bg = _mm_unpackhi_epi8(b8, g8);
+	ra = _mm_unpackhi_epi8(r8, a8);
+	_mm_storeu_si128((__m128i *)(argb + 32), _mm_unpacklo_epi16(bg, ra));
+	_mm_storeu_si128((__m128i *)(argb + 48), _mm_unpackhi_epi16(bg, ra));
+}
+
+static TBM_TARGET_AVX2 void
+_convert_yuv_to_argb_avx2(const uint8_t *y, const uint8_t *u, const uint8_t *v,
+			  uint8_t *argb, int width, const tbm_convert_coef *c)
+{
+	int x;
+
+	for (x = 0; x + 32 <= width; x += 32) {
+		__m128i uv = _mm_loadu_si128((const __m128i *)(u + x / 2));
+		__m128i vv = _mm_loadu_si128((const __m128i *)(v + x / 2));
+
+		_convert_yuv_to_argb_16_avx2(_mm_loadu_si128((const __m128i *)(y + x)),
+					     _mm_unpacklo_epi8(uv, uv), _mm_unpacklo_epi8(vv, vv),
+					     argb + x * 4, c);
+		_convert_yuv_to_argb_16_avx2(_mm_loadu_si128((const __m128i *)(y + x + 16)),
+					     _mm_unpackhi_epi8(uv, uv), _mm_unpackhi_epi8(vv, vv),
+					     argb + (x + 16) * 4, c);
+	}
+
+	if (x < width)
+		_convert_yuv_to_argb_sse2(y + x, u + x / 2, v + x / 2, argb + x * 4, width - x, c);
+}
+
+static inline TBM_TARGET_AVX2 __m256i
+_convert_dot_8_avx2(__m256i argb, int16_t cb, int16_t cg, int16_t cr)
+{
+	__m256i br = _mm256_and_si256(argb, _mm256_set1_epi32(0x00ff00ff));
+	__m256i g1 = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(argb, 8), _mm256_set1_epi32(0xff)),
+				     _mm256_set1_epi32(0x10000));
+	__m256i sum;
+
+	sum = _mm256_add_epi32(_mm256_madd_epi16(br, _mm256_set1_epi32(((uint32_t)(uint16_t)cr << 16) | (uint16_t)cb)),
+			       _mm256_madd_epi16(g1, _mm256_set1_epi32((128 << 16) | (uint16_t)cg)));
+
+	return _mm256_srai_epi32(sum, 8);
+}
+
+static TBM_TARGET_AVX2 void
+_convert_argb_to_y_avx2(const uint8_t *argb, uint8_t *y, int width,
+			const tbm_convert_coef *c)
+{
+	const __m256i off = _mm256_set1_epi16(c->y_off);
+	int x;
+
+	for (x = 0; x + 32 <= width; x += 32) {
+		const uint8_t *p = argb + x * 4;
+		__m256i y0, y1, y2, y3;
+
+		y0 = _convert_dot_8_avx2(_mm256_loadu_si256((const __m256i *)p), c->y_b, c->y_g, c->y_r);
+		y1 = _convert_dot_8_avx2(_mm256_loadu_si256((const __m256i *)(p + 32)), c->y_b, c->y_g, c->y_r);
+		y2 = _convert_dot_8_avx2(_mm256_loadu_si256((const __m256i *)(p + 64)), c->y_b, c->y_g, c->y_r);
+		y3 = _convert_dot_8_avx2(_mm256_loadu_si256((const __m256i *)(p + 96)), c->y_b, c->y_g, c->y_r);
+
+		/* packs/packus interleave the 128-bit lanes, 0xd8 puts them back in order */
+		y0 = _mm256_permute4x64_epi64(_mm256_packs_epi32(y0, y1), 0xd8);
+		y2 = _mm256_permute4x64_epi64(_mm256_packs_epi32(y2, y3), 0xd8);
+		y0 = _mm256_packus_epi16(_mm256_add_epi16(y0, off), _mm256_add_epi16(y2, off));
+
+		_mm256_storeu_si256((__m256i *)(y + x), _mm256_permute4x64_epi64(y0, 0xd8));
+	}
+
+	if (x < width)
+		_convert_argb_to_y_sse2(argb + x * 4, y + x, width - x, c);
+}
+
+/* the averaged color of 8 2x2 blocks from 16 pixels of 2 rows, in order */
+static inline TBM_TARGET_AVX2 __m256i
+_convert_avg_2x2_avx2(const uint8_t *argb0, const uint8_t *argb1)
+{
+	__m256i a = _mm256_avg_epu8(_mm256_loadu_si256((const __m256i *)argb0),
+				    _mm256_loadu_si256((const __m256i *)argb1));
+	__m256i b = _mm256_avg_epu8(_mm256_loadu_si256((const __m256i *)(argb0 + 32)),
+				    _mm256_loadu_si256((const __m256i *)(argb1 + 32)));
+	__m256i even = _mm256_castps_si256(_mm256_shuffle_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b),
+							     _MM_SHUFFLE(2, 0, 2, 0)));
+	__m256i odd = _mm256_castps_si256(_mm256_shuffle_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b),
+							    _MM_SHUFFLE(3, 1, 3, 1)));
+
+	/* blocks come out as 0 1 4 5 | 2 3 6 7 */
+	return _mm256_permute4x64_epi64(_mm256_avg_epu8(even, odd), 0xd8);
+}
+
+static TBM_TARGET_AVX2 void
+_convert_argb_to_uv_avx2(const uint8_t *argb0, const uint8_t *argb1,
+			 uint8_t *u, uint8_t *v, int width, const tbm_convert_coef *c)
+{
+	const __m256i off = _mm256_set1_epi16(128);
+	int x;
+
+	for (x = 0; x + 32 <= width; x += 32) {
+		__m256i m0 = _convert_avg_2x2_avx2(argb0 + x * 4, argb1 + x * 4);
+		__m256i m1 = _convert_avg_2x2_avx2(argb0 + x * 4 + 64, argb1 + x * 4 + 64);
+		__m256i uu, vv;
+
+		uu = _mm256_packs_epi32(_convert_dot_8_avx2(m0, c->u_b, c->u_g, c->u_r),
+					_convert_dot_8_avx2(m1, c->u_b, c->u_g, c->u_r));
+		vv = _mm256_packs_epi32(_convert_dot_8_avx2(m0, c->v_b, c->v_g, c->v_r),
+					_convert_dot_8_avx2(m1, c->v_b, c->v_g, c->v_r));
+		uu = _mm256_permute4x64_epi64(_mm256_add_epi16(uu, off), 0xd8);
+		vv = _mm256_permute4x64_epi64(_mm256_add_epi16(vv, off), 0xd8);
+
+		/* packus(a, b) keeps a in the low 8 bytes of both lanes */
+		uu = _mm256_permute4x64_epi64(_mm256_packus_epi16(uu, uu), 0xd8);
+		vv = _mm256_permute4x64_epi64(_mm256_packus_epi16(vv, vv), 0xd8);
+
+		_mm_storeu_si128((__m128i *)(u + x / 2), _mm256_castsi256_si128(uu));
+		_mm_storeu_si128((__m128i *)(v + x / 2), _mm256_castsi256_si128(vv));
+	}
+
+	if (x < width)
+		_convert_argb_to_uv_sse2(argb0 + x * 4, argb1 + x * 4, u + x / 2, v + x / 2, width - x, c);
+}
+
+static const tbm_convert_kernels convert_kernels_avx2 = {
+	_convert_yuv_to_argb_avx2,
+	_convert_argb_to_y_avx2,
+	_convert_argb_to_uv_avx2,
+	_convert_split_sse2,
+	_convert_merge_sse2,
+};
+#endif
+
+#ifdef TBM_SIMD_NEON
+static inline void
+_convert_yuv_to_argb_8_neon(uint8x8_t y8, uint8x8_t u8, uint8x8_t v8, uint8_t *argb,
+			    const tbm_convert_coef *c)
+{
+	int16x8_t y = vreinterpretq_s16_u16(vmovl_u8(y8));
+	int16x8_t u = vreinterpretq_s16_u16(vmovl_u8(u8));
+	int16x8_t v = vreinterpretq_s16_u16(vmovl_u8(v8));
+	int16x8_t yy, uu, vv, g;
+	uint8x8x4_t out;
+
+	yy = vaddq_s16(vmulq_n_s16(vsubq_s16(y, vdupq_n_s16(c->y_off)), c->y_mul), vdupq_n_s16(32));
+	uu = vsubq_s16(u, vdupq_n_s16(128));
+	vv = vsubq_s16(v, vdupq_n_s16(128));
+
+	g = vqsubq_s16(vqsubq_s16(yy, vmulq_n_s16(uu, c->g_u)), vmulq_n_s16(vv, c->g_v));
+
+	out.val[0] = vqmovun_s16(vshrq_n_s16(vqaddq_s16(yy, vmulq_n_s16(uu, c->b_u)), 6));
+	out.val[1] = vqmovun_s16(vshrq_n_s16(g, 6));
+	out.val[2] = vqmovun_s16(vshrq_n_s16(vqaddq_s16(yy, vmulq_n_s16(vv, c->r_v)), 6));
+	out.val[3] = vdup_n_u8(0xff);
+
+	vst4_u8(argb, out);
+}
+
+static void
+_convert_yuv_to_argb_neon(const uint8_t *y, const uint8_t *u, const uint8_t *v,
+			  uint8_t *argb, int width, const tbm_convert_coef *c)
+{
+	int x;
+
+	for (x = 0; x + 16 <= width; x += 16) {
+		uint8x16_t yv = vld1q_u8(y + x);
+		uint8x8x2_t uv = vzip_u8(vld1_u8(u + x / 2), vld1_u8(u + x / 2));
+		uint8x8x2_t vv = vzip_u8(vld1_u8(v + x / 2), vld1_u8(v + x / 2));
+
+		_convert_yuv_to_argb_8_neon(vget_low_u8(yv), uv.val[0], vv.val[0], argb + x * 4, c);
+		_convert_yuv_to_argb_8_neon(vget_high_u8(yv), uv.val[1], vv.val[1], argb + (x + 8) * 4, c);
+	}
+
+	if (x < width)
+		_convert_yuv_to_argb_c(y + x, u + x / 2, v + x / 2, argb + x * 4, width - x, c);
+}
+
+static void
+_convert_argb_to_y_neon(const uint8_t *argb, uint8_t *y, int width,
+			const tbm_convert_coef *c)
+{
+	int x;
+
+	/* the y weights are positive and sum up to at most 256 */
+	for (x = 0; x + 8 <= width; x += 8) {
+		uint8x8x4_t p = vld4_u8(argb + x * 4);
+		uint16x8_t sum;
+
+		sum = vmull_u8(p.val[0], vdup_n_u8(c->y_b));
+		sum = vmlal_u8(sum, p.val[1], vdup_n_u8(c->y_g));
+		sum = vmlal_u8(sum, p.val[2], vdup_n_u8(c->y_r));
+		sum = vshrq_n_u16(vaddq_u16(sum, vdupq_n_u16(128)), 8);
+
+		vst1_u8(y + x, vqmovn_u16(vaddq_u16(sum, vdupq_n_u16(c->y_off))));
+	}
+
+	if (x < width)
+		_convert_argb_to_y_c(argb + x * 4, y + x, width - x, c);
+}
+
+static inline int16x8_t
+_convert_dot_8_neon(int16x8_t b, int16x8_t g, int16x8_t r, int16_t cb, int16_t cg, int16_t cr)
+{
+	int32x4_t lo, hi;
+
+	lo = vmull_n_s16(vget_low_s16(b), cb);
+	lo = vmlal_n_s16(lo, vget_low_s16(g), cg);
+	lo = vmlal_n_s16(lo, vget_low_s16(r), cr);
+	hi = vmull_n_s16(vget_high_s16(b), cb);
+	hi = vmlal_n_s16(hi, vget_high_s16(g), cg);
+	hi = vmlal_n_s16(hi, vget_high_s16(r), cr);
+
+	lo = vshrq_n_s32(vaddq_s32(lo, vdupq_n_s32(128)), 8);
+	hi = vshrq_n_s32(vaddq_s32(hi, vdupq_n_s32(128)), 8);
+
+	return vaddq_s16(vcombine_s16(vmovn_s32(lo), vmovn_s32(hi)), vdupq_n_s16(128));
+}
+
+static void
+_convert_argb_to_uv_neon(const uint8_t *argb0, const uint8_t *argb1,
+			 uint8_t *u, uint8_t *v, int width, const tbm_convert_coef *c)
+{
+	int x;
+
+	for (x = 0; x + 16 <= width; x += 16) {
+		uint8x16x4_t p0 = vld4q_u8(argb0 + x * 4);
+		uint8x16x4_t p1 = vld4q_u8(argb1 + x * 4);
+		int16x8_t ch[3];
+		int i;
+
+		for (i = 0; i < 3; i++) {
+			uint8x16_t m = vrhaddq_u8(p0.val[i], p1.val[i]);
+			uint8x8x2_t eo = vuzp_u8(vget_low_u8(m), vget_high_u8(m));
+
+			ch[i] = vreinterpretq_s16_u16(vmovl_u8(vrhadd_u8(eo.val[0], eo.val[1])));
+		}
+
+		vst1_u8(u + x / 2, vqmovun_s16(_convert_dot_8_neon(ch[0], ch[1], ch[2], c->u_b, c->u_g, c->u_r)));
+		vst1_u8(v + x / 2, vqmovun_s16(_convert_dot_8_neon(ch[0], ch[1], ch[2], c->v_b, c->v_g, c->v_r)));
+	}
+
+	if (x < width)
+		_convert_argb_to_uv_c(argb0 + x * 4, argb1 + x * 4, u + x / 2, v + x / 2, width - x, c);
+}
+
+static void
+_convert_split_neon(const uint8_t *src, uint8_t *even, uint8_t *odd, int n)
+{
+	int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		uint8x16x2_t p = vld2q_u8(src + 2 * i);
+
+		vst1q_u8(even + i, p.val[0]);
+		vst1q_u8(odd + i, p.val[1]);
+	}
+
+	if (i < n)
+		_convert_split_c(src + 2 * i, even + i, odd + i, n - i);
+}
+
+static void
+_convert_merge_neon(const uint8_t *even, const uint8_t *odd, uint8_t *dst, int n)
+{
+	int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		uint8x16x2_t p;
+
+		p.val[0] = vld1q_u8(even + i);
+		p.val[1] = vld1q_u8(odd + i);
+		vst2q_u8(dst + 2 * i, p);
+	}
+
+	if (i < n)
+		_convert_merge_c(even + i, odd + i, dst + 2 * i, n - i);
+}
+
+static const tbm_convert_kernels convert_kernels_neon = {
+	_convert_yuv_to_argb_neon,
+	_convert_argb_to_y_neon,
+	_convert_argb_to_uv_neon,
+	_convert_split_neon,
+	_convert_merge_neon,
+};
+#endif
+
+static const tbm_convert_kernels *
+_tbm_convert_get_kernels(void)
+{
+	unsigned int features = _tbm_cpu_get_features();
+
+#ifdef TBM_SIMD_AVX2
+	if (features & TBM_CPU_AVX2)
+		return &convert_kernels_avx2;
+#endif
+#ifdef TBM_SIMD_SSE2
+	if (features & TBM_CPU_SSE2)
+		return &convert_kernels_sse2;
+#endif
+#ifdef TBM_SIMD_NEON
+	if (features & TBM_CPU_NEON)
+		return &convert_kernels_neon;
+#endif
+
+	return &convert_kernels_c;
+}
+
+#define CONVERT_LAYOUT_RGB		0	/* b, g, r, a */
+#define CONVERT_LAYOUT_PLANAR	1	/* Y, U, V planes, 2x2 subsampled */
+#define CONVERT_LAYOUT_SEMIPLANAR	2	/* Y plane, UV plane, 2x2 subsampled */
+#define CONVERT_LAYOUT_PACKED	3	/* Y, U, Y, V, 2x1 subsampled */
+
+typedef struct {
+	tbm_format format;
+	int layout;
+	int swap_uv;	/* V comes before U */
+	int y_first;	/* packed only, Y is at the even bytes */
+} tbm_convert_format;
+
+static const tbm_convert_format convert_formats[] = {
+	{ TBM_FORMAT_ARGB8888, CONVERT_LAYOUT_RGB, 0, 0 },
+	{ TBM_FORMAT_XRGB8888, CONVERT_LAYOUT_RGB, 0, 0 },
+	{ TBM_FORMAT_YUV420, CONVERT_LAYOUT_PLANAR, 0, 0 },
+	{ TBM_FORMAT_YVU420, CONVERT_LAYOUT_PLANAR, 1, 0 },
+	{ TBM_FORMAT_NV12, CONVERT_LAYOUT_SEMIPLANAR, 0, 0 },
+	{ TBM_FORMAT_NV21, CONVERT_LAYOUT_SEMIPLANAR, 1, 0 },
+	{ TBM_FORMAT_YUYV, CONVERT_LAYOUT_PACKED, 0, 1 },
+	{ TBM_FORMAT_UYVY, CONVERT_LAYOUT_PACKED, 0, 0 },
+};
+
+#define NUM_CONVERT_FORMATS (sizeof(convert_formats) / sizeof(convert_formats[0]))
+
+static const tbm_convert_format *
+_tbm_convert_get_format(tbm_format format)
+{
+	unsigned int i;
+
+	for (i = 0; i < NUM_CONVERT_FORMATS; i++) {
+		if (convert_formats[i].format == format)
+			return &convert_formats[i];
+	}
+
+	return NULL;
+}
+
+static int
+_tbm_convert_yuv_to_argb(const tbm_convert_kernels *k, const tbm_convert_coef *c,
+			 const tbm_convert_format *fmt, tbm_surface_info_s *src,
+			 tbm_surface_info_s *dst, const tbm_surface_rect_s *r)
+{
+	int width = r->width, x = r->x;
+	int cwidth = (width + 1) / 2;
+	const uint8_t *y, *u, *v;
+	uint8_t *buf, *ubuf, *vbuf, *even, *odd;
+	int row;
+
+	/* a row of U, V and 2 rows of even/odd bytes of a packed line */
+	buf = calloc(3, cwidth * 2);
+	if (!buf) {
+		TBM_LOG_E("fail to alloc the row buffer\n");
+		return 0;
+	}
+
+	ubuf = buf;
+	vbuf = ubuf + cwidth;
+	even = vbuf + cwidth;
+	odd = even + cwidth * 2;
+
+	for (row = r->y; row < r->y + r->height; row++) {
+		const uint8_t *line = src->planes[0].ptr + row * src->planes[0].stride;
+
+		switch (fmt->layout) {
+		case CONVERT_LAYOUT_PLANAR:
+			y = line + x;
+			u = src->planes[1].ptr + (row >> 1) * src->planes[1].stride + x / 2;
+			v = src->planes[2].ptr + (row >> 1) * src->planes[2].stride + x / 2;
+			break;
+		case CONVERT_LAYOUT_SEMIPLANAR:
+			y = line + x;
+			if (!(row & 1))
+				k->split(src->planes[1].ptr + (row >> 1) * src->planes[1].stride + x,
+					 ubuf, vbuf, cwidth);
+			u = ubuf;
+			v = vbuf;
+			break;
+		default:
+			k->split(line + x * 2, even, odd, cwidth * 2);
+			if (fmt->y_first) {
+				y = even;
+				k->split(odd, ubuf, vbuf, cwidth);
+			} else {
+				y = odd;
+				k->split(even, ubuf, vbuf, cwidth);
+			}
+			u = ubuf;
+			v = vbuf;
+			break;
+		}
+
+		if (fmt->swap_uv) {
+			const uint8_t *tmp = u;
+
+			u = v;
+			v = tmp;
+		}
+
+		k->yuv_to_argb(y, u, v, dst->planes[0].ptr + row * dst->planes[0].stride + x * 4,
+			       width, c);
+	}
+
+	free(buf);
+
+	return 1;
+}
+
+static int
+_tbm_convert_argb_to_yuv(const tbm_convert_kernels *k, const tbm_convert_coef *c,
+			 const tbm_convert_format *fmt, tbm_surface_info_s *src,
+			 tbm_surface_info_s *dst, const tbm_surface_rect_s *r)
+{
+	int width = r->width, x = r->x, end = r->y + r->height;
+	int cwidth = (width + 1) / 2;
+	int step = (fmt->layout == CONVERT_LAYOUT_PACKED) ? 1 : 2;
+	int ycpp = (fmt->layout == CONVERT_LAYOUT_PACKED) ? 2 : 1;
+	uint8_t *buf, *ubuf, *vbuf, *ybuf, *uvbuf, *u, *v;
+	int row;
+
+	buf = calloc(3, cwidth * 2);
+	if (!buf) {
+		TBM_LOG_E("fail to alloc the row buffer\n");
+		return 0;
+	}
+
+	ubuf = buf;
+	vbuf = ubuf + cwidth;
+	ybuf = vbuf + cwidth;
+	uvbuf = ybuf + cwidth * 2;
+
+	for (row = r->y; row < end; row += step) {
+		const uint8_t *s0 = src->planes[0].ptr + row * src->planes[0].stride + x * 4;
+		const uint8_t *s1 = s0;
+		uint8_t *d = dst->planes[0].ptr + row * dst->planes[0].stride + x * ycpp;
+
+		/* the last line of an odd height is paired with itself */
+		if (step == 2 && row + 1 < end)
+			s1 = s0 + src->planes[0].stride;
+
+		if (fmt->layout == CONVERT_LAYOUT_PACKED) {
+			k->argb_to_y(s0, ybuf, width, c);
+			k->argb_to_uv(s0, s0, ubuf, vbuf, width, c);
+			if (width & 1)
+				ybuf[width] = ybuf[width - 1];
+
+			k->merge(ubuf, vbuf, uvbuf, cwidth);
+			if (fmt->y_first)
+				k->merge(ybuf, uvbuf, d, cwidth * 2);
+			else
+				k->merge(uvbuf, ybuf, d, cwidth * 2);
+			continue;
+		}
+
+		k->argb_to_y(s0, d, width, c);
+		if (s1 != s0)
+			k->argb_to_y(s1, d + dst->planes[0].stride, width, c);
+
+		if (fmt->layout == CONVERT_LAYOUT_PLANAR) {
+			u = dst->planes[1].ptr + (row >> 1) * dst->planes[1].stride + x / 2;
+			v = dst->planes[2].ptr + (row >> 1) * dst->planes[2].stride + x / 2;
+			if (fmt->swap_uv)
+				k->argb_to_uv(s0, s1, v, u, width, c);
+			else
+				k->argb_to_uv(s0, s1, u, v, width, c);
+		} else {
+			k->argb_to_uv(s0, s1, ubuf, vbuf, width, c);
+			d = dst->planes[1].ptr + (row >> 1) * dst->planes[1].stride + x;
+			if (fmt->swap_uv)
+				k->merge(vbuf, ubuf, d, cwidth);
+			else
+				k->merge(ubuf, vbuf, d, cwidth);
+		}
+	}
+
+	free(buf);
+
+	return 1;
+}
+
+int
+tbm_surface_internal_convert_with_colorspace(tbm_surface_h src, tbm_surface_h dst,
+					      tbm_surface_colorspace_e colorspace)
+{
+	const tbm_convert_format *src_fmt, *dst_fmt;
+	tbm_surface_info_s src_info, dst_info;
+	const tbm_convert_kernels *k;
+	const tbm_convert_coef *c;
+	tbm_surface_rect_s r;
+	int ret, damaged, x2, y2;
+
+	TBM_RETURN_VAL_IF_FAIL(src, 0);
+	TBM_RETURN_VAL_IF_FAIL(dst, 0);
+	TBM_RETURN_VAL_IF_FAIL(src != dst, 0);
+	TBM_RETURN_VAL_IF_FAIL((unsigned int)colorspace < NUM_CONVERT_COEFS, 0);
+
+	src_fmt = _tbm_convert_get_format(tbm_surface_internal_get_format(src));
+	dst_fmt = _tbm_convert_get_format(tbm_surface_internal_get_format(dst));
+	if (!src_fmt || !dst_fmt ||
+	    (src_fmt->layout == CONVERT_LAYOUT_RGB) == (dst_fmt->layout == CONVERT_LAYOUT_RGB)) {
+		TBM_LOG_E("error: not supported conversion src(%p) dst(%p)\n", src, dst);
+		return 0;
+	}
+
+	if (tbm_surface_internal_get_width(src) != tbm_surface_internal_get_width(dst) ||
+	    tbm_surface_internal_get_height(src) != tbm_surface_internal_get_height(dst)) {
+		TBM_LOG_E("error: size mismatch src(%p) dst(%p)\n", src, dst);
+		return 0;
+	}
+
+	if (!tbm_surface_internal_get_info(src, TBM_SURF_OPTION_READ, &src_info, 1)) {
+		TBM_LOG_E("error: fail to map src(%p)\n", src);
+		return 0;
+	}
+
+	if (!tbm_surface_internal_get_info(dst, TBM_SURF_OPTION_WRITE, &dst_info, 1)) {
+		TBM_LOG_E("error: fail to map dst(%p)\n", dst);
+		tbm_surface_internal_unmap(src);
+		return 0;
+	}
+
+	/* only the bounding box of the damage of src, on chroma boundaries */
+	damaged = _tbm_surface_internal_get_damage_bounds(src, &r);
+	if (damaged) {
+		x2 = (r.x + r.width + 1) & ~1;
+		y2 = (r.y + r.height + 1) & ~1;
+		r.x &= ~1;
+		r.y &= ~1;
+		r.width = ((x2 < (int)src_info.width) ? x2 : (int)src_info.width) - r.x;
+		r.height = ((y2 < (int)src_info.height) ? y2 : (int)src_info.height) - r.y;
+	} else {
+		r.x = r.y = 0;
+		r.width = src_info.width;
+		r.height = src_info.height;
+	}
+
+	k = _tbm_convert_get_kernels();
+	c = &convert_coefs[colorspace];
+
+	if (src_fmt->layout == CONVERT_LAYOUT_RGB)
+		ret = _tbm_convert_argb_to_yuv(k, c, dst_fmt, &src_info, &dst_info, &r);
+	else
+		ret = _tbm_convert_yuv_to_argb(k, c, src_fmt, &src_info, &dst_info, &r);
+
+	tbm_surface_internal_unmap(dst);
+	tbm_surface_internal_unmap(src);
+
+	if (ret && damaged)
+		tbm_surface_internal_add_damage(dst, &r);
+	else if (ret)
+		_tbm_surface_internal_add_written_damage(dst, &r);
+
+	TBM_TRACE("src(%p) dst(%p) colorspace(%d) ret(%d)\n", src, dst, colorspace, ret);
+
+	return ret;
+}
+
+int
+tbm_surface_internal_convert(tbm_surface_h src, tbm_surface_h dst)
+{
+	return tbm_surface_internal_convert_with_colorspace(src, dst,
+							     TBM_SURFACE_COLORSPACE_BT601_LIMITED);
+}
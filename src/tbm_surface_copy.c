@@ -0,0 +1,276 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#include "config.h"
+
+#include <stdint.h>
+#include "tbm_bufmgr_int.h"
+
+#ifdef TBM_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+typedef struct {
+	const uint8_t *src;
+	uint8_t *dst;
+	uint32_t src_stride;
+	uint32_t dst_stride;
+	uint32_t bytes;		/* bytes of a row */
+	uint32_t rows;
+	int stream;			/* use non-temporal stores */
+} tbm_copy_plane;
+
+typedef struct {
+	tbm_copy_plane planes[TBM_SURFACE_DAMAGE_MAX * TBM_SURF_PLANE_MAX];
+	int num_planes;
+	int num_bands;
+	int use_sse2;
+} tbm_copy_job;
+
+#ifdef TBM_SIMD_SSE2
+/* WC and uncached memory is written in full lines without the reads
+ * a normal store would cause
+ */
+static void
+_tbm_copy_stream_sse2(uint8_t *dst, const uint8_t *src, uint32_t size)
+{
+	uint32_t head = (16 - ((uintptr_t)dst & 15)) & 15;
+
+	if (head > size)
+		head = size;
+
+	memcpy(dst, src, head);
+	dst += head;
+	src += head;
+	size -= head;
+
+	for (; size >= 64; size -= 64, src += 64, dst += 64) {
+		__m128i a = _mm_loadu_si128((const __m128i *)src);
+		__m128i b = _mm_loadu_si128((const __m128i *)(src + 16));
+		__m128i c = _mm_loadu_si128((const __m128i *)(src + 32));
+		__m128i d = _mm_loadu_si128((const __m128i *)(src + 48));
+
+		_mm_stream_si128((__m128i *)dst, a);
+		_mm_stream_si128((__m128i *)(dst + 16), b);
+		_mm_stream_si128((__m128i *)(dst + 32), c);
+		_mm_stream_si128((__m128i *)(dst + 48), d);
+	}
+
+	for (; size >= 16; size -= 16, src += 16, dst += 16)
+		_mm_stream_si128((__m128i *)dst, _mm_loadu_si128((const __m128i *)src));
+
+	memcpy(dst, src, size);
+}
+#endif
+
+static void
+_tbm_copy_band(void *data, int idx)
+{
+	tbm_copy_job *job = data;
+	int i, streamed = 0;
+
+	for (i = 0; i < job->num_planes; i++) {
+		tbm_copy_plane *p = &job->planes[i];
+		uint32_t start = (uint64_t)p->rows * idx / job->num_bands;
+		uint32_t end = (uint64_t)p->rows * (idx + 1) / job->num_bands;
+		const uint8_t *src = p->src + start * p->src_stride;
+		uint8_t *dst = p->dst + start * p->dst_stride;
+		uint32_t row, size = p->bytes;
+
+		if (start == end)
+			continue;
+
+		/* the band is contiguous in both surfaces */
+		if (p->bytes == p->src_stride && p->bytes == p->dst_stride) {
+			size = p->bytes * (end - start);
+			end = start + 1;
+		}
+
+#ifdef TBM_SIMD_SSE2
+		if (p->stream && job->use_sse2) {
+			for (row = start; row < end; row++, src += p->src_stride, dst += p->dst_stride)
+				_tbm_copy_stream_sse2(dst, src, size);
+			streamed = 1;
+			continue;
+		}
+#endif
+
+		for (row = start; row < end; row++, src += p->src_stride, dst += p->dst_stride)
+			memcpy(dst, src, size);
+	}
+
+#ifdef TBM_SIMD_SSE2
+	if (streamed)
+		_mm_sfence();
+#endif
+}
+
+/* 1 if the bo of the plane is write-combined or uncached memory */
+int
+_tbm_surface_internal_plane_is_wc(tbm_surface_h surface, int plane_idx)
+{
+	tbm_bo bo;
+
+	bo = tbm_surface_internal_get_bo(surface,
+					 tbm_surface_internal_get_plane_bo_idx(surface, plane_idx));
+	if (!bo)
+		return 0;
+
+	return !!(tbm_bo_get_flags(bo) & (TBM_BO_WC | TBM_BO_NONCACHABLE));
+}
+
+/* grow a damage rect to the chroma subsampling, within the surface */
+static void
+_tbm_copy_align_rect(tbm_surface_rect_s *r, const tbm_format_desc_s *desc, int width, int height)
+{
+	int x2 = r->x + r->width, y2 = r->y + r->height;
+
+	r->x -= r->x % desc->hsub;
+	r->y -= r->y % desc->vsub;
+	x2 = (x2 + desc->hsub - 1) / desc->hsub * desc->hsub;
+	y2 = (y2 + desc->vsub - 1) / desc->vsub * desc->vsub;
+
+	r->width = ((x2 < width) ? x2 : width) - r->x;
+	r->height = ((y2 < height) ? y2 : height) - r->y;
+}
+
+int
+tbm_surface_internal_copy(tbm_surface_h src, tbm_surface_h dst, tbm_surface_rect_s *rect)
+{
+	const tbm_format_desc_s *desc;
+	tbm_surface_info_s src_info, dst_info;
+	tbm_surface_rect_s rects[TBM_SURFACE_DAMAGE_MAX];
+	tbm_copy_job job;
+	uint64_t total = 0;
+	tbm_format format;
+	int i, n, num_rects = 0, damaged = 0;
+	int src_w, src_h;
+
+	TBM_RETURN_VAL_IF_FAIL(src, 0);
+	TBM_RETURN_VAL_IF_FAIL(dst, 0);
+	TBM_RETURN_VAL_IF_FAIL(src != dst, 0);
+
+	format = tbm_surface_internal_get_format(src);
+	desc = tbm_format_get_desc(format);
+	if (!desc || format != tbm_surface_internal_get_format(dst) ||
+	    format == TBM_FORMAT_NV12MT) {
+		TBM_LOG_E("error: not supported format src(%p) dst(%p)\n", src, dst);
+		return 0;
+	}
+
+	src_w = tbm_surface_internal_get_width(src);
+	src_h = tbm_surface_internal_get_height(src);
+
+	if (rect) {
+		rects[0] = *rect;
+		num_rects = 1;
+	} else if (tbm_surface_internal_get_damage(src, rects, &num_rects) && num_rects > 0) {
+		/* only the damaged area of src is copied */
+		for (n = 0; n < num_rects; n++)
+			_tbm_copy_align_rect(&rects[n], desc, src_w, src_h);
+		damaged = 1;
+	} else {
+		rects[0].x = rects[0].y = 0;
+		rects[0].width = src_w;
+		rects[0].height = src_h;
+		num_rects = 1;
+	}
+
+	for (n = 0; n < num_rects; n++) {
+		tbm_surface_rect_s *r = &rects[n];
+
+		if (!_tbm_format_check_rect(desc, r, src_w, src_h) ||
+		    !_tbm_format_check_rect(desc, r, tbm_surface_internal_get_width(dst),
+					    tbm_surface_internal_get_height(dst))) {
+			TBM_LOG_E("error: invalid rect(%d,%d %dx%d) src(%p) dst(%p)\n",
+				  r->x, r->y, r->width, r->height, src, dst);
+			return 0;
+		}
+	}
+
+	if (!tbm_surface_internal_get_info(src, TBM_SURF_OPTION_READ, &src_info, 1)) {
+		TBM_LOG_E("error: fail to map src(%p)\n", src);
+		return 0;
+	}
+
+	if (!tbm_surface_internal_get_info(dst, TBM_SURF_OPTION_WRITE, &dst_info, 1)) {
+		TBM_LOG_E("error: fail to map dst(%p)\n", dst);
+		tbm_surface_internal_unmap(src);
+		return 0;
+	}
+
+	memset(&job, 0, sizeof(job));
+	job.num_planes = num_rects * desc->num_planes;
+	job.use_sse2 = !!(_tbm_cpu_get_features() & TBM_CPU_SSE2);
+
+	for (n = 0; n < num_rects; n++) {
+		tbm_surface_rect_s *r = &rects[n];
+
+		for (i = 0; i < desc->num_planes; i++) {
+			tbm_copy_plane *p = &job.planes[n * desc->num_planes + i];
+			tbm_surface_rect_s pr;
+
+			_tbm_format_plane_rect(desc, i, r, &pr);
+
+			p->src_stride = src_info.planes[i].stride;
+			p->dst_stride = dst_info.planes[i].stride;
+			p->src = src_info.planes[i].ptr + pr.y * p->src_stride + pr.x * desc->cpp[i];
+			p->dst = dst_info.planes[i].ptr + pr.y * p->dst_stride + pr.x * desc->cpp[i];
+			p->bytes = pr.width * desc->cpp[i];
+			p->rows = pr.height;
+			p->stream = _tbm_surface_internal_plane_is_wc(dst, i);
+
+			total += (uint64_t)p->bytes * p->rows;
+		}
+	}
+
+	job.num_bands = _tbm_worker_get_bands(total);
+
+	_tbm_worker_run(_tbm_copy_band, &job, job.num_bands);
+
+	tbm_surface_internal_unmap(dst);
+	tbm_surface_internal_unmap(src);
+
+	/* dst changed only where src did */
+	for (n = 0; n < num_rects; n++) {
+		if (damaged)
+			tbm_surface_internal_add_damage(dst, &rects[n]);
+		else
+			_tbm_surface_internal_add_written_damage(dst, &rects[n]);
+	}
+
+	TBM_TRACE("src(%p) dst(%p) rect(%d,%d %dx%d) num_rects(%d) bands(%d)\n", src, dst,
+		  rects[0].x, rects[0].y, rects[0].width, rects[0].height, num_rects,
+		  job.num_bands);
+
+	return 1;
+}
@@ -0,0 +1,282 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#include "config.h"
+
+#include <stdint.h>
+#include "tbm_bufmgr_int.h"
+
+#ifdef TBM_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef TBM_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+/* NV12MT is NV12 in tiles of 64x32 bytes, each tile stored linearly.
+ * The tiles are ordered in groups of 2x2 tiles walked in a Z, the
+ * groups of 2 tile rows in a Z flipped every other group (the
+ * ZFLIPZ_2X2 tile mode of gstreamer). The width of the planes is
+ * aligned to 2 tiles and the height to 1 tile.
+ */
+#define TBM_TILE_W		64
+#define TBM_TILE_H		32
+#define TBM_TILE_SIZE	(TBM_TILE_W * TBM_TILE_H)
+
+typedef void (*tbm_detile_func)(const uint8_t *tile, uint8_t *dst, uint32_t stride);
+
+typedef struct {
+	const uint8_t *src;
+	uint8_t *dst;
+	uint32_t dst_stride;
+	int width;		/* in bytes */
+	int height;
+	int x_tiles;
+	int y_tiles;
+} tbm_detile_plane;
+
+typedef struct {
+	tbm_detile_plane planes[2];
+	int num_bands;
+	tbm_detile_func tile;
+} tbm_detile_job;
+
+static void
+_tbm_detile_tile_c(const uint8_t *tile, uint8_t *dst, uint32_t stride)
+{
+	int row;
+
+	for (row = 0; row < TBM_TILE_H; row++, tile += TBM_TILE_W, dst += stride)
+		memcpy(dst, tile, TBM_TILE_W);
+}
+
+#ifdef TBM_SIMD_SSE2
+static void
+_tbm_detile_tile_sse2(const uint8_t *tile, uint8_t *dst, uint32_t stride)
+{
+	int row;
+
+	for (row = 0; row < TBM_TILE_H; row++, tile += TBM_TILE_W, dst += stride) {
+		__m128i a = _mm_loadu_si128((const __m128i *)tile);
+		__m128i b = _mm_loadu_si128((const __m128i *)(tile + 16));
+		__m128i c = _mm_loadu_si128((const __m128i *)(tile + 32));
+		__m128i d = _mm_loadu_si128((const __m128i *)(tile + 48));
+
+		_mm_storeu_si128((__m128i *)dst, a);
+		_mm_storeu_si128((__m128i *)(dst + 16), b);
+		_mm_storeu_si128((__m128i *)(dst + 32), c);
+		_mm_storeu_si128((__m128i *)(dst + 48), d);
+	}
+}
+#endif
+
+#ifdef TBM_SIMD_NEON
+static void
+_tbm_detile_tile_neon(const uint8_t *tile, uint8_t *dst, uint32_t stride)
+{
+	int row;
+
+	for (row = 0; row < TBM_TILE_H; row++, tile += TBM_TILE_W, dst += stride) {
+		uint8x16_t a = vld1q_u8(tile);
+		uint8x16_t b = vld1q_u8(tile + 16);
+		uint8x16_t c = vld1q_u8(tile + 32);
+		uint8x16_t d = vld1q_u8(tile + 48);
+
+		vst1q_u8(dst, a);
+		vst1q_u8(dst + 16, b);
+		vst1q_u8(dst + 32, c);
+		vst1q_u8(dst + 48, d);
+	}
+}
+#endif
+
+static tbm_detile_func
+_tbm_detile_get_func(void)
+{
+	unsigned int features = _tbm_cpu_get_features();
+
+#ifdef TBM_SIMD_SSE2
+	if (features & TBM_CPU_SSE2)
+		return _tbm_detile_tile_sse2;
+#endif
+#ifdef TBM_SIMD_NEON
+	if (features & TBM_CPU_NEON)
+		return _tbm_detile_tile_neon;
+#endif
+
+	return _tbm_detile_tile_c;
+}
+
+/* the position of the tile (x, y) in the plane */
+static inline int
+_tbm_detile_get_index(int x, int y, int x_tiles, int y_tiles)
+{
+	int idx = (y & ~1) * x_tiles + x;
+
+	if (y & 1)
+		idx += (x & ~3) + 2;
+	else if ((y_tiles & 1) == 0 || y != y_tiles - 1)
+		idx += (x + 2) & ~3;
+
+	return idx;
+}
+
+static void
+_tbm_detile_band(void *data, int idx)
+{
+	tbm_detile_job *job = data;
+	int i, x, y, row;
+
+	for (i = 0; i < 2; i++) {
+		tbm_detile_plane *p = &job->planes[i];
+		int start = (int64_t)p->y_tiles * idx / job->num_bands;
+		int end = (int64_t)p->y_tiles * (idx + 1) / job->num_bands;
+
+		/* a row of tiles at a time, the src is read in order of the
+		 * groups and the dst is written in 32 rows
+		 */
+		for (y = start; y < end; y++) {
+			int h = p->height - y * TBM_TILE_H;
+
+			if (h > TBM_TILE_H)
+				h = TBM_TILE_H;
+
+			for (x = 0; x < p->x_tiles; x++) {
+				const uint8_t *tile = p->src +
+					(size_t)_tbm_detile_get_index(x, y, p->x_tiles, p->y_tiles) * TBM_TILE_SIZE;
+				uint8_t *dst = p->dst + (size_t)y * TBM_TILE_H * p->dst_stride + x * TBM_TILE_W;
+				int w = p->width - x * TBM_TILE_W;
+
+				if (w <= 0)
+					break;
+
+				if (w >= TBM_TILE_W && h == TBM_TILE_H) {
+					job->tile(tile, dst, p->dst_stride);
+					continue;
+				}
+
+				/* the right and bottom edges */
+				if (w > TBM_TILE_W)
+					w = TBM_TILE_W;
+				for (row = 0; row < h; row++)
+					memcpy(dst + row * p->dst_stride, tile + row * TBM_TILE_W, w);
+			}
+		}
+	}
+}
+
+int
+_tbm_surface_internal_detile_nv12mt(tbm_surface_info_s *info,
+				    unsigned char *dst_y, uint32_t y_stride,
+				    unsigned char *dst_uv, uint32_t uv_stride)
+{
+	tbm_detile_job job;
+	int i;
+
+	TBM_RETURN_VAL_IF_FAIL(info, 0);
+	TBM_RETURN_VAL_IF_FAIL(info->format == TBM_FORMAT_NV12MT, 0);
+	TBM_RETURN_VAL_IF_FAIL(dst_y && dst_uv, 0);
+	TBM_RETURN_VAL_IF_FAIL(y_stride >= info->width && uv_stride >= info->width, 0);
+
+	memset(&job, 0, sizeof(job));
+	job.tile = _tbm_detile_get_func();
+
+	for (i = 0; i < 2; i++) {
+		tbm_detile_plane *p = &job.planes[i];
+
+		p->src = info->planes[i].ptr;
+		p->dst = i ? dst_uv : dst_y;
+		p->dst_stride = i ? uv_stride : y_stride;
+		p->width = info->width;
+		p->height = i ? (info->height + 1) / 2 : info->height;
+		p->x_tiles = (info->width + TBM_TILE_W * 2 - 1) / (TBM_TILE_W * 2) * 2;
+		p->y_tiles = (p->height + TBM_TILE_H - 1) / TBM_TILE_H;
+
+		if (!p->src ||
+		    info->planes[i].size < (uint32_t)(p->x_tiles * p->y_tiles * TBM_TILE_SIZE)) {
+			TBM_LOG_E("error: plane(%d) size(%u) is too small for %dx%d tiles\n",
+				  i, info->planes[i].size, p->x_tiles, p->y_tiles);
+			return 0;
+		}
+	}
+
+	job.num_bands = _tbm_worker_get_bands((uint64_t)info->width * info->height);
+
+	_tbm_worker_run(_tbm_detile_band, &job, job.num_bands);
+
+	return 1;
+}
+
+int
+tbm_surface_internal_detile(tbm_surface_h src, tbm_surface_h dst)
+{
+	tbm_surface_info_s src_info, dst_info;
+	int ret;
+
+	TBM_RETURN_VAL_IF_FAIL(src, 0);
+	TBM_RETURN_VAL_IF_FAIL(dst, 0);
+	TBM_RETURN_VAL_IF_FAIL(src != dst, 0);
+
+	if (tbm_surface_internal_get_format(src) != TBM_FORMAT_NV12MT ||
+	    tbm_surface_internal_get_format(dst) != TBM_FORMAT_NV12) {
+		TBM_LOG_E("error: not supported format src(%p) dst(%p)\n", src, dst);
+		return 0;
+	}
+
+	if (tbm_surface_internal_get_width(src) != tbm_surface_internal_get_width(dst) ||
+	    tbm_surface_internal_get_height(src) != tbm_surface_internal_get_height(dst)) {
+		TBM_LOG_E("error: different size src(%p) dst(%p)\n", src, dst);
+		return 0;
+	}
+
+	if (!tbm_surface_internal_get_info(src, TBM_SURF_OPTION_READ, &src_info, 1)) {
+		TBM_LOG_E("error: fail to map src(%p)\n", src);
+		return 0;
+	}
+
+	if (!tbm_surface_internal_get_info(dst, TBM_SURF_OPTION_WRITE, &dst_info, 1)) {
+		TBM_LOG_E("error: fail to map dst(%p)\n", dst);
+		tbm_surface_internal_unmap(src);
+		return 0;
+	}
+
+	ret = _tbm_surface_internal_detile_nv12mt(&src_info,
+						  dst_info.planes[0].ptr, dst_info.planes[0].stride,
+						  dst_info.planes[1].ptr, dst_info.planes[1].stride);
+
+	tbm_surface_internal_unmap(dst);
+	tbm_surface_internal_unmap(src);
+
+	TBM_TRACE("src(%p) dst(%p) ret(%d)\n", src, dst, ret);
+
+	return ret;
+}
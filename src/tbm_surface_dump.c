@@ -0,0 +1,1537 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#include "config.h"
+
+#include <signal.h>
+#include <time.h>
+#include <sys/mman.h>
+#include "tbm_bufmgr_int.h"
+#include "list.h"
+
+#define C(b, m)              (((b) >> (m)) & 0xFF)
+#define FOURCC_STR(id)      C(id, 0), C(id, 8), C(id, 16), C(id, 24)
+
+/* The asynchronous dump: the producer only copies the surface into a free
+ * staging surface and a writer thread encodes and writes the file, so the
+ * frame rate of a dumped queue holds. The staging surfaces are recycled,
+ * their number bounds the memory, and a frame coming while all of them are
+ * busy is dropped and counted.
+ */
+
+/* The stream of TBM_SURFACE_DUMP_MODE_STREAM, all in the byte order of the
+ * device:
+ *   tbm_dump_stream_header
+ *   the frames, a tbm_dump_stream_frame followed by the planes, every
+ *   plane starts on a page of the writer so it can be mapped by itself
+ *   the index, the offsets of the frames in uint64_t
+ *   tbm_dump_stream_trailer
+ * A stream without the index, ex) the process died, is read by walking the
+ * frames from the first one.
+ */
+#define TBM_DUMP_STREAM_MAGIC	0x444d4254	/* "TBMD" */
+#define TBM_DUMP_FRAME_MAGIC	0x464d4254	/* "TBMF" */
+#define TBM_DUMP_INDEX_MAGIC	0x494d4254	/* "TBMI" */
+#define TBM_DUMP_STREAM_VERSION	1
+#define TBM_DUMP_STREAM_ALIGN	4096		/* at least, the page size is used */
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t align;				/* the alignment of the planes */
+	uint32_t reserved;
+} tbm_dump_stream_header;
+
+typedef struct {
+	uint32_t magic;
+	uint32_t header_size;
+	uint64_t frame_size;		/* from this header to the next one */
+	tbm_surface_dump_frame_s frame;
+} tbm_dump_stream_frame;
+
+typedef struct {
+	uint64_t index_offset;
+	uint32_t num_frames;
+	uint32_t magic;
+} tbm_dump_stream_trailer;
+
+struct _tbm_surface_dump_stream {
+	int fd;
+	uint64_t size;
+	int num_frames;
+	uint64_t *index;
+};
+
+typedef struct {
+	tbm_surface_h staging;		/* kept for the next frames of the same size */
+	char name[256];
+	uint64_t timestamp;
+	uint64_t queue_id;
+	uint64_t surface_id;
+	char type[16];
+	struct list_head link;
+} tbm_dump_job;
+
+typedef struct {
+	char path[1024];
+	tbm_surface_dump_mode_e mode;
+	pthread_t thread;
+	int quit;
+	int in_flight;				/* jobs taken by the producers */
+	int num_jobs;
+	unsigned int count;			/* the index of the next file */
+	tbm_surface_dump_stats_s stats;
+	tbm_dump_job *jobs;
+	struct list_head free_list;
+	struct list_head pending_list;
+
+	/* TBM_SURFACE_DUMP_MODE_STREAM and _Y4M, only touched by the writer */
+	FILE *fp;
+	uint64_t offset;			/* the end of the last frame */
+	uint64_t align;				/* of the planes */
+	uint64_t *index;
+	int num_frames;
+	int index_size;
+	int y4m_width;				/* the size of the first frame */
+	int y4m_height;
+	uint8_t *y4m_frame;
+} tbm_dump_async;
+
+static pthread_mutex_t tbm_dump_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t tbm_dump_cond = PTHREAD_COND_INITIALIZER;
+static tbm_dump_async *g_dump_async;
+
+static uint64_t
+_tbm_dump_get_time_ns(void)
+{
+	struct timespec tp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tp);
+
+	return (uint64_t)tp.tv_sec * 1000000000ULL + tp.tv_nsec;
+}
+
+static double
+_tbm_dump_get_time(void)
+{
+	struct timespec tp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tp);
+
+	return tp.tv_sec * 1000.0 + tp.tv_nsec / 1000000.0;
+}
+
+static int
+_tbm_dump_stream_pad(FILE *fp, uint64_t bytes)
+{
+	static const uint8_t zeros[256];
+
+	while (bytes) {
+		size_t n = bytes < sizeof(zeros) ? bytes : sizeof(zeros);
+
+		if (fwrite(zeros, 1, n, fp) != n)
+			return 0;
+		bytes -= n;
+	}
+
+	return 1;
+}
+
+/* appends the frame of the staging surface to the stream */
+static int
+_tbm_dump_write_frame(tbm_dump_async *dump, tbm_dump_job *job, tbm_surface_info_s *info)
+{
+	tbm_dump_stream_frame header;
+	uint64_t pos;
+	int i;
+
+	if (dump->num_frames == dump->index_size) {
+		int size = dump->index_size ? dump->index_size * 2 : 256;
+		uint64_t *index = calloc(size, sizeof(uint64_t));
+
+		if (!index) {
+			TBM_LOG_E("fail to alloc the index of the stream\n");
+			return 0;
+		}
+
+		if (dump->index)
+			memcpy(index, dump->index, sizeof(uint64_t) * dump->num_frames);
+		free(dump->index);
+		dump->index = index;
+		dump->index_size = size;
+	}
+
+	memset(&header, 0, sizeof(header));
+	header.magic = TBM_DUMP_FRAME_MAGIC;
+	header.header_size = sizeof(header);
+	header.frame.format = info->format;
+	header.frame.width = info->width;
+	header.frame.height = info->height;
+	header.frame.num_planes = info->num_planes;
+	header.frame.timestamp = job->timestamp;
+	header.frame.queue_id = job->queue_id;
+	header.frame.surface_id = job->surface_id;
+	memcpy(header.frame.type, job->type, sizeof(header.frame.type));
+
+	pos = dump->offset + sizeof(header);
+	for (i = 0; i < (int)info->num_planes; i++) {
+		pos = (pos + dump->align - 1) & ~(dump->align - 1);
+		header.frame.strides[i] = info->planes[i].stride;
+		header.frame.sizes[i] = info->planes[i].size;
+		header.frame.offsets[i] = pos;
+		pos += info->planes[i].size;
+	}
+	header.frame_size = pos - dump->offset;
+
+	if (fwrite(&header, sizeof(header), 1, dump->fp) != 1)
+		goto fail;
+
+	pos = dump->offset + sizeof(header);
+	for (i = 0; i < (int)info->num_planes; i++) {
+		if (!_tbm_dump_stream_pad(dump->fp, header.frame.offsets[i] - pos))
+			goto fail;
+		if (fwrite(info->planes[i].ptr, 1, info->planes[i].size, dump->fp) != info->planes[i].size)
+			goto fail;
+		pos = header.frame.offsets[i] + info->planes[i].size;
+	}
+
+	dump->index[dump->num_frames++] = dump->offset;
+	dump->offset = pos;
+
+	return 1;
+
+fail:
+	TBM_LOG_E("fail to write the frame to %s (%m)\n", dump->path);
+
+	/* the next frame overwrites the broken one */
+	fseeko(dump->fp, dump->offset, SEEK_SET);
+
+	return 0;
+}
+
+static int
+_tbm_dump_is_y4m_supported(tbm_format format)
+{
+	switch (format) {
+	case TBM_FORMAT_YVU420:
+	case TBM_FORMAT_YUV420:
+	case TBM_FORMAT_NV12:
+	case TBM_FORMAT_NV21:
+	case TBM_FORMAT_NV12MT:
+	case TBM_FORMAT_YUYV:
+	case TBM_FORMAT_UYVY:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+/* appends the frame of the staging surface to the y4m stream as I420 */
+static int
+_tbm_dump_write_y4m(tbm_dump_async *dump, tbm_surface_info_s *info)
+{
+	int size;
+
+	/* the header of y4m is written with the size of the first frame */
+	if (!dump->y4m_frame) {
+		size = _tbm_surface_internal_y4m_get_frame_size(info->width, info->height);
+		dump->y4m_frame = calloc(1, size);
+		if (!dump->y4m_frame) {
+			TBM_LOG_E("fail to alloc the y4m frame\n");
+			return 0;
+		}
+
+		dump->y4m_width = info->width;
+		dump->y4m_height = info->height;
+
+		if (fprintf(dump->fp, "YUV4MPEG2 W%d H%d F30:1 Ip A1:1 C420jpeg\n",
+			    dump->y4m_width, dump->y4m_height) < 0) {
+			TBM_LOG_E("fail to write %s (%m)\n", dump->path);
+			return 0;
+		}
+	}
+
+	if ((int)info->width != dump->y4m_width || (int)info->height != dump->y4m_height) {
+		TBM_LOG_E("can't change the size of %s, %ux%u to %dx%d\n", dump->path,
+			  info->width, info->height, dump->y4m_width, dump->y4m_height);
+		return 0;
+	}
+
+	if (!_tbm_surface_internal_y4m_convert(info, dump->y4m_frame)) {
+		TBM_LOG_E("can't convert %c%c%c%c to y4m\n", FOURCC_STR(info->format));
+		return 0;
+	}
+
+	size = _tbm_surface_internal_y4m_get_frame_size(info->width, info->height);
+	if (fwrite("FRAME\n", 1, 6, dump->fp) != 6 ||
+	    fwrite(dump->y4m_frame, 1, size, dump->fp) != (size_t)size) {
+		TBM_LOG_E("fail to write %s (%m)\n", dump->path);
+		return 0;
+	}
+
+	return 1;
+}
+
+static int
+_tbm_dump_write(tbm_dump_async *dump, tbm_dump_job *job)
+{
+	tbm_surface_info_s info;
+	char file[2048];
+
+	if (tbm_surface_map(job->staging, TBM_SURF_OPTION_READ, &info) != TBM_SURFACE_ERROR_NONE) {
+		TBM_LOG_E("fail to map the staging surface of %s\n", job->name);
+		return 0;
+	}
+
+	if (dump->mode != TBM_SURFACE_DUMP_MODE_FILES) {
+		int ret;
+
+		if (dump->mode == TBM_SURFACE_DUMP_MODE_STREAM)
+			ret = _tbm_dump_write_frame(dump, job, &info);
+		else
+			ret = _tbm_dump_write_y4m(dump, &info);
+
+		tbm_surface_unmap(job->staging);
+
+		return ret;
+	}
+
+	snprintf(file, sizeof(file), "%s/%s", dump->path, job->name);
+
+	if (!_tbm_surface_internal_dump_file(file, &info)) {
+		TBM_LOG_E("can't dump %s buffer\n", _tbm_surface_internal_format_to_str(info.format));
+		tbm_surface_unmap(job->staging);
+		return 0;
+	}
+
+	tbm_surface_unmap(job->staging);
+
+	TBM_LOG_I("Dump File.. %s generated.\n", file);
+
+	return 1;
+}
+
+static void *
+_tbm_dump_writer_main(void *data)
+{
+	tbm_dump_async *dump = data;
+	tbm_dump_job *job;
+	int ret;
+
+	pthread_mutex_lock(&tbm_dump_lock);
+
+	while (1) {
+		while (LIST_IS_EMPTY(&dump->pending_list) && !dump->quit)
+			pthread_cond_wait(&tbm_dump_cond, &tbm_dump_lock);
+
+		/* the pending frames are written before quitting */
+		if (LIST_IS_EMPTY(&dump->pending_list))
+			break;
+
+		job = LIST_ENTRY(tbm_dump_job, dump->pending_list.next, link);
+		LIST_DEL(&job->link);
+
+		pthread_mutex_unlock(&tbm_dump_lock);
+
+		ret = _tbm_dump_write(dump, job);
+
+		pthread_mutex_lock(&tbm_dump_lock);
+
+		if (ret)
+			dump->stats.written++;
+		else
+			dump->stats.failed++;
+		LIST_ADDTAIL(&job->link, &dump->free_list);
+	}
+
+	pthread_mutex_unlock(&tbm_dump_lock);
+
+	return NULL;
+}
+
+/* copy the surface into the staging surface of job, made again for a new size */
+static int
+_tbm_dump_snapshot(tbm_dump_job *job, tbm_surface_h surface, tbm_format format)
+{
+	tbm_format staging_format = (format == TBM_FORMAT_NV12MT) ? TBM_FORMAT_NV12 : format;
+	tbm_surface_rect_s rect;
+
+	rect.x = rect.y = 0;
+	rect.width = tbm_surface_internal_get_width(surface);
+	rect.height = tbm_surface_internal_get_height(surface);
+
+	if (job->staging &&
+	    (tbm_surface_internal_get_format(job->staging) != staging_format ||
+	     (int)tbm_surface_internal_get_width(job->staging) != rect.width ||
+	     (int)tbm_surface_internal_get_height(job->staging) != rect.height)) {
+		tbm_surface_destroy(job->staging);
+		job->staging = NULL;
+	}
+
+	if (!job->staging) {
+		job->staging = tbm_surface_internal_create_with_flags(rect.width, rect.height,
+								      staging_format, TBM_BO_DEFAULT);
+		if (!job->staging) {
+			TBM_LOG_E("fail to create the staging surface\n");
+			return 0;
+		}
+	}
+
+	/* the whole frame, not only its damage */
+	if (format == TBM_FORMAT_NV12MT)
+		return tbm_surface_internal_detile(surface, job->staging);
+
+	return tbm_surface_internal_copy(surface, job->staging, &rect);
+}
+
+int
+_tbm_surface_internal_dump_async_buffer(tbm_surface_h surface, tbm_surface_queue_h queue,
+					const char *type)
+{
+	tbm_dump_async *dump;
+	tbm_dump_job *job;
+	tbm_format format;
+	unsigned int count;
+	int ret;
+
+	pthread_mutex_lock(&tbm_dump_lock);
+
+	dump = g_dump_async;
+	if (!dump) {
+		pthread_mutex_unlock(&tbm_dump_lock);
+		return 0;
+	}
+
+	/* the stream takes the planes as they are */
+	format = tbm_surface_internal_get_format(surface);
+	if ((dump->mode == TBM_SURFACE_DUMP_MODE_FILES && !tbm_format_get_desc(format)) ||
+	    (dump->mode == TBM_SURFACE_DUMP_MODE_Y4M && !_tbm_dump_is_y4m_supported(format))) {
+		TBM_LOG_E("can't dump %c%c%c%c buffer\n", FOURCC_STR(format));
+		dump->stats.failed++;
+		pthread_mutex_unlock(&tbm_dump_lock);
+		return 1;
+	}
+
+	/* the writer is behind */
+	if (LIST_IS_EMPTY(&dump->free_list)) {
+		dump->stats.dropped++;
+		pthread_mutex_unlock(&tbm_dump_lock);
+		return 1;
+	}
+
+	job = LIST_ENTRY(tbm_dump_job, dump->free_list.next, link);
+	LIST_DEL(&job->link);
+	dump->in_flight++;
+	count = dump->count++ % 1000;
+
+	pthread_mutex_unlock(&tbm_dump_lock);
+
+	ret = _tbm_dump_snapshot(job, surface, format);
+	if (ret) {
+		job->timestamp = _tbm_dump_get_time_ns();
+		job->queue_id = (uintptr_t)queue;
+		job->surface_id = (uintptr_t)surface;
+		snprintf(job->type, sizeof(job->type), "%s", type);
+	}
+	if (ret && dump->mode == TBM_SURFACE_DUMP_MODE_FILES) {
+		if (!tbm_format_get_desc(format)->is_yuv)
+			snprintf(job->name, sizeof(job->name), "%10.3f_%03u_%p-%s.png",
+				 _tbm_dump_get_time(), count, surface, type);
+		else
+			snprintf(job->name, sizeof(job->name), "%10.3f_%03u-%s_%dx%d_%c%c%c%c.yuv",
+				 _tbm_dump_get_time(), count, type,
+				 tbm_surface_internal_get_width(job->staging),
+				 tbm_surface_internal_get_height(job->staging),
+				 FOURCC_STR(tbm_surface_internal_get_format(job->staging)));
+	}
+
+	pthread_mutex_lock(&tbm_dump_lock);
+
+	if (ret) {
+		LIST_ADDTAIL(&job->link, &dump->pending_list);
+		dump->stats.queued++;
+	} else {
+		LIST_ADDTAIL(&job->link, &dump->free_list);
+		dump->stats.failed++;
+	}
+
+	dump->in_flight--;
+	pthread_cond_broadcast(&tbm_dump_cond);
+
+	pthread_mutex_unlock(&tbm_dump_lock);
+
+	return 1;
+}
+
+static void
+_tbm_dump_stream_close(tbm_dump_async *dump)
+{
+	tbm_dump_stream_trailer trailer;
+
+	if (dump->mode == TBM_SURFACE_DUMP_MODE_Y4M) {
+		fclose(dump->fp);
+		free(dump->y4m_frame);
+		return;
+	}
+
+	trailer.index_offset = dump->offset;
+	trailer.num_frames = dump->num_frames;
+	trailer.magic = TBM_DUMP_INDEX_MAGIC;
+
+	if ((dump->num_frames &&
+	     fwrite(dump->index, sizeof(uint64_t), dump->num_frames, dump->fp) != (size_t)dump->num_frames) ||
+	    fwrite(&trailer, sizeof(trailer), 1, dump->fp) != 1)
+		TBM_LOG_E("fail to write the index to %s (%m)\n", dump->path);
+
+	fclose(dump->fp);
+	free(dump->index);
+}
+
+static int
+_tbm_dump_stream_open(tbm_dump_async *dump)
+{
+	tbm_dump_stream_header header;
+	long page_size = sysconf(_SC_PAGESIZE);
+
+	dump->fp = fopen(dump->path, "wb");
+	if (!dump->fp) {
+		TBM_LOG_E("fail to open %s (%m)\n", dump->path);
+		return 0;
+	}
+
+	/* the header of y4m needs the first frame */
+	if (dump->mode == TBM_SURFACE_DUMP_MODE_Y4M)
+		return 1;
+
+	header.magic = TBM_DUMP_STREAM_MAGIC;
+	header.version = TBM_DUMP_STREAM_VERSION;
+	header.align = TBM_DUMP_STREAM_ALIGN;
+	if (page_size > TBM_DUMP_STREAM_ALIGN)
+		header.align = page_size;
+	header.reserved = 0;
+
+	if (fwrite(&header, sizeof(header), 1, dump->fp) != 1) {
+		TBM_LOG_E("fail to write %s (%m)\n", dump->path);
+		fclose(dump->fp);
+		return 0;
+	}
+
+	dump->offset = sizeof(header);
+	dump->align = header.align;
+
+	return 1;
+}
+
+int
+tbm_surface_internal_dump_async_start(const char *path, int count)
+{
+	return tbm_surface_internal_dump_async_start_with_mode(path, count,
+							       TBM_SURFACE_DUMP_MODE_FILES);
+}
+
+int
+tbm_surface_internal_dump_async_start_with_mode(const char *path, int count,
+						tbm_surface_dump_mode_e mode)
+{
+	tbm_dump_async *dump;
+	sigset_t set, old;
+	int i, ret;
+
+	TBM_RETURN_VAL_IF_FAIL(path != NULL, 0);
+	TBM_RETURN_VAL_IF_FAIL(count > 0, 0);
+	TBM_RETURN_VAL_IF_FAIL(mode >= TBM_SURFACE_DUMP_MODE_FILES &&
+			       mode <= TBM_SURFACE_DUMP_MODE_Y4M, 0);
+
+	dump = calloc(1, sizeof(tbm_dump_async));
+	if (!dump) {
+		TBM_LOG_E("fail to alloc the dump\n");
+		return 0;
+	}
+
+	dump->jobs = calloc(count, sizeof(tbm_dump_job));
+	if (!dump->jobs) {
+		TBM_LOG_E("fail to alloc the dump jobs\n");
+		free(dump);
+		return 0;
+	}
+
+	snprintf(dump->path, sizeof(dump->path), "%s", path);
+	dump->mode = mode;
+	dump->num_jobs = count;
+	LIST_INITHEAD(&dump->free_list);
+	LIST_INITHEAD(&dump->pending_list);
+	for (i = 0; i < count; i++)
+		LIST_ADDTAIL(&dump->jobs[i].link, &dump->free_list);
+
+	pthread_mutex_lock(&tbm_dump_lock);
+
+	if (g_dump_async) {
+		TBM_LOG_W("warning already running the asynchronous dump.\n");
+		pthread_mutex_unlock(&tbm_dump_lock);
+		free(dump->jobs);
+		free(dump);
+		return 0;
+	}
+
+	if (mode != TBM_SURFACE_DUMP_MODE_FILES && !_tbm_dump_stream_open(dump)) {
+		pthread_mutex_unlock(&tbm_dump_lock);
+		free(dump->jobs);
+		free(dump);
+		return 0;
+	}
+
+	/* the signals of the application are not ours to handle */
+	sigfillset(&set);
+	pthread_sigmask(SIG_SETMASK, &set, &old);
+	ret = pthread_create(&dump->thread, NULL, _tbm_dump_writer_main, dump);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+	if (ret) {
+		TBM_LOG_E("fail to create the dump writer\n");
+		if (dump->fp)
+			_tbm_dump_stream_close(dump);
+		pthread_mutex_unlock(&tbm_dump_lock);
+		free(dump->jobs);
+		free(dump);
+		return 0;
+	}
+
+	g_dump_async = dump;
+
+	pthread_mutex_unlock(&tbm_dump_lock);
+
+	TBM_LOG_I("Dump Start.. path:%s, count:%d async mode:%d\n", dump->path, count, mode);
+
+	return 1;
+}
+
+void
+tbm_surface_internal_dump_async_end(void)
+{
+	tbm_dump_async *dump;
+	int i;
+
+	pthread_mutex_lock(&tbm_dump_lock);
+
+	dump = g_dump_async;
+	if (!dump) {
+		pthread_mutex_unlock(&tbm_dump_lock);
+		return;
+	}
+
+	/* no new frame, the taken ones are queued */
+	g_dump_async = NULL;
+	while (dump->in_flight)
+		pthread_cond_wait(&tbm_dump_cond, &tbm_dump_lock);
+
+	dump->quit = 1;
+	pthread_cond_broadcast(&tbm_dump_cond);
+
+	pthread_mutex_unlock(&tbm_dump_lock);
+
+	pthread_join(dump->thread, NULL);
+
+	if (dump->mode != TBM_SURFACE_DUMP_MODE_FILES)
+		_tbm_dump_stream_close(dump);
+
+	for (i = 0; i < dump->num_jobs; i++) {
+		if (dump->jobs[i].staging)
+			tbm_surface_destroy(dump->jobs[i].staging);
+	}
+
+	TBM_LOG_I("Dump End.. queued:%u written:%u dropped:%u failed:%u\n",
+		  dump->stats.queued, dump->stats.written, dump->stats.dropped, dump->stats.failed);
+
+	free(dump->jobs);
+	free(dump);
+}
+
+int
+tbm_surface_internal_dump_async_get_stats(tbm_surface_dump_stats_s *stats)
+{
+	TBM_RETURN_VAL_IF_FAIL(stats != NULL, 0);
+
+	pthread_mutex_lock(&tbm_dump_lock);
+
+	if (!g_dump_async) {
+		pthread_mutex_unlock(&tbm_dump_lock);
+		return 0;
+	}
+
+	*stats = g_dump_async->stats;
+
+	pthread_mutex_unlock(&tbm_dump_lock);
+
+	return 1;
+}
+
+static int
+_tbm_dump_stream_read_header(tbm_surface_dump_stream_h stream, uint64_t offset,
+			     tbm_dump_stream_frame *header)
+{
+	int i;
+
+	if (offset + sizeof(*header) > stream->size ||
+	    pread(stream->fd, header, sizeof(*header), offset) != sizeof(*header))
+		return 0;
+
+	if (header->magic != TBM_DUMP_FRAME_MAGIC || header->header_size != sizeof(*header) ||
+	    header->frame.num_planes > TBM_SURF_PLANE_MAX ||
+	    header->frame_size < sizeof(*header) || offset + header->frame_size > stream->size)
+		return 0;
+
+	for (i = 0; i < (int)header->frame.num_planes; i++) {
+		if (header->frame.offsets[i] + header->frame.sizes[i] > offset + header->frame_size)
+			return 0;
+	}
+
+	return 1;
+}
+
+/* the frames of a stream without the index, the truncated last one is left out */
+static int
+_tbm_dump_stream_scan(tbm_surface_dump_stream_h stream)
+{
+	tbm_dump_stream_frame header;
+	uint64_t offset = sizeof(tbm_dump_stream_header);
+	int size = 0;
+
+	while (_tbm_dump_stream_read_header(stream, offset, &header)) {
+		if (stream->num_frames == size) {
+			uint64_t *index;
+
+			size = size ? size * 2 : 256;
+			index = calloc(size, sizeof(uint64_t));
+			if (!index) {
+				TBM_LOG_E("fail to alloc the index of the stream\n");
+				return 0;
+			}
+
+			if (stream->index)
+				memcpy(index, stream->index, sizeof(uint64_t) * stream->num_frames);
+			free(stream->index);
+			stream->index = index;
+		}
+
+		stream->index[stream->num_frames++] = offset;
+		offset += header.frame_size;
+	}
+
+	return 1;
+}
+
+tbm_surface_dump_stream_h
+tbm_surface_internal_dump_stream_open(const char *file)
+{
+	tbm_surface_dump_stream_h stream;
+	tbm_dump_stream_header header;
+	tbm_dump_stream_trailer trailer;
+	struct stat st;
+
+	TBM_RETURN_VAL_IF_FAIL(file != NULL, NULL);
+
+	stream = calloc(1, sizeof(struct _tbm_surface_dump_stream));
+	if (!stream) {
+		TBM_LOG_E("fail to alloc the stream\n");
+		return NULL;
+	}
+
+	stream->fd = open(file, O_RDONLY | O_CLOEXEC);
+	if (stream->fd < 0) {
+		TBM_LOG_E("fail to open %s (%m)\n", file);
+		free(stream);
+		return NULL;
+	}
+
+	if (fstat(stream->fd, &st) < 0 ||
+	    pread(stream->fd, &header, sizeof(header), 0) != sizeof(header) ||
+	    header.magic != TBM_DUMP_STREAM_MAGIC || header.version != TBM_DUMP_STREAM_VERSION) {
+		TBM_LOG_E("%s isn't a dump stream\n", file);
+		goto fail;
+	}
+	stream->size = st.st_size;
+
+	/* the index when the writer ended well */
+	if (stream->size >= sizeof(header) + sizeof(trailer) &&
+	    pread(stream->fd, &trailer, sizeof(trailer), stream->size - sizeof(trailer)) == sizeof(trailer) &&
+	    trailer.magic == TBM_DUMP_INDEX_MAGIC &&
+	    trailer.index_offset + (uint64_t)trailer.num_frames * sizeof(uint64_t) + sizeof(trailer) == stream->size) {
+		stream->num_frames = trailer.num_frames;
+		if (stream->num_frames) {
+			stream->index = calloc(stream->num_frames, sizeof(uint64_t));
+			if (!stream->index) {
+				TBM_LOG_E("fail to alloc the index of the stream\n");
+				goto fail;
+			}
+
+			if (pread(stream->fd, stream->index, sizeof(uint64_t) * stream->num_frames,
+				  trailer.index_offset) != (ssize_t)(sizeof(uint64_t) * stream->num_frames)) {
+				TBM_LOG_E("fail to read the index of %s\n", file);
+				goto fail;
+			}
+		}
+	} else {
+		if (!_tbm_dump_stream_scan(stream))
+			goto fail;
+	}
+
+	TBM_TRACE("stream(%p) file(%s) frames(%d)\n", stream, file, stream->num_frames);
+
+	return stream;
+
+fail:
+	free(stream->index);
+	close(stream->fd);
+	free(stream);
+
+	return NULL;
+}
+
+void
+tbm_surface_internal_dump_stream_close(tbm_surface_dump_stream_h stream)
+{
+	TBM_RETURN_IF_FAIL(stream != NULL);
+
+	free(stream->index);
+	close(stream->fd);
+	free(stream);
+}
+
+int
+tbm_surface_internal_dump_stream_get_num_frames(tbm_surface_dump_stream_h stream)
+{
+	TBM_RETURN_VAL_IF_FAIL(stream != NULL, 0);
+
+	return stream->num_frames;
+}
+
+int
+tbm_surface_internal_dump_stream_get_frame(tbm_surface_dump_stream_h stream, int idx,
+					   tbm_surface_dump_frame_s *frame)
+{
+	tbm_dump_stream_frame header;
+
+	TBM_RETURN_VAL_IF_FAIL(stream != NULL, 0);
+	TBM_RETURN_VAL_IF_FAIL(idx >= 0 && idx < stream->num_frames, 0);
+	TBM_RETURN_VAL_IF_FAIL(frame != NULL, 0);
+
+	if (!_tbm_dump_stream_read_header(stream, stream->index[idx], &header)) {
+		TBM_LOG_E("broken frame %d\n", idx);
+		return 0;
+	}
+
+	*frame = header.frame;
+
+	return 1;
+}
+
+int
+tbm_surface_internal_dump_stream_read_frame(tbm_surface_dump_stream_h stream, int idx,
+					    tbm_surface_h surface)
+{
+	tbm_dump_stream_frame header;
+	tbm_surface_info_s info;
+	uint64_t page_mask = sysconf(_SC_PAGESIZE) - 1;
+	int i, row;
+
+	TBM_RETURN_VAL_IF_FAIL(stream != NULL, 0);
+	TBM_RETURN_VAL_IF_FAIL(idx >= 0 && idx < stream->num_frames, 0);
+	TBM_RETURN_VAL_IF_FAIL(surface != NULL, 0);
+
+	if (!_tbm_dump_stream_read_header(stream, stream->index[idx], &header)) {
+		TBM_LOG_E("broken frame %d\n", idx);
+		return 0;
+	}
+
+	if (tbm_surface_internal_get_format(surface) != header.frame.format ||
+	    tbm_surface_internal_get_width(surface) != header.frame.width ||
+	    tbm_surface_internal_get_height(surface) != header.frame.height) {
+		TBM_LOG_E("surface(%p) doesn't match the frame %d %c%c%c%c %ux%u\n", surface, idx,
+			  FOURCC_STR(header.frame.format), header.frame.width, header.frame.height);
+		return 0;
+	}
+
+	if (tbm_surface_map(surface, TBM_SURF_OPTION_WRITE, &info) != TBM_SURFACE_ERROR_NONE) {
+		TBM_LOG_E("fail to map surface(%p)\n", surface);
+		return 0;
+	}
+
+	for (i = 0; i < (int)header.frame.num_planes && i < (int)info.num_planes; i++) {
+		uint32_t src_stride = header.frame.strides[i];
+		uint32_t dst_stride = info.planes[i].stride;
+		uint32_t bytes = src_stride < dst_stride ? src_stride : dst_stride;
+		uint32_t rows;
+		uint64_t start, skip;
+		uint8_t *src;
+
+		if (!src_stride || !header.frame.sizes[i])
+			continue;
+
+		rows = header.frame.sizes[i] / src_stride;
+		if (rows > info.planes[i].size / dst_stride)
+			rows = info.planes[i].size / dst_stride;
+
+		/* the planes start on a page of the writer, which may be smaller */
+		start = header.frame.offsets[i] & ~page_mask;
+		skip = header.frame.offsets[i] - start;
+		src = mmap(NULL, skip + header.frame.sizes[i], PROT_READ, MAP_PRIVATE, stream->fd,
+			   start);
+		if (src == MAP_FAILED) {
+			TBM_LOG_E("fail to map the plane %d of the frame %d (%m)\n", i, idx);
+			tbm_surface_unmap(surface);
+			return 0;
+		}
+
+		for (row = 0; row < (int)rows; row++)
+			memcpy(info.planes[i].ptr + row * dst_stride, src + skip + row * src_stride, bytes);
+
+		munmap(src, skip + header.frame.sizes[i]);
+	}
+
+	tbm_surface_unmap(surface);
+
+	TBM_TRACE("stream(%p) frame(%d) surface(%p)\n", stream, idx, surface);
+
+	return 1;
+}
+
+/* The compressed ring of tbm_surface_internal_dump_ring_start(): the frames
+ * are compressed with LZ4 as they come into one buffer of a fixed size,
+ * used from the start to the end and again from the start, and the oldest
+ * frames are evicted for the new ones. Nothing is encoded before the end.
+ * A producer maps, detiles and compresses its frame into a scratch of its
+ * own without the lock, only the copy into the ring is done under it.
+ */
+typedef struct {
+	char name[256];
+	tbm_surface_info_s info;	/* the planes are one after the other */
+	int offset;					/* in the ring */
+	int size;
+	int sizes[TBM_SURF_PLANE_MAX];	/* the compressed planes */
+	struct list_head link;
+} tbm_dump_ring_frame;
+
+typedef struct {
+	uint8_t *raw;				/* a detiled frame */
+	int raw_size;
+	uint8_t *comp;
+	int comp_size;
+	uint32_t table[1 << TBM_LZ4_HASH_LOG];
+	struct list_head link;
+} tbm_dump_ring_scratch;
+
+typedef struct {
+	char path[1024];
+	uint8_t *ring;
+	int ring_size;
+	int head;					/* the end of the newest frame */
+	uint8_t *raw;				/* a decompressed frame */
+	int raw_size;
+	int in_flight;				/* frames compressed by the producers */
+	struct list_head scratch_list;
+	unsigned int count;			/* the index of the next file */
+	unsigned int evicted;
+	unsigned int dropped;
+	uint64_t raw_bytes;
+	uint64_t comp_bytes;
+	struct list_head frames;	/* the oldest first */
+} tbm_dump_ring;
+
+static tbm_dump_ring *g_dump_ring;
+
+static int
+_tbm_dump_ring_reserve(uint8_t **buf, int *size, int need)
+{
+	if (*size >= need)
+		return 1;
+
+	free(*buf);
+	*buf = calloc(1, need);
+	if (!*buf) {
+		*size = 0;
+		TBM_LOG_E("fail to alloc %d bytes for the dump ring\n", need);
+		return 0;
+	}
+	*size = need;
+
+	return 1;
+}
+
+static void
+_tbm_dump_ring_evict(tbm_dump_ring *ring)
+{
+	tbm_dump_ring_frame *frame;
+
+	frame = LIST_ENTRY(tbm_dump_ring_frame, ring->frames.next, link);
+	LIST_DEL(&frame->link);
+	free(frame);
+
+	ring->evicted++;
+}
+
+/* takes a frame of the ring and a scratch for it, NULL without the ring */
+static tbm_dump_ring *
+_tbm_dump_ring_begin(tbm_dump_ring_scratch **scratch, unsigned int *count)
+{
+	tbm_dump_ring *ring;
+
+	pthread_mutex_lock(&tbm_dump_lock);
+
+	ring = g_dump_ring;
+	if (!ring) {
+		pthread_mutex_unlock(&tbm_dump_lock);
+		return NULL;
+	}
+
+	*scratch = NULL;
+	if (!LIST_IS_EMPTY(&ring->scratch_list)) {
+		*scratch = LIST_ENTRY(tbm_dump_ring_scratch, ring->scratch_list.next, link);
+		LIST_DEL(&(*scratch)->link);
+	}
+	ring->in_flight++;
+	*count = ring->count++ % 1000;
+
+	pthread_mutex_unlock(&tbm_dump_lock);
+
+	if (!*scratch) {
+		*scratch = calloc(1, sizeof(tbm_dump_ring_scratch));
+		if (!*scratch)
+			TBM_LOG_E("fail to alloc the scratch of the dump ring\n");
+	}
+
+	return ring;
+}
+
+/* compresses the planes of info into the scratch, the ring isn't touched */
+static tbm_dump_ring_frame *
+_tbm_dump_ring_compress(tbm_dump_ring_scratch *scratch, tbm_surface_info_s *info,
+			const char *name)
+{
+	tbm_dump_ring_frame *frame;
+	int bound = 0, size = 0, i;
+
+	for (i = 0; i < (int)info->num_planes; i++)
+		bound += _tbm_lz4_compress_bound(info->planes[i].size);
+
+	if (!_tbm_dump_ring_reserve(&scratch->comp, &scratch->comp_size, bound))
+		return NULL;
+
+	frame = calloc(1, sizeof(tbm_dump_ring_frame));
+	if (!frame) {
+		TBM_LOG_E("fail to alloc the dump ring frame\n");
+		return NULL;
+	}
+
+	for (i = 0; i < (int)info->num_planes; i++) {
+		frame->sizes[i] = _tbm_lz4_compress(info->planes[i].ptr, info->planes[i].size,
+						    scratch->comp + size, bound - size, scratch->table);
+		size += frame->sizes[i];
+	}
+
+	snprintf(frame->name, sizeof(frame->name), "%s", name);
+	frame->info = *info;
+	frame->size = size;
+
+	return frame;
+}
+
+/* puts the compressed frame into the ring, must be called with the lock */
+static int
+_tbm_dump_ring_add(tbm_dump_ring *ring, tbm_dump_ring_frame *frame, uint8_t *comp)
+{
+	tbm_dump_ring_frame *oldest;
+	int raw = 0, size = frame->size, pos, i;
+
+	if (size > ring->ring_size) {
+		TBM_LOG_W("Dump skip. %s over the ring size(%d, %d)\n", frame->name, size,
+			  ring->ring_size);
+		free(frame);
+		ring->dropped++;
+		return 0;
+	}
+
+	/* from the start again, the frames at the end are the oldest */
+	pos = ring->head;
+	if (pos + size > ring->ring_size) {
+		while (!LIST_IS_EMPTY(&ring->frames)) {
+			oldest = LIST_ENTRY(tbm_dump_ring_frame, ring->frames.next, link);
+			if (oldest->offset < pos)
+				break;
+			_tbm_dump_ring_evict(ring);
+		}
+		pos = 0;
+	}
+
+	while (!LIST_IS_EMPTY(&ring->frames)) {
+		oldest = LIST_ENTRY(tbm_dump_ring_frame, ring->frames.next, link);
+		if (oldest->offset >= pos + size || oldest->offset + oldest->size <= pos)
+			break;
+		_tbm_dump_ring_evict(ring);
+	}
+
+	memcpy(ring->ring + pos, comp, size);
+
+	frame->offset = pos;
+	LIST_ADDTAIL(&frame->link, &ring->frames);
+
+	for (i = 0; i < (int)frame->info.num_planes; i++)
+		raw += frame->info.planes[i].size;
+
+	ring->head = pos + size;
+	ring->raw_bytes += raw;
+	ring->comp_bytes += size;
+
+	return 1;
+}
+
+/* publishes the frame, if any, and gives the scratch back */
+static int
+_tbm_dump_ring_end_frame(tbm_dump_ring *ring, tbm_dump_ring_scratch *scratch,
+			 tbm_dump_ring_frame *frame)
+{
+	int ret = 0;
+
+	pthread_mutex_lock(&tbm_dump_lock);
+
+	if (frame)
+		ret = _tbm_dump_ring_add(ring, frame, scratch->comp);
+	if (scratch)
+		LIST_ADDTAIL(&scratch->link, &ring->scratch_list);
+
+	ring->in_flight--;
+	pthread_cond_broadcast(&tbm_dump_cond);
+
+	pthread_mutex_unlock(&tbm_dump_lock);
+
+	return ret;
+}
+
+int
+_tbm_surface_internal_dump_ring_buffer(tbm_surface_h surface, const char *type)
+{
+	tbm_dump_ring *ring;
+	tbm_dump_ring_scratch *scratch;
+	tbm_dump_ring_frame *frame = NULL;
+	tbm_surface_info_s info, linear;
+	char name[256];
+	unsigned int count;
+
+	ring = _tbm_dump_ring_begin(&scratch, &count);
+	if (!ring)
+		return 0;
+
+	if (!scratch)
+		goto done;
+
+	if (tbm_surface_map(surface, TBM_SURF_OPTION_READ, &info) != TBM_SURFACE_ERROR_NONE) {
+		TBM_LOG_E("fail to map surface(%p)\n", surface);
+		goto done;
+	}
+
+	if (!tbm_format_get_desc(info.format)) {
+		TBM_LOG_E("can't dump %c%c%c%c buffer\n", FOURCC_STR(info.format));
+		tbm_surface_unmap(surface);
+		goto done;
+	}
+
+	if (info.format == TBM_FORMAT_NV12MT) {
+		/* the tiles are kept as linear NV12 */
+		memset(&linear, 0, sizeof(linear));
+		linear.width = info.width;
+		linear.height = info.height;
+		linear.format = TBM_FORMAT_NV12;
+		linear.num_planes = 2;
+		linear.planes[0].stride = linear.planes[1].stride = info.width;
+		linear.planes[0].size = info.width * info.height;
+		linear.planes[1].size = info.width * ((info.height + 1) / 2);
+
+		if (!_tbm_dump_ring_reserve(&scratch->raw, &scratch->raw_size,
+					    linear.planes[0].size + linear.planes[1].size) ||
+		    !_tbm_surface_internal_detile_nv12mt(&info, scratch->raw, info.width,
+							 scratch->raw + linear.planes[0].size,
+							 info.width)) {
+			TBM_LOG_E("can't detile %c%c%c%c buffer\n", FOURCC_STR(info.format));
+			tbm_surface_unmap(surface);
+			goto done;
+		}
+		linear.planes[0].ptr = scratch->raw;
+		linear.planes[1].ptr = scratch->raw + linear.planes[0].size;
+	} else {
+		linear = info;
+	}
+
+	if (!tbm_format_get_desc(linear.format)->is_yuv)
+		snprintf(name, sizeof(name), "%10.3f_%03u_%p-%s.png",
+			 _tbm_dump_get_time(), count, surface, type);
+	else
+		snprintf(name, sizeof(name), "%10.3f_%03u-%s_%dx%d_%c%c%c%c.yuv",
+			 _tbm_dump_get_time(), count, type, linear.width,
+			 linear.height, FOURCC_STR(linear.format));
+
+	frame = _tbm_dump_ring_compress(scratch, &linear, name);
+
+	tbm_surface_unmap(surface);
+
+done:
+	if (_tbm_dump_ring_end_frame(ring, scratch, frame))
+		TBM_LOG_I("Dump %s \n", name);
+
+	return 1;
+}
+
+int
+_tbm_surface_internal_dump_ring_shm_buffer(void *ptr, int w, int h, int stride, const char *type)
+{
+	tbm_dump_ring *ring;
+	tbm_dump_ring_scratch *scratch;
+	tbm_dump_ring_frame *frame = NULL;
+	tbm_surface_info_s info;
+	char name[256];
+	unsigned int count;
+
+	ring = _tbm_dump_ring_begin(&scratch, &count);
+	if (!ring)
+		return 0;
+
+	if (scratch) {
+		memset(&info, 0, sizeof(info));
+		info.width = stride >> 2;
+		info.height = h;
+		info.format = TBM_FORMAT_ARGB8888;
+		info.num_planes = 1;
+		info.planes[0].ptr = ptr;
+		info.planes[0].stride = stride;
+		info.planes[0].size = stride * h;
+
+		snprintf(name, sizeof(name), "%10.3f_%03u-%s.png",
+			 _tbm_dump_get_time(), count, type);
+
+		frame = _tbm_dump_ring_compress(scratch, &info, name);
+	}
+
+	if (_tbm_dump_ring_end_frame(ring, scratch, frame))
+		TBM_LOG_I("Dump %s \n", name);
+
+	return 1;
+}
+
+/* writes info as a png or a raw file by its format */
+static int
+_tbm_dump_write_file(const char *file, tbm_surface_info_s *info)
+{
+	if (!_tbm_surface_internal_dump_file(file, info)) {
+		TBM_LOG_E("can't dump %c%c%c%c buffer\n", FOURCC_STR(info->format));
+		return 0;
+	}
+
+	TBM_LOG_I("Dump File.. %s generated.\n", file);
+
+	return 1;
+}
+
+/* decompresses the frame and writes its file */
+static void
+_tbm_dump_ring_write(tbm_dump_ring *ring, tbm_dump_ring_frame *frame)
+{
+	tbm_surface_info_s *info = &frame->info;
+	int raw = 0, comp = 0, i;
+	char file[2048];
+
+	for (i = 0; i < (int)info->num_planes; i++)
+		raw += info->planes[i].size;
+
+	if (!_tbm_dump_ring_reserve(&ring->raw, &ring->raw_size, raw))
+		return;
+
+	raw = 0;
+	for (i = 0; i < (int)info->num_planes; i++) {
+		if (!_tbm_lz4_decompress(ring->ring + frame->offset + comp, frame->sizes[i],
+					 ring->raw + raw, info->planes[i].size)) {
+			TBM_LOG_E("broken frame %s in the dump ring\n", frame->name);
+			return;
+		}
+		info->planes[i].ptr = ring->raw + raw;
+		raw += info->planes[i].size;
+		comp += frame->sizes[i];
+	}
+
+	snprintf(file, sizeof(file), "%s/%s", ring->path, frame->name);
+
+	_tbm_dump_write_file(file, info);
+}
+
+int
+tbm_surface_internal_dump_ring_start(const char *path, int size)
+{
+	tbm_dump_ring *ring;
+
+	TBM_RETURN_VAL_IF_FAIL(path != NULL, 0);
+	TBM_RETURN_VAL_IF_FAIL(size > 0, 0);
+
+	ring = calloc(1, sizeof(tbm_dump_ring));
+	if (!ring) {
+		TBM_LOG_E("fail to alloc the dump ring\n");
+		return 0;
+	}
+
+	ring->ring = calloc(1, size);
+	if (!ring->ring) {
+		TBM_LOG_E("fail to alloc the dump ring of %d bytes\n", size);
+		free(ring);
+		return 0;
+	}
+
+	snprintf(ring->path, sizeof(ring->path), "%s", path);
+	ring->ring_size = size;
+	LIST_INITHEAD(&ring->scratch_list);
+	LIST_INITHEAD(&ring->frames);
+
+	pthread_mutex_lock(&tbm_dump_lock);
+
+	if (g_dump_ring) {
+		TBM_LOG_W("warning already running the dump ring.\n");
+		pthread_mutex_unlock(&tbm_dump_lock);
+		free(ring->ring);
+		free(ring);
+		return 0;
+	}
+
+	g_dump_ring = ring;
+
+	pthread_mutex_unlock(&tbm_dump_lock);
+
+	TBM_LOG_I("Dump Start.. path:%s, ring:%d bytes\n", ring->path, size);
+
+	return 1;
+}
+
+int
+_tbm_surface_internal_dump_ring_end(void)
+{
+	tbm_dump_ring_frame *frame, *tmp;
+	tbm_dump_ring_scratch *scratch, *stmp;
+	tbm_dump_ring *ring;
+	int kept = 0;
+
+	pthread_mutex_lock(&tbm_dump_lock);
+
+	ring = g_dump_ring;
+	if (!ring) {
+		pthread_mutex_unlock(&tbm_dump_lock);
+		return 0;
+	}
+
+	/* no new frame, the taken ones are put into the ring */
+	g_dump_ring = NULL;
+	while (ring->in_flight)
+		pthread_cond_wait(&tbm_dump_cond, &tbm_dump_lock);
+
+	pthread_mutex_unlock(&tbm_dump_lock);
+
+	LIST_FOR_EACH_ENTRY_SAFE(frame, tmp, &ring->frames, link) {
+		_tbm_dump_ring_write(ring, frame);
+		LIST_DEL(&frame->link);
+		free(frame);
+		kept++;
+	}
+
+	TBM_LOG_I("Dump End.. kept:%d evicted:%u dropped:%u compressed:%llu/%llu bytes\n",
+		  kept, ring->evicted, ring->dropped,
+		  (unsigned long long)ring->comp_bytes, (unsigned long long)ring->raw_bytes);
+
+	LIST_FOR_EACH_ENTRY_SAFE(scratch, stmp, &ring->scratch_list, link) {
+		LIST_DEL(&scratch->link);
+		free(scratch->raw);
+		free(scratch->comp);
+		free(scratch);
+	}
+
+	free(ring->ring);
+	free(ring->raw);
+	free(ring);
+
+	return 1;
+}
+
+/* The dump of all the surfaces: the surfaces are referenced in one pass
+ * under the surface lock, then every one is mapped, copied, unmapped and
+ * encoded without any lock of libtbm, on the worker threads when there are
+ * some. The surfaces are mapped only for the copy.
+ */
+typedef struct {
+	const char *path;
+	tbm_surface_h *surfaces;
+	int num;
+	int done;
+	int written;
+	uint64_t copy_ns;
+	uint64_t encode_ns;
+} tbm_dump_all;
+
+/* copies the planes of info into one buffer, NV12MT as linear NV12 */
+static uint8_t *
+_tbm_dump_all_copy(tbm_surface_info_s *info, tbm_surface_info_s *copy)
+{
+	uint8_t *buf;
+	int size = 0, i;
+
+	*copy = *info;
+
+	if (info->format == TBM_FORMAT_NV12MT) {
+		copy->format = TBM_FORMAT_NV12;
+		copy->num_planes = 2;
+		copy->planes[0].stride = copy->planes[1].stride = info->width;
+		copy->planes[0].size = info->width * info->height;
+		copy->planes[1].size = info->width * ((info->height + 1) / 2);
+		copy->planes[2].size = 0;
+	}
+
+	for (i = 0; i < (int)copy->num_planes; i++)
+		size += copy->planes[i].size;
+
+	buf = calloc(1, size);
+	if (!buf) {
+		TBM_LOG_E("fail to alloc %d bytes for the dump\n", size);
+		return NULL;
+	}
+
+	if (info->format == TBM_FORMAT_NV12MT) {
+		if (!_tbm_surface_internal_detile_nv12mt(info, buf, info->width,
+							 buf + copy->planes[0].size, info->width)) {
+			TBM_LOG_E("can't detile %c%c%c%c buffer\n", FOURCC_STR(info->format));
+			free(buf);
+			return NULL;
+		}
+		copy->planes[0].ptr = buf;
+		copy->planes[1].ptr = buf + copy->planes[0].size;
+		return buf;
+	}
+
+	size = 0;
+	for (i = 0; i < (int)copy->num_planes; i++) {
+		memcpy(buf + size, info->planes[i].ptr, info->planes[i].size);
+		copy->planes[i].ptr = buf + size;
+		size += copy->planes[i].size;
+	}
+
+	return buf;
+}
+
+static void
+_tbm_dump_all_func(void *data, int idx)
+{
+	tbm_dump_all *dump = data;
+	tbm_surface_h surface = dump->surfaces[idx];
+	const tbm_format_desc_s *desc = NULL;
+	tbm_surface_info_s info, copy;
+	uint64_t start, copied;
+	char file[2048];
+	uint8_t *buf = NULL;
+	int done;
+
+	start = _tbm_dump_get_time_ns();
+
+	if (tbm_surface_map(surface, TBM_SURF_OPTION_READ, &info) != TBM_SURFACE_ERROR_NONE) {
+		TBM_LOG_E("fail to map surface(%p)\n", surface);
+	} else {
+		desc = tbm_format_get_desc(info.format);
+		if (desc)
+			buf = _tbm_dump_all_copy(&info, &copy);
+		else
+			TBM_LOG_E("can't dump %c%c%c%c buffer\n", FOURCC_STR(info.format));
+
+		tbm_surface_unmap(surface);
+	}
+
+	copied = _tbm_dump_get_time_ns();
+
+	if (buf) {
+		if (!desc->is_yuv)
+			snprintf(file, sizeof(file), "%s/%10.3f_%03d_%p-dump_all.png",
+				 dump->path, _tbm_dump_get_time(), idx % 1000, surface);
+		else
+			snprintf(file, sizeof(file), "%s/%10.3f_%03d-dump_all_%dx%d_%c%c%c%c.yuv",
+				 dump->path, _tbm_dump_get_time(), idx % 1000,
+				 copy.width, copy.height, FOURCC_STR(copy.format));
+
+		if (_tbm_dump_write_file(file, &copy))
+			__atomic_add_fetch(&dump->written, 1, __ATOMIC_RELAXED);
+		free(buf);
+	}
+
+	__atomic_add_fetch(&dump->copy_ns, copied - start, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&dump->encode_ns, _tbm_dump_get_time_ns() - copied, __ATOMIC_RELAXED);
+
+	/* every tenth */
+	done = __atomic_add_fetch(&dump->done, 1, __ATOMIC_RELAXED);
+	if (done * 10 / dump->num != (done - 1) * 10 / dump->num)
+		TBM_LOG_I("Dump All.. %d/%d\n", done, dump->num);
+}
+
+int
+_tbm_surface_internal_dump_all(const char *path)
+{
+	tbm_dump_all dump;
+	uint64_t start, snapshot;
+	int i;
+
+	TBM_RETURN_VAL_IF_FAIL(path != NULL, 0);
+
+	memset(&dump, 0, sizeof(dump));
+	dump.path = path;
+
+	start = _tbm_dump_get_time_ns();
+
+	dump.surfaces = _tbm_surface_internal_get_surfaces(&dump.num);
+	if (!dump.surfaces) {
+		TBM_LOG_E("No tbm_surface.\n");
+		return 0;
+	}
+
+	snapshot = _tbm_dump_get_time_ns();
+
+	TBM_LOG_I("Dump All.. path:%s, count:%d, workers:%d\n",
+		  path, dump.num, _tbm_worker_get_count());
+
+	_tbm_worker_run(_tbm_dump_all_func, &dump, dump.num);
+
+	for (i = 0; i < dump.num; i++)
+		tbm_surface_internal_unref(dump.surfaces[i]);
+	free(dump.surfaces);
+
+	TBM_LOG_I("Dump All End.. written:%d/%d snapshot:%.3fms copy:%.3fms encode:%.3fms total:%.3fms\n",
+		  dump.written, dump.num, (snapshot - start) / 1000000.0,
+		  dump.copy_ns / 1000000.0, dump.encode_ns / 1000000.0,
+		  (_tbm_dump_get_time_ns() - start) / 1000000.0);
+
+	return 1;
+}
@@ -0,0 +1,477 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#include "config.h"
+
+#include <stdint.h>
+#include "tbm_bufmgr_int.h"
+
+#ifdef TBM_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef TBM_SIMD_AVX2
+#include <immintrin.h>
+#endif
+#ifdef TBM_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+/* fills bigger than this don't fit in the cache, the non-temporal stores
+ * don't evict it for nothing
+ */
+#define TBM_FILL_STREAM_SIZE	(2 * 1024 * 1024)
+
+/* The pixels of a plane repeat every 1, 2, 3 or 4 bytes, so a row is
+ * filled with a pattern of 48 bytes, 3 vectors of 16 bytes or 3 vectors
+ * of 32 bytes for 2 patterns. The pattern is repeated in the buffer so
+ * it can be read from any offset.
+ */
+#define TBM_FILL_PERIOD		48
+
+typedef struct {
+	uint8_t pattern[TBM_FILL_PERIOD * 4];
+	uint8_t *dst;
+	uint32_t stride;
+	uint32_t bytes;		/* bytes of a row */
+	uint32_t rows;
+	int stream;			/* use non-temporal stores */
+} tbm_fill_plane;
+
+typedef void (*tbm_fill_row_func)(uint8_t *dst, const uint8_t *pattern, uint32_t size, int stream);
+
+typedef struct {
+	tbm_fill_plane planes[TBM_SURF_PLANE_MAX];
+	int num_planes;
+	int num_bands;
+	tbm_fill_row_func fill_row;
+} tbm_fill_job;
+
+static void
+_tbm_fill_row_c(uint8_t *dst, const uint8_t *pattern, uint32_t size, int stream)
+{
+	for (; size >= TBM_FILL_PERIOD; size -= TBM_FILL_PERIOD, dst += TBM_FILL_PERIOD)
+		memcpy(dst, pattern, TBM_FILL_PERIOD);
+
+	memcpy(dst, pattern, size);
+}
+
+#ifdef TBM_SIMD_SSE2
+static void
+_tbm_fill_row_sse2(uint8_t *dst, const uint8_t *pattern, uint32_t size, int stream)
+{
+	uint32_t head = (16 - ((uintptr_t)dst & 15)) & 15;
+	__m128i v0, v1, v2;
+
+	if (head > size)
+		head = size;
+
+	memcpy(dst, pattern, head);
+	dst += head;
+	size -= head;
+	pattern += head;
+
+	v0 = _mm_loadu_si128((const __m128i *)pattern);
+	v1 = _mm_loadu_si128((const __m128i *)(pattern + 16));
+	v2 = _mm_loadu_si128((const __m128i *)(pattern + 32));
+
+	if (stream) {
+		for (; size >= 48; size -= 48, dst += 48) {
+			_mm_stream_si128((__m128i *)dst, v0);
+			_mm_stream_si128((__m128i *)(dst + 16), v1);
+			_mm_stream_si128((__m128i *)(dst + 32), v2);
+		}
+	} else {
+		for (; size >= 48; size -= 48, dst += 48) {
+			_mm_store_si128((__m128i *)dst, v0);
+			_mm_store_si128((__m128i *)(dst + 16), v1);
+			_mm_store_si128((__m128i *)(dst + 32), v2);
+		}
+	}
+
+	memcpy(dst, pattern, size);
+}
+#endif
+
+#ifdef TBM_SIMD_AVX2
+static TBM_TARGET_AVX2 void
+_tbm_fill_row_avx2(uint8_t *dst, const uint8_t *pattern, uint32_t size, int stream)
+{
+	uint32_t head = (32 - ((uintptr_t)dst & 31)) & 31;
+	__m256i v0, v1, v2;
+
+	if (head > size)
+		head = size;
+
+	memcpy(dst, pattern, head);
+	dst += head;
+	size -= head;
+	pattern += head % TBM_FILL_PERIOD;
+
+	v0 = _mm256_loadu_si256((const __m256i *)pattern);
+	v1 = _mm256_loadu_si256((const __m256i *)(pattern + 32));
+	v2 = _mm256_loadu_si256((const __m256i *)(pattern + 64));
+
+	if (stream) {
+		for (; size >= 96; size -= 96, dst += 96) {
+			_mm256_stream_si256((__m256i *)dst, v0);
+			_mm256_stream_si256((__m256i *)(dst + 32), v1);
+			_mm256_stream_si256((__m256i *)(dst + 64), v2);
+		}
+	} else {
+		for (; size >= 96; size -= 96, dst += 96) {
+			_mm256_store_si256((__m256i *)dst, v0);
+			_mm256_store_si256((__m256i *)(dst + 32), v1);
+			_mm256_store_si256((__m256i *)(dst + 64), v2);
+		}
+	}
+
+	/* the pattern goes on from the same offset every 96 bytes */
+	for (; size >= TBM_FILL_PERIOD; size -= TBM_FILL_PERIOD, dst += TBM_FILL_PERIOD)
+		memcpy(dst, pattern, TBM_FILL_PERIOD);
+
+	memcpy(dst, pattern, size);
+}
+#endif
+
+#ifdef TBM_SIMD_NEON
+static void
+_tbm_fill_row_neon(uint8_t *dst, const uint8_t *pattern, uint32_t size, int stream)
+{
+	uint8x16_t v0 = vld1q_u8(pattern);
+	uint8x16_t v1 = vld1q_u8(pattern + 16);
+	uint8x16_t v2 = vld1q_u8(pattern + 32);
+
+	/* no non-temporal stores, the write buffers combine the full lines */
+	for (; size >= 48; size -= 48, dst += 48) {
+		vst1q_u8(dst, v0);
+		vst1q_u8(dst + 16, v1);
+		vst1q_u8(dst + 32, v2);
+	}
+
+	memcpy(dst, pattern, size);
+}
+#endif
+
+static tbm_fill_row_func
+_tbm_fill_get_func(void)
+{
+	unsigned int features = _tbm_cpu_get_features();
+
+#ifdef TBM_SIMD_AVX2
+	if (features & TBM_CPU_AVX2)
+		return _tbm_fill_row_avx2;
+#endif
+#ifdef TBM_SIMD_SSE2
+	if (features & TBM_CPU_SSE2)
+		return _tbm_fill_row_sse2;
+#endif
+#ifdef TBM_SIMD_NEON
+	if (features & TBM_CPU_NEON)
+		return _tbm_fill_row_neon;
+#endif
+
+	return _tbm_fill_row_c;
+}
+
+static void
+_tbm_fill_band(void *data, int idx)
+{
+	tbm_fill_job *job = data;
+	int i, streamed = 0;
+
+	for (i = 0; i < job->num_planes; i++) {
+		tbm_fill_plane *p = &job->planes[i];
+		uint32_t start = (uint64_t)p->rows * idx / job->num_bands;
+		uint32_t end = (uint64_t)p->rows * (idx + 1) / job->num_bands;
+		uint8_t *dst = p->dst + start * p->stride;
+		uint32_t row, size = p->bytes;
+
+		if (start == end)
+			continue;
+
+		/* the band is contiguous, the rows are whole periods of the pattern */
+		if (p->bytes == p->stride) {
+			size = p->bytes * (end - start);
+			end = start + 1;
+		}
+
+		for (row = start; row < end; row++, dst += p->stride)
+			job->fill_row(dst, p->pattern, size, p->stream);
+
+		streamed |= p->stream;
+	}
+
+#ifdef TBM_SIMD_SSE2
+	if (streamed)
+		_mm_sfence();
+#endif
+}
+
+static void
+_tbm_fill_rgb_to_yuv(uint32_t color, uint8_t *y, uint8_t *u, uint8_t *v)
+{
+	int r = (color >> 16) & 0xff, g = (color >> 8) & 0xff, b = color & 0xff;
+
+	/* BT.601 limited range */
+	*y = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+	*u = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+	*v = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+}
+
+static uint32_t
+_tbm_fill_to_10bit(uint32_t c)
+{
+	return (c << 2) | (c >> 6);
+}
+
+/* the bytes of one period of each plane, the number of planes or 0 */
+static int
+_tbm_fill_get_pixels(tbm_format format, uint32_t color, uint8_t pixels[][4], int *sizes)
+{
+	uint32_t a = color >> 24, r = (color >> 16) & 0xff, g = (color >> 8) & 0xff, b = color & 0xff;
+	uint32_t value;
+	uint8_t y, u, v;
+	int i;
+
+	_tbm_fill_rgb_to_yuv(color, &y, &u, &v);
+
+	switch (format) {
+	case TBM_FORMAT_ARGB8888:
+	case TBM_FORMAT_XRGB8888:
+		value = color;
+		break;
+	case TBM_FORMAT_ABGR8888:
+	case TBM_FORMAT_XBGR8888:
+		value = (a << 24) | (b << 16) | (g << 8) | r;
+		break;
+	case TBM_FORMAT_RGBA8888:
+	case TBM_FORMAT_RGBX8888:
+		value = (r << 24) | (g << 16) | (b << 8) | a;
+		break;
+	case TBM_FORMAT_BGRA8888:
+	case TBM_FORMAT_BGRX8888:
+		value = (b << 24) | (g << 16) | (r << 8) | a;
+		break;
+	case TBM_FORMAT_ARGB2101010:
+	case TBM_FORMAT_XRGB2101010:
+		value = ((a >> 6) << 30) | (_tbm_fill_to_10bit(r) << 20) |
+			(_tbm_fill_to_10bit(g) << 10) | _tbm_fill_to_10bit(b);
+		break;
+	case TBM_FORMAT_ABGR2101010:
+	case TBM_FORMAT_XBGR2101010:
+		value = ((a >> 6) << 30) | (_tbm_fill_to_10bit(b) << 20) |
+			(_tbm_fill_to_10bit(g) << 10) | _tbm_fill_to_10bit(r);
+		break;
+	case TBM_FORMAT_RGB565:
+		sizes[0] = 2;
+		value = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+		pixels[0][0] = value;
+		pixels[0][1] = value >> 8;
+		return 1;
+	case TBM_FORMAT_BGR565:
+		sizes[0] = 2;
+		value = ((b >> 3) << 11) | ((g >> 2) << 5) | (r >> 3);
+		pixels[0][0] = value;
+		pixels[0][1] = value >> 8;
+		return 1;
+	case TBM_FORMAT_RGB888:
+		sizes[0] = 3;
+		pixels[0][0] = b;
+		pixels[0][1] = g;
+		pixels[0][2] = r;
+		return 1;
+	case TBM_FORMAT_BGR888:
+		sizes[0] = 3;
+		pixels[0][0] = r;
+		pixels[0][1] = g;
+		pixels[0][2] = b;
+		return 1;
+	case TBM_FORMAT_YUYV:
+	case TBM_FORMAT_YVYU:
+	case TBM_FORMAT_UYVY:
+	case TBM_FORMAT_VYUY:
+		/* 2 pixels */
+		sizes[0] = 4;
+		if (format == TBM_FORMAT_YVYU || format == TBM_FORMAT_VYUY) {
+			uint8_t t = u;
+
+			u = v;
+			v = t;
+		}
+		if (format == TBM_FORMAT_YUYV || format == TBM_FORMAT_YVYU) {
+			pixels[0][0] = y;
+			pixels[0][1] = u;
+			pixels[0][2] = y;
+			pixels[0][3] = v;
+		} else {
+			pixels[0][0] = u;
+			pixels[0][1] = y;
+			pixels[0][2] = v;
+			pixels[0][3] = y;
+		}
+		return 1;
+	case TBM_FORMAT_NV12:
+	case TBM_FORMAT_NV21:
+	case TBM_FORMAT_NV16:
+	case TBM_FORMAT_NV61:
+		sizes[0] = 1;
+		sizes[1] = 2;
+		pixels[0][0] = y;
+		if (format == TBM_FORMAT_NV12 || format == TBM_FORMAT_NV16) {
+			pixels[1][0] = u;
+			pixels[1][1] = v;
+		} else {
+			pixels[1][0] = v;
+			pixels[1][1] = u;
+		}
+		return 2;
+	case TBM_FORMAT_YUV410:
+	case TBM_FORMAT_YUV411:
+	case TBM_FORMAT_YUV420:
+	case TBM_FORMAT_YUV422:
+	case TBM_FORMAT_YUV444:
+		sizes[0] = sizes[1] = sizes[2] = 1;
+		pixels[0][0] = y;
+		pixels[1][0] = u;
+		pixels[2][0] = v;
+		return 3;
+	case TBM_FORMAT_YVU410:
+	case TBM_FORMAT_YVU411:
+	case TBM_FORMAT_YVU420:
+	case TBM_FORMAT_YVU422:
+	case TBM_FORMAT_YVU444:
+		sizes[0] = sizes[1] = sizes[2] = 1;
+		pixels[0][0] = y;
+		pixels[1][0] = v;
+		pixels[2][0] = u;
+		return 3;
+	default:
+		return 0;
+	}
+
+	/* 32 bit little endian pixels */
+	sizes[0] = 4;
+	for (i = 0; i < 4; i++)
+		pixels[0][i] = value >> (i * 8);
+
+	return 1;
+}
+
+int
+tbm_surface_internal_fill(tbm_surface_h surface, tbm_surface_rect_s *rect, uint32_t color)
+{
+	const tbm_format_desc_s *desc;
+	tbm_surface_info_s info;
+	tbm_surface_rect_s r;
+	tbm_fill_job job;
+	uint8_t pixels[TBM_SURF_PLANE_MAX][4];
+	int sizes[TBM_SURF_PLANE_MAX];
+	uint64_t total = 0;
+	tbm_format format;
+	int i, j, num_planes;
+
+	TBM_RETURN_VAL_IF_FAIL(surface, 0);
+
+	format = tbm_surface_internal_get_format(surface);
+	desc = tbm_format_get_desc(format);
+	num_planes = _tbm_fill_get_pixels(format, color, pixels, sizes);
+	if (!desc || !num_planes) {
+		TBM_LOG_E("error: not supported format surface(%p)\n", surface);
+		return 0;
+	}
+
+	if (rect) {
+		r = *rect;
+	} else {
+		r.x = r.y = 0;
+		r.width = tbm_surface_internal_get_width(surface);
+		r.height = tbm_surface_internal_get_height(surface);
+	}
+
+	if (!_tbm_format_check_rect(desc, &r, tbm_surface_internal_get_width(surface),
+				    tbm_surface_internal_get_height(surface))) {
+		TBM_LOG_E("error: invalid rect(%d,%d %dx%d) surface(%p)\n",
+			  r.x, r.y, r.width, r.height, surface);
+		return 0;
+	}
+
+	if (_tbm_surface_internal_fill_by_backend(surface, &r, color)) {
+		_tbm_surface_internal_add_written_damage(surface, &r);
+		TBM_TRACE("surface(%p) rect(%d,%d %dx%d) color(0x%08x) by backend\n",
+			  surface, r.x, r.y, r.width, r.height, color);
+		return 1;
+	}
+
+	if (!tbm_surface_internal_get_info(surface, TBM_SURF_OPTION_WRITE, &info, 1)) {
+		TBM_LOG_E("error: fail to map surface(%p)\n", surface);
+		return 0;
+	}
+
+	memset(&job, 0, sizeof(job));
+	job.num_planes = num_planes;
+	job.fill_row = _tbm_fill_get_func();
+
+	for (i = 0; i < job.num_planes; i++) {
+		tbm_fill_plane *p = &job.planes[i];
+		tbm_surface_rect_s pr;
+
+		_tbm_format_plane_rect(desc, i, &r, &pr);
+
+		for (j = 0; j < (int)sizeof(p->pattern); j++)
+			p->pattern[j] = pixels[i][j % sizes[i]];
+
+		/* the pixels of packed YUV are the pairs, a pair is filled whole */
+		p->stride = info.planes[i].stride;
+		p->dst = info.planes[i].ptr + pr.y * p->stride + pr.x * desc->cpp[i];
+		p->bytes = (pr.width * desc->cpp[i] + sizes[i] - 1) / sizes[i] * sizes[i];
+		p->rows = pr.height;
+
+		total += (uint64_t)p->bytes * p->rows;
+	}
+
+	for (i = 0; i < job.num_planes; i++)
+		job.planes[i].stream = total >= TBM_FILL_STREAM_SIZE ||
+				       _tbm_surface_internal_plane_is_wc(surface, i);
+
+	job.num_bands = _tbm_worker_get_bands(total);
+
+	_tbm_worker_run(_tbm_fill_band, &job, job.num_bands);
+
+	tbm_surface_internal_unmap(surface);
+
+	_tbm_surface_internal_add_written_damage(surface, &r);
+
+	TBM_TRACE("surface(%p) rect(%d,%d %dx%d) color(0x%08x) bands(%d)\n",
+		  surface, r.x, r.y, r.width, r.height, color, job.num_bands);
+
+	return 1;
+}
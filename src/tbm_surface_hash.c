@@ -0,0 +1,663 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#include <stdint.h>
+#include "tbm_bufmgr_int.h"
+
+#ifdef TBM_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef TBM_SIMD_AVX2
+#include <immintrin.h>
+#endif
+#ifdef TBM_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+/* The hash is built like XXH3 of 64 bit: 8 lanes of 64 bits accumulate
+ * stripes of 64 bytes mixed with a secret, the lanes are scrambled every
+ * block of 16 stripes and folded into the result at the end. The rows
+ * are fed one after the other without the stride padding, the last
+ * stripe of a row is padded with zeros.
+ */
+#define TBM_HASH_STRIPE		64
+#define TBM_HASH_BLOCK		16		/* stripes of a block */
+#define TBM_HASH_LANES		8
+
+#define TBM_HASH_PRIME32_1	0x9E3779B1U
+#define TBM_HASH_PRIME64_1	0x9E3779B185EBCA87ULL
+#define TBM_HASH_PRIME64_2	0xC2B2AE3D27D4EB4FULL
+
+/* the incremental hash keeps the hash of every tile of 64x64 pixels */
+#define TBM_HASH_TILE_SIZE	64
+
+/* stripe n of a block uses the keys [n, n + 8), the scramble [16, 24) */
+static const uint64_t hash_secret[TBM_HASH_BLOCK + TBM_HASH_LANES] = {
+	0x579ee76114e7322eULL, 0xd2faaba86e33e052ULL, 0x1c2acadc47c2dec3ULL,
+	0xc4a0aec5a0cd951cULL, 0xc07a467fafd916aeULL, 0x4b1f5e5c29ef42a6ULL,
+	0x301350bd9c534310ULL, 0x55caf5c0bd645a7eULL, 0x1dcd89791ae62b36ULL,
+	0xfa9dfa8ce79fe0b8ULL, 0x8761664c2d8d325fULL, 0x6228bd0d0922398aULL,
+	0x49f696273023558fULL, 0x1f9ddaf08202af0fULL, 0x70c17b42bbb5270bULL,
+	0x352039e645e25d7dULL, 0x1e04b3ea597bf9fbULL, 0x838ffb53deb425a0ULL,
+	0xc09a38e44cc7354dULL, 0x23c3bb5751b6c6a4ULL, 0xd6c1ddf277a4609dULL,
+	0x6faaf368995aee53ULL, 0x9821a1360ad3d41dULL, 0xf97543756bb41399ULL,
+};
+
+typedef struct {
+	/* num stripes of data into acc, stripe n uses the keys from key + n */
+	void (*accumulate)(uint64_t *acc, const uint8_t *data, const uint64_t *key,
+			   uint32_t num);
+	void (*scramble)(uint64_t *acc, const uint64_t *key);
+} tbm_hash_kernels;
+
+typedef struct {
+	uint64_t acc[TBM_HASH_LANES];
+	uint32_t stripe;		/* stripes done in the current block */
+	uint64_t len;
+} tbm_hash_state;
+
+/* the tile hashes of a surface, kept in its user data */
+typedef struct {
+	tbm_format format;
+	uint32_t width;
+	uint32_t height;
+	int tiles_x;
+	int tiles_y;
+	uint64_t *hashes;
+	uint8_t *dirty;
+} tbm_hash_tiles;
+
+typedef struct {
+	const tbm_hash_kernels *k;
+	const tbm_format_desc_s *desc;
+	tbm_surface_info_s *info;
+	tbm_hash_tiles *tiles;
+	int num_bands;
+} tbm_hash_job;
+
+/* the address is the user data key of the tile hashes */
+static const char hash_tiles_key;
+#define TBM_HASH_TILES_KEY	((unsigned long)&hash_tiles_key)
+
+static inline uint64_t
+_tbm_hash_read64(const uint8_t *p)
+{
+	uint64_t v;
+
+	memcpy(&v, p, sizeof(v));
+
+	return v;
+}
+
+static void
+_tbm_hash_accumulate_c(uint64_t *acc, const uint8_t *data, const uint64_t *key, uint32_t num)
+{
+	uint32_t n;
+	int i;
+
+	for (n = 0; n < num; n++, data += TBM_HASH_STRIPE, key++) {
+		for (i = 0; i < TBM_HASH_LANES; i++) {
+			uint64_t v = _tbm_hash_read64(data + i * 8);
+			uint64_t k = v ^ key[i];
+
+			acc[i ^ 1] += v;
+			acc[i] += (k & 0xffffffff) * (k >> 32);
+		}
+	}
+}
+
+static void
+_tbm_hash_scramble_c(uint64_t *acc, const uint64_t *key)
+{
+	int i;
+
+	for (i = 0; i < TBM_HASH_LANES; i++) {
+		uint64_t a = acc[i];
+
+		a ^= a >> 47;
+		a ^= key[i];
+		acc[i] = a * TBM_HASH_PRIME32_1;
+	}
+}
+
+static const tbm_hash_kernels hash_kernels_c = {
+	_tbm_hash_accumulate_c,
+	_tbm_hash_scramble_c,
+};
+
+#ifdef TBM_SIMD_SSE2
+static void
+_tbm_hash_accumulate_sse2(uint64_t *acc, const uint8_t *data, const uint64_t *key, uint32_t num)
+{
+	__m128i a[4];
+	uint32_t n;
+	int j;
+
+	for (j = 0; j < 4; j++)
+		a[j] = _mm_loadu_si128((const __m128i *)(acc + j * 2));
+
+	for (n = 0; n < num; n++, data += TBM_HASH_STRIPE, key++) {
+		for (j = 0; j < 4; j++) {
+			__m128i v = _mm_loadu_si128((const __m128i *)(data + j * 16));
+			__m128i k = _mm_xor_si128(v, _mm_loadu_si128((const __m128i *)(key + j * 2)));
+			/* the high halves of the keyed lanes times their low halves */
+			__m128i p = _mm_mul_epu32(k, _mm_shuffle_epi32(k, _MM_SHUFFLE(0, 3, 0, 1)));
+
+			a[j] = _mm_add_epi64(a[j], _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+			a[j] = _mm_add_epi64(a[j], p);
+		}
+	}
+
+	for (j = 0; j < 4; j++)
+		_mm_storeu_si128((__m128i *)(acc + j * 2), a[j]);
+}
+
+static void
+_tbm_hash_scramble_sse2(uint64_t *acc, const uint64_t *key)
+{
+	const __m128i prime = _mm_set1_epi32(TBM_HASH_PRIME32_1);
+	int j;
+
+	for (j = 0; j < 4; j++) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(acc + j * 2));
+		__m128i lo, hi;
+
+		a = _mm_xor_si128(a, _mm_srli_epi64(a, 47));
+		a = _mm_xor_si128(a, _mm_loadu_si128((const __m128i *)(key + j * 2)));
+		lo = _mm_mul_epu32(a, prime);
+		hi = _mm_mul_epu32(_mm_srli_epi64(a, 32), prime);
+		_mm_storeu_si128((__m128i *)(acc + j * 2), _mm_add_epi64(lo, _mm_slli_epi64(hi, 32)));
+	}
+}
+
+static const tbm_hash_kernels hash_kernels_sse2 = {
+	_tbm_hash_accumulate_sse2,
+	_tbm_hash_scramble_sse2,
+};
+#endif
+
+#ifdef TBM_SIMD_AVX2
+static TBM_TARGET_AVX2 void
+_tbm_hash_accumulate_avx2(uint64_t *acc, const uint8_t *data, const uint64_t *key, uint32_t num)
+{
+	__m256i a0 = _mm256_loadu_si256((const __m256i *)acc);
+	__m256i a1 = _mm256_loadu_si256((const __m256i *)(acc + 4));
+	uint32_t n;
+
+	for (n = 0; n < num; n++, data += TBM_HASH_STRIPE, key++) {
+		__m256i v0 = _mm256_loadu_si256((const __m256i *)data);
+		__m256i v1 = _mm256_loadu_si256((const __m256i *)(data + 32));
+		__m256i k0 = _mm256_xor_si256(v0, _mm256_loadu_si256((const __m256i *)key));
+		__m256i k1 = _mm256_xor_si256(v1, _mm256_loadu_si256((const __m256i *)(key + 4)));
+
+		a0 = _mm256_add_epi64(a0, _mm256_shuffle_epi32(v0, _MM_SHUFFLE(1, 0, 3, 2)));
+		a1 = _mm256_add_epi64(a1, _mm256_shuffle_epi32(v1, _MM_SHUFFLE(1, 0, 3, 2)));
+		a0 = _mm256_add_epi64(a0, _mm256_mul_epu32(k0, _mm256_srli_epi64(k0, 32)));
+		a1 = _mm256_add_epi64(a1, _mm256_mul_epu32(k1, _mm256_srli_epi64(k1, 32)));
+	}
+
+	_mm256_storeu_si256((__m256i *)acc, a0);
+	_mm256_storeu_si256((__m256i *)(acc + 4), a1);
+}
+
+static TBM_TARGET_AVX2 void
+_tbm_hash_scramble_avx2(uint64_t *acc, const uint64_t *key)
+{
+	const __m256i prime = _mm256_set1_epi32(TBM_HASH_PRIME32_1);
+	int j;
+
+	for (j = 0; j < 2; j++) {
+		__m256i a = _mm256_loadu_si256((const __m256i *)(acc + j * 4));
+		__m256i lo, hi;
+
+		a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+		a = _mm256_xor_si256(a, _mm256_loadu_si256((const __m256i *)(key + j * 4)));
+		lo = _mm256_mul_epu32(a, prime);
+		hi = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), prime);
+		_mm256_storeu_si256((__m256i *)(acc + j * 4),
+				    _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32)));
+	}
+}
+
+static const tbm_hash_kernels hash_kernels_avx2 = {
+	_tbm_hash_accumulate_avx2,
+	_tbm_hash_scramble_avx2,
+};
+#endif
+
+#ifdef TBM_SIMD_NEON
+static void
+_tbm_hash_accumulate_neon(uint64_t *acc, const uint8_t *data, const uint64_t *key, uint32_t num)
+{
+	uint64x2_t a[4];
+	uint32_t n;
+	int j;
+
+	for (j = 0; j < 4; j++)
+		a[j] = vld1q_u64(acc + j * 2);
+
+	for (n = 0; n < num; n++, data += TBM_HASH_STRIPE, key++) {
+		for (j = 0; j < 4; j++) {
+			uint64x2_t v = vreinterpretq_u64_u8(vld1q_u8(data + j * 16));
+			uint64x2_t k = veorq_u64(v, vld1q_u64(key + j * 2));
+
+			a[j] = vaddq_u64(a[j], vextq_u64(v, v, 1));
+			a[j] = vmlal_u32(a[j], vmovn_u64(k), vshrn_n_u64(k, 32));
+		}
+	}
+
+	for (j = 0; j < 4; j++)
+		vst1q_u64(acc + j * 2, a[j]);
+}
+
+static void
+_tbm_hash_scramble_neon(uint64_t *acc, const uint64_t *key)
+{
+	const uint32x2_t prime = vdup_n_u32(TBM_HASH_PRIME32_1);
+	int j;
+
+	for (j = 0; j < 4; j++) {
+		uint64x2_t a = vld1q_u64(acc + j * 2);
+		uint64x2_t hi;
+
+		a = veorq_u64(a, vshrq_n_u64(a, 47));
+		a = veorq_u64(a, vld1q_u64(key + j * 2));
+		hi = vshlq_n_u64(vmull_u32(vshrn_n_u64(a, 32), prime), 32);
+		vst1q_u64(acc + j * 2, vmlal_u32(hi, vmovn_u64(a), prime));
+	}
+}
+
+static const tbm_hash_kernels hash_kernels_neon = {
+	_tbm_hash_accumulate_neon,
+	_tbm_hash_scramble_neon,
+};
+#endif
+
+static const tbm_hash_kernels *
+_tbm_hash_get_kernels(void)
+{
+	unsigned int features = _tbm_cpu_get_features();
+
+#ifdef TBM_SIMD_AVX2
+	if (features & TBM_CPU_AVX2)
+		return &hash_kernels_avx2;
+#endif
+#ifdef TBM_SIMD_SSE2
+	if (features & TBM_CPU_SSE2)
+		return &hash_kernels_sse2;
+#endif
+#ifdef TBM_SIMD_NEON
+	if (features & TBM_CPU_NEON)
+		return &hash_kernels_neon;
+#endif
+
+	(void)features;
+
+	return &hash_kernels_c;
+}
+
+static void
+_tbm_hash_init(tbm_hash_state *st)
+{
+	static const uint64_t init[TBM_HASH_LANES] = {
+		TBM_HASH_PRIME32_1, TBM_HASH_PRIME64_1, TBM_HASH_PRIME64_2, 0x165667B19E3779F9ULL,
+		0x85EBCA77C2B2AE63ULL, 0x85EBCA6BU, 0x27D4EB2F165667C5ULL, 0x61C8864FU,
+	};
+
+	memcpy(st->acc, init, sizeof(init));
+	st->stripe = 0;
+	st->len = 0;
+}
+
+static void
+_tbm_hash_stripes(const tbm_hash_kernels *k, tbm_hash_state *st, const uint8_t *data,
+		  uint32_t num)
+{
+	uint32_t n;
+
+	while (num) {
+		n = TBM_HASH_BLOCK - st->stripe;
+		if (n > num)
+			n = num;
+
+		k->accumulate(st->acc, data, hash_secret + st->stripe, n);
+		st->stripe += n;
+		data += n * TBM_HASH_STRIPE;
+		num -= n;
+
+		if (st->stripe == TBM_HASH_BLOCK) {
+			k->scramble(st->acc, hash_secret + TBM_HASH_BLOCK);
+			st->stripe = 0;
+		}
+	}
+}
+
+/* a row, the last stripe is padded with zeros */
+static void
+_tbm_hash_update(const tbm_hash_kernels *k, tbm_hash_state *st, const uint8_t *data,
+		 uint32_t size)
+{
+	uint8_t tail[TBM_HASH_STRIPE];
+	uint32_t rest = size % TBM_HASH_STRIPE;
+
+	st->len += size;
+
+	_tbm_hash_stripes(k, st, data, size / TBM_HASH_STRIPE);
+
+	if (rest) {
+		memset(tail, 0, sizeof(tail));
+		memcpy(tail, data + size - rest, rest);
+		_tbm_hash_stripes(k, st, tail, 1);
+	}
+}
+
+/* the low and high halves of the 128 bits product, xored */
+static uint64_t
+_tbm_hash_fold(uint64_t a, uint64_t b)
+{
+	uint64_t lo_lo = (a & 0xffffffff) * (b & 0xffffffff);
+	uint64_t hi_lo = (a >> 32) * (b & 0xffffffff);
+	uint64_t lo_hi = (a & 0xffffffff) * (b >> 32);
+	uint64_t hi_hi = (a >> 32) * (b >> 32);
+	uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+	uint64_t hi = hi_hi + (hi_lo >> 32) + (cross >> 32);
+	uint64_t lo = (cross << 32) | (lo_lo & 0xffffffff);
+
+	return lo ^ hi;
+}
+
+static uint64_t
+_tbm_hash_digest(tbm_hash_state *st, uint64_t seed)
+{
+	uint64_t h = st->len * TBM_HASH_PRIME64_1 ^ seed;
+	int i;
+
+	for (i = 0; i < TBM_HASH_LANES; i += 2)
+		h += _tbm_hash_fold(st->acc[i] ^ hash_secret[i + 3],
+				    st->acc[i + 1] ^ hash_secret[i + 4]);
+
+	h ^= h >> 37;
+	h *= 0x165667919E3779F9ULL;
+	h ^= h >> 32;
+
+	return h;
+}
+
+/* the rows of rect in every plane of info */
+static void
+_tbm_hash_rect(const tbm_hash_kernels *k, tbm_hash_state *st, const tbm_format_desc_s *desc,
+	       tbm_surface_info_s *info, tbm_surface_rect_s *r)
+{
+	int i, row;
+
+	for (i = 0; i < desc->num_planes; i++) {
+		tbm_surface_rect_s pr;
+		const uint8_t *src;
+
+		_tbm_format_plane_rect(desc, i, r, &pr);
+
+		src = info->planes[i].ptr + pr.y * info->planes[i].stride + pr.x * desc->cpp[i];
+		for (row = 0; row < pr.height; row++, src += info->planes[i].stride)
+			_tbm_hash_update(k, st, src, pr.width * desc->cpp[i]);
+	}
+}
+
+static uint64_t
+_tbm_hash_seed(const tbm_format_desc_s *desc, tbm_surface_rect_s *r)
+{
+	return ((uint64_t)desc->format << 32) ^ ((uint64_t)r->width << 16) ^ r->height;
+}
+
+int
+tbm_surface_internal_hash(tbm_surface_h surface, tbm_surface_rect_s *rect, uint64_t *hash)
+{
+	const tbm_format_desc_s *desc;
+	tbm_surface_info_s info;
+	tbm_hash_state st;
+	tbm_surface_rect_s r;
+	tbm_format format;
+	int width, height;
+
+	TBM_RETURN_VAL_IF_FAIL(surface, 0);
+	TBM_RETURN_VAL_IF_FAIL(hash, 0);
+
+	format = tbm_surface_internal_get_format(surface);
+	desc = tbm_format_get_desc(format);
+	if (!desc || format == TBM_FORMAT_NV12MT) {
+		TBM_LOG_E("error: not supported format surface(%p)\n", surface);
+		return 0;
+	}
+
+	width = tbm_surface_internal_get_width(surface);
+	height = tbm_surface_internal_get_height(surface);
+
+	if (rect) {
+		r = *rect;
+	} else {
+		r.x = r.y = 0;
+		r.width = width;
+		r.height = height;
+	}
+
+	if (!_tbm_format_check_rect(desc, &r, width, height)) {
+		TBM_LOG_E("error: invalid rect(%d,%d %dx%d) surface(%p)\n",
+			  r.x, r.y, r.width, r.height, surface);
+		return 0;
+	}
+
+	if (!tbm_surface_internal_get_info(surface, TBM_SURF_OPTION_READ, &info, 1)) {
+		TBM_LOG_E("error: fail to map surface(%p)\n", surface);
+		return 0;
+	}
+
+	_tbm_hash_init(&st);
+	_tbm_hash_rect(_tbm_hash_get_kernels(), &st, desc, &info, &r);
+	*hash = _tbm_hash_digest(&st, _tbm_hash_seed(desc, &r));
+
+	tbm_surface_internal_unmap(surface);
+
+	TBM_TRACE("surface(%p) rect(%d,%d %dx%d) hash(0x%016llx)\n", surface,
+		  r.x, r.y, r.width, r.height, (unsigned long long)*hash);
+
+	return 1;
+}
+
+static void
+_tbm_hash_tile_band(void *data, int idx)
+{
+	tbm_hash_job *job = data;
+	tbm_hash_tiles *tiles = job->tiles;
+	int start = (int64_t)tiles->tiles_y * idx / job->num_bands;
+	int end = (int64_t)tiles->tiles_y * (idx + 1) / job->num_bands;
+	tbm_hash_state st;
+	tbm_surface_rect_s r;
+	int tx, ty, t;
+
+	for (ty = start; ty < end; ty++) {
+		for (tx = 0; tx < tiles->tiles_x; tx++) {
+			t = ty * tiles->tiles_x + tx;
+			if (!tiles->dirty[t])
+				continue;
+
+			r.x = tx * TBM_HASH_TILE_SIZE;
+			r.y = ty * TBM_HASH_TILE_SIZE;
+			r.width = (int)tiles->width - r.x;
+			r.height = (int)tiles->height - r.y;
+			if (r.width > TBM_HASH_TILE_SIZE)
+				r.width = TBM_HASH_TILE_SIZE;
+			if (r.height > TBM_HASH_TILE_SIZE)
+				r.height = TBM_HASH_TILE_SIZE;
+
+			_tbm_hash_init(&st);
+			_tbm_hash_rect(job->k, &st, job->desc, job->info, &r);
+			tiles->hashes[t] = _tbm_hash_digest(&st, t);
+			tiles->dirty[t] = 0;
+		}
+	}
+}
+
+static tbm_hash_tiles *
+_tbm_hash_tiles_create(tbm_format format, uint32_t width, uint32_t height)
+{
+	int tiles_x = (width + TBM_HASH_TILE_SIZE - 1) / TBM_HASH_TILE_SIZE;
+	int tiles_y = (height + TBM_HASH_TILE_SIZE - 1) / TBM_HASH_TILE_SIZE;
+	int num = tiles_x * tiles_y;
+	tbm_hash_tiles *tiles;
+
+	tiles = calloc(1, sizeof(tbm_hash_tiles) + num * (sizeof(uint64_t) + 1));
+	if (!tiles)
+		return NULL;
+
+	tiles->format = format;
+	tiles->width = width;
+	tiles->height = height;
+	tiles->tiles_x = tiles_x;
+	tiles->tiles_y = tiles_y;
+	tiles->hashes = (uint64_t *)(tiles + 1);
+	tiles->dirty = (uint8_t *)(tiles->hashes + num);
+	memset(tiles->dirty, 1, num);
+
+	return tiles;
+}
+
+/* the tiles of the surface which need to be hashed again */
+static tbm_hash_tiles *
+_tbm_hash_get_tiles(tbm_surface_h surface, tbm_format format, uint32_t width, uint32_t height)
+{
+	tbm_surface_rect_s rects[TBM_SURFACE_DAMAGE_MAX];
+	tbm_hash_tiles *tiles = NULL;
+	int n, num, tx, ty;
+
+	if (!tbm_surface_internal_get_user_data(surface, TBM_HASH_TILES_KEY, (void **)&tiles)) {
+		if (!tbm_surface_internal_add_user_data(surface, TBM_HASH_TILES_KEY, free))
+			return NULL;
+	}
+
+	if (tiles && tiles->format == format && tiles->width == width && tiles->height == height) {
+		/* no damage, the whole surface is dirty */
+		if (!tbm_surface_internal_get_damage(surface, rects, &num) || !num) {
+			memset(tiles->dirty, 1, tiles->tiles_x * tiles->tiles_y);
+			return tiles;
+		}
+
+		for (n = 0; n < num; n++) {
+			for (ty = rects[n].y / TBM_HASH_TILE_SIZE;
+			     ty <= (rects[n].y + rects[n].height - 1) / TBM_HASH_TILE_SIZE; ty++)
+				for (tx = rects[n].x / TBM_HASH_TILE_SIZE;
+				     tx <= (rects[n].x + rects[n].width - 1) / TBM_HASH_TILE_SIZE; tx++)
+					tiles->dirty[ty * tiles->tiles_x + tx] = 1;
+		}
+
+		return tiles;
+	}
+
+	/* the first time or the surface changed */
+	tiles = _tbm_hash_tiles_create(format, width, height);
+	if (!tiles)
+		return NULL;
+
+	tbm_surface_internal_set_user_data(surface, TBM_HASH_TILES_KEY, tiles);
+
+	return tiles;
+}
+
+int
+tbm_surface_internal_hash_incremental(tbm_surface_h surface, uint64_t *hash)
+{
+	const tbm_format_desc_s *desc;
+	tbm_surface_info_s info;
+	tbm_hash_tiles *tiles;
+	tbm_hash_state st;
+	tbm_hash_job job;
+	uint64_t dirty_bytes = 0;
+	tbm_format format;
+	uint32_t width, height;
+	int t, num_tiles;
+
+	TBM_RETURN_VAL_IF_FAIL(surface, 0);
+	TBM_RETURN_VAL_IF_FAIL(hash, 0);
+
+	format = tbm_surface_internal_get_format(surface);
+	desc = tbm_format_get_desc(format);
+	if (!desc || format == TBM_FORMAT_NV12MT) {
+		TBM_LOG_E("error: not supported format surface(%p)\n", surface);
+		return 0;
+	}
+
+	width = tbm_surface_internal_get_width(surface);
+	height = tbm_surface_internal_get_height(surface);
+	if (!width || !height) {
+		TBM_LOG_E("error: empty surface(%p)\n", surface);
+		return 0;
+	}
+
+	tiles = _tbm_hash_get_tiles(surface, format, width, height);
+	if (!tiles) {
+		TBM_LOG_E("error: fail to get the tiles surface(%p)\n", surface);
+		return 0;
+	}
+
+	num_tiles = tiles->tiles_x * tiles->tiles_y;
+	for (t = 0; t < num_tiles; t++)
+		dirty_bytes += tiles->dirty[t];
+	dirty_bytes *= TBM_HASH_TILE_SIZE * TBM_HASH_TILE_SIZE * desc->bpp / 8;
+
+	if (dirty_bytes) {
+		if (!tbm_surface_internal_get_info(surface, TBM_SURF_OPTION_READ, &info, 1)) {
+			TBM_LOG_E("error: fail to map surface(%p)\n", surface);
+			return 0;
+		}
+
+		job.k = _tbm_hash_get_kernels();
+		job.desc = desc;
+		job.info = &info;
+		job.tiles = tiles;
+		job.num_bands = _tbm_worker_get_bands(dirty_bytes);
+		if (job.num_bands > tiles->tiles_y)
+			job.num_bands = tiles->tiles_y;
+
+		_tbm_worker_run(_tbm_hash_tile_band, &job, job.num_bands);
+
+		tbm_surface_internal_unmap(surface);
+	}
+
+	/* the hash of the tile hashes */
+	_tbm_hash_init(&st);
+	_tbm_hash_update(&hash_kernels_c, &st, (const uint8_t *)tiles->hashes,
+			 num_tiles * sizeof(uint64_t));
+	*hash = _tbm_hash_digest(&st, ((uint64_t)format << 32) ^ ((uint64_t)width << 16) ^ height);
+
+	TBM_TRACE("surface(%p) dirty(%llu bytes) hash(0x%016llx)\n", surface,
+		  (unsigned long long)dirty_bytes, (unsigned long long)*hash);
+
+	return 1;
+}
@@ -38,7 +38,6 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "tbm_bufmgr_int.h"
 #include "tbm_surface_internal.h"
 #include "list.h"
-#include <png.h>
 
 static tbm_bufmgr g_surface_bufmgr;
 static pthread_mutex_t tbm_surface_lock;
@@ -67,6 +66,167 @@ void _tbm_surface_mutex_unlock(void);
 	} \
 }
 
+#ifndef MIN
+#define MIN(x, y) (((x) < (y)) ? (x) : (y))
+#endif
+#ifndef MAX
+#define MAX(x, y) (((x) > (y)) ? (x) : (y))
+#endif
+
+/* format, bpp, num_planes, hsub, vsub, cpp of each plane, has_alpha, is_yuv */
+#define TBM_FORMAT_DESC(fmt, bpp, np, hs, vs, c0, c1, c2, a, y) \
+	{ fmt, #fmt, bpp, np, hs, vs, { c0, c1, c2, 0 }, a, y }
+
+static const tbm_format_desc_s tbm_format_descs[] = {
+	TBM_FORMAT_DESC(TBM_FORMAT_C8,          8, 1, 1, 1, 1, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_RGB332,      8, 1, 1, 1, 1, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_BGR233,      8, 1, 1, 1, 1, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_XRGB4444,   16, 1, 1, 1, 2, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_XBGR4444,   16, 1, 1, 1, 2, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_RGBX4444,   16, 1, 1, 1, 2, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_BGRX4444,   16, 1, 1, 1, 2, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_ARGB4444,   16, 1, 1, 1, 2, 0, 0, 1, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_ABGR4444,   16, 1, 1, 1, 2, 0, 0, 1, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_RGBA4444,   16, 1, 1, 1, 2, 0, 0, 1, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_BGRA4444,   16, 1, 1, 1, 2, 0, 0, 1, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_XRGB1555,   16, 1, 1, 1, 2, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_XBGR1555,   16, 1, 1, 1, 2, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_RGBX5551,   16, 1, 1, 1, 2, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_BGRX5551,   16, 1, 1, 1, 2, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_ARGB1555,   16, 1, 1, 1, 2, 0, 0, 1, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_ABGR1555,   16, 1, 1, 1, 2, 0, 0, 1, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_RGBA5551,   16, 1, 1, 1, 2, 0, 0, 1, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_BGRA5551,   16, 1, 1, 1, 2, 0, 0, 1, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_RGB565,     16, 1, 1, 1, 2, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_BGR565,     16, 1, 1, 1, 2, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_RGB888,     24, 1, 1, 1, 3, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_BGR888,     24, 1, 1, 1, 3, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_XRGB8888,   32, 1, 1, 1, 4, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_XBGR8888,   32, 1, 1, 1, 4, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_RGBX8888,   32, 1, 1, 1, 4, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_BGRX8888,   32, 1, 1, 1, 4, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_ARGB8888,   32, 1, 1, 1, 4, 0, 0, 1, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_ABGR8888,   32, 1, 1, 1, 4, 0, 0, 1, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_RGBA8888,   32, 1, 1, 1, 4, 0, 0, 1, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_BGRA8888,   32, 1, 1, 1, 4, 0, 0, 1, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_XRGB2101010, 32, 1, 1, 1, 4, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_XBGR2101010, 32, 1, 1, 1, 4, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_RGBX1010102, 32, 1, 1, 1, 4, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_BGRX1010102, 32, 1, 1, 1, 4, 0, 0, 0, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_ARGB2101010, 32, 1, 1, 1, 4, 0, 0, 1, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_ABGR2101010, 32, 1, 1, 1, 4, 0, 0, 1, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_RGBA1010102, 32, 1, 1, 1, 4, 0, 0, 1, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_BGRA1010102, 32, 1, 1, 1, 4, 0, 0, 1, 0),
+	TBM_FORMAT_DESC(TBM_FORMAT_YUYV,       32, 1, 2, 1, 2, 0, 0, 0, 1),
+	TBM_FORMAT_DESC(TBM_FORMAT_YVYU,       32, 1, 2, 1, 2, 0, 0, 0, 1),
+	TBM_FORMAT_DESC(TBM_FORMAT_UYVY,       32, 1, 2, 1, 2, 0, 0, 0, 1),
+	TBM_FORMAT_DESC(TBM_FORMAT_VYUY,       32, 1, 2, 1, 2, 0, 0, 0, 1),
+	TBM_FORMAT_DESC(TBM_FORMAT_AYUV,       32, 1, 1, 1, 4, 0, 0, 1, 1),
+	TBM_FORMAT_DESC(TBM_FORMAT_NV12,       12, 2, 2, 2, 1, 2, 0, 0, 1),
+	TBM_FORMAT_DESC(TBM_FORMAT_NV12MT,     12, 2, 2, 2, 1, 2, 0, 0, 1),
+	TBM_FORMAT_DESC(TBM_FORMAT_NV21,       12, 2, 2, 2, 1, 2, 0, 0, 1),
+	TBM_FORMAT_DESC(TBM_FORMAT_NV16,       16, 2, 2, 1, 1, 2, 0, 0, 1),
+	TBM_FORMAT_DESC(TBM_FORMAT_NV61,       16, 2, 2, 1, 1, 2, 0, 0, 1),
+	TBM_FORMAT_DESC(TBM_FORMAT_YUV410,      9, 3, 4, 4, 1, 1, 1, 0, 1),
+	TBM_FORMAT_DESC(TBM_FORMAT_YVU410,      9, 3, 4, 4, 1, 1, 1, 0, 1),
+	TBM_FORMAT_DESC(TBM_FORMAT_YUV411,     12, 3, 4, 1, 1, 1, 1, 0, 1),
+	TBM_FORMAT_DESC(TBM_FORMAT_YVU411,     12, 3, 4, 1, 1, 1, 1, 0, 1),
+	TBM_FORMAT_DESC(TBM_FORMAT_YUV420,     12, 3, 2, 2, 1, 1, 1, 0, 1),
+	TBM_FORMAT_DESC(TBM_FORMAT_YVU420,     12, 3, 2, 2, 1, 1, 1, 0, 1),
+	TBM_FORMAT_DESC(TBM_FORMAT_YUV422,     16, 3, 2, 1, 1, 1, 1, 0, 1),
+	TBM_FORMAT_DESC(TBM_FORMAT_YVU422,     16, 3, 2, 1, 1, 1, 1, 0, 1),
+	TBM_FORMAT_DESC(TBM_FORMAT_YUV444,     24, 3, 1, 1, 1, 1, 1, 0, 1),
+	TBM_FORMAT_DESC(TBM_FORMAT_YVU444,     24, 3, 1, 1, 1, 1, 1, 0, 1),
+};
+
+#define TBM_FORMAT_DESC_NUM	(sizeof(tbm_format_descs) / sizeof(tbm_format_descs[0]))
+
+/* the bufmgr has a bit for each of them in format_bits */
+typedef char tbm_format_bits_check[(TBM_FORMAT_DESC_NUM <= TBM_FORMAT_BITS_WORDS * 32) ? 1 : -1];
+
+/* The fourccs are spread over a 32bit space, so a multiplicative hash picks
+ * a slot in a 256 entry index. The multiplier was chosen to be collision free
+ * for the formats above; a format added later that collides is still found
+ * by the linear fallback in tbm_format_get_desc().
+ */
+#define TBM_FORMAT_DESC_HASH_BITS	8
+#define TBM_FORMAT_DESC_HASH(f)	(((uint32_t)(f) * 0xbe9f1893U) >> (32 - TBM_FORMAT_DESC_HASH_BITS))
+
+static unsigned char tbm_format_desc_index[1 << TBM_FORMAT_DESC_HASH_BITS];
+static int tbm_format_desc_collision;
+static pthread_once_t tbm_format_desc_once = PTHREAD_ONCE_INIT;
+
+static void
+_tbm_format_desc_init(void)
+{
+	unsigned int i, slot;
+
+	for (i = 0; i < TBM_FORMAT_DESC_NUM; i++) {
+		slot = TBM_FORMAT_DESC_HASH(tbm_format_descs[i].format);
+		if (tbm_format_desc_index[slot]) {
+			TBM_LOG_E("format hash collision: %s, %s\n", tbm_format_descs[i].name,
+				  tbm_format_descs[tbm_format_desc_index[slot] - 1].name);
+			tbm_format_desc_collision = 1;
+			continue;
+		}
+
+		/* 0 marks an empty slot */
+		tbm_format_desc_index[slot] = i + 1;
+	}
+}
+
+const tbm_format_desc_s *
+tbm_format_get_desc(tbm_format format)
+{
+	const tbm_format_desc_s *desc;
+	unsigned int i, idx;
+
+	pthread_once(&tbm_format_desc_once, _tbm_format_desc_init);
+
+	idx = tbm_format_desc_index[TBM_FORMAT_DESC_HASH(format)];
+	if (idx) {
+		desc = &tbm_format_descs[idx - 1];
+		if (desc->format == format)
+			return desc;
+	}
+
+	if (tbm_format_desc_collision) {
+		for (i = 0; i < TBM_FORMAT_DESC_NUM; i++)
+			if (tbm_format_descs[i].format == format)
+				return &tbm_format_descs[i];
+	}
+
+	return NULL;
+}
+
+/* rect is in a surface of width x height and starts on the chroma
+ * samples, so no chroma sample is cut in half
+ */
+int
+_tbm_format_check_rect(const tbm_format_desc_s *desc, const tbm_surface_rect_s *rect,
+		       int width, int height)
+{
+	return rect->x >= 0 && rect->y >= 0 && rect->width > 0 && rect->height > 0 &&
+	       !(rect->x % desc->hsub) && !(rect->y % desc->vsub) &&
+	       rect->x + rect->width <= width && rect->y + rect->height <= height;
+}
+
+/* rect in the samples of a plane. only the chroma planes of a planar
+ * format are subsampled and a partial sample at the end is included.
+ */
+void
+_tbm_format_plane_rect(const tbm_format_desc_s *desc, int plane_idx,
+		       const tbm_surface_rect_s *rect, tbm_surface_rect_s *plane_rect)
+{
+	int hsub = plane_idx ? desc->hsub : 1, vsub = plane_idx ? desc->vsub : 1;
+	int x = rect->x / hsub, y = rect->y / vsub;
+
+	plane_rect->width = (rect->x + rect->width + hsub - 1) / hsub - x;
+	plane_rect->height = (rect->y + rect->height + vsub - 1) / vsub - y;
+	plane_rect->x = x;
+	plane_rect->y = y;
+}
+
 /* LCOV_EXCL_START */
 
 static double
@@ -94,128 +254,12 @@ _tbm_surface_internal_debug_data_delete(tbm_surface_debug_data *debug_data)
 char *
 _tbm_surface_internal_format_to_str(tbm_format format)
 {
-	switch (format) {
-	case TBM_FORMAT_C8:
-		return "TBM_FORMAT_C8";
-	case TBM_FORMAT_RGB332:
-		return "TBM_FORMAT_RGB332";
-	case TBM_FORMAT_BGR233:
-		return "TBM_FORMAT_BGR233";
-	case TBM_FORMAT_XRGB4444:
-		return "TBM_FORMAT_XRGB4444";
-	case TBM_FORMAT_XBGR4444:
-		return "TBM_FORMAT_XBGR4444";
-	case TBM_FORMAT_RGBX4444:
-		return "TBM_FORMAT_RGBX4444";
-	case TBM_FORMAT_BGRX4444:
-		return "TBM_FORMAT_BGRX4444";
-	case TBM_FORMAT_ARGB4444:
-		return "TBM_FORMAT_ARGB4444";
-	case TBM_FORMAT_ABGR4444:
-		return "TBM_FORMAT_ABGR4444";
-	case TBM_FORMAT_RGBA4444:
-		return "TBM_FORMAT_RGBA4444";
-	case TBM_FORMAT_BGRA4444:
-		return "TBM_FORMAT_BGRA4444";
-	case TBM_FORMAT_XRGB1555:
-		return "TBM_FORMAT_XRGB1555";
-	case TBM_FORMAT_XBGR1555:
-		return "TBM_FORMAT_XBGR1555";
-	case TBM_FORMAT_RGBX5551:
-		return "TBM_FORMAT_RGBX5551";
-	case TBM_FORMAT_BGRX5551:
-		return "TBM_FORMAT_BGRX5551";
-	case TBM_FORMAT_ARGB1555:
-		return "TBM_FORMAT_ARGB1555";
-	case TBM_FORMAT_ABGR1555:
-		return "TBM_FORMAT_ABGR1555";
-	case TBM_FORMAT_RGBA5551:
-		return "TBM_FORMAT_RGBA5551";
-	case TBM_FORMAT_BGRA5551:
-		return "TBM_FORMAT_BGRA5551";
-	case TBM_FORMAT_RGB565:
-		return "TBM_FORMAT_RGB565";
-	case TBM_FORMAT_BGR565:
-		return "TBM_FORMAT_BGR565";
-	case TBM_FORMAT_RGB888:
-		return "TBM_FORMAT_RGB888";
-	case TBM_FORMAT_BGR888:
-		return "TBM_FORMAT_BGR888";
-	case TBM_FORMAT_XRGB8888:
-		return "TBM_FORMAT_XRGB8888";
-	case TBM_FORMAT_XBGR8888:
-		return "TBM_FORMAT_XBGR8888";
-	case TBM_FORMAT_RGBX8888:
-		return "TBM_FORMAT_RGBX8888";
-	case TBM_FORMAT_BGRX8888:
-		return "TBM_FORMAT_BGRX8888";
-	case TBM_FORMAT_ARGB8888:
-		return "TBM_FORMAT_ARGB8888";
-	case TBM_FORMAT_ABGR8888:
-		return "TBM_FORMAT_ABGR8888";
-	case TBM_FORMAT_RGBA8888:
-		return "TBM_FORMAT_RGBA8888";
-	case TBM_FORMAT_BGRA8888:
-		return "TBM_FORMAT_BGRA8888";
-	case TBM_FORMAT_XRGB2101010:
-		return "TBM_FORMAT_XRGB2101010";
-	case TBM_FORMAT_XBGR2101010:
-		return "TBM_FORMAT_XBGR2101010";
-	case TBM_FORMAT_RGBX1010102:
-		return "TBM_FORMAT_RGBX1010102";
-	case TBM_FORMAT_BGRX1010102:
-		return "TBM_FORMAT_BGRX1010102";
-	case TBM_FORMAT_ARGB2101010:
-		return "TBM_FORMAT_ARGB2101010";
-	case TBM_FORMAT_ABGR2101010:
-		return "TBM_FORMAT_ABGR2101010";
-	case TBM_FORMAT_RGBA1010102:
-		return "TBM_FORMAT_RGBA1010102";
-	case TBM_FORMAT_BGRA1010102:
-		return "TBM_FORMAT_BGRA1010102";
-	case TBM_FORMAT_YUYV:
-		return "TBM_FORMAT_YUYV";
-	case TBM_FORMAT_YVYU:
-		return "TBM_FORMAT_YVYU";
-	case TBM_FORMAT_UYVY:
-		return "TBM_FORMAT_UYVY";
-	case TBM_FORMAT_VYUY:
-		return "TBM_FORMAT_VYUY";
-	case TBM_FORMAT_AYUV:
-		return "TBM_FORMAT_AYUV";
-	case TBM_FORMAT_NV12:
-		return "TBM_FORMAT_NV12";
-	case TBM_FORMAT_NV21:
-		return "TBM_FORMAT_NV21";
-	case TBM_FORMAT_NV16:
-		return "TBM_FORMAT_NV16";
-	case TBM_FORMAT_NV61:
-		return "TBM_FORMAT_NV61";
-	case TBM_FORMAT_YUV410:
-		return "TBM_FORMAT_YUV410";
-	case TBM_FORMAT_YVU410:
-		return "TBM_FORMAT_YVU410";
-	case TBM_FORMAT_YUV411:
-		return "TBM_FORMAT_YUV411";
-	case TBM_FORMAT_YVU411:
-		return "TBM_FORMAT_YVU411";
-	case TBM_FORMAT_YUV420:
-		return "TBM_FORMAT_YUV420";
-	case TBM_FORMAT_YVU420:
-		return "TBM_FORMAT_YVU420";
-	case TBM_FORMAT_YUV422:
-		return "TBM_FORMAT_YUV422";
-	case TBM_FORMAT_YVU422:
-		return "TBM_FORMAT_YVU422";
-	case TBM_FORMAT_YUV444:
-		return "TBM_FORMAT_YUV444";
-	case TBM_FORMAT_YVU444:
-		return "TBM_FORMAT_YVU444";
-	case TBM_FORMAT_NV12MT:
-		return "TBM_FORMAT_NV12MT";
-	default:
+	const tbm_format_desc_s *desc = tbm_format_get_desc(format);
+
+	if (!desc)
 		return "unknwon";
-	}
+
+	return (char *)desc->name;
 }
 /* LCOV_EXCL_STOP */
 
@@ -292,40 +336,231 @@ _tbm_surface_internal_is_valid(tbm_surface_h surface)
 	return 0;
 }
 
+/* The geometry of a surface never changes after creation, so a copy of it
+ * is published in a table keyed by the handle while the surface is in
+ * surf_list. The getters look the handle up by its value and read the copy
+ * without the surface lock, the memory of the handle is never touched, so a
+ * stale or destroyed handle is simply not found. The table is written under
+ * the surface lock and each slot is a seqlock, a reader which races with a
+ * writer, misses the handle or finds the table full takes the validated path.
+ */
+#define TBM_SURFACE_GEOMETRY_SIZE	512
+#define TBM_SURFACE_GEOMETRY_PROBE	8
+#define TBM_SURFACE_GEOMETRY_REMOVED	((tbm_surface_h)1)
+
+typedef struct {
+	unsigned int seq;			/* odd while the slot is written */
+	tbm_surface_h surface;			/* NULL if the slot was never used */
+	unsigned int width;
+	unsigned int height;
+	tbm_format format;
+	int num_bos;
+	int planes_bo_idx[TBM_SURF_PLANE_MAX];
+} tbm_surface_geometry;
+
+static tbm_surface_geometry g_surface_geometry[TBM_SURFACE_GEOMETRY_SIZE];
+
+static inline unsigned int
+_tbm_surface_internal_geometry_hash(tbm_surface_h surface)
+{
+	uintptr_t key = (uintptr_t)surface >> 4;
+
+	return (unsigned int)(key * 0x9E3779B1u) % TBM_SURFACE_GEOMETRY_SIZE;
+}
+
+static void
+_tbm_surface_internal_geometry_write(tbm_surface_geometry *g, tbm_surface_h surface,
+				     struct _tbm_surface *surf)
+{
+	unsigned int seq = __atomic_load_n(&g->seq, __ATOMIC_RELAXED);
+	int i;
+
+	__atomic_store_n(&g->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	__atomic_store_n(&g->surface, surface, __ATOMIC_RELAXED);
+	if (surf) {
+		__atomic_store_n(&g->width, surf->info.width, __ATOMIC_RELAXED);
+		__atomic_store_n(&g->height, surf->info.height, __ATOMIC_RELAXED);
+		__atomic_store_n(&g->format, surf->info.format, __ATOMIC_RELAXED);
+		__atomic_store_n(&g->num_bos, surf->num_bos, __ATOMIC_RELAXED);
+		for (i = 0; i < TBM_SURF_PLANE_MAX; i++)
+			__atomic_store_n(&g->planes_bo_idx[i], surf->planes_bo_idx[i], __ATOMIC_RELAXED);
+	}
+
+	__atomic_store_n(&g->seq, seq + 2, __ATOMIC_RELEASE);
+}
+
+/* called with the surface lock once surf is in surf_list */
+static void
+_tbm_surface_internal_geometry_add(struct _tbm_surface *surf)
+{
+	unsigned int h = _tbm_surface_internal_geometry_hash(surf);
+	tbm_surface_geometry *g;
+	int i;
+
+	for (i = 0; i < TBM_SURFACE_GEOMETRY_PROBE; i++) {
+		g = &g_surface_geometry[(h + i) % TBM_SURFACE_GEOMETRY_SIZE];
+		if (!g->surface || g->surface == TBM_SURFACE_GEOMETRY_REMOVED) {
+			_tbm_surface_internal_geometry_write(g, surf, surf);
+			return;
+		}
+	}
+
+	/* the getters of surf take the validated path */
+}
+
+/* called with the surface lock before surf is unlinked and freed */
+static void
+_tbm_surface_internal_geometry_remove(struct _tbm_surface *surf)
+{
+	unsigned int h = _tbm_surface_internal_geometry_hash(surf);
+	tbm_surface_geometry *g;
+	int i;
+
+	for (i = 0; i < TBM_SURFACE_GEOMETRY_PROBE; i++) {
+		g = &g_surface_geometry[(h + i) % TBM_SURFACE_GEOMETRY_SIZE];
+		if (!g->surface)
+			return;
+		if (g->surface == surf) {
+			_tbm_surface_internal_geometry_write(g, TBM_SURFACE_GEOMETRY_REMOVED, NULL);
+			return;
+		}
+	}
+}
+
+/* 1 with the geometry of surface if it is published and was read whole */
 static int
-_tbm_surface_internal_query_plane_data(tbm_surface_h surface,
-				       int plane_idx, uint32_t *size, uint32_t *offset, uint32_t *pitch, int *bo_idx)
+_tbm_surface_internal_get_immutable(tbm_surface_h surface, tbm_surface_geometry *geom)
 {
-	TBM_RETURN_VAL_IF_FAIL(surface, 0);
-	TBM_RETURN_VAL_IF_FAIL(plane_idx > -1, 0);
+	unsigned int h, seq;
+	tbm_surface_geometry *g;
+	tbm_surface_h key;
+	int i, j;
 
-	struct _tbm_surface *surf = (struct _tbm_surface *)surface;
-	struct _tbm_bufmgr *mgr = surf->bufmgr;
-	int ret = 0;
+	if (!surface)
+		return 0;
+
+	h = _tbm_surface_internal_geometry_hash(surface);
+
+	for (i = 0; i < TBM_SURFACE_GEOMETRY_PROBE; i++) {
+		g = &g_surface_geometry[(h + i) % TBM_SURFACE_GEOMETRY_SIZE];
+
+		seq = __atomic_load_n(&g->seq, __ATOMIC_ACQUIRE);
+		key = __atomic_load_n(&g->surface, __ATOMIC_RELAXED);
+		if (!key)
+			return 0;
+		if (key != surface)
+			continue;
+		if (seq & 1)
+			return 0;
+
+		geom->width = __atomic_load_n(&g->width, __ATOMIC_RELAXED);
+		geom->height = __atomic_load_n(&g->height, __ATOMIC_RELAXED);
+		geom->format = __atomic_load_n(&g->format, __ATOMIC_RELAXED);
+		geom->num_bos = __atomic_load_n(&g->num_bos, __ATOMIC_RELAXED);
+		for (j = 0; j < TBM_SURF_PLANE_MAX; j++)
+			geom->planes_bo_idx[j] = __atomic_load_n(&g->planes_bo_idx[j], __ATOMIC_RELAXED);
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+		return __atomic_load_n(&g->seq, __ATOMIC_RELAXED) == seq;
+	}
+
+	return 0;
+}
+
+/* the planes of a surface from the backend, in one call of its
+ * surface_get_layout or a call of surface_get_plane_data for each plane.
+ */
+static int
+_tbm_surface_internal_query_planes(struct _tbm_bufmgr *mgr, int width, int height,
+				   tbm_format format, int num_planes,
+				   tbm_surface_plane_s *planes, int *bo_idx)
+{
+	tbm_surface_layout_s layout;
+	int i;
 
-	TBM_RETURN_VAL_IF_FAIL(mgr != NULL, 0);
-	TBM_RETURN_VAL_IF_FAIL(surf->info.width > 0, 0);
-	TBM_RETURN_VAL_IF_FAIL(surf->info.height > 0, 0);
-	TBM_RETURN_VAL_IF_FAIL(surf->info.format > 0, 0);
+	TBM_RETURN_VAL_IF_FAIL(num_planes <= TBM_SURF_PLANE_MAX, 0);
+
+	if (mgr->backend->surface_get_layout) {
+		memset(&layout, 0, sizeof(layout));
+
+		if (!mgr->backend->surface_get_layout(width, height, format, &layout)) {
+			TBM_LOG_E("Fail to surface_get_layout. format(%s)\n",
+				  _tbm_surface_internal_format_to_str(format));
+			return 0;
+		}
+
+		for (i = 0; i < num_planes; i++) {
+			planes[i].size = layout.size[i];
+			planes[i].offset = layout.offset[i];
+			planes[i].stride = layout.pitch[i];
+			bo_idx[i] = layout.bo_idx[i];
+		}
+
+		return 1;
+	}
 
 	if (!mgr->backend->surface_get_plane_data)
 		return 0;
 
-	ret = mgr->backend->surface_get_plane_data(surf->info.width,
-			surf->info.height, surf->info.format, plane_idx, size, offset, pitch, bo_idx);
-	if (!ret) {
-		TBM_LOG_E("Fail to surface_get_plane_data. surface(%p)\n", surface);
-		return 0;
+	for (i = 0; i < num_planes; i++) {
+		if (!mgr->backend->surface_get_plane_data(width, height, format, i,
+							  &planes[i].size, &planes[i].offset,
+							  &planes[i].stride, &bo_idx[i])) {
+			TBM_LOG_E("Fail to surface_get_plane_data. format(%s)\n",
+				  _tbm_surface_internal_format_to_str(format));
+			return 0;
+		}
 	}
 
 	return 1;
 }
 
+/* the layout of the backend for a surface which is not created yet. returns
+ * the number of bos the planes are spread over, 0 on failure.
+ */
+int
+_tbm_surface_internal_get_layout(tbm_bufmgr bufmgr, int width, int height, int format,
+				 tbm_surface_info_s *info)
+{
+	int bo_idx[TBM_SURF_PLANE_MAX];
+	int num_bos = 0, i;
+
+	TBM_RETURN_VAL_IF_FAIL(bufmgr, 0);
+	TBM_RETURN_VAL_IF_FAIL(info, 0);
+
+	memset(info, 0, sizeof(tbm_surface_info_s));
+	info->width = width;
+	info->height = height;
+	info->format = format;
+	info->bpp = tbm_surface_internal_get_bpp(format);
+	info->num_planes = tbm_surface_internal_get_num_planes(format);
+	if (!info->num_planes)
+		return 0;
+
+	if (!_tbm_surface_internal_query_planes(bufmgr, width, height, format,
+						info->num_planes, info->planes, bo_idx))
+		return 0;
+
+	for (i = 0; i < (int)info->num_planes; i++) {
+		if (bo_idx[i] == 0 && info->size < info->planes[i].offset + info->planes[i].size)
+			info->size = info->planes[i].offset + info->planes[i].size;
+
+		if (num_bos < bo_idx[i] + 1)
+			num_bos = bo_idx[i] + 1;
+	}
+
+	return num_bos;
+}
+
 static void
 _tbm_surface_internal_destroy(tbm_surface_h surface)
 {
 	int i;
 	tbm_bufmgr bufmgr = surface->bufmgr;
+	tbm_surface_h parent = surface->parent;
 	tbm_user_data *old_data = NULL, *tmp = NULL;
 	tbm_surface_debug_data *debug_old_data = NULL, *debug_tmp = NULL;
 
@@ -338,7 +573,9 @@ _tbm_surface_internal_destroy(tbm_surface_h surface)
 	}
 
 	for (i = 0; i < surface->num_bos; i++) {
-		surface->bos[i]->surface = NULL;
+		/* the bos of a view stay with the parent */
+		if (surface->bos[i]->surface == surface)
+			surface->bos[i]->surface = NULL;
 
 		tbm_bo_unref(surface->bos[i]);
 		surface->bos[i] = NULL;
@@ -349,6 +586,7 @@ _tbm_surface_internal_destroy(tbm_surface_h surface)
 			_tbm_surface_internal_debug_data_delete(debug_old_data);
 	}
 
+	_tbm_surface_internal_geometry_remove(surface);
 	LIST_DEL(&surface->item_link);
 
 	free(surface);
@@ -365,6 +603,10 @@ _tbm_surface_internal_destroy(tbm_surface_h surface)
 
 		_deinit_surface_bufmgr();
 	}
+
+	/* the parent is in surf_list until here */
+	if (parent && --parent->refcnt == 0)
+		_tbm_surface_internal_destroy(parent);
 }
 
 int
@@ -387,44 +629,107 @@ tbm_surface_internal_is_valid(tbm_surface_h surface)
 	return ret;
 }
 
-int
-tbm_surface_internal_query_supported_formats(uint32_t **formats,
-		uint32_t *num)
+/* caches the formats of the backend in the bufmgr with a bit for each
+ * known format. must be called with the surface lock.
+ */
+static int
+_tbm_surface_internal_cache_formats(struct _tbm_bufmgr *mgr)
 {
-	struct _tbm_bufmgr *mgr;
-	int ret = 0;
-	bool bufmgr_initialized = false;
+	const tbm_format_desc_s *desc;
+	uint32_t *formats = NULL;
+	uint32_t num = 0, i, idx;
 
-	_tbm_surface_mutex_lock();
+	if (mgr->formats)
+		return 1;
+
+	if (!mgr->backend->surface_supported_format)
+		return 0;
+
+	if (!mgr->backend->surface_supported_format(&formats, &num)) {
+		TBM_LOG_E("Fail to surface_supported_format.\n");
+		return 0;
+	}
+
+	memset(mgr->format_bits, 0, sizeof(mgr->format_bits));
+
+	for (i = 0; i < num; i++) {
+		desc = tbm_format_get_desc(formats[i]);
+		if (!desc)
+			continue;
+
+		idx = desc - tbm_format_descs;
+		mgr->format_bits[idx / 32] |= 1U << (idx % 32);
+	}
+
+	mgr->formats = formats;
+	mgr->num_formats = num;
+
+	TBM_TRACE("tbm_bufmgr(%p) format num(%u)\n", mgr, num);
+
+	return 1;
+}
+
+/* the bufmgr with the cached formats. must be called with the surface lock,
+ * a bufmgr initialized here is kept like the one of the surfaces.
+ */
+static struct _tbm_bufmgr *
+_tbm_surface_internal_get_format_bufmgr(void)
+{
+	bool bufmgr_initialized = false;
 
 	if (!g_surface_bufmgr) {
 		_init_surface_bufmgr();
+		if (!g_surface_bufmgr)
+			return NULL;
+
 		LIST_INITHEAD(&g_surface_bufmgr->surf_list);
 		bufmgr_initialized = true;
 	}
 
-	mgr = g_surface_bufmgr;
+	if (!_tbm_surface_internal_cache_formats(g_surface_bufmgr)) {
+		if (bufmgr_initialized) {
+			LIST_DELINIT(&g_surface_bufmgr->surf_list);
+			_deinit_surface_bufmgr();
+		}
 
-	if (!mgr->backend->surface_supported_format)
+		return NULL;
+	}
+
+	return g_surface_bufmgr;
+}
+
+int
+tbm_surface_internal_query_supported_formats(uint32_t **formats,
+		uint32_t *num)
+{
+	struct _tbm_bufmgr *mgr;
+
+	TBM_RETURN_VAL_IF_FAIL(formats, 0);
+	TBM_RETURN_VAL_IF_FAIL(num, 0);
+
+	_tbm_surface_mutex_lock();
+
+	mgr = _tbm_surface_internal_get_format_bufmgr();
+	if (!mgr)
 		goto fail;
 
-	ret = mgr->backend->surface_supported_format(formats, num);
-	if (!ret)  {
-		TBM_LOG_E("Fail to surface_supported_format.\n");
+	/* the caller frees the array as the one of the backend */
+	*formats = calloc(mgr->num_formats ? mgr->num_formats : 1, sizeof(uint32_t));
+	if (!*formats) {
+		TBM_LOG_E("fail to alloc the formats\n");
 		goto fail;
 	}
 
-	TBM_TRACE("tbm_bufmgr(%p) format num(%u)\n", g_surface_bufmgr, *num);
+	memcpy(*formats, mgr->formats, mgr->num_formats * sizeof(uint32_t));
+	*num = mgr->num_formats;
+
+	TBM_TRACE("tbm_bufmgr(%p) format num(%u)\n", mgr, *num);
 
 	_tbm_surface_mutex_unlock();
 
-	return ret;
+	return 1;
 
 fail:
-	if (bufmgr_initialized) {
-		LIST_DELINIT(&g_surface_bufmgr->surf_list);
-		_deinit_surface_bufmgr();
-	}
 	_tbm_surface_mutex_unlock();
 
 	TBM_LOG_E("error: tbm_bufmgr(%p)\n", g_surface_bufmgr);
@@ -433,238 +738,112 @@ fail:
 }
 
 int
-tbm_surface_internal_get_num_planes(tbm_format format)
+tbm_surface_internal_get_supported_formats(uint32_t *formats, uint32_t size, uint32_t *num)
 {
-	int num_planes = 0;
+	struct _tbm_bufmgr *mgr;
 
-	switch (format) {
-	case TBM_FORMAT_C8:
-	case TBM_FORMAT_RGB332:
-	case TBM_FORMAT_BGR233:
-	case TBM_FORMAT_XRGB4444:
-	case TBM_FORMAT_XBGR4444:
-	case TBM_FORMAT_RGBX4444:
-	case TBM_FORMAT_BGRX4444:
-	case TBM_FORMAT_ARGB4444:
-	case TBM_FORMAT_ABGR4444:
-	case TBM_FORMAT_RGBA4444:
-	case TBM_FORMAT_BGRA4444:
-	case TBM_FORMAT_XRGB1555:
-	case TBM_FORMAT_XBGR1555:
-	case TBM_FORMAT_RGBX5551:
-	case TBM_FORMAT_BGRX5551:
-	case TBM_FORMAT_ARGB1555:
-	case TBM_FORMAT_ABGR1555:
-	case TBM_FORMAT_RGBA5551:
-	case TBM_FORMAT_BGRA5551:
-	case TBM_FORMAT_RGB565:
-	case TBM_FORMAT_BGR565:
-	case TBM_FORMAT_RGB888:
-	case TBM_FORMAT_BGR888:
-	case TBM_FORMAT_XRGB8888:
-	case TBM_FORMAT_XBGR8888:
-	case TBM_FORMAT_RGBX8888:
-	case TBM_FORMAT_BGRX8888:
-	case TBM_FORMAT_ARGB8888:
-	case TBM_FORMAT_ABGR8888:
-	case TBM_FORMAT_RGBA8888:
-	case TBM_FORMAT_BGRA8888:
-	case TBM_FORMAT_XRGB2101010:
-	case TBM_FORMAT_XBGR2101010:
-	case TBM_FORMAT_RGBX1010102:
-	case TBM_FORMAT_BGRX1010102:
-	case TBM_FORMAT_ARGB2101010:
-	case TBM_FORMAT_ABGR2101010:
-	case TBM_FORMAT_RGBA1010102:
-	case TBM_FORMAT_BGRA1010102:
-	case TBM_FORMAT_YUYV:
-	case TBM_FORMAT_YVYU:
-	case TBM_FORMAT_UYVY:
-	case TBM_FORMAT_VYUY:
-	case TBM_FORMAT_AYUV:
-		num_planes = 1;
-		break;
-	case TBM_FORMAT_NV12:
-	case TBM_FORMAT_NV12MT:
-	case TBM_FORMAT_NV21:
-	case TBM_FORMAT_NV16:
-	case TBM_FORMAT_NV61:
-		num_planes = 2;
-		break;
-	case TBM_FORMAT_YUV410:
-	case TBM_FORMAT_YVU410:
-	case TBM_FORMAT_YUV411:
-	case TBM_FORMAT_YVU411:
-	case TBM_FORMAT_YUV420:
-	case TBM_FORMAT_YVU420:
-	case TBM_FORMAT_YUV422:
-	case TBM_FORMAT_YVU422:
-	case TBM_FORMAT_YUV444:
-	case TBM_FORMAT_YVU444:
-		num_planes = 3;
-		break;
-
-	default:
-		break;
+	TBM_RETURN_VAL_IF_FAIL(num, 0);
+
+	_tbm_surface_mutex_lock();
+
+	mgr = _tbm_surface_internal_get_format_bufmgr();
+	if (!mgr) {
+		_tbm_surface_mutex_unlock();
+		TBM_LOG_E("error: tbm_bufmgr(%p)\n", g_surface_bufmgr);
+		return 0;
 	}
 
-	TBM_TRACE("tbm_format(%s) num_planes(%d)\n", _tbm_surface_internal_format_to_str(format), num_planes);
+	if (formats)
+		memcpy(formats, mgr->formats, MIN(size, mgr->num_formats) * sizeof(uint32_t));
+	*num = mgr->num_formats;
 
-	return num_planes;
+	TBM_TRACE("tbm_bufmgr(%p) format num(%u) size(%u)\n", mgr, *num, size);
+
+	_tbm_surface_mutex_unlock();
+
+	return 1;
 }
 
 int
-tbm_surface_internal_get_bpp(tbm_format format)
+tbm_surface_internal_is_format_supported(tbm_format format)
 {
+	const tbm_format_desc_s *desc;
+	struct _tbm_bufmgr *mgr;
+	uint32_t i, idx;
+	int ret = 0;
 
-	int bpp = 0;
+	_tbm_surface_mutex_lock();
 
-	switch (format) {
-	case TBM_FORMAT_C8:
-	case TBM_FORMAT_RGB332:
-	case TBM_FORMAT_BGR233:
-		bpp = 8;
-		break;
-	case TBM_FORMAT_XRGB4444:
-	case TBM_FORMAT_XBGR4444:
-	case TBM_FORMAT_RGBX4444:
-	case TBM_FORMAT_BGRX4444:
-	case TBM_FORMAT_ARGB4444:
-	case TBM_FORMAT_ABGR4444:
-	case TBM_FORMAT_RGBA4444:
-	case TBM_FORMAT_BGRA4444:
-	case TBM_FORMAT_XRGB1555:
-	case TBM_FORMAT_XBGR1555:
-	case TBM_FORMAT_RGBX5551:
-	case TBM_FORMAT_BGRX5551:
-	case TBM_FORMAT_ARGB1555:
-	case TBM_FORMAT_ABGR1555:
-	case TBM_FORMAT_RGBA5551:
-	case TBM_FORMAT_BGRA5551:
-	case TBM_FORMAT_RGB565:
-	case TBM_FORMAT_BGR565:
-		bpp = 16;
-		break;
-	case TBM_FORMAT_RGB888:
-	case TBM_FORMAT_BGR888:
-		bpp = 24;
-		break;
-	case TBM_FORMAT_XRGB8888:
-	case TBM_FORMAT_XBGR8888:
-	case TBM_FORMAT_RGBX8888:
-	case TBM_FORMAT_BGRX8888:
-	case TBM_FORMAT_ARGB8888:
-	case TBM_FORMAT_ABGR8888:
-	case TBM_FORMAT_RGBA8888:
-	case TBM_FORMAT_BGRA8888:
-	case TBM_FORMAT_XRGB2101010:
-	case TBM_FORMAT_XBGR2101010:
-	case TBM_FORMAT_RGBX1010102:
-	case TBM_FORMAT_BGRX1010102:
-	case TBM_FORMAT_ARGB2101010:
-	case TBM_FORMAT_ABGR2101010:
-	case TBM_FORMAT_RGBA1010102:
-	case TBM_FORMAT_BGRA1010102:
-	case TBM_FORMAT_YUYV:
-	case TBM_FORMAT_YVYU:
-	case TBM_FORMAT_UYVY:
-	case TBM_FORMAT_VYUY:
-	case TBM_FORMAT_AYUV:
-		bpp = 32;
-		break;
-	case TBM_FORMAT_NV12:
-	case TBM_FORMAT_NV12MT:
-	case TBM_FORMAT_NV21:
-		bpp = 12;
-		break;
-	case TBM_FORMAT_NV16:
-	case TBM_FORMAT_NV61:
-		bpp = 16;
-		break;
-	case TBM_FORMAT_YUV410:
-	case TBM_FORMAT_YVU410:
-		bpp = 9;
-		break;
-	case TBM_FORMAT_YUV411:
-	case TBM_FORMAT_YVU411:
-	case TBM_FORMAT_YUV420:
-	case TBM_FORMAT_YVU420:
-		bpp = 12;
-		break;
-	case TBM_FORMAT_YUV422:
-	case TBM_FORMAT_YVU422:
-		bpp = 16;
-		break;
-	case TBM_FORMAT_YUV444:
-	case TBM_FORMAT_YVU444:
-		bpp = 24;
-		break;
-	default:
-		break;
+	mgr = _tbm_surface_internal_get_format_bufmgr();
+	if (!mgr) {
+		_tbm_surface_mutex_unlock();
+		return 0;
 	}
 
-	TBM_TRACE("tbm_format(%s) bpp(%d)\n", _tbm_surface_internal_format_to_str(format), bpp);
+	desc = tbm_format_get_desc(format);
+	if (desc) {
+		idx = desc - tbm_format_descs;
+		ret = !!(mgr->format_bits[idx / 32] & (1U << (idx % 32)));
+	} else {
+		/* a format of the backend only */
+		for (i = 0; i < mgr->num_formats; i++) {
+			if (mgr->formats[i] == format) {
+				ret = 1;
+				break;
+			}
+		}
+	}
 
-	return bpp;
+	_tbm_surface_mutex_unlock();
+
+	return ret;
 }
 
-tbm_surface_h
-tbm_surface_internal_create_with_flags(int width, int height,
-				       int format, int flags)
+int
+tbm_surface_internal_get_num_planes(tbm_format format)
 {
-	TBM_RETURN_VAL_IF_FAIL(width > 0, NULL);
-	TBM_RETURN_VAL_IF_FAIL(height > 0, NULL);
+	const tbm_format_desc_s *desc = tbm_format_get_desc(format);
+	int num_planes = 0;
 
-	struct _tbm_bufmgr *mgr;
-	struct _tbm_surface *surf = NULL;
-	uint32_t size = 0;
-	uint32_t offset = 0;
-	uint32_t stride = 0;
-	uint32_t bo_size = 0;
-	int bo_idx;
-	int i, j;
-	bool bufmgr_initialized = false;
+	if (desc)
+		num_planes = desc->num_planes;
 
-	_tbm_surface_mutex_lock();
+	TBM_TRACE("tbm_format(%s) num_planes(%d)\n", _tbm_surface_internal_format_to_str(format), num_planes);
 
-	if (!g_surface_bufmgr) {
-		_init_surface_bufmgr();
-		LIST_INITHEAD(&g_surface_bufmgr->surf_list);
-		bufmgr_initialized = true;
-	}
+	return num_planes;
+}
 
-	mgr = g_surface_bufmgr;
-	if (!TBM_BUFMGR_IS_VALID(mgr)) {
-		TBM_LOG_E("The bufmgr is invalid\n");
-		goto check_valid_fail;
-	}
+int
+tbm_surface_internal_get_bpp(tbm_format format)
+{
+	const tbm_format_desc_s *desc = tbm_format_get_desc(format);
+	int bpp = 0;
 
-	surf = calloc(1, sizeof(struct _tbm_surface));
-	if (!surf) {
-		TBM_LOG_E("fail to alloc surf\n");
-		goto alloc_surf_fail;
-	}
+	if (desc)
+		bpp = desc->bpp;
 
-	surf->bufmgr = mgr;
-	surf->info.width = width;
-	surf->info.height = height;
-	surf->info.format = format;
-	surf->info.bpp = tbm_surface_internal_get_bpp(format);
-	surf->info.num_planes = tbm_surface_internal_get_num_planes(format);
-	surf->refcnt = 1;
+	TBM_TRACE("tbm_format(%s) bpp(%d)\n", _tbm_surface_internal_format_to_str(format), bpp);
 
-	/* get size, stride and offset bo_idx */
-	for (i = 0; i < surf->info.num_planes; i++) {
-		if (!_tbm_surface_internal_query_plane_data(surf, i, &size,
-						&offset, &stride, &bo_idx)) {
-			TBM_LOG_E("fail to query plane data\n");
-			goto query_plane_data_fail;
-		}
+	return bpp;
+}
+
+/* fill the plane layout and the number of bos from the width, height and
+ * format of the surface.
+ */
+static int
+_tbm_surface_internal_set_layout(struct _tbm_surface *surf)
+{
+	int i;
 
-		surf->info.planes[i].size = size;
-		surf->info.planes[i].offset = offset;
-		surf->info.planes[i].stride = stride;
-		surf->planes_bo_idx[i] = bo_idx;
+	surf->info.bpp = tbm_surface_internal_get_bpp(surf->info.format);
+	surf->info.num_planes = tbm_surface_internal_get_num_planes(surf->info.format);
+
+	/* get size, stride and offset bo_idx */
+	if (!_tbm_surface_internal_query_planes(surf->bufmgr, surf->info.width, surf->info.height,
+						surf->info.format, surf->info.num_planes,
+						surf->info.planes, surf->planes_bo_idx)) {
+		TBM_LOG_E("fail to query plane data\n");
+		return 0;
 	}
 
 	surf->num_bos = 1;
@@ -676,15 +855,33 @@ tbm_surface_internal_create_with_flags(int width, int height,
 			surf->num_bos = surf->planes_bo_idx[i] + 1;
 	}
 
-	surf->flags = flags;
+	return 1;
+}
 
-	for (i = 0; i < surf->num_bos; i++) {
-		bo_size = 0;
-		for (j = 0; j < surf->info.num_planes; j++) {
-			if (surf->planes_bo_idx[j] == i)
-				bo_size += surf->info.planes[j].size;
-		}
+static uint32_t
+_tbm_surface_internal_get_bo_size(struct _tbm_surface *surf, int bo_idx)
+{
+	uint32_t bo_size = 0;
+	int i;
 
+	for (i = 0; i < surf->info.num_planes; i++) {
+		if (surf->planes_bo_idx[i] == bo_idx)
+			bo_size += surf->info.planes[i].size;
+	}
+
+	return bo_size;
+}
+
+/* allocate the bos of a surface which has its layout already.
+ * either all bos are allocated or none of them.
+ */
+static int
+_tbm_surface_internal_alloc_bos(struct _tbm_surface *surf)
+{
+	struct _tbm_bufmgr *mgr = surf->bufmgr;
+	int i, j;
+
+	for (i = 0; i < surf->num_bos; i++) {
 		if (mgr->backend->surface_bo_alloc) {
 			/* LCOV_EXCL_START */
 			tbm_bo bo = NULL;
@@ -700,7 +897,8 @@ tbm_surface_internal_create_with_flags(int width, int height,
 
 			pthread_mutex_lock(&surf->bufmgr->lock);
 
-			bo_priv = mgr->backend->surface_bo_alloc(bo, width, height, format, flags, i);
+			bo_priv = mgr->backend->surface_bo_alloc(bo, surf->info.width, surf->info.height,
+								 surf->info.format, surf->flags, i);
 			if (!bo_priv) {
 				TBM_LOG_E("fail to alloc bo priv\n");
 				free(bo);
@@ -709,7 +907,7 @@ tbm_surface_internal_create_with_flags(int width, int height,
 			}
 
 			bo->ref_cnt = 1;
-			bo->flags = flags;
+			bo->flags = surf->flags;
 			bo->priv = bo_priv;
 
 			LIST_INITHEAD(&bo->user_data_list);
@@ -721,7 +919,8 @@ tbm_surface_internal_create_with_flags(int width, int height,
 			surf->bos[i] = bo;
 			/* LCOV_EXCL_STOP */
 		} else {
-			surf->bos[i] = tbm_bo_alloc(mgr, bo_size, flags);
+			surf->bos[i] = tbm_bo_alloc(mgr, _tbm_surface_internal_get_bo_size(surf, i),
+						    surf->flags);
 			if (!surf->bos[i]) {
 				TBM_LOG_E("fail to alloc bo idx:%d\n", i);
 				goto alloc_bo_fail;
@@ -731,6 +930,63 @@ tbm_surface_internal_create_with_flags(int width, int height,
 		_tbm_bo_set_surface(surf->bos[i], surf);
 	}
 
+	return 1;
+
+alloc_bo_fail:
+	for (j = 0; j < i; j++) {
+		if (surf->bos[j]) {
+			tbm_bo_unref(surf->bos[j]);
+			surf->bos[j] = NULL;
+		}
+	}
+
+	return 0;
+}
+
+tbm_surface_h
+tbm_surface_internal_create_with_flags(int width, int height,
+				       int format, int flags)
+{
+	TBM_RETURN_VAL_IF_FAIL(width > 0, NULL);
+	TBM_RETURN_VAL_IF_FAIL(height > 0, NULL);
+
+	struct _tbm_bufmgr *mgr;
+	struct _tbm_surface *surf = NULL;
+	bool bufmgr_initialized = false;
+
+	_tbm_surface_mutex_lock();
+
+	if (!g_surface_bufmgr) {
+		_init_surface_bufmgr();
+		LIST_INITHEAD(&g_surface_bufmgr->surf_list);
+		bufmgr_initialized = true;
+	}
+
+	mgr = g_surface_bufmgr;
+	if (!TBM_BUFMGR_IS_VALID(mgr)) {
+		TBM_LOG_E("The bufmgr is invalid\n");
+		goto check_valid_fail;
+	}
+
+	surf = calloc(1, sizeof(struct _tbm_surface));
+	if (!surf) {
+		TBM_LOG_E("fail to alloc surf\n");
+		goto alloc_surf_fail;
+	}
+
+	surf->bufmgr = mgr;
+	surf->info.width = width;
+	surf->info.height = height;
+	surf->info.format = format;
+	surf->refcnt = 1;
+	surf->flags = flags;
+
+	if (!_tbm_surface_internal_set_layout(surf))
+		goto set_layout_fail;
+
+	if (!_tbm_surface_internal_alloc_bos(surf))
+		goto alloc_bo_fail;
+
 	TBM_TRACE("width(%d) height(%d) format(%s) flags(%d) tbm_surface(%p)\n", width, height,
 			_tbm_surface_internal_format_to_str(format), flags, surf);
 
@@ -738,17 +994,14 @@ tbm_surface_internal_create_with_flags(int width, int height,
 	LIST_INITHEAD(&surf->debug_data_list);
 
 	LIST_ADD(&surf->item_link, &mgr->surf_list);
+	_tbm_surface_internal_geometry_add(surf);
 
 	_tbm_surface_mutex_unlock();
 
 	return surf;
 
 alloc_bo_fail:
-	for (j = 0; j < i; j++) {
-		if (surf->bos[j])
-			tbm_bo_unref(surf->bos[j]);
-	}
-query_plane_data_fail:
+set_layout_fail:
 	free(surf);
 alloc_surf_fail:
 check_valid_fail:
@@ -765,6 +1018,140 @@ check_valid_fail:
 	return NULL;
 }
 
+int
+tbm_surface_internal_create_multi(int width, int height, int format, int flags,
+				  int count, tbm_surface_h *surfaces)
+{
+	TBM_RETURN_VAL_IF_FAIL(width > 0, 0);
+	TBM_RETURN_VAL_IF_FAIL(height > 0, 0);
+	TBM_RETURN_VAL_IF_FAIL(count > 0, 0);
+	TBM_RETURN_VAL_IF_FAIL(surfaces, 0);
+
+	struct _tbm_bufmgr *mgr;
+	struct _tbm_surface layout;
+	struct _tbm_surface *surf;
+	tbm_bo *bos = NULL;
+	bool bufmgr_initialized = false;
+	int i, j;
+
+	memset(surfaces, 0, sizeof(tbm_surface_h) * count);
+
+	_tbm_surface_mutex_lock();
+
+	if (!g_surface_bufmgr) {
+		_init_surface_bufmgr();
+		LIST_INITHEAD(&g_surface_bufmgr->surf_list);
+		bufmgr_initialized = true;
+	}
+
+	mgr = g_surface_bufmgr;
+	if (!TBM_BUFMGR_IS_VALID(mgr)) {
+		TBM_LOG_E("The bufmgr is invalid\n");
+		goto check_valid_fail;
+	}
+
+	/* all surfaces share the layout, so query the backend only once */
+	memset(&layout, 0, sizeof(struct _tbm_surface));
+	layout.bufmgr = mgr;
+	layout.info.width = width;
+	layout.info.height = height;
+	layout.info.format = format;
+	layout.refcnt = 1;
+	layout.flags = flags;
+
+	if (!_tbm_surface_internal_set_layout(&layout))
+		goto fail;
+
+	for (i = 0; i < count; i++) {
+		surfaces[i] = calloc(1, sizeof(struct _tbm_surface));
+		if (!surfaces[i]) {
+			TBM_LOG_E("fail to alloc surf\n");
+			goto fail;
+		}
+
+		memcpy(surfaces[i], &layout, sizeof(struct _tbm_surface));
+	}
+
+	if (mgr->backend->surface_bo_alloc) {
+		/* LCOV_EXCL_START */
+		for (i = 0; i < count; i++) {
+			if (!_tbm_surface_internal_alloc_bos(surfaces[i]))
+				goto fail;
+		}
+		/* LCOV_EXCL_STOP */
+	} else {
+		bos = calloc(count, sizeof(tbm_bo));
+		if (!bos) {
+			TBM_LOG_E("fail to alloc bos\n");
+			goto fail;
+		}
+
+		for (j = 0; j < layout.num_bos; j++) {
+			if (!_tbm_bo_alloc_multi(mgr, _tbm_surface_internal_get_bo_size(&layout, j),
+						 flags, count, bos)) {
+				TBM_LOG_E("fail to alloc bo idx:%d\n", j);
+				goto fail;
+			}
+
+			for (i = 0; i < count; i++) {
+				surfaces[i]->bos[j] = bos[i];
+
+				/* the bos are not shared with anybody yet */
+				bos[i]->surface = surfaces[i];
+			}
+		}
+
+		free(bos);
+	}
+
+	for (i = 0; i < count; i++) {
+		surf = surfaces[i];
+
+		LIST_INITHEAD(&surf->user_data_list);
+		LIST_INITHEAD(&surf->debug_data_list);
+
+		LIST_ADD(&surf->item_link, &mgr->surf_list);
+		_tbm_surface_internal_geometry_add(surf);
+	}
+
+	TBM_TRACE("width(%d) height(%d) format(%s) flags(%d) count(%d)\n", width, height,
+			_tbm_surface_internal_format_to_str(format), flags, count);
+
+	_tbm_surface_mutex_unlock();
+
+	return 1;
+
+fail:
+	for (i = 0; i < count; i++) {
+		surf = surfaces[i];
+		if (!surf)
+			continue;
+
+		for (j = 0; j < surf->num_bos; j++) {
+			if (surf->bos[j])
+				tbm_bo_unref(surf->bos[j]);
+		}
+
+		free(surf);
+		surfaces[i] = NULL;
+	}
+
+	if (bos)
+		free(bos);
+check_valid_fail:
+	if (bufmgr_initialized && mgr) {
+		LIST_DELINIT(&mgr->surf_list);
+		_deinit_surface_bufmgr();
+	}
+	_tbm_surface_mutex_unlock();
+
+	TBM_LOG_E("error: width(%d) height(%d) format(%s) flags(%d) count(%d)\n",
+			width, height,
+			_tbm_surface_internal_format_to_str(format), flags, count);
+
+	return 0;
+}
+
 tbm_surface_h
 tbm_surface_internal_create_with_bos(tbm_surface_info_s *info,
 				     tbm_bo *bos, int num)
@@ -851,6 +1238,7 @@ tbm_surface_internal_create_with_bos(tbm_surface_info_s *info,
 	LIST_INITHEAD(&surf->debug_data_list);
 
 	LIST_ADD(&surf->item_link, &mgr->surf_list);
+	_tbm_surface_internal_geometry_add(surf);
 
 	_tbm_surface_mutex_unlock();
 
@@ -877,6 +1265,99 @@ check_valid_fail:
 	return NULL;
 }
 
+tbm_surface_h
+tbm_surface_internal_create_view(tbm_surface_h parent, int x, int y,
+				 int width, int height)
+{
+	const tbm_format_desc_s *desc;
+	tbm_surface_info_s info;
+	tbm_bo bos[TBM_SURF_PLANE_MAX];
+	tbm_surface_h owners[TBM_SURF_PLANE_MAX];
+	tbm_surface_h view;
+	int num_bos, i;
+
+	TBM_RETURN_VAL_IF_FAIL(x >= 0 && y >= 0, NULL);
+	TBM_RETURN_VAL_IF_FAIL(width > 0 && height > 0, NULL);
+
+	_tbm_surface_mutex_lock();
+
+	TBM_SURFACE_RETURN_VAL_IF_FAIL(_tbm_surface_internal_is_valid(parent), NULL);
+	TBM_SURFACE_RETURN_VAL_IF_FAIL(x + width <= (int)parent->info.width, NULL);
+	TBM_SURFACE_RETURN_VAL_IF_FAIL(y + height <= (int)parent->info.height, NULL);
+
+	desc = tbm_format_get_desc(parent->info.format);
+	if (!desc || parent->info.format == TBM_FORMAT_NV12MT) {
+		TBM_LOG_E("can't make a view of format(%s)\n",
+			  _tbm_surface_internal_format_to_str(parent->info.format));
+		_tbm_surface_mutex_unlock();
+		return NULL;
+	}
+
+	if (x % desc->hsub || y % desc->vsub) {
+		TBM_LOG_E("(%d,%d) isn't on the chroma samples of format(%s)\n", x, y,
+			  _tbm_surface_internal_format_to_str(parent->info.format));
+		_tbm_surface_mutex_unlock();
+		return NULL;
+	}
+
+	/* the planes are in one bo or one bo each, as create_with_bos makes them */
+	num_bos = parent->num_bos;
+	for (i = 0; i < (int)parent->info.num_planes; i++) {
+		if (parent->planes_bo_idx[i] != (num_bos == 1 ? 0 : i)) {
+			TBM_LOG_E("can't make a view of tbm_surface(%p), plane(%d) is in bo(%d)\n",
+				  parent, i, parent->planes_bo_idx[i]);
+			_tbm_surface_mutex_unlock();
+			return NULL;
+		}
+	}
+
+	info = parent->info;
+	info.width = width;
+	info.height = height;
+	info.size = 0;
+
+	for (i = 0; i < (int)info.num_planes; i++) {
+		int hsub = i ? desc->hsub : 1, vsub = i ? desc->vsub : 1;
+		int rows = (height + vsub - 1) / vsub;
+		int bytes = (width + hsub - 1) / hsub * desc->cpp[i];
+
+		info.planes[i].offset += (y / vsub) * info.planes[i].stride + (x / hsub) * desc->cpp[i];
+		/* up to the end of the last row, not over the end of the parent */
+		info.planes[i].size = info.planes[i].stride * (rows - 1) + bytes;
+	}
+
+	for (i = 0; i < num_bos; i++) {
+		bos[i] = parent->bos[i];
+		owners[i] = bos[i]->surface;
+	}
+
+	/* the bos stay valid while the reference is held */
+	parent->refcnt++;
+
+	_tbm_surface_mutex_unlock();
+
+	view = tbm_surface_internal_create_with_bos(&info, bos, num_bos);
+	if (!view) {
+		TBM_LOG_E("fail to create a view of tbm_surface(%p)\n", parent);
+		tbm_surface_internal_unref(parent);
+		return NULL;
+	}
+
+	_tbm_surface_mutex_lock();
+
+	view->parent = parent;
+	view->flags = parent->flags;
+	for (i = 0; i < num_bos; i++)
+		_tbm_bo_set_surface(bos[i], owners[i]);
+
+	TBM_TRACE("tbm_surface(%p) view(%d,%d %dx%d) of tbm_surface(%p)\n",
+		  view, x, y, width, height, parent);
+
+	_tbm_surface_mutex_unlock();
+
+	return view;
+}
+
 void
 tbm_surface_internal_destroy(tbm_surface_h surface)
 {
@@ -921,28 +1402,79 @@ tbm_surface_internal_unref(tbm_surface_h surface)
 
 	TBM_SURFACE_RETURN_IF_FAIL(_tbm_surface_internal_is_valid(surface));
 
-	surface->refcnt--;
+	surface->refcnt--;
+
+	if (surface->refcnt > 0) {
+		TBM_TRACE("reduce a refcnt(%d) of tbm_surface(%p)\n", surface->refcnt, surface);
+		_tbm_surface_mutex_unlock();
+		return;
+	}
+
+	TBM_TRACE("destroy tbm_surface(%p) refcnt(%d)\n", surface, surface->refcnt);
+
+	if (surface->refcnt == 0)
+		_tbm_surface_internal_destroy(surface);
+
+	_tbm_surface_mutex_unlock();
+}
+
+/*
+ * take a reference to every surface in one pass under the surface lock.
+ * the caller unrefs them with tbm_surface_internal_unref and frees the array.
+ */
+tbm_surface_h *
+_tbm_surface_internal_get_surfaces(int *num)
+{
+	tbm_surface_h *surfaces = NULL;
+	tbm_surface_h surface;
+	int count = 0;
+
+	TBM_RETURN_VAL_IF_FAIL(num != NULL, NULL);
+
+	*num = 0;
+
+	_tbm_surface_mutex_lock();
+
+	if (!g_surface_bufmgr || LIST_IS_EMPTY(&g_surface_bufmgr->surf_list)) {
+		_tbm_surface_mutex_unlock();
+		return NULL;
+	}
+
+	LIST_FOR_EACH_ENTRY(surface, &g_surface_bufmgr->surf_list, item_link)
+		count++;
 
-	if (surface->refcnt > 0) {
-		TBM_TRACE("reduce a refcnt(%d) of tbm_surface(%p)\n", surface->refcnt, surface);
+	surfaces = calloc(count, sizeof(tbm_surface_h));
+	if (!surfaces) {
+		TBM_LOG_E("fail to alloc the list of %d surfaces\n", count);
 		_tbm_surface_mutex_unlock();
-		return;
+		return NULL;
 	}
 
-	TBM_TRACE("destroy tbm_surface(%p) refcnt(%d)\n", surface, surface->refcnt);
-
-	if (surface->refcnt == 0)
-		_tbm_surface_internal_destroy(surface);
+	LIST_FOR_EACH_ENTRY(surface, &g_surface_bufmgr->surf_list, item_link) {
+		surface->refcnt++;
+		surfaces[(*num)++] = surface;
+	}
 
 	_tbm_surface_mutex_unlock();
+
+	return surfaces;
 }
 
 int
 tbm_surface_internal_get_num_bos(tbm_surface_h surface)
 {
+	tbm_surface_geometry geom;
 	struct _tbm_surface *surf;
 	int num;
 
+	if (_tbm_surface_internal_get_immutable(surface, &geom)) {
+		num = geom.num_bos;
+
+		TBM_TRACE("tbm_surface(%p) num_bos(%d)\n", surface, num);
+
+		return num;
+	}
+
 	_tbm_surface_mutex_lock();
 
 	TBM_SURFACE_RETURN_VAL_IF_FAIL(_tbm_surface_internal_is_valid(surface), 0);
@@ -1041,7 +1573,9 @@ tbm_surface_internal_get_info(tbm_surface_h surface, int opt,
 {
 	struct _tbm_surface *surf;
 	tbm_bo_handle bo_handles[4];
-	int i, j;
+	tbm_bo bos[4];
+	int num_bos;
+	int i;
 
 	_tbm_surface_mutex_lock();
 
@@ -1060,19 +1594,18 @@ tbm_surface_internal_get_info(tbm_surface_h surface, int opt,
 	info->num_planes = surf->info.num_planes;
 
 	if (map == 1) {
-		for (i = 0; i < surf->num_bos; i++) {
-			_tbm_surface_mutex_unlock();
-			bo_handles[i] = tbm_bo_map(surf->bos[i], TBM_DEVICE_CPU, opt);
-			_tbm_surface_mutex_lock();
-			if (bo_handles[i].ptr == NULL) {
-				for (j = 0; j < i; j++)
-					tbm_bo_unmap(surf->bos[j]);
+		num_bos = surf->num_bos;
+		memcpy(bos, surf->bos, sizeof(tbm_bo) * num_bos);
 
-				TBM_LOG_E("error: tbm_surface(%p) opt(%d) map(%d)\n", surface, opt, map);
-				_tbm_surface_mutex_unlock();
-				return 0;
-			}
+		/* locking a bo may wait for other processes, so map all bos
+		 * in one pass without holding the surface mutex.
+		 */
+		_tbm_surface_mutex_unlock();
+		if (!_tbm_bo_map_multi(bos, num_bos, TBM_DEVICE_CPU, opt, bo_handles)) {
+			TBM_LOG_E("error: tbm_surface(%p) opt(%d) map(%d)\n", surface, opt, map);
+			return 0;
 		}
+		_tbm_surface_mutex_lock();
 	} else {
 		for (i = 0; i < surf->num_bos; i++) {
 			bo_handles[i] = tbm_bo_get_handle(surf->bos[i], TBM_DEVICE_CPU);
@@ -1105,7 +1638,6 @@ void
 tbm_surface_internal_unmap(tbm_surface_h surface)
 {
 	struct _tbm_surface *surf;
-	int i;
 
 	_tbm_surface_mutex_lock();
 
@@ -1113,8 +1645,7 @@ tbm_surface_internal_unmap(tbm_surface_h surface)
 
 	surf = (struct _tbm_surface *)surface;
 
-	for (i = 0; i < surf->num_bos; i++)
-		tbm_bo_unmap(surf->bos[i]);
+	_tbm_bo_unmap_multi(surf->bos, surf->num_bos);
 
 	TBM_TRACE("tbm_surface(%p)\n", surface);
 
@@ -1124,9 +1655,18 @@ tbm_surface_internal_unmap(tbm_surface_h surface)
 unsigned int
 tbm_surface_internal_get_width(tbm_surface_h surface)
 {
+	tbm_surface_geometry geom;
 	struct _tbm_surface *surf;
 	unsigned int width;
 
+	if (_tbm_surface_internal_get_immutable(surface, &geom)) {
+		width = geom.width;
+
+		TBM_TRACE("tbm_surface(%p) width(%u)\n", surface, width);
+
+		return width;
+	}
+
 	_tbm_surface_mutex_lock();
 
 	TBM_SURFACE_RETURN_VAL_IF_FAIL(_tbm_surface_internal_is_valid(surface), 0);
@@ -1144,9 +1684,18 @@ tbm_surface_internal_get_width(tbm_surface_h surface)
 unsigned int
 tbm_surface_internal_get_height(tbm_surface_h surface)
 {
+	tbm_surface_geometry geom;
 	struct _tbm_surface *surf;
 	unsigned int height;
 
+	if (_tbm_surface_internal_get_immutable(surface, &geom)) {
+		height = geom.height;
+
+		TBM_TRACE("tbm_surface(%p) height(%u)\n", surface, height);
+
+		return height;
+	}
+
 	_tbm_surface_mutex_lock();
 
 	TBM_SURFACE_RETURN_VAL_IF_FAIL(_tbm_surface_internal_is_valid(surface), 0);
@@ -1165,9 +1714,18 @@ tbm_surface_internal_get_height(tbm_surface_h surface)
 tbm_format
 tbm_surface_internal_get_format(tbm_surface_h surface)
 {
+	tbm_surface_geometry geom;
 	struct _tbm_surface *surf;
 	tbm_format format;
 
+	if (_tbm_surface_internal_get_immutable(surface, &geom)) {
+		format = geom.format;
+
+		TBM_TRACE("tbm_surface(%p) format(%s)\n", surface, _tbm_surface_internal_format_to_str(format));
+
+		return format;
+	}
+
 	_tbm_surface_mutex_lock();
 
 	TBM_SURFACE_RETURN_VAL_IF_FAIL(_tbm_surface_internal_is_valid(surface), 0);
@@ -1185,9 +1743,19 @@ tbm_surface_internal_get_format(tbm_surface_h surface)
 int
 tbm_surface_internal_get_plane_bo_idx(tbm_surface_h surface, int plane_idx)
 {
+	tbm_surface_geometry geom;
 	struct _tbm_surface *surf;
 	int bo_idx;
 
+	if (plane_idx > -1 && plane_idx < TBM_SURF_PLANE_MAX &&
+	    _tbm_surface_internal_get_immutable(surface, &geom)) {
+		bo_idx = geom.planes_bo_idx[plane_idx];
+
+		TBM_TRACE("tbm_surface(%p) plane_idx(%d) bo_idx(%d)\n", surface, plane_idx, bo_idx);
+
+		return bo_idx;
+	}
+
 	_tbm_surface_mutex_lock();
 
 	TBM_SURFACE_RETURN_VAL_IF_FAIL(_tbm_surface_internal_is_valid(surface), 0);
@@ -1203,6 +1771,235 @@ tbm_surface_internal_get_plane_bo_idx(tbm_surface_h surface, int plane_idx)
 	return bo_idx;
 }
 
+int
+_tbm_surface_internal_fill_by_backend(tbm_surface_h surface, tbm_surface_rect_s *rect,
+				      uint32_t color)
+{
+	int (*surface_fill)(tbm_surface_h surface, int x, int y, int width, int height,
+			    uint32_t color);
+	struct _tbm_surface *surf;
+	int ret = 0;
+
+	_tbm_surface_mutex_lock();
+
+	TBM_SURFACE_RETURN_VAL_IF_FAIL(_tbm_surface_internal_is_valid(surface), 0);
+	TBM_SURFACE_RETURN_VAL_IF_FAIL(rect, 0);
+
+	surf = (struct _tbm_surface *)surface;
+	surface_fill = surf->bufmgr->backend->surface_fill;
+
+	_tbm_surface_mutex_unlock();
+
+	/* the hook looks up the bos of the surface, which takes the surface
+	 * lock again. the caller keeps the surface alive.
+	 */
+	if (surface_fill)
+		ret = surface_fill(surface, rect->x, rect->y, rect->width, rect->height, color);
+
+	TBM_TRACE("tbm_surface(%p) color(0x%08x) ret(%d)\n", surface, color, ret);
+
+	return ret;
+}
+
+static int
+_tbm_surface_internal_rect_area(const tbm_surface_rect_s *r)
+{
+	return r->width * r->height;
+}
+
+static int
+_tbm_surface_internal_rect_contains(const tbm_surface_rect_s *a, const tbm_surface_rect_s *b)
+{
+	return b->x >= a->x && b->y >= a->y &&
+	       b->x + b->width <= a->x + a->width &&
+	       b->y + b->height <= a->y + a->height;
+}
+
+static void
+_tbm_surface_internal_rect_union(const tbm_surface_rect_s *a, const tbm_surface_rect_s *b,
+				 tbm_surface_rect_s *u)
+{
+	int x1 = MIN(a->x, b->x), y1 = MIN(a->y, b->y);
+	int x2 = MAX(a->x + a->width, b->x + b->width);
+	int y2 = MAX(a->y + a->height, b->y + b->height);
+
+	u->x = x1;
+	u->y = y1;
+	u->width = x2 - x1;
+	u->height = y2 - y1;
+}
+
+/* add r to the damage of surf. the rects covered by r are dropped and
+ * when the list is full, r is merged with the rect whose union grows the
+ * damaged area the least, so the region stays bounded.
+ */
+static void
+_tbm_surface_internal_damage_add(struct _tbm_surface *surf, tbm_surface_rect_s r)
+{
+	tbm_surface_rect_s u;
+	int i, best, cost, best_cost;
+
+	while (1) {
+		for (i = 0; i < surf->num_damage; i++) {
+			if (_tbm_surface_internal_rect_contains(&surf->damage[i], &r))
+				return;
+
+			if (_tbm_surface_internal_rect_contains(&r, &surf->damage[i]))
+				surf->damage[i--] = surf->damage[--surf->num_damage];
+		}
+
+		if (surf->num_damage < TBM_SURFACE_DAMAGE_MAX) {
+			surf->damage[surf->num_damage++] = r;
+			return;
+		}
+
+		best = 0;
+		best_cost = INT_MAX;
+		for (i = 0; i < surf->num_damage; i++) {
+			_tbm_surface_internal_rect_union(&surf->damage[i], &r, &u);
+			cost = _tbm_surface_internal_rect_area(&u) -
+			       _tbm_surface_internal_rect_area(&surf->damage[i]);
+			if (cost < best_cost) {
+				best = i;
+				best_cost = cost;
+			}
+		}
+
+		_tbm_surface_internal_rect_union(&surf->damage[best], &r, &r);
+		surf->damage[best] = surf->damage[--surf->num_damage];
+	}
+}
+
+int
+tbm_surface_internal_add_damage(tbm_surface_h surface, tbm_surface_rect_s *rect)
+{
+	struct _tbm_surface *surf;
+	tbm_surface_rect_s r;
+	int x2, y2;
+
+	_tbm_surface_mutex_lock();
+
+	TBM_SURFACE_RETURN_VAL_IF_FAIL(_tbm_surface_internal_is_valid(surface), 0);
+
+	surf = (struct _tbm_surface *)surface;
+
+	if (!rect) {
+		r.x = r.y = 0;
+		r.width = surf->info.width;
+		r.height = surf->info.height;
+	} else {
+		/* clip to the surface */
+		r.x = MAX(rect->x, 0);
+		r.y = MAX(rect->y, 0);
+		x2 = MIN(rect->x + rect->width, (int)surf->info.width);
+		y2 = MIN(rect->y + rect->height, (int)surf->info.height);
+		r.width = x2 - r.x;
+		r.height = y2 - r.y;
+	}
+
+	if (r.width > 0 && r.height > 0)
+		_tbm_surface_internal_damage_add(surf, r);
+
+	TBM_TRACE("tbm_surface(%p) rect(%d,%d %dx%d) num_damage(%d)\n", surface,
+		  r.x, r.y, r.width, r.height, surf->num_damage);
+
+	_tbm_surface_mutex_unlock();
+
+	return 1;
+}
+
+int
+tbm_surface_internal_get_damage(tbm_surface_h surface, tbm_surface_rect_s *rects, int *num)
+{
+	struct _tbm_surface *surf;
+
+	_tbm_surface_mutex_lock();
+
+	TBM_SURFACE_RETURN_VAL_IF_FAIL(_tbm_surface_internal_is_valid(surface), 0);
+	TBM_SURFACE_RETURN_VAL_IF_FAIL(num != NULL, 0);
+
+	surf = (struct _tbm_surface *)surface;
+
+	*num = surf->num_damage;
+	if (rects && surf->num_damage)
+		memcpy(rects, surf->damage, sizeof(tbm_surface_rect_s) * surf->num_damage);
+
+	TBM_TRACE("tbm_surface(%p) num_damage(%d)\n", surface, *num);
+
+	_tbm_surface_mutex_unlock();
+
+	return 1;
+}
+
+int
+tbm_surface_internal_clear_damage(tbm_surface_h surface)
+{
+	struct _tbm_surface *surf;
+
+	_tbm_surface_mutex_lock();
+
+	TBM_SURFACE_RETURN_VAL_IF_FAIL(_tbm_surface_internal_is_valid(surface), 0);
+
+	surf = (struct _tbm_surface *)surface;
+	surf->num_damage = 0;
+
+	TBM_TRACE("tbm_surface(%p)\n", surface);
+
+	_tbm_surface_mutex_unlock();
+
+	return 1;
+}
+
+/* the bounding box of the damage of the surface, 0 if nothing was damaged,
+ * which means the whole surface is dirty.
+ */
+int
+_tbm_surface_internal_get_damage_bounds(tbm_surface_h surface, tbm_surface_rect_s *bounds)
+{
+	struct _tbm_surface *surf;
+	int i;
+
+	_tbm_surface_mutex_lock();
+
+	TBM_SURFACE_RETURN_VAL_IF_FAIL(_tbm_surface_internal_is_valid(surface), 0);
+
+	surf = (struct _tbm_surface *)surface;
+	if (!surf->num_damage) {
+		_tbm_surface_mutex_unlock();
+		return 0;
+	}
+
+	*bounds = surf->damage[0];
+	for (i = 1; i < surf->num_damage; i++)
+		_tbm_surface_internal_rect_union(bounds, &surf->damage[i], bounds);
+
+	_tbm_surface_mutex_unlock();
+
+	return 1;
+}
+
+/* a library writer changed rect of the surface. a surface without damage
+ * is already dirty as a whole, so rect is added only to an existing damage.
+ */
+void
+_tbm_surface_internal_add_written_damage(tbm_surface_h surface, tbm_surface_rect_s *rect)
+{
+	struct _tbm_surface *surf;
+
+	_tbm_surface_mutex_lock();
+
+	TBM_SURFACE_RETURN_IF_FAIL(_tbm_surface_internal_is_valid(surface));
+
+	surf = (struct _tbm_surface *)surface;
+	if (surf->num_damage)
+		_tbm_surface_internal_damage_add(surf, *rect);
+
+	TBM_TRACE("tbm_surface(%p) rect(%d,%d %dx%d) num_damage(%d)\n", surface,
+		  rect->x, rect->y, rect->width, rect->height, surf->num_damage);
+
+	_tbm_surface_mutex_unlock();
+}
+
 int
 tbm_surface_internal_add_user_data(tbm_surface_h surface, unsigned long key,
 				   tbm_data_free data_free_func)
@@ -1325,6 +2122,22 @@ tbm_surface_internal_delete_user_data(tbm_surface_h surface,
 	return 1;
 }
 
+int
+_tbm_surface_internal_get_refcnt(tbm_surface_h surface)
+{
+	int refcnt;
+
+	_tbm_surface_mutex_lock();
+
+	TBM_SURFACE_RETURN_VAL_IF_FAIL(_tbm_surface_internal_is_valid(surface), 0);
+
+	refcnt = surface->refcnt;
+
+	_tbm_surface_mutex_unlock();
+
+	return refcnt;
+}
+
 /* LCOV_EXCL_START */
 unsigned int
 _tbm_surface_internal_get_debug_pid(tbm_surface_h surface)
@@ -1473,7 +2286,7 @@ struct _tbm_surface_dump_info {
 static tbm_surface_dump_info *g_dump_info = NULL;
 static const char *dump_postfix[2] = {"png", "yuv"};
 
-static void
+void
 _tbm_surface_internal_dump_file_raw(const char *file, void *data1, int size1,
 				void *data2, int size2, void *data3, int size3)
 {
@@ -1497,89 +2310,57 @@ _tbm_surface_internal_dump_file_raw(const char *file, void *data1, int size1,
 	fclose(fp);
 }
 
-static void
-_tbm_surface_internal_dump_file_png(const char *file, const void *data, int width, int height)
+/*
+ * write the visible part of a surface by its format, the RGB formats as a
+ * RGBA png and the YUV formats as the raw planes without the padding of the
+ * rows. 0 if the format can't be written as it is, ex) the tiled ones.
+ */
+int
+_tbm_surface_internal_dump_file(const char *file, tbm_surface_info_s *info)
 {
-	unsigned int *blocks = (unsigned int *)data;
-	FILE *fp = fopen(file, "wb");
-	TBM_RETURN_IF_FAIL(fp != NULL);
-	const int pixel_size = 4;	// RGBA
-	png_bytep *row_pointers;
-	int depth = 8, y;
-
-	png_structp pPngStruct = png_create_write_struct(PNG_LIBPNG_VER_STRING,
-							NULL, NULL, NULL);
-	if (!pPngStruct) {
-		TBM_LOG_E("fail to create a png write structure.\n");
-		fclose(fp);
-		return;
-	}
+	const tbm_format_desc_s *desc;
+	FILE *fp;
+	int i, y;
 
-	png_infop pPngInfo = png_create_info_struct(pPngStruct);
-	if (!pPngInfo) {
-		TBM_LOG_E("fail to create a png info structure.\n");
-		png_destroy_write_struct(&pPngStruct, NULL);
-		fclose(fp);
-		return;
-	}
+	TBM_RETURN_VAL_IF_FAIL(file != NULL, 0);
+	TBM_RETURN_VAL_IF_FAIL(info != NULL, 0);
 
-	png_init_io(pPngStruct, fp);
-	png_set_IHDR(pPngStruct,
-			pPngInfo,
-			width,
-			height,
-			depth,
-			PNG_COLOR_TYPE_RGBA,
-			PNG_INTERLACE_NONE,
-			PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
-
-	png_set_bgr(pPngStruct);
-	png_write_info(pPngStruct, pPngInfo);
-
-	row_pointers = png_malloc(pPngStruct, height * sizeof(png_byte *));
-	if (!row_pointers) {
-		TBM_LOG_E("fail to allocate the png row_pointers.\n");
-		png_destroy_write_struct(&pPngStruct, &pPngInfo);
-		fclose(fp);
-		return;
-	}
+	desc = tbm_format_get_desc(info->format);
+	if (!desc || info->format == TBM_FORMAT_NV12MT)
+		return 0;
 
-	for (y = 0; y < height; ++y) {
-		png_bytep row;
-		int x = 0;
+	if (!desc->is_yuv)
+		return _tbm_surface_internal_dump_file_png_format(file, info->planes[0].ptr,
+								  info->width, info->height,
+								  info->planes[0].stride,
+								  info->format);
 
-		row = png_malloc(pPngStruct, sizeof(png_byte) * width * pixel_size);
-		if (!row) {
-			TBM_LOG_E("fail to allocate the png row.\n");
-			for (x = 0; x < y; x++)
-				png_free(pPngStruct, row_pointers[x]);
-			png_free(pPngStruct, row_pointers);
-			png_destroy_write_struct(&pPngStruct, &pPngInfo);
-			fclose(fp);
-			return;
-		}
-		row_pointers[y] = (png_bytep)row;
+	fp = fopen(file, "w+");
+	TBM_RETURN_VAL_IF_FAIL(fp != NULL, 0);
 
-		for (x = 0; x < width; ++x) {
-			unsigned int curBlock = blocks[y * width + x];
+	for (i = 0; i < desc->num_planes; i++) {
+		int hsub = i ? desc->hsub : 1, vsub = i ? desc->vsub : 1;
+		int width = info->width, rows, bytes;
 
-			row[x * pixel_size] = (curBlock & 0xFF);
-			row[1 + x * pixel_size] = (curBlock >> 8) & 0xFF;
-			row[2 + x * pixel_size] = (curBlock >> 16) & 0xFF;
-			row[3 + x * pixel_size] = (curBlock >> 24) & 0xFF;
-		}
-	}
+		/* a packed plane keeps its whole macro pixels, ex) YUYV */
+		if (desc->num_planes == 1)
+			width = (width + desc->hsub - 1) / desc->hsub * desc->hsub;
 
-	png_write_image(pPngStruct, row_pointers);
-	png_write_end(pPngStruct, pPngInfo);
+		bytes = (width + hsub - 1) / hsub * desc->cpp[i];
+		rows = (info->height + vsub - 1) / vsub;
 
-	for (y = 0; y < height; y++)
-		png_free(pPngStruct, row_pointers[y]);
-	png_free(pPngStruct, row_pointers);
+		if (bytes == (int)info->planes[i].stride) {
+			fwrite(info->planes[i].ptr, 1, bytes * rows, fp);
+			continue;
+		}
 
-	png_destroy_write_struct(&pPngStruct, &pPngInfo);
+		for (y = 0; y < rows; y++)
+			fwrite(info->planes[i].ptr + info->planes[i].stride * y, 1, bytes, fp);
+	}
 
 	fclose(fp);
+
+	return 1;
 }
 
 void
@@ -1684,6 +2465,8 @@ tbm_surface_internal_dump_end(void)
 	tbm_surface_dump_buf_info *buf_info = NULL, *tmp = NULL;
 	tbm_bo_handle bo_handle;
 
+	_tbm_surface_internal_dump_ring_end();
+
 	if (!g_dump_info)
 		return;
 
@@ -1709,45 +2492,15 @@ tbm_surface_internal_dump_end(void)
 		TBM_LOG_I("Dump File.. %s generated.\n", file);
 
 		if (buf_info->dirty) {
-			void *ptr1 = NULL, *ptr2 = NULL;
-
-			switch (buf_info->info.format) {
-			case TBM_FORMAT_ARGB8888:
-			case TBM_FORMAT_XRGB8888:
-				_tbm_surface_internal_dump_file_png(file, bo_handle.ptr,
-							buf_info->info.planes[0].stride >> 2,
-							buf_info->info.height);
-				break;
-			case TBM_FORMAT_YVU420:
-			case TBM_FORMAT_YUV420:
-				ptr1 = bo_handle.ptr + buf_info->info.planes[0].stride * buf_info->info.height;
-				ptr2 = ptr1 + buf_info->info.planes[1].stride * (buf_info->info.height >> 1);
-				_tbm_surface_internal_dump_file_raw(file, bo_handle.ptr,
-							buf_info->info.planes[0].stride * buf_info->info.height,
-							ptr1,
-							buf_info->info.planes[1].stride * (buf_info->info.height >> 1),
-							ptr2,
-							buf_info->info.planes[2].stride * (buf_info->info.height >> 1));
-				break;
-			case TBM_FORMAT_NV12:
-			case TBM_FORMAT_NV21:
-				ptr1 = bo_handle.ptr + buf_info->info.planes[0].stride * buf_info->info.height;
-				_tbm_surface_internal_dump_file_raw(file, bo_handle.ptr,
-							buf_info->info.planes[0].stride * buf_info->info.height,
-							ptr1,
-							buf_info->info.planes[1].stride * (buf_info->info.height >> 1),
-							NULL, 0);
-				break;
-			case TBM_FORMAT_YUYV:
-			case TBM_FORMAT_UYVY:
-				_tbm_surface_internal_dump_file_raw(file, bo_handle.ptr,
-							buf_info->info.planes[0].stride * buf_info->info.height,
-							NULL, 0, NULL, 0);
-				break;
-			default:
-				TBM_LOG_E("can't dump %c%c%c%c buffer", FOURCC_STR(buf_info->info.format));
-				break;
-			}
+			tbm_surface_info_s info = buf_info->info;
+			int i;
+
+			for (i = 0; i < (int)info.num_planes; i++)
+				info.planes[i].ptr = (unsigned char *)bo_handle.ptr + info.planes[i].offset;
+
+			if (!_tbm_surface_internal_dump_file(file, &info))
+				TBM_LOG_E("can't dump %s buffer\n",
+					  _tbm_surface_internal_format_to_str(info.format));
 		} else if (buf_info->dirty_shm)
 			_tbm_surface_internal_dump_file_png(file, bo_handle.ptr,
 							buf_info->shm_stride >> 2,
@@ -1772,11 +2525,18 @@ tbm_surface_internal_dump_buffer(tbm_surface_h surface, const char *type)
 	TBM_RETURN_IF_FAIL(type != NULL);
 
 	tbm_surface_dump_buf_info *buf_info;
+	const tbm_format_desc_s *desc;
 	struct list_head *next_link;
 	tbm_surface_info_s info;
 	tbm_bo_handle bo_handle;
 	const char *postfix;
-	int ret;
+	int ret, i, size;
+
+	if (_tbm_surface_internal_dump_async_buffer(surface, NULL, type))
+		return;
+
+	if (_tbm_surface_internal_dump_ring_buffer(surface, type))
+		return;
 
 	if (!g_dump_info)
 		return;
@@ -1795,17 +2555,26 @@ tbm_surface_internal_dump_buffer(tbm_surface_h surface, const char *type)
 	ret = tbm_surface_map(surface, TBM_SURF_OPTION_READ|TBM_SURF_OPTION_WRITE, &info);
 	TBM_RETURN_IF_FAIL(ret == TBM_SURFACE_ERROR_NONE);
 
-	if (info.size > buf_info->size) {
-		TBM_LOG_W("Dump skip. surface over created buffer size(%u, %d)\n",
-				info.size, buf_info->size);
+	desc = tbm_format_get_desc(info.format);
+	if (!desc) {
+		TBM_LOG_E("can't copy %s buffer\n", _tbm_surface_internal_format_to_str(info.format));
 		tbm_surface_unmap(surface);
 		return;
 	}
 
-	if (info.format == TBM_FORMAT_ARGB8888 || info.format == TBM_FORMAT_XRGB8888)
-		postfix = dump_postfix[0];
-	else
-		postfix = dump_postfix[1];
+	/* the planes are packed one after another in the bo */
+	size = 0;
+	for (i = 0; i < desc->num_planes; i++)
+		size += info.planes[i].stride * ((info.height + (i ? desc->vsub : 1) - 1) / (i ? desc->vsub : 1));
+
+	if (size > buf_info->size) {
+		TBM_LOG_W("Dump skip. surface over created buffer size(%d, %d)\n",
+				size, buf_info->size);
+		tbm_surface_unmap(surface);
+		return;
+	}
+
+	postfix = dump_postfix[desc->is_yuv ? 1 : 0];
 
 	/* make the file information */
 	memcpy(&buf_info->info, &info, sizeof(tbm_surface_info_s));
@@ -1817,55 +2586,50 @@ tbm_surface_internal_dump_buffer(tbm_surface_h surface, const char *type)
 		tbm_surface_unmap(surface);
 		return;
 	}
-	memset(bo_handle.ptr, 0x00, buf_info->size);
 
-	switch (info.format) {
-	case TBM_FORMAT_ARGB8888:
-	case TBM_FORMAT_XRGB8888:
-		snprintf(buf_info->name, sizeof(buf_info->name),
-				"%10.3f_%03d_%p-%s.%s",
-				 _tbm_surface_internal_get_time(),
-				 g_dump_info->count++, surface, type, postfix);
-		memcpy(bo_handle.ptr, info.planes[0].ptr, info.size);
-		break;
-	case TBM_FORMAT_YVU420:
-	case TBM_FORMAT_YUV420:
-		snprintf(buf_info->name, sizeof(buf_info->name),
-				"%10.3f_%03d-%s_%dx%d_%c%c%c%c.%s",
-				 _tbm_surface_internal_get_time(),
-				 g_dump_info->count++, type, info.planes[0].stride,
-				info.height, FOURCC_STR(info.format), postfix);
-		memcpy(bo_handle.ptr, info.planes[0].ptr, info.planes[0].stride * info.height);
-		bo_handle.ptr += info.planes[0].stride * info.height;
-		memcpy(bo_handle.ptr, info.planes[1].ptr, info.planes[1].stride * (info.height >> 1));
-		bo_handle.ptr += info.planes[1].stride * (info.height >> 1);
-		memcpy(bo_handle.ptr, info.planes[2].ptr, info.planes[2].stride * (info.height >> 1));
-		break;
-	case TBM_FORMAT_NV12:
-	case TBM_FORMAT_NV21:
-		snprintf(buf_info->name, sizeof(buf_info->name),
-				"%10.3f_%03d-%s_%dx%d_%c%c%c%c.%s",
-				 _tbm_surface_internal_get_time(),
-				 g_dump_info->count++, type, info.planes[0].stride,
-				info.height, FOURCC_STR(info.format), postfix);
-		memcpy(bo_handle.ptr, info.planes[0].ptr, info.planes[0].stride * info.height);
-		bo_handle.ptr += info.planes[0].stride * info.height;
-		memcpy(bo_handle.ptr, info.planes[1].ptr, info.planes[1].stride * (info.height >> 1));
-		break;
-	case TBM_FORMAT_YUYV:
-	case TBM_FORMAT_UYVY:
+	if (info.format == TBM_FORMAT_NV12MT) {
+		/* the tiles are dumped as linear NV12 */
 		snprintf(buf_info->name, sizeof(buf_info->name),
 				"%10.3f_%03d-%s_%dx%d_%c%c%c%c.%s",
 				 _tbm_surface_internal_get_time(),
-				 g_dump_info->count++, type, info.planes[0].stride,
-				info.height, FOURCC_STR(info.format), postfix);
-		memcpy(bo_handle.ptr, info.planes[0].ptr, info.planes[0].stride * info.height);
-		break;
-	default:
-		TBM_LOG_E("can't copy %c%c%c%c buffer", FOURCC_STR(info.format));
-		tbm_bo_unmap(buf_info->bo);
-		tbm_surface_unmap(surface);
-		return;
+				 g_dump_info->count++, type, info.width,
+				info.height, FOURCC_STR(TBM_FORMAT_NV12), postfix);
+		if (!_tbm_surface_internal_detile_nv12mt(&info, (unsigned char *)bo_handle.ptr, info.width,
+					(unsigned char *)bo_handle.ptr + info.width * info.height, info.width)) {
+			TBM_LOG_E("can't detile %c%c%c%c buffer", FOURCC_STR(info.format));
+			tbm_bo_unmap(buf_info->bo);
+			tbm_surface_unmap(surface);
+			return;
+		}
+		buf_info->info.format = TBM_FORMAT_NV12;
+		buf_info->info.planes[0].offset = 0;
+		buf_info->info.planes[0].stride = info.width;
+		buf_info->info.planes[1].offset = info.width * info.height;
+		buf_info->info.planes[1].stride = info.width;
+	} else {
+		if (desc->is_yuv)
+			snprintf(buf_info->name, sizeof(buf_info->name),
+					"%10.3f_%03d-%s_%dx%d_%c%c%c%c.%s",
+					 _tbm_surface_internal_get_time(),
+					 g_dump_info->count++, type, info.width,
+					info.height, FOURCC_STR(info.format), postfix);
+		else
+			snprintf(buf_info->name, sizeof(buf_info->name),
+					"%10.3f_%03d_%p-%s.%s",
+					 _tbm_surface_internal_get_time(),
+					 g_dump_info->count++, surface, type, postfix);
+
+		/* the whole frame, whatever the damage of the surface */
+		size = 0;
+		for (i = 0; i < desc->num_planes; i++) {
+			int vsub = i ? desc->vsub : 1;
+			int rows = (info.height + vsub - 1) / vsub;
+
+			memcpy((unsigned char *)bo_handle.ptr + size, info.planes[i].ptr,
+			       info.planes[i].stride * rows);
+			buf_info->info.planes[i].offset = size;
+			size += info.planes[i].stride * rows;
+		}
 	}
 
 	tbm_bo_unmap(buf_info->bo);
@@ -1897,6 +2661,9 @@ void tbm_surface_internal_dump_shm_buffer(void *ptr, int w, int h, int stride,
 	tbm_bo_handle bo_handle;
 	int size;
 
+	if (_tbm_surface_internal_dump_ring_shm_buffer(ptr, w, h, stride, type))
+		return;
+
 	if (!g_dump_info)
 		return;
 
@@ -1952,7 +2719,9 @@ tbm_surface_internal_capture_buffer(tbm_surface_h surface, const char *path, con
 	TBM_RETURN_VAL_IF_FAIL(path != NULL, 0);
 	TBM_RETURN_VAL_IF_FAIL(name != NULL, 0);
 
+	const tbm_format_desc_s *desc;
 	tbm_surface_info_s info;
+	unsigned char *linear = NULL;
 	const char *postfix;
 	int ret;
 	char file[1024];
@@ -1960,10 +2729,11 @@ tbm_surface_internal_capture_buffer(tbm_surface_h surface, const char *path, con
 	ret = tbm_surface_map(surface, TBM_SURF_OPTION_READ|TBM_SURF_OPTION_WRITE, &info);
 	TBM_RETURN_VAL_IF_FAIL(ret == TBM_SURFACE_ERROR_NONE, 0);
 
-	if (info.format == TBM_FORMAT_ARGB8888 || info.format == TBM_FORMAT_XRGB8888)
-		postfix = dump_postfix[0];
-	else
+	desc = tbm_format_get_desc(info.format);
+	if (desc && desc->is_yuv)
 		postfix = dump_postfix[1];
+	else
+		postfix = dump_postfix[0];
 
 	if (strcmp(postfix, type)) {
 		TBM_LOG_E("not support type(%s) %c%c%c%c buffer", type, FOURCC_STR(info.format));
@@ -1979,37 +2749,24 @@ tbm_surface_internal_capture_buffer(tbm_surface_h surface, const char *path, con
 		return 0;
 	}
 
-	switch (info.format) {
-	case TBM_FORMAT_ARGB8888:
-	case TBM_FORMAT_XRGB8888:
-		_tbm_surface_internal_dump_file_png(file, info.planes[0].ptr,
-							info.planes[0].stride >> 2,
-							info.height);
-		break;
-	case TBM_FORMAT_YVU420:
-	case TBM_FORMAT_YUV420:
-		_tbm_surface_internal_dump_file_raw(file, info.planes[0].ptr,
-				info.planes[0].stride * info.height,
-				info.planes[1].ptr,
-				info.planes[1].stride * (info.height >> 1),
-				info.planes[2].ptr,
-				info.planes[2].stride * (info.height >> 1));
-		break;
-	case TBM_FORMAT_NV12:
-	case TBM_FORMAT_NV21:
-		_tbm_surface_internal_dump_file_raw(file, info.planes[0].ptr,
-					info.planes[0].stride * info.height,
-					info.planes[1].ptr,
-					info.planes[1].stride * (info.height >> 1),
+	if (info.format == TBM_FORMAT_NV12MT) {
+		/* the tiles are captured as linear NV12 */
+		linear = malloc(info.width * (info.height + (info.height + 1) / 2));
+		if (!linear ||
+		    !_tbm_surface_internal_detile_nv12mt(&info, linear, info.width,
+							 linear + info.width * info.height, info.width)) {
+			TBM_LOG_E("can't detile %c%c%c%c buffer", FOURCC_STR(info.format));
+			free(linear);
+			tbm_surface_unmap(surface);
+			return 0;
+		}
+		_tbm_surface_internal_dump_file_raw(file, linear,
+					info.width * info.height,
+					linear + info.width * info.height,
+					info.width * ((info.height + 1) / 2),
 					NULL, 0);
-		break;
-	case TBM_FORMAT_YUYV:
-	case TBM_FORMAT_UYVY:
-		_tbm_surface_internal_dump_file_raw(file, info.planes[0].ptr,
-					info.planes[0].stride * info.height,
-					NULL, 0, NULL, 0);
-		break;
-	default:
+		free(linear);
+	} else if (!_tbm_surface_internal_dump_file(file, &info)) {
 		TBM_LOG_E("can't dump %c%c%c%c buffer", FOURCC_STR(info.format));
 		tbm_surface_unmap(surface);
 		return 0;
@@ -34,11 +34,28 @@ SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #define _TBM_SURFACE_INTERNAL_H_
 
 #include <tbm_bufmgr.h>
+#include <tbm_surface.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief Definition for the static description of a tbm_format.
+ * @since_tizen 3.0
+ */
+typedef struct _tbm_format_desc {
+	tbm_format format;           /**< fourcc of the format */
+	const char *name;            /**< printable name ex) "TBM_FORMAT_NV12" */
+	int bpp;                     /**< bits per pixel, same as tbm_surface_internal_get_bpp() */
+	int num_planes;              /**< the number of planes */
+	int hsub;                    /**< horizontal chroma subsampling factor */
+	int vsub;                    /**< vertical chroma subsampling factor */
+	int cpp[TBM_SURF_PLANE_MAX]; /**< bytes per (subsampled) pixel of each plane */
+	int has_alpha;               /**< 1 if the format has an alpha channel */
+	int is_yuv;                  /**< 1 if the format is a YUV format */
+} tbm_format_desc_s;
+
 /**
  * @brief Queries formats which the system can support.
  * @since_tizen @if MOBILE 2.3 @elseif WEARABLE 2.3.1 @endif
@@ -68,6 +85,61 @@ extern "C" {
 int tbm_surface_internal_query_supported_formats(uint32_t **formats,
 						 uint32_t *num);
 
+/**
+ * @brief Gets formats which the system can support without allocating.
+ * @details
+ * The formats of the backend are queried once and cached in the buffer
+ * manager, this function copies them to the array of the caller.
+ * @param[out] formats : the array for the formats, NULL to get the number only
+ * @param[in] size : the number of the entries of formats
+ * @param[out] num : the number of formats, may be more than size
+ * @return 1 if this function succeeds, otherwise 0
+ * @par Example
+   @code
+   #include <tbm_surface.h>
+   #include <tbm_surface_internal.h>
+
+   uint32_t formats[64];
+   uint32_t format_num;
+
+   ret = tbm_surface_internal_get_supported_formats (formats, 64, &format_num);
+   @endcode
+ */
+int tbm_surface_internal_get_supported_formats(uint32_t *formats, uint32_t size,
+					       uint32_t *num);
+
+/**
+ * @brief Checks if the system can support a format.
+ * @details
+ * The check is a bit test in the cached formats of the buffer manager, it
+ * is cheap enough to be called at every window creation.
+ * @param[in] format : the format of surface
+ * @return 1 if the format is supported, otherwise 0
+ */
+int tbm_surface_internal_is_format_supported(tbm_format format);
+
+/**
+ * @brief Gets the description of a format.
+ * @since_tizen 3.0
+ * @details
+ * The description is static and must not be freed. The lookup does not
+ * take any lock, so it is cheap enough to be called on hot paths.
+ * @param[in] format : the format of surface
+ * @return the description if the format is known, otherwise NULL
+ * @par Example
+   @code
+   #include <tbm_surface.h>
+   #include <tbm_surface_internal.h>
+
+   const tbm_format_desc_s *desc;
+
+   desc = tbm_format_get_desc (TBM_FORMAT_NV12);
+   if (desc && desc->is_yuv)
+      chroma_height = height / desc->vsub;
+   @endcode
+ */
+const tbm_format_desc_s *tbm_format_get_desc(tbm_format format);
+
 /**
  * @brief Creates the tbm_surface with memory type.
  * @since_tizen @if MOBILE 2.3 @elseif WEARABLE 2.3.1 @endif
@@ -107,6 +179,40 @@ int tbm_surface_internal_query_supported_formats(uint32_t **formats,
 tbm_surface_h tbm_surface_internal_create_with_flags(int width, int height,
 						     int format, int flags);
 
+/**
+ * @brief Creates the tbm_surfaces with the same size, format and memory type.
+ * @details
+ * The plane layout is queried once and the buffer objects of all surfaces
+ * are allocated in a batch, which is cheaper than calling
+ * tbm_surface_internal_create_with_flags() count times when setting up
+ * a swapchain. Either all surfaces are created or none of them.
+ * @param[in] width  : the width of surface
+ * @param[in] height : the height of surface
+ * @param[in] format : the format of surface
+ * @param[in] flags  : the flags of memory type
+ * @param[in] count  : the number of surfaces
+ * @param[out] surfaces : the array of count tbm_surface_h to be filled
+ * @return 1 if this function succeeds, otherwise 0
+ * @par Example
+   @code
+   #include <tbm_surface.h>
+   #include <tbm_surface_internal.h>
+
+   tbm_surface_h surfaces[3];
+   int i;
+
+   if (!tbm_surface_internal_create_multi (720, 1280, TBM_FORMAT_ARGB8888, TBM_BO_SCANOUT, 3, surfaces))
+      return;
+
+   ...
+
+   for (i = 0; i < 3; i++)
+      tbm_surface_destroy (surfaces[i]);
+   @endcode
+ */
+int tbm_surface_internal_create_multi(int width, int height, int format, int flags,
+				      int count, tbm_surface_h *surfaces);
+
 /**
  * @brief Creates the tbm_surface with buffer objects.
  * @since_tizen @if MOBILE 2.3 @elseif WEARABLE 2.3.1 @endif
@@ -156,6 +262,40 @@ tbm_surface_h tbm_surface_internal_create_with_flags(int width, int height,
 tbm_surface_h tbm_surface_internal_create_with_bos(tbm_surface_info_s *info,
 						   tbm_bo *bos, int num);
 
+/**
+ * @brief Creates a surface which is a rectangle of another surface.
+ * @since_tizen 3.0
+ * @details
+ * The view shares the buffer objects of the parent, nothing is copied. Its
+ * planes start at (x, y) of the planes of the parent with the same strides.
+ * The view holds a reference to the parent until it is destroyed, so the
+ * parent can be destroyed first. (x, y) has to be on the chroma samples of
+ * a YUV format, ex) even for NV12. A tiled parent can't have views.
+ * @param[in] parent : the surface which the view is in
+ * @param[in] x : the left of the view in the parent
+ * @param[in] y : the top of the view in the parent
+ * @param[in] width : the width of the view
+ * @param[in] height : the height of the view
+ * @return a tbm_surface_h if this function succeeds, otherwise NULL
+ * @par Example
+   @code
+   #include <tbm_surface.h>
+   #include <tbm_surface_internal.h>
+
+   tbm_surface_h frame, left_eye;
+
+   frame = tbm_surface_create (3840, 1080, TBM_FORMAT_NV12);
+   left_eye = tbm_surface_internal_create_view (frame, 0, 0, 1920, 1080);
+
+   ...
+
+   tbm_surface_destroy (left_eye);
+   tbm_surface_destroy (frame);
+   @endcode
+ */
+tbm_surface_h tbm_surface_internal_create_view(tbm_surface_h parent, int x, int y,
+					       int width, int height);
+
 /**
  * @brief Destroy the tbm surface
     TODO:
@@ -418,6 +558,23 @@ int tbm_surface_internal_delete_user_data(tbm_surface_h surface,
  */
 void tbm_surface_internal_dump_start(char *path, int w, int h, int count);
 
+/**
+ * @brief Start the dump debugging into a compressed memory ring.
+ * @details
+ * Unlike tbm_surface_internal_dump_start(), no buffer is allocated for
+ * every frame: tbm_surface_internal_dump_buffer() and
+ * tbm_surface_internal_dump_shm_buffer() compress the whole frame with LZ4
+ * into a ring of size bytes, and the oldest frames are evicted for the new
+ * ones, so the ring keeps the last frames which fit. The frames are
+ * decompressed and their files written by tbm_surface_internal_dump_end().
+ * The formats of tbm_surface_internal_dump_buffer() are supported.
+ * @param[in] path : the given dump path
+ * @param[in] size : the size of the ring in bytes
+ * @return 1 if success, otherwise 0.
+ * @see #tbm_surface_internal_dump_end()
+ */
+int tbm_surface_internal_dump_ring_start(const char *path, int size);
+
 /**
  * @brief End the dump debugging.
  * @since_tizen 3.0
@@ -428,17 +585,9 @@ void tbm_surface_internal_dump_end(void);
 /**
  * @brief Dump a buffer
  * @details
- * This function supports only if a buffer has below formats.
- * - TBM_FORMAT_ARGB8888
- * - TBM_FORMAT_XRGB8888
- * - TBM_FORMAT_YVU420
- * - TBM_FORMAT_YUV420
- * - TBM_FORMAT_NV12
- * - TBM_FORMAT_NV21
- * - TBM_FORMAT_YUYV
- * - TBM_FORMAT_UYVY
- * The filename extension should be "png" for TBM_FORMAT_ARGB8888 and TBM_FORMAT_XRGB8888
- * or "yuv" for YUV formats.
+ * This function supports every format which has a descriptor, see
+ * tbm_format_get_desc(). TBM_FORMAT_NV12MT is dumped as TBM_FORMAT_NV12.
+ * The filename extension is "png" for RGB formats or "yuv" for YUV formats.
  * @param[in] surface : a tbm surface
  * @param[in] name : a string used by a file name
  */
@@ -456,6 +605,179 @@ void tbm_surface_internal_dump_buffer(tbm_surface_h surface, const char *name);
  */
 void tbm_surface_internal_dump_shm_buffer(void *ptr, int w, int h, int stride, const char *name);
 
+/**
+ * @brief Enumeration of the row filters of the png dumps.
+ */
+typedef enum {
+	TBM_SURFACE_PNG_FILTER_DEFAULT = 0,	/**< libpng picks a filter for every row */
+	TBM_SURFACE_PNG_FILTER_NONE,		/**< no filter, the fastest */
+	TBM_SURFACE_PNG_FILTER_SUB,		/**< the difference to the left pixel */
+	TBM_SURFACE_PNG_FILTER_UP,		/**< the difference to the pixel above */
+	TBM_SURFACE_PNG_FILTER_PAETH,		/**< the paeth predictor */
+} tbm_surface_png_filter_e;
+
+/**
+ * @brief Sets the compression of the png files of the dump and the capture.
+ * @details
+ * The default is the zlib default level with the filters picked by libpng,
+ * the level 1 with TBM_SURFACE_PNG_FILTER_NONE is many times faster for
+ * larger files. With the none, sub or up filter the large images are cut
+ * in strips which are compressed in parallel by the worker threads.
+ * @param[in] level : the zlib level from 0 to 9, -1 is the zlib default
+ * @param[in] filter : the row filter
+ * @return 1 if success, otherwise 0.
+ */
+int tbm_surface_internal_dump_set_png_compression(int level, tbm_surface_png_filter_e filter);
+
+/**
+ * @brief The counters of the asynchronous dump.
+ */
+typedef struct _tbm_surface_dump_stats {
+	unsigned int queued;	/**< the frames copied and queued to the writer */
+	unsigned int written;	/**< the files written */
+	unsigned int dropped;	/**< the frames dropped while the writer was behind */
+	unsigned int failed;	/**< the frames failed to be copied or written */
+} tbm_surface_dump_stats_s;
+
+/**
+ * @brief Enumeration of the outputs of the asynchronous dump.
+ */
+typedef enum {
+	TBM_SURFACE_DUMP_MODE_FILES = 0,	/**< a png or yuv file for every frame */
+	TBM_SURFACE_DUMP_MODE_STREAM,		/**< all the frames appended to one stream file */
+	TBM_SURFACE_DUMP_MODE_Y4M,		/**< the YUV frames appended to one y4m file as I420 */
+} tbm_surface_dump_mode_e;
+
+/**
+ * @brief The header of a frame of a dump stream.
+ */
+typedef struct _tbm_surface_dump_frame {
+	tbm_format format;				/**< the format of the frame */
+	uint32_t width;					/**< the width of the frame */
+	uint32_t height;				/**< the height of the frame */
+	uint32_t num_planes;				/**< the number of the planes */
+	uint32_t strides[TBM_SURF_PLANE_MAX];	/**< the strides of the planes */
+	uint32_t sizes[TBM_SURF_PLANE_MAX];		/**< the sizes of the planes */
+	uint64_t offsets[TBM_SURF_PLANE_MAX];	/**< the offsets of the planes in the file, page aligned */
+	uint64_t timestamp;				/**< the CLOCK_MONOTONIC time of the dump in ns */
+	uint64_t queue_id;				/**< the queue which dumped the frame, 0 for none */
+	uint64_t surface_id;				/**< the surface which was dumped */
+	char type[16];					/**< the type given to the dump, ex) enqueue */
+} tbm_surface_dump_frame_s;
+
+/**
+ * @brief The handle of a dump stream opened for reading.
+ */
+typedef struct _tbm_surface_dump_stream *tbm_surface_dump_stream_h;
+
+/**
+ * @brief Start the asynchronous dump debugging.
+ * @details
+ * While it runs, tbm_surface_internal_dump_buffer() only copies the surface
+ * into a staging surface and a writer thread encodes and writes the file,
+ * so dumping a queue doesn't stall the frames. A TBM_FORMAT_NV12MT surface
+ * is detiled into a TBM_FORMAT_NV12 file. There are count staging surfaces,
+ * which bound the memory used, and the frames coming while they are all
+ * busy are dropped. Every frame gets its own file, named like the ones of
+ * tbm_surface_internal_capture_buffer().
+ * @param[in] path : the given dump path
+ * @param[in] count : the number of the staging surfaces
+ * @return 1 if success, otherwise 0.
+ * @see #tbm_surface_internal_dump_async_end()
+ */
+int tbm_surface_internal_dump_async_start(const char *path, int count);
+
+/**
+ * @brief Start the asynchronous dump debugging with an output mode.
+ * @details
+ * With TBM_SURFACE_DUMP_MODE_FILES it is tbm_surface_internal_dump_async_start().
+ * With TBM_SURFACE_DUMP_MODE_STREAM path is a file and all the frames are
+ * appended to it with their planes as they are, any format which
+ * tbm_surface_internal_copy() supports can be dumped. Every frame has a
+ * header with its format, size, planes, time and ids, and the file ends
+ * with an index of the frames once the dump ends. The stream is read with
+ * tbm_surface_internal_dump_stream_open().
+ * With TBM_SURFACE_DUMP_MODE_Y4M path is a file and the frames are
+ * appended to it as a YUV4MPEG2 stream of I420 frames without padding,
+ * which the encoders and the video tools read as is. TBM_FORMAT_YUV420,
+ * TBM_FORMAT_YVU420, TBM_FORMAT_NV12, TBM_FORMAT_NV21, TBM_FORMAT_NV12MT,
+ * TBM_FORMAT_YUYV and TBM_FORMAT_UYVY are supported and all the frames must
+ * have the size of the first one. The frame rate of the header is 30.
+ * @param[in] path : the given dump path, the file for a stream or y4m
+ * @param[in] count : the number of the staging surfaces
+ * @param[in] mode : the output mode
+ * @return 1 if success, otherwise 0.
+ * @see #tbm_surface_internal_dump_async_end()
+ */
+int tbm_surface_internal_dump_async_start_with_mode(const char *path, int count,
+						    tbm_surface_dump_mode_e mode);
+
+/**
+ * @brief End the asynchronous dump debugging.
+ * @details
+ * The frames already queued are written before it returns.
+ * @see #tbm_surface_internal_dump_async_start()
+ */
+void tbm_surface_internal_dump_async_end(void);
+
+/**
+ * @brief Gets the counters of the running asynchronous dump.
+ * @param[out] stats : the counters
+ * @return 1 if success, 0 if the asynchronous dump doesn't run.
+ */
+int tbm_surface_internal_dump_async_get_stats(tbm_surface_dump_stats_s *stats);
+
+/**
+ * @brief Opens a dump stream for reading.
+ * @details
+ * A stream whose writer didn't end, ex) the process died, has no index,
+ * its frames are found from the first one and a truncated last frame is
+ * left out.
+ * @param[in] file : the stream file
+ * @return the stream if success, otherwise NULL.
+ * @see #tbm_surface_internal_dump_async_start_with_mode()
+ */
+tbm_surface_dump_stream_h tbm_surface_internal_dump_stream_open(const char *file);
+
+/**
+ * @brief Closes a dump stream.
+ * @param[in] stream : the stream
+ */
+void tbm_surface_internal_dump_stream_close(tbm_surface_dump_stream_h stream);
+
+/**
+ * @brief Gets the number of the frames of a dump stream.
+ * @param[in] stream : the stream
+ * @return the number of the frames.
+ */
+int tbm_surface_internal_dump_stream_get_num_frames(tbm_surface_dump_stream_h stream);
+
+/**
+ * @brief Gets the header of a frame of a dump stream.
+ * @details
+ * The planes can be mapped from the file directly at their offsets.
+ * @param[in] stream : the stream
+ * @param[in] idx : the index of the frame
+ * @param[out] frame : the header of the frame
+ * @return 1 if success, otherwise 0.
+ */
+int tbm_surface_internal_dump_stream_get_frame(tbm_surface_dump_stream_h stream, int idx,
+					       tbm_surface_dump_frame_s *frame);
+
+/**
+ * @brief Reads a frame of a dump stream into a surface.
+ * @details
+ * The surface must have the format, width and height of the frame, the
+ * rows are copied to its strides. The frame can then be saved with
+ * tbm_surface_internal_capture_buffer().
+ * @param[in] stream : the stream
+ * @param[in] idx : the index of the frame
+ * @param[in] surface : the tbm surface
+ * @return 1 if success, otherwise 0.
+ */
+int tbm_surface_internal_dump_stream_read_frame(tbm_surface_dump_stream_h stream, int idx,
+						tbm_surface_h surface);
+
 /**
  * @brief check valid tbm surface.
  * @since_tizen 3.0
@@ -504,6 +826,260 @@ int tbm_surface_internal_capture_buffer(tbm_surface_h surface, const char *path,
 int tbm_surface_internal_capture_shm_buffer(void *ptr, int w, int h, int stride,
 				       const char *path, const char *name, const char *type);
 
+/**
+ * @brief Definition for a rectangle in a tbm surface.
+ */
+typedef struct _tbm_surface_rect {
+	int x;
+	int y;
+	int width;
+	int height;
+} tbm_surface_rect_s;
+
+/**
+ * @brief Copies the pixels of a surface into another surface.
+ * @details
+ * The src and dst surfaces must have the same format, the strides may differ.
+ * All planes are copied, the rect is scaled down for subsampled chroma planes
+ * so x and y have to be aligned to the chroma subsampling of the format.
+ * The copy uses non-temporal stores when the destination buffer object is
+ * TBM_BO_WC or TBM_BO_NONCACHABLE, and large copies are split among worker
+ * threads (TBM_WORKERS=0 disables them).
+ * @param[in] src : the source tbm surface
+ * @param[in] dst : the destination tbm surface
+ * @param[in] rect : the area to be copied, the same in both surfaces. NULL
+ *                   copies the damage of src, grown to the chroma
+ *                   subsampling, and adds it to the damage of dst, or the
+ *                   whole src surface when src has no damage.
+ * @return 1 if success, otherwise 0.
+ */
+int tbm_surface_internal_copy(tbm_surface_h src, tbm_surface_h dst, tbm_surface_rect_s *rect);
+
+/**
+ * @brief Enumeration of the filters used by the scaling.
+ */
+typedef enum {
+	TBM_SURFACE_SCALE_FILTER_NEAREST = 0,	/**< nearest neighbour */
+	TBM_SURFACE_SCALE_FILTER_BILINEAR,	/**< bilinear interpolation */
+	TBM_SURFACE_SCALE_FILTER_BOX,		/**< average of the covered pixels, for downscaling */
+} tbm_surface_scale_filter_e;
+
+/**
+ * @brief Scales an area of a surface into an area of another surface.
+ * @details
+ * The src and dst surfaces must have the same format, one of below formats.
+ * - TBM_FORMAT_ARGB8888, TBM_FORMAT_XRGB8888, TBM_FORMAT_ABGR8888,
+ *   TBM_FORMAT_XBGR8888, TBM_FORMAT_RGBA8888, TBM_FORMAT_RGBX8888,
+ *   TBM_FORMAT_BGRA8888, TBM_FORMAT_BGRX8888
+ * - TBM_FORMAT_NV12, TBM_FORMAT_NV21
+ * - TBM_FORMAT_YUV420, TBM_FORMAT_YVU420
+ * Each plane is scaled on its own, the rects are scaled down for subsampled
+ * chroma planes, so their x and y have to be aligned to the chroma
+ * subsampling. SSE2/AVX2 or NEON kernels are used when the cpu supports
+ * them and large scales are split among worker threads.
+ * @param[in] src : the source tbm surface
+ * @param[in] src_rect : the area to be read. NULL means the whole src surface.
+ * @param[in] dst : the destination tbm surface
+ * @param[in] dst_rect : the area to be written. NULL means the whole dst surface.
+ * @param[in] filter : the filter
+ * @return 1 if success, otherwise 0.
+ */
+int tbm_surface_internal_scale(tbm_surface_h src, tbm_surface_rect_s *src_rect,
+			       tbm_surface_h dst, tbm_surface_rect_s *dst_rect,
+			       tbm_surface_scale_filter_e filter);
+
+/**
+ * @brief Enumeration of the transforms of tbm_surface_internal_rotate().
+ * @details The rotations are clockwise. The flipped transforms mirror
+ * the surface horizontally first, then rotate it.
+ */
+typedef enum {
+	TBM_SURFACE_TRANSFORM_NORMAL = 0,	/**< no transform */
+	TBM_SURFACE_TRANSFORM_90,		/**< 90 degrees */
+	TBM_SURFACE_TRANSFORM_180,		/**< 180 degrees */
+	TBM_SURFACE_TRANSFORM_270,		/**< 270 degrees */
+	TBM_SURFACE_TRANSFORM_FLIPPED,		/**< horizontal flip */
+	TBM_SURFACE_TRANSFORM_FLIPPED_90,	/**< horizontal flip and 90 degrees */
+	TBM_SURFACE_TRANSFORM_FLIPPED_180,	/**< vertical flip */
+	TBM_SURFACE_TRANSFORM_FLIPPED_270,	/**< horizontal flip and 270 degrees, a transpose */
+} tbm_surface_transform_e;
+
+/**
+ * @brief Rotates or flips the pixels of a surface into another surface.
+ * @details
+ * The src and dst surfaces must have the same format. The width and height
+ * of dst are the ones of src, swapped for the 90 and 270 degrees transforms.
+ * RGB formats of 1, 2 or 4 bytes per pixel and the planar and semi-planar
+ * YUV formats (ex. TBM_FORMAT_NV12, TBM_FORMAT_YUV420) are supported, the
+ * 90 and 270 degrees transforms need the same horizontal and vertical
+ * chroma subsampling. The size of a YUV surface must be aligned to the
+ * chroma subsampling.
+ * The transposes are done in cache sized blocks with SSE2 or NEON kernels
+ * when the cpu supports them, and large surfaces are split among worker
+ * threads.
+ * @param[in] src : the source tbm surface
+ * @param[in] dst : the destination tbm surface
+ * @param[in] transform : the transform
+ * @return 1 if success, otherwise 0.
+ */
+int tbm_surface_internal_rotate(tbm_surface_h src, tbm_surface_h dst,
+				tbm_surface_transform_e transform);
+
+/**
+ * @brief Converts a TBM_FORMAT_NV12MT surface into a linear TBM_FORMAT_NV12 surface.
+ * @details
+ * NV12MT is the tiled output of the video decoders, 64x32 tiles in the
+ * Z-flipped-Z order. The src and dst surfaces must have the same width
+ * and height. The tiles are copied with SSE2 or NEON when the cpu
+ * supports them and large surfaces are split among worker threads.
+ * @param[in] src : the TBM_FORMAT_NV12MT tbm surface
+ * @param[in] dst : the TBM_FORMAT_NV12 tbm surface
+ * @return 1 if success, otherwise 0.
+ */
+int tbm_surface_internal_detile(tbm_surface_h src, tbm_surface_h dst);
+
+/**
+ * @brief Fills an area of a surface with a color.
+ * @details
+ * The color is a TBM_FORMAT_ARGB8888 value which is packed for the format
+ * of the surface. The YUV formats take it in BT.601 limited range, each
+ * plane gets its Y, U or V value, so 0xff000000 is the black of YUV too.
+ * The RGB formats of 8 and 10 bits per component, RGB565, RGB888 and the
+ * planar, semi-planar and packed YUV formats are supported.
+ * A backend which has the surface_fill hook fills the area by itself.
+ * Otherwise the rows are filled with SSE2/AVX2 or NEON stores, which are
+ * non-temporal for TBM_BO_WC or TBM_BO_NONCACHABLE memory and for large
+ * areas, and large areas are split among worker threads.
+ * @param[in] surface : the tbm surface
+ * @param[in] rect : the area to be filled, x and y have to be aligned to the
+ *                   chroma subsampling. NULL fills the whole surface.
+ * @param[in] color : the color, ex) 0xff000000 for the opaque black
+ * @return 1 if success, otherwise 0.
+ */
+int tbm_surface_internal_fill(tbm_surface_h surface, tbm_surface_rect_s *rect, uint32_t color);
+
+/**
+ * @brief Definition for the maximum number of damage rects of a surface.
+ */
+#define TBM_SURFACE_DAMAGE_MAX 8
+
+/**
+ * @brief Adds a damaged area to a surface.
+ * @details
+ * The damage tells which part of a surface changed, so the copy and the
+ * conversion can touch only that part. The rects are clipped
+ * to the surface and accumulated until tbm_surface_internal_clear_damage()
+ * is called. At most TBM_SURFACE_DAMAGE_MAX rects are kept, an overflowing
+ * rect is merged with the rect whose bounding box grows the least.
+ * A surface without any damage is considered dirty as a whole.
+ * The library writers keep the damage of their destination: when it already
+ * has damage, tbm_surface_internal_fill(), tbm_surface_internal_copy(),
+ * tbm_surface_internal_convert(), tbm_surface_internal_scale() and
+ * tbm_surface_internal_rotate() add the rect they wrote to it. Other writers
+ * of a damaged surface, ex) a client rendering by the cpu or the gpu, have
+ * to add the rects they write themselves.
+ * tbm_surface_queue clears the damage of a dequeued surface and carries the
+ * damage of an enqueued surface to the consumer which acquires it.
+ * @param[in] surface : the tbm surface
+ * @param[in] rect : the damaged area. NULL damages the whole surface.
+ * @return 1 if success, otherwise 0.
+ */
+int tbm_surface_internal_add_damage(tbm_surface_h surface, tbm_surface_rect_s *rect);
+
+/**
+ * @brief Gets the damaged areas of a surface.
+ * @param[in] surface : the tbm surface
+ * @param[out] rects : an array of TBM_SURFACE_DAMAGE_MAX rects, or NULL to
+ *                     get the number only
+ * @param[out] num : the number of the damage rects, 0 means the whole
+ *                   surface is dirty
+ * @return 1 if success, otherwise 0.
+ */
+int tbm_surface_internal_get_damage(tbm_surface_h surface, tbm_surface_rect_s *rects, int *num);
+
+/**
+ * @brief Clears the damage of a surface.
+ * @param[in] surface : the tbm surface
+ * @return 1 if success, otherwise 0.
+ */
+int tbm_surface_internal_clear_damage(tbm_surface_h surface);
+
+/**
+ * @brief Computes a hash of the pixels of a surface.
+ * @details
+ * The hash tells whether the content of a surface changed, ex) to skip the
+ * composition of a frame submitted again. It is a fast non-cryptographic
+ * hash of 64 bits built like XXH3, computed with SSE2/AVX2 or NEON when the
+ * cpu supports them. Only the visible bytes of each plane are hashed, the
+ * stride padding is not. The value depends on the format and the size of
+ * the rect, and on the endianness of the cpu.
+ * @param[in] surface : the tbm surface
+ * @param[in] rect : the area to be hashed, x and y have to be aligned to the
+ *                   chroma subsampling. NULL hashes the whole surface.
+ * @param[out] hash : the hash
+ * @return 1 if success, otherwise 0.
+ */
+int tbm_surface_internal_hash(tbm_surface_h surface, tbm_surface_rect_s *rect, uint64_t *hash);
+
+/**
+ * @brief Computes a hash of a surface rehashing only its damaged tiles.
+ * @details
+ * The hashes of the tiles of 64x64 pixels of the surface are kept with the
+ * surface, and only the tiles touched by the damage of the surface (see
+ * tbm_surface_internal_add_damage()) are hashed again. A surface without
+ * damage is hashed as a whole. The result is the hash of the tile hashes,
+ * so it differs from the one of tbm_surface_internal_hash() for the same
+ * content. Large rehashes are split among worker threads.
+ * @param[in] surface : the tbm surface
+ * @param[out] hash : the hash
+ * @return 1 if success, otherwise 0.
+ */
+int tbm_surface_internal_hash_incremental(tbm_surface_h surface, uint64_t *hash);
+
+/**
+ * @brief Enumeration of the YCbCr color encodings used by the conversion.
+ */
+typedef enum {
+	TBM_SURFACE_COLORSPACE_BT601_LIMITED = 0,	/**< BT.601, Y in [16, 235] */
+	TBM_SURFACE_COLORSPACE_BT601_FULL,		/**< BT.601, Y in [0, 255] */
+	TBM_SURFACE_COLORSPACE_BT709_LIMITED,		/**< BT.709, Y in [16, 235] */
+	TBM_SURFACE_COLORSPACE_BT709_FULL,		/**< BT.709, Y in [0, 255] */
+} tbm_surface_colorspace_e;
+
+/**
+ * @brief Converts the pixels of a surface into another surface of a different format.
+ * @details
+ * The src and dst surfaces must have the same width and height. One of them
+ * has to be TBM_FORMAT_ARGB8888 or TBM_FORMAT_XRGB8888 and the other one of
+ * below formats.
+ * - TBM_FORMAT_NV12
+ * - TBM_FORMAT_NV21
+ * - TBM_FORMAT_YUV420
+ * - TBM_FORMAT_YVU420
+ * - TBM_FORMAT_YUYV
+ * - TBM_FORMAT_UYVY
+ * The YUV data is treated as TBM_SURFACE_COLORSPACE_BT601_LIMITED.
+ * SSE2/AVX2 or NEON kernels are used when the cpu supports them.
+ * When src has damage, only its bounding box, grown to the chroma samples,
+ * is converted and added to the damage of dst.
+ * @param[in] src : the source tbm surface
+ * @param[in] dst : the destination tbm surface
+ * @return 1 if success, otherwise 0.
+ * @see tbm_surface_internal_convert_with_colorspace()
+ */
+int tbm_surface_internal_convert(tbm_surface_h src, tbm_surface_h dst);
+
+/**
+ * @brief Converts the pixels of a surface with the given color encoding.
+ * @details Same as tbm_surface_internal_convert() except the color encoding.
+ * @param[in] src : the source tbm surface
+ * @param[in] dst : the destination tbm surface
+ * @param[in] colorspace : the color encoding of the YUV surface
+ * @return 1 if success, otherwise 0.
+ */
+int tbm_surface_internal_convert_with_colorspace(tbm_surface_h src, tbm_surface_h dst,
+						  tbm_surface_colorspace_e colorspace);
+
 #ifdef __cplusplus
 }
 #endif
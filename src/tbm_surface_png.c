@@ -0,0 +1,588 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#include "config.h"
+
+#include <stdint.h>
+#include <png.h>
+#include <zlib.h>
+#include "tbm_bufmgr_int.h"
+
+#ifdef TBM_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef TBM_SIMD_AVX2
+#include <immintrin.h>
+#endif
+#ifdef TBM_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+/* The pixels of a packed RGB format are converted row by row to RGBA into
+ * one row buffer and handed to libpng, nothing is kept for the whole
+ * image. The formats of 8 bits channels, ex) ARGB8888 which is BGRA in
+ * memory, are byte swizzles, the others are unpacked channel by channel.
+ * The large images with the none, sub or up filter are cut in strips of
+ * rows which the workers filter and deflate on their own, a strip ends on
+ * a byte boundary with a sync flush so the strips are one zlib stream once
+ * put one after the other.
+ */
+
+#define TBM_PNG_STRIP_MAX	32
+
+/* the channels of a little endian pixel, in r, g, b, a order */
+typedef struct {
+	tbm_format format;
+	int bytes;					/* of a pixel */
+	uint8_t shift[4];
+	uint8_t bits[4];			/* 0 for no alpha, it is opaque then */
+} tbm_png_pixel;
+
+#define TBM_PNG_PIXEL(fmt, bytes, rs, rb, gs, gb, bs, bb, as, ab) \
+	{ fmt, bytes, { rs, gs, bs, as }, { rb, gb, bb, ab } }
+
+static const tbm_png_pixel tbm_png_pixels[] = {
+	/* no palette, the index is taken as a gray level */
+	TBM_PNG_PIXEL(TBM_FORMAT_C8,          1,  0, 8,  0, 8,  0, 8,  0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_RGB332,      1,  5, 3,  2, 3,  0, 2,  0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_BGR233,      1,  0, 3,  3, 3,  6, 2,  0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_XRGB4444,    2,  8, 4,  4, 4,  0, 4,  0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_XBGR4444,    2,  0, 4,  4, 4,  8, 4,  0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_RGBX4444,    2, 12, 4,  8, 4,  4, 4,  0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_BGRX4444,    2,  4, 4,  8, 4, 12, 4,  0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_ARGB4444,    2,  8, 4,  4, 4,  0, 4, 12, 4),
+	TBM_PNG_PIXEL(TBM_FORMAT_ABGR4444,    2,  0, 4,  4, 4,  8, 4, 12, 4),
+	TBM_PNG_PIXEL(TBM_FORMAT_RGBA4444,    2, 12, 4,  8, 4,  4, 4,  0, 4),
+	TBM_PNG_PIXEL(TBM_FORMAT_BGRA4444,    2,  4, 4,  8, 4, 12, 4,  0, 4),
+	TBM_PNG_PIXEL(TBM_FORMAT_XRGB1555,    2, 10, 5,  5, 5,  0, 5,  0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_XBGR1555,    2,  0, 5,  5, 5, 10, 5,  0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_RGBX5551,    2, 11, 5,  6, 5,  1, 5,  0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_BGRX5551,    2,  1, 5,  6, 5, 11, 5,  0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_ARGB1555,    2, 10, 5,  5, 5,  0, 5, 15, 1),
+	TBM_PNG_PIXEL(TBM_FORMAT_ABGR1555,    2,  0, 5,  5, 5, 10, 5, 15, 1),
+	TBM_PNG_PIXEL(TBM_FORMAT_RGBA5551,    2, 11, 5,  6, 5,  1, 5,  0, 1),
+	TBM_PNG_PIXEL(TBM_FORMAT_BGRA5551,    2,  1, 5,  6, 5, 11, 5,  0, 1),
+	TBM_PNG_PIXEL(TBM_FORMAT_RGB565,      2, 11, 5,  5, 6,  0, 5,  0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_BGR565,      2,  0, 5,  5, 6, 11, 5,  0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_RGB888,      3, 16, 8,  8, 8,  0, 8,  0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_BGR888,      3,  0, 8,  8, 8, 16, 8,  0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_XRGB8888,    4, 16, 8,  8, 8,  0, 8,  0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_XBGR8888,    4,  0, 8,  8, 8, 16, 8,  0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_RGBX8888,    4, 24, 8, 16, 8,  8, 8,  0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_BGRX8888,    4,  8, 8, 16, 8, 24, 8,  0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_ARGB8888,    4, 16, 8,  8, 8,  0, 8, 24, 8),
+	TBM_PNG_PIXEL(TBM_FORMAT_ABGR8888,    4,  0, 8,  8, 8, 16, 8, 24, 8),
+	TBM_PNG_PIXEL(TBM_FORMAT_RGBA8888,    4, 24, 8, 16, 8,  8, 8,  0, 8),
+	TBM_PNG_PIXEL(TBM_FORMAT_BGRA8888,    4,  8, 8, 16, 8, 24, 8,  0, 8),
+	TBM_PNG_PIXEL(TBM_FORMAT_XRGB2101010, 4, 20, 10, 10, 10, 0, 10, 0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_XBGR2101010, 4,  0, 10, 10, 10, 20, 10, 0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_RGBX1010102, 4, 22, 10, 12, 10, 2, 10, 0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_BGRX1010102, 4,  2, 10, 12, 10, 22, 10, 0, 0),
+	TBM_PNG_PIXEL(TBM_FORMAT_ARGB2101010, 4, 20, 10, 10, 10, 0, 10, 30, 2),
+	TBM_PNG_PIXEL(TBM_FORMAT_ABGR2101010, 4,  0, 10, 10, 10, 20, 10, 30, 2),
+	TBM_PNG_PIXEL(TBM_FORMAT_RGBA1010102, 4, 22, 10, 12, 10, 2, 10, 0, 2),
+	TBM_PNG_PIXEL(TBM_FORMAT_BGRA1010102, 4,  2, 10, 12, 10, 22, 10, 0, 2),
+};
+
+typedef void (*tbm_png_swizzle_func)(uint8_t *dst, const uint8_t *src, int pixels,
+				     const tbm_png_pixel *pixel);
+
+typedef struct {
+	tbm_png_swizzle_func swizzle;
+	const tbm_png_pixel *pixel;
+	const uint8_t *data;
+	int width;
+	int height;
+	int stride;
+	int level;
+	tbm_surface_png_filter_e filter;
+	int num_strips;
+	struct {
+		uint8_t *out;
+		unsigned long out_size;
+		uLong adler;
+		uLong len;				/* the bytes of the filtered rows */
+		int error;
+	} strips[TBM_PNG_STRIP_MAX];
+} tbm_png_job;
+
+static int png_level = Z_DEFAULT_COMPRESSION;
+static tbm_surface_png_filter_e png_filter = TBM_SURFACE_PNG_FILTER_DEFAULT;
+
+static const tbm_png_pixel *
+_tbm_png_get_pixel(tbm_format format)
+{
+	unsigned int i;
+
+	for (i = 0; i < sizeof(tbm_png_pixels) / sizeof(tbm_png_pixels[0]); i++) {
+		if (tbm_png_pixels[i].format == format)
+			return &tbm_png_pixels[i];
+	}
+
+	return NULL;
+}
+
+/* a channel of bits to 8 bits, the low bits repeat the high ones */
+static inline uint8_t
+_tbm_png_expand(uint32_t v, int bits)
+{
+	uint32_t max = (1 << bits) - 1;
+
+	if (bits >= 8)
+		return v >> (bits - 8);
+
+	return (v * 255 + max / 2) / max;
+}
+
+static void
+_tbm_png_unpack_c(uint8_t *dst, const uint8_t *src, int pixels, const tbm_png_pixel *pixel)
+{
+	int i, j, k;
+
+	for (i = 0; i < pixels; i++, dst += 4, src += pixel->bytes) {
+		uint32_t v = 0;
+
+		for (j = 0; j < pixel->bytes; j++)
+			v |= (uint32_t)src[j] << (j * 8);
+
+		for (k = 0; k < 4; k++) {
+			if (!pixel->bits[k])
+				dst[k] = 0xff;
+			else
+				dst[k] = _tbm_png_expand((v >> pixel->shift[k]) & ((1 << pixel->bits[k]) - 1),
+							 pixel->bits[k]);
+		}
+	}
+}
+
+/* the swizzles of the 32 bits formats of 8 bits channels */
+static void
+_tbm_png_swizzle_c(uint8_t *dst, const uint8_t *src, int pixels, const tbm_png_pixel *pixel)
+{
+	int r = pixel->shift[0] >> 3, g = pixel->shift[1] >> 3;
+	int b = pixel->shift[2] >> 3, a = pixel->shift[3] >> 3;
+	int i;
+
+	for (i = 0; i < pixels; i++, dst += 4, src += 4) {
+		dst[0] = src[r];
+		dst[1] = src[g];
+		dst[2] = src[b];
+		dst[3] = pixel->bits[3] ? src[a] : 0xff;
+	}
+}
+
+#ifdef TBM_SIMD_SSE2
+static void
+_tbm_png_swizzle_sse2(uint8_t *dst, const uint8_t *src, int pixels, const tbm_png_pixel *pixel)
+{
+	const __m128i mask = _mm_set1_epi32(0xff);
+	const __m128i opaque = _mm_set1_epi32(pixel->bits[3] ? 0 : 0xff000000);
+	const __m128i r = _mm_cvtsi32_si128(pixel->shift[0]);
+	const __m128i g = _mm_cvtsi32_si128(pixel->shift[1]);
+	const __m128i b = _mm_cvtsi32_si128(pixel->shift[2]);
+	const __m128i a = _mm_cvtsi32_si128(pixel->shift[3]);
+	int i;
+
+	for (i = 0; i + 4 <= pixels; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i * 4));
+		__m128i out;
+
+		out = _mm_and_si128(_mm_srl_epi32(v, r), mask);
+		out = _mm_or_si128(out, _mm_slli_epi32(_mm_and_si128(_mm_srl_epi32(v, g), mask), 8));
+		out = _mm_or_si128(out, _mm_slli_epi32(_mm_and_si128(_mm_srl_epi32(v, b), mask), 16));
+		out = _mm_or_si128(out, _mm_slli_epi32(_mm_srl_epi32(v, a), 24));
+
+		_mm_storeu_si128((__m128i *)(dst + i * 4), _mm_or_si128(out, opaque));
+	}
+
+	_tbm_png_swizzle_c(dst + i * 4, src + i * 4, pixels - i, pixel);
+}
+#endif
+
+#ifdef TBM_SIMD_AVX2
+static TBM_TARGET_AVX2 void
+_tbm_png_swizzle_avx2(uint8_t *dst, const uint8_t *src, int pixels, const tbm_png_pixel *pixel)
+{
+	const __m256i opaque = _mm256_set1_epi32(pixel->bits[3] ? 0 : 0xff000000);
+	uint8_t idx[32];
+	__m256i shuffle;
+	int i, k;
+
+	/* the shuffle works within the 128 bits lanes */
+	for (i = 0; i < 32; i += 4) {
+		for (k = 0; k < 4; k++)
+			idx[i + k] = (i & 15) + (pixel->shift[k] >> 3);
+	}
+	shuffle = _mm256_loadu_si256((const __m256i *)idx);
+
+	for (i = 0; i + 8 <= pixels; i += 8) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(src + i * 4));
+
+		v = _mm256_or_si256(_mm256_shuffle_epi8(v, shuffle), opaque);
+		_mm256_storeu_si256((__m256i *)(dst + i * 4), v);
+	}
+
+	_tbm_png_swizzle_c(dst + i * 4, src + i * 4, pixels - i, pixel);
+}
+#endif
+
+#ifdef TBM_SIMD_NEON
+static void
+_tbm_png_swizzle_neon(uint8_t *dst, const uint8_t *src, int pixels, const tbm_png_pixel *pixel)
+{
+	int r = pixel->shift[0] >> 3, g = pixel->shift[1] >> 3;
+	int b = pixel->shift[2] >> 3, a = pixel->shift[3] >> 3;
+	int i;
+
+	for (i = 0; i + 16 <= pixels; i += 16) {
+		uint8x16x4_t v = vld4q_u8(src + i * 4);
+		uint8x16x4_t out;
+
+		out.val[0] = v.val[r];
+		out.val[1] = v.val[g];
+		out.val[2] = v.val[b];
+		out.val[3] = pixel->bits[3] ? v.val[a] : vdupq_n_u8(0xff);
+		vst4q_u8(dst + i * 4, out);
+	}
+
+	_tbm_png_swizzle_c(dst + i * 4, src + i * 4, pixels - i, pixel);
+}
+#endif
+
+static tbm_png_swizzle_func
+_tbm_png_get_swizzle(const tbm_png_pixel *pixel)
+{
+	unsigned int features = _tbm_cpu_get_features();
+	int k;
+
+	if (pixel->bytes != 4)
+		return _tbm_png_unpack_c;
+
+	for (k = 0; k < 4; k++) {
+		if ((pixel->bits[k] != 8 && (k < 3 || pixel->bits[k])) || (pixel->shift[k] & 7))
+			return _tbm_png_unpack_c;
+	}
+
+#ifdef TBM_SIMD_AVX2
+	if (features & TBM_CPU_AVX2)
+		return _tbm_png_swizzle_avx2;
+#endif
+#ifdef TBM_SIMD_SSE2
+	if (features & TBM_CPU_SSE2)
+		return _tbm_png_swizzle_sse2;
+#endif
+#ifdef TBM_SIMD_NEON
+	if (features & TBM_CPU_NEON)
+		return _tbm_png_swizzle_neon;
+#endif
+
+	(void)features;
+
+	return _tbm_png_swizzle_c;
+}
+
+/* the filter type byte and the filtered row of cur, prev is the row above */
+static void
+_tbm_png_filter_row(uint8_t *dst, const uint8_t *cur, const uint8_t *prev, int bytes,
+		    tbm_surface_png_filter_e filter)
+{
+	int i;
+
+	switch (filter) {
+	case TBM_SURFACE_PNG_FILTER_SUB:
+		dst[0] = 1;
+		memcpy(dst + 1, cur, 4);
+		for (i = 4; i < bytes; i++)
+			dst[1 + i] = cur[i] - cur[i - 4];
+		break;
+	case TBM_SURFACE_PNG_FILTER_UP:
+		dst[0] = 2;
+		if (!prev) {
+			memcpy(dst + 1, cur, bytes);
+			break;
+		}
+		for (i = 0; i < bytes; i++)
+			dst[1 + i] = cur[i] - prev[i];
+		break;
+	default:
+		dst[0] = 0;
+		memcpy(dst + 1, cur, bytes);
+		break;
+	}
+}
+
+static void
+_tbm_png_encode_strip(void *data, int idx)
+{
+	tbm_png_job *job = data;
+	int bytes = job->width * 4;
+	int y = (int64_t)job->height * idx / job->num_strips;
+	int end = (int64_t)job->height * (idx + 1) / job->num_strips;
+	uint8_t *rows, *cur, *prev, *filtered;
+	z_stream zs;
+	int ret = Z_OK;
+
+	job->strips[idx].error = 1;
+
+	rows = calloc(3, bytes + 1);
+	if (!rows)
+		return;
+	cur = rows;
+	prev = rows + bytes + 1;
+	filtered = rows + (bytes + 1) * 2;
+
+	memset(&zs, 0, sizeof(zs));
+	if (deflateInit2(&zs, job->level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+		free(rows);
+		return;
+	}
+
+	job->strips[idx].out_size = deflateBound(&zs, (uLong)(bytes + 1) * (end - y)) + 16;
+	job->strips[idx].out = calloc(1, job->strips[idx].out_size);
+	if (!job->strips[idx].out) {
+		deflateEnd(&zs);
+		free(rows);
+		return;
+	}
+
+	zs.next_out = job->strips[idx].out;
+	zs.avail_out = job->strips[idx].out_size;
+
+	job->strips[idx].adler = adler32(0L, Z_NULL, 0);
+	job->strips[idx].len = 0;
+
+	/* the up filter of the first row needs the last row of the strip above */
+	if (y > 0)
+		job->swizzle(prev, job->data + (size_t)(y - 1) * job->stride, job->width, job->pixel);
+
+	for (; y < end && ret == Z_OK; y++) {
+		uint8_t *tmp;
+
+		job->swizzle(cur, job->data + (size_t)y * job->stride, job->width, job->pixel);
+		_tbm_png_filter_row(filtered, cur, y > 0 ? prev : NULL, bytes, job->filter);
+
+		job->strips[idx].adler = adler32(job->strips[idx].adler, filtered, bytes + 1);
+		job->strips[idx].len += bytes + 1;
+
+		zs.next_in = filtered;
+		zs.avail_in = bytes + 1;
+		if (y + 1 < end)
+			ret = deflate(&zs, Z_NO_FLUSH);
+		else
+			ret = deflate(&zs, idx + 1 < job->num_strips ? Z_SYNC_FLUSH : Z_FINISH);
+
+		tmp = prev;
+		prev = cur;
+		cur = tmp;
+	}
+
+	if (ret == Z_OK || ret == Z_STREAM_END) {
+		job->strips[idx].out_size = zs.total_out;
+		job->strips[idx].error = 0;
+	}
+
+	deflateEnd(&zs);
+	free(rows);
+}
+
+/* the IDAT chunks made of the strips, 0 when it can't so the caller encodes as usual */
+static int
+_tbm_png_write_strips(png_structp png, tbm_png_job *job)
+{
+	uint8_t header[2] = { 0x78, 0x01 };
+	uint8_t trailer[4];
+	uLong adler;
+	int i, ret = 0;
+
+	_tbm_worker_run(_tbm_png_encode_strip, job, job->num_strips);
+
+	for (i = 0; i < job->num_strips; i++) {
+		if (job->strips[i].error)
+			goto done;
+	}
+
+	adler = job->strips[0].adler;
+	for (i = 1; i < job->num_strips; i++)
+		adler = adler32_combine(adler, job->strips[i].adler, job->strips[i].len);
+
+	trailer[0] = adler >> 24;
+	trailer[1] = adler >> 16;
+	trailer[2] = adler >> 8;
+	trailer[3] = adler;
+
+	png_write_chunk(png, (png_const_bytep)"IDAT", header, sizeof(header));
+	for (i = 0; i < job->num_strips; i++)
+		png_write_chunk(png, (png_const_bytep)"IDAT", job->strips[i].out, job->strips[i].out_size);
+	png_write_chunk(png, (png_const_bytep)"IDAT", trailer, sizeof(trailer));
+	png_write_chunk(png, (png_const_bytep)"IEND", NULL, 0);
+
+	ret = 1;
+
+done:
+	for (i = 0; i < job->num_strips; i++)
+		free(job->strips[i].out);
+
+	return ret;
+}
+
+static int
+_tbm_png_get_filters(tbm_surface_png_filter_e filter)
+{
+	switch (filter) {
+	case TBM_SURFACE_PNG_FILTER_NONE:
+		return PNG_FILTER_NONE;
+	case TBM_SURFACE_PNG_FILTER_SUB:
+		return PNG_FILTER_SUB;
+	case TBM_SURFACE_PNG_FILTER_UP:
+		return PNG_FILTER_UP;
+	case TBM_SURFACE_PNG_FILTER_PAETH:
+		return PNG_FILTER_PAETH;
+	default:
+		return PNG_ALL_FILTERS;
+	}
+}
+
+void
+_tbm_surface_internal_dump_file_png(const char *file, const void *data, int width, int height)
+{
+	_tbm_surface_internal_dump_file_png_format(file, data, width, height, width * 4,
+						   TBM_FORMAT_ARGB8888);
+}
+
+int
+_tbm_surface_internal_dump_file_png_format(const char *file, const void *data, int width,
+					   int height, int stride, tbm_format format)
+{
+	const tbm_png_pixel *pixel = _tbm_png_get_pixel(format);
+	tbm_png_job job;
+	png_bytep row;
+	FILE *fp;
+	int y;
+
+	TBM_RETURN_VAL_IF_FAIL(pixel != NULL, 0);
+
+	fp = fopen(file, "wb");
+	TBM_RETURN_VAL_IF_FAIL(fp != NULL, 0);
+
+	memset(&job, 0, sizeof(job));
+	job.swizzle = _tbm_png_get_swizzle(pixel);
+	job.pixel = pixel;
+	job.data = data;
+	job.width = width;
+	job.height = height;
+	job.stride = stride;
+	job.level = png_level;
+	job.filter = png_filter;
+
+	png_structp pPngStruct = png_create_write_struct(PNG_LIBPNG_VER_STRING,
+							NULL, NULL, NULL);
+	if (!pPngStruct) {
+		TBM_LOG_E("fail to create a png write structure.\n");
+		fclose(fp);
+		return 0;
+	}
+
+	png_infop pPngInfo = png_create_info_struct(pPngStruct);
+	if (!pPngInfo) {
+		TBM_LOG_E("fail to create a png info structure.\n");
+		png_destroy_write_struct(&pPngStruct, NULL);
+		fclose(fp);
+		return 0;
+	}
+
+	png_init_io(pPngStruct, fp);
+	png_set_IHDR(pPngStruct,
+			pPngInfo,
+			width,
+			height,
+			8,
+			PNG_COLOR_TYPE_RGBA,
+			PNG_INTERLACE_NONE,
+			PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+
+	png_set_compression_level(pPngStruct, png_level);
+	png_set_filter(pPngStruct, PNG_FILTER_TYPE_BASE, _tbm_png_get_filters(png_filter));
+	png_write_info(pPngStruct, pPngInfo);
+
+	if (png_filter == TBM_SURFACE_PNG_FILTER_NONE ||
+	    png_filter == TBM_SURFACE_PNG_FILTER_SUB ||
+	    png_filter == TBM_SURFACE_PNG_FILTER_UP) {
+		job.num_strips = _tbm_worker_get_bands((uint64_t)width * height * 4);
+		if (job.num_strips > TBM_PNG_STRIP_MAX)
+			job.num_strips = TBM_PNG_STRIP_MAX;
+		if (job.num_strips > height)
+			job.num_strips = height;
+	}
+
+	if (job.num_strips > 1 && _tbm_png_write_strips(pPngStruct, &job)) {
+		png_destroy_write_struct(&pPngStruct, &pPngInfo);
+		fclose(fp);
+		return 1;
+	}
+
+	row = png_malloc(pPngStruct, width * 4);
+	if (!row) {
+		TBM_LOG_E("fail to allocate the png row.\n");
+		png_destroy_write_struct(&pPngStruct, &pPngInfo);
+		fclose(fp);
+		return 0;
+	}
+
+	for (y = 0; y < height; y++) {
+		job.swizzle(row, job.data + (size_t)y * stride, width, pixel);
+		png_write_row(pPngStruct, row);
+	}
+
+	png_write_end(pPngStruct, pPngInfo);
+
+	png_free(pPngStruct, row);
+	png_destroy_write_struct(&pPngStruct, &pPngInfo);
+
+	fclose(fp);
+
+	return 1;
+}
+
+int
+tbm_surface_internal_dump_set_png_compression(int level, tbm_surface_png_filter_e filter)
+{
+	TBM_RETURN_VAL_IF_FAIL(level >= Z_DEFAULT_COMPRESSION && level <= Z_BEST_COMPRESSION, 0);
+	TBM_RETURN_VAL_IF_FAIL(filter >= TBM_SURFACE_PNG_FILTER_DEFAULT &&
+			       filter <= TBM_SURFACE_PNG_FILTER_PAETH, 0);
+
+	png_level = level;
+	png_filter = filter;
+
+	TBM_TRACE("level(%d) filter(%d)\n", level, filter);
+
+	return 1;
+}
@@ -0,0 +1,326 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#include "config.h"
+
+#include "tbm_bufmgr_int.h"
+#include "tbm_surface_pool.h"
+#include "list.h"
+
+typedef struct {
+	tbm_surface_h surface;
+
+	int width;
+	int height;
+	int format;
+	int flags;
+	unsigned int size;
+
+	/* link of cache_list or acquired_list */
+	struct list_head item_link;
+} tbm_surface_pool_entry;
+
+struct _tbm_surface_pool {
+	pthread_mutex_t lock;
+
+	unsigned int max_size;
+	unsigned int max_count;
+
+	/* the most recently released entry comes first */
+	struct list_head cache_list;
+	struct list_head acquired_list;
+
+	tbm_surface_pool_stats_s stats;
+};
+
+static int
+_tbm_surface_pool_over_limit(tbm_surface_pool_h pool)
+{
+	if (pool->max_count && pool->stats.num_cached > pool->max_count)
+		return 1;
+
+	if (pool->max_size && pool->stats.cached_size > pool->max_size)
+		return 1;
+
+	return 0;
+}
+
+/* move the least recently used entries to evict_list until the pool
+ * respects its limits. must be called with the pool locked.
+ */
+static void
+_tbm_surface_pool_evict(tbm_surface_pool_h pool, struct list_head *evict_list)
+{
+	tbm_surface_pool_entry *entry;
+
+	while (_tbm_surface_pool_over_limit(pool) && !LIST_IS_EMPTY(&pool->cache_list)) {
+		entry = LIST_ENTRY(tbm_surface_pool_entry, pool->cache_list.prev, item_link);
+
+		LIST_DEL(&entry->item_link);
+		LIST_ADDTAIL(&entry->item_link, evict_list);
+
+		pool->stats.num_cached--;
+		pool->stats.cached_size -= entry->size;
+		pool->stats.evictions++;
+	}
+}
+
+static void
+_tbm_surface_pool_free_entries(struct list_head *list)
+{
+	tbm_surface_pool_entry *entry = NULL, *tmp = NULL;
+
+	LIST_FOR_EACH_ENTRY_SAFE(entry, tmp, list, item_link) {
+		LIST_DEL(&entry->item_link);
+
+		if (entry->surface)
+			tbm_surface_internal_unref(entry->surface);
+
+		free(entry);
+	}
+}
+
+tbm_surface_pool_h
+tbm_surface_pool_create(unsigned int max_size, unsigned int max_count)
+{
+	tbm_surface_pool_h pool;
+
+	pool = calloc(1, sizeof(struct _tbm_surface_pool));
+	if (!pool) {
+		TBM_LOG_E("fail to alloc surface pool\n");
+		return NULL;
+	}
+
+	if (pthread_mutex_init(&pool->lock, NULL)) {
+		TBM_LOG_E("fail: pthread_mutex_init for surface pool\n");
+		free(pool);
+		return NULL;
+	}
+
+	pool->max_size = max_size;
+	pool->max_count = max_count;
+
+	LIST_INITHEAD(&pool->cache_list);
+	LIST_INITHEAD(&pool->acquired_list);
+
+	TBM_TRACE("tbm_surface_pool(%p) max_size(%u) max_count(%u)\n", pool, max_size, max_count);
+
+	return pool;
+}
+
+void
+tbm_surface_pool_destroy(tbm_surface_pool_h pool)
+{
+	tbm_surface_pool_entry *entry = NULL, *tmp = NULL;
+
+	TBM_RETURN_IF_FAIL(pool);
+
+	TBM_TRACE("tbm_surface_pool(%p)\n", pool);
+
+	_tbm_surface_pool_free_entries(&pool->cache_list);
+
+	/* the acquired surfaces belong to their users from now on */
+	LIST_FOR_EACH_ENTRY_SAFE(entry, tmp, &pool->acquired_list, item_link) {
+		LIST_DEL(&entry->item_link);
+		free(entry);
+	}
+
+	pthread_mutex_destroy(&pool->lock);
+	free(pool);
+}
+
+tbm_surface_h
+tbm_surface_pool_acquire(tbm_surface_pool_h pool, int width, int height,
+			 int format, int flags)
+{
+	tbm_surface_pool_entry *entry = NULL, *found = NULL;
+	tbm_surface_h surface;
+
+	TBM_RETURN_VAL_IF_FAIL(pool, NULL);
+	TBM_RETURN_VAL_IF_FAIL(width > 0, NULL);
+	TBM_RETURN_VAL_IF_FAIL(height > 0, NULL);
+
+	pthread_mutex_lock(&pool->lock);
+
+	LIST_FOR_EACH_ENTRY(entry, &pool->cache_list, item_link) {
+		if (entry->width == width && entry->height == height &&
+		    entry->format == format && entry->flags == flags) {
+			found = entry;
+			break;
+		}
+	}
+
+	if (found) {
+		LIST_DEL(&found->item_link);
+		LIST_ADD(&found->item_link, &pool->acquired_list);
+
+		pool->stats.num_cached--;
+		pool->stats.cached_size -= found->size;
+		pool->stats.num_acquired++;
+		pool->stats.hits++;
+
+		pthread_mutex_unlock(&pool->lock);
+
+		TBM_TRACE("tbm_surface_pool(%p) reuse tbm_surface(%p)\n", pool, found->surface);
+
+		return found->surface;
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+
+	entry = calloc(1, sizeof(tbm_surface_pool_entry));
+	if (!entry) {
+		TBM_LOG_E("fail to alloc pool entry\n");
+		return NULL;
+	}
+
+	surface = tbm_surface_internal_create_with_flags(width, height, format, flags);
+	if (!surface) {
+		TBM_LOG_E("fail to create surface\n");
+		free(entry);
+		return NULL;
+	}
+
+	entry->surface = surface;
+	entry->width = width;
+	entry->height = height;
+	entry->format = format;
+	entry->flags = flags;
+	entry->size = tbm_surface_internal_get_size(surface);
+
+	pthread_mutex_lock(&pool->lock);
+
+	LIST_ADD(&entry->item_link, &pool->acquired_list);
+	pool->stats.num_acquired++;
+	pool->stats.misses++;
+
+	pthread_mutex_unlock(&pool->lock);
+
+	TBM_TRACE("tbm_surface_pool(%p) new tbm_surface(%p)\n", pool, surface);
+
+	return surface;
+}
+
+void
+tbm_surface_pool_release(tbm_surface_pool_h pool, tbm_surface_h surface)
+{
+	tbm_surface_pool_entry *entry = NULL, *found = NULL;
+	struct list_head evict_list;
+
+	TBM_RETURN_IF_FAIL(pool);
+	TBM_RETURN_IF_FAIL(surface);
+
+	LIST_INITHEAD(&evict_list);
+
+	pthread_mutex_lock(&pool->lock);
+
+	LIST_FOR_EACH_ENTRY(entry, &pool->acquired_list, item_link) {
+		if (entry->surface == surface) {
+			found = entry;
+			break;
+		}
+	}
+
+	if (!found) {
+		TBM_LOG_E("error: tbm_surface(%p) is not acquired from tbm_surface_pool(%p)\n",
+			  surface, pool);
+		pthread_mutex_unlock(&pool->lock);
+		return;
+	}
+
+	LIST_DEL(&found->item_link);
+	pool->stats.num_acquired--;
+
+	/* don't hand out a surface which is still used somewhere else */
+	if (_tbm_surface_internal_get_refcnt(surface) != 1) {
+		pthread_mutex_unlock(&pool->lock);
+
+		TBM_TRACE("tbm_surface_pool(%p) tbm_surface(%p) is still referenced\n", pool, surface);
+
+		tbm_surface_internal_unref(surface);
+		free(found);
+		return;
+	}
+
+	LIST_ADD(&found->item_link, &pool->cache_list);
+	pool->stats.num_cached++;
+	pool->stats.cached_size += found->size;
+
+	_tbm_surface_pool_evict(pool, &evict_list);
+
+	pthread_mutex_unlock(&pool->lock);
+
+	TBM_TRACE("tbm_surface_pool(%p) tbm_surface(%p)\n", pool, surface);
+
+	_tbm_surface_pool_free_entries(&evict_list);
+}
+
+void
+tbm_surface_pool_flush(tbm_surface_pool_h pool)
+{
+	struct list_head flush_list;
+
+	TBM_RETURN_IF_FAIL(pool);
+
+	LIST_INITHEAD(&flush_list);
+
+	pthread_mutex_lock(&pool->lock);
+
+	/* take over the whole cache_list */
+	if (!LIST_IS_EMPTY(&pool->cache_list)) {
+		LIST_REPLACE(&pool->cache_list, &flush_list);
+		LIST_INITHEAD(&pool->cache_list);
+	}
+
+	pool->stats.evictions += pool->stats.num_cached;
+	pool->stats.num_cached = 0;
+	pool->stats.cached_size = 0;
+
+	pthread_mutex_unlock(&pool->lock);
+
+	TBM_TRACE("tbm_surface_pool(%p)\n", pool);
+
+	_tbm_surface_pool_free_entries(&flush_list);
+}
+
+int
+tbm_surface_pool_get_stats(tbm_surface_pool_h pool, tbm_surface_pool_stats_s *stats)
+{
+	TBM_RETURN_VAL_IF_FAIL(pool, 0);
+	TBM_RETURN_VAL_IF_FAIL(stats, 0);
+
+	pthread_mutex_lock(&pool->lock);
+	*stats = pool->stats;
+	pthread_mutex_unlock(&pool->lock);
+
+	return 1;
+}
@@ -0,0 +1,137 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#ifndef _TBM_SURFACE_POOL_H_
+#define _TBM_SURFACE_POOL_H_
+
+#include <tbm_surface.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct _tbm_surface_pool *tbm_surface_pool_h;
+
+/**
+ * @brief Definition for the statistics of a surface pool.
+ */
+typedef struct _tbm_surface_pool_stats {
+	unsigned int hits;          /**< acquires served by a cached surface */
+	unsigned int misses;        /**< acquires which allocated a new surface */
+	unsigned int evictions;     /**< cached surfaces destroyed to respect the limits */
+	unsigned int num_cached;    /**< the number of surfaces held by the pool */
+	unsigned int cached_size;   /**< the bytes held by the pool */
+	unsigned int num_acquired;  /**< the number of surfaces handed out and not released */
+} tbm_surface_pool_stats_s;
+
+/**
+ * @brief Creates a surface pool.
+ * @details
+ * A surface pool keeps released surfaces, with their bos and plane layout,
+ * and hands them out again to an acquire with the same width, height, format
+ * and flags. Cached surfaces beyond the limits are destroyed in least
+ * recently used order.
+ * @param[in] max_size : the maximum bytes of cached surfaces, 0 for no limit
+ * @param[in] max_count : the maximum number of cached surfaces, 0 for no limit
+ * @return a surface pool if this function succeeds, otherwise NULL
+ * @par Example
+   @code
+   #include <tbm_surface_pool.h>
+
+   tbm_surface_pool_h pool;
+   tbm_surface_h surface;
+
+   pool = tbm_surface_pool_create (32 * 1024 * 1024, 16);
+   surface = tbm_surface_pool_acquire (pool, 720, 1280, TBM_FORMAT_ARGB8888, TBM_BO_DEFAULT);
+
+   ...
+
+   tbm_surface_pool_release (pool, surface);
+   tbm_surface_pool_destroy (pool);
+   @endcode
+ */
+tbm_surface_pool_h tbm_surface_pool_create(unsigned int max_size, unsigned int max_count);
+
+/**
+ * @brief Destroys a surface pool and the surfaces cached in it.
+ * @remarks Surfaces which are still acquired are not destroyed. They must be
+ * destroyed with tbm_surface_destroy() instead of being released.
+ * @param[in] pool : the surface pool
+ */
+void tbm_surface_pool_destroy(tbm_surface_pool_h pool);
+
+/**
+ * @brief Acquires a surface from a surface pool.
+ * @details
+ * A cached surface with the same width, height, format and flags is reused
+ * if there is one, otherwise a new surface is created.
+ * @remarks The contents of a reused surface are undefined, and the user data
+ * set by the previous user is kept.
+ * @param[in] pool : the surface pool
+ * @param[in] width  : the width of surface
+ * @param[in] height : the height of surface
+ * @param[in] format : the format of surface
+ * @param[in] flags  : the flags of memory type
+ * @return a tbm_surface_h if this function succeeds, otherwise NULL
+ */
+tbm_surface_h tbm_surface_pool_acquire(tbm_surface_pool_h pool, int width, int height,
+				       int format, int flags);
+
+/**
+ * @brief Releases a surface to a surface pool.
+ * @details
+ * The surface is cached for a later acquire. If somebody else still holds
+ * a reference of the surface, the reference of the caller is dropped and
+ * the surface is not cached.
+ * @param[in] pool : the surface pool
+ * @param[in] surface : the surface acquired from the pool
+ */
+void tbm_surface_pool_release(tbm_surface_pool_h pool, tbm_surface_h surface);
+
+/**
+ * @brief Destroys all surfaces cached in a surface pool.
+ * @param[in] pool : the surface pool
+ */
+void tbm_surface_pool_flush(tbm_surface_pool_h pool);
+
+/**
+ * @brief Gets the statistics of a surface pool.
+ * @param[in] pool : the surface pool
+ * @param[out] stats : the statistics
+ * @return 1 if this function succeeds, otherwise 0
+ */
+int tbm_surface_pool_get_stats(tbm_surface_pool_h pool, tbm_surface_pool_stats_s *stats);
+
+#ifdef __cplusplus
+}
+#endif
+#endif							/* _TBM_SURFACE_POOL_H_ */
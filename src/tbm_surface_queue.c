@@ -97,6 +97,9 @@ typedef struct {
 	Queue_Node_Type type;
 
 	unsigned int priv_flags;	/*for each queue*/
+
+	int num_damage;			/* the damage of the enqueued surface */
+	tbm_surface_rect_s damage[TBM_SURFACE_DAMAGE_MAX];
 } queue_node;
 
 typedef struct {
@@ -1078,7 +1081,8 @@ tbm_surface_queue_enqueue(tbm_surface_queue_h
 	TBM_SURF_QUEUE_RETURN_VAL_IF_FAIL(surface != NULL,
 			       TBM_SURFACE_QUEUE_ERROR_INVALID_SURFACE);
 
-	if (b_dump_queue)
+	if (b_dump_queue &&
+	    !_tbm_surface_internal_dump_async_buffer(surface, surface_queue, "enqueue"))
 		tbm_surface_internal_dump_buffer(surface, "enqueue");
 
 	pthread_mutex_lock(&surface_queue->lock);
@@ -1110,6 +1114,10 @@ tbm_surface_queue_enqueue(tbm_surface_queue_h
 
 	node->type = QUEUE_NODE_TYPE_ENQUEUE;
 
+	/* keep the damage of this frame until it is acquired */
+	if (!tbm_surface_internal_get_damage(surface, node->damage, &node->num_damage))
+		node->num_damage = 0;
+
 	pthread_mutex_unlock(&surface_queue->lock);
 	pthread_cond_signal(&surface_queue->dirty_cond);
 
@@ -1155,6 +1163,9 @@ tbm_surface_queue_dequeue(tbm_surface_queue_h
 	node->type = QUEUE_NODE_TYPE_DEQUEUE;
 	*surface = node->surface;
 
+	/* the producer damages the new frame from scratch */
+	tbm_surface_internal_clear_damage(node->surface);
+
 	TBM_QUEUE_TRACE("tbm_surface_queue(%p) tbm_surface(%p)\n", surface_queue, *surface);
 
 	pthread_mutex_unlock(&surface_queue->lock);
@@ -1301,6 +1312,7 @@ tbm_surface_queue_acquire(tbm_surface_queue_h
 			  surface_queue, tbm_surface_h *surface)
 {
 	queue_node *node;
+	int i;
 
 	_tbm_surf_queue_mutex_lock();
 
@@ -1330,13 +1342,18 @@ tbm_surface_queue_acquire(tbm_surface_queue_h
 
 	*surface = node->surface;
 
+	tbm_surface_internal_clear_damage(node->surface);
+	for (i = 0; i < node->num_damage; i++)
+		tbm_surface_internal_add_damage(node->surface, &node->damage[i]);
+
 	TBM_QUEUE_TRACE("tbm_surface_queue(%p) tbm_surface(%p)\n", surface_queue, *surface);
 
 	pthread_mutex_unlock(&surface_queue->lock);
 
 	_tbm_surf_queue_mutex_unlock();
 
-	if (b_dump_queue)
+	if (b_dump_queue &&
+	    !_tbm_surface_internal_dump_async_buffer(*surface, surface_queue, "acquire"))
 		tbm_surface_internal_dump_buffer(*surface, "acquire");
 
 	_trace_emit(surface_queue, &surface_queue->trace_noti, *surface, TBM_SURFACE_QUEUE_TRACE_ACQUIRE);
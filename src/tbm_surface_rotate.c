@@ -0,0 +1,694 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#include "config.h"
+
+#include <stdint.h>
+#include "tbm_bufmgr_int.h"
+
+#ifdef TBM_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef TBM_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+/* the transposes are done in blocks of 2 cache lines wide rows of
+ * pixels which stay in the cache, each block in tiles of the simd kernels
+ */
+#define TBM_ROTATE_BLOCK_SIZE	128
+#define TBM_ROTATE_TILE(cpp)	((cpp) == 4 ? 4 : 8)
+
+/* kernels of the pixels of 1, 2 and 4 bytes */
+typedef struct {
+	/* dst column i = src row i of a TBM_ROTATE_TILE x TBM_ROTATE_TILE tile */
+	void (*tile)(const uint8_t *src, intptr_t src_stride, uint8_t *dst, intptr_t dst_stride);
+	/* dst[i] = src[n - 1 - i] */
+	void (*reverse)(const uint8_t *src, uint8_t *dst, int n);
+} tbm_rotate_kernel;
+
+typedef struct {
+	tbm_rotate_kernel cpp1;
+	tbm_rotate_kernel cpp2;
+	tbm_rotate_kernel cpp4;
+} tbm_rotate_kernels;
+
+/* A transform is done as a copy, a mirror or a transpose of the src rows
+ * with the src and dst rows walked from the top or from the bottom.
+ * Negative strides point at the last row.
+ */
+typedef struct {
+	const uint8_t *src;
+	uint8_t *dst;
+	intptr_t src_stride;
+	intptr_t dst_stride;
+	int src_w, src_h;	/* in pixels */
+	int dst_h;
+	int cpp;
+	const tbm_rotate_kernel *k;
+} tbm_rotate_plane;
+
+typedef struct {
+	tbm_rotate_plane planes[TBM_SURF_PLANE_MAX];
+	int num_planes;
+	int num_bands;
+	int transpose;
+	int mirror;
+} tbm_rotate_job;
+
+static void
+_tbm_rotate_tile8_c(const uint8_t *src, intptr_t src_stride, uint8_t *dst, intptr_t dst_stride)
+{
+	int i, j;
+
+	for (i = 0; i < 8; i++)
+		for (j = 0; j < 8; j++)
+			dst[j * dst_stride + i] = src[i * src_stride + j];
+}
+
+static void
+_tbm_rotate_tile16_c(const uint8_t *src, intptr_t src_stride, uint8_t *dst, intptr_t dst_stride)
+{
+	int i, j;
+
+	for (i = 0; i < 8; i++)
+		for (j = 0; j < 8; j++)
+			((uint16_t *)(dst + j * dst_stride))[i] = ((const uint16_t *)(src + i * src_stride))[j];
+}
+
+static void
+_tbm_rotate_tile32_c(const uint8_t *src, intptr_t src_stride, uint8_t *dst, intptr_t dst_stride)
+{
+	int i, j;
+
+	for (i = 0; i < 4; i++)
+		for (j = 0; j < 4; j++)
+			((uint32_t *)(dst + j * dst_stride))[i] = ((const uint32_t *)(src + i * src_stride))[j];
+}
+
+static void
+_tbm_rotate_reverse8_c(const uint8_t *src, uint8_t *dst, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = src[n - 1 - i];
+}
+
+static void
+_tbm_rotate_reverse16_c(const uint8_t *src, uint8_t *dst, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		((uint16_t *)dst)[i] = ((const uint16_t *)src)[n - 1 - i];
+}
+
+static void
+_tbm_rotate_reverse32_c(const uint8_t *src, uint8_t *dst, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		((uint32_t *)dst)[i] = ((const uint32_t *)src)[n - 1 - i];
+}
+
+static const tbm_rotate_kernels rotate_kernels_c = {
+	{ _tbm_rotate_tile8_c, _tbm_rotate_reverse8_c },
+	{ _tbm_rotate_tile16_c, _tbm_rotate_reverse16_c },
+	{ _tbm_rotate_tile32_c, _tbm_rotate_reverse32_c },
+};
+
+#ifdef TBM_SIMD_SSE2
+static void
+_tbm_rotate_tile8_sse2(const uint8_t *src, intptr_t src_stride, uint8_t *dst, intptr_t dst_stride)
+{
+	__m128i a[8], b0, b1, b2, b3, c0, c1, c2, c3, d[4];
+	int i;
+
+	for (i = 0; i < 8; i++)
+		a[i] = _mm_loadl_epi64((const __m128i *)(src + i * src_stride));
+
+	b0 = _mm_unpacklo_epi8(a[0], a[1]);
+	b1 = _mm_unpacklo_epi8(a[2], a[3]);
+	b2 = _mm_unpacklo_epi8(a[4], a[5]);
+	b3 = _mm_unpacklo_epi8(a[6], a[7]);
+
+	/* columns 0-3 and 4-7 of the rows 0-3 and 4-7 */
+	c0 = _mm_unpacklo_epi16(b0, b1);
+	c1 = _mm_unpackhi_epi16(b0, b1);
+	c2 = _mm_unpacklo_epi16(b2, b3);
+	c3 = _mm_unpackhi_epi16(b2, b3);
+
+	/* 2 columns in each */
+	d[0] = _mm_unpacklo_epi32(c0, c2);
+	d[1] = _mm_unpackhi_epi32(c0, c2);
+	d[2] = _mm_unpacklo_epi32(c1, c3);
+	d[3] = _mm_unpackhi_epi32(c1, c3);
+
+	for (i = 0; i < 4; i++) {
+		_mm_storel_epi64((__m128i *)(dst + (i * 2) * dst_stride), d[i]);
+		_mm_storel_epi64((__m128i *)(dst + (i * 2 + 1) * dst_stride), _mm_unpackhi_epi64(d[i], d[i]));
+	}
+}
+
+static void
+_tbm_rotate_tile16_sse2(const uint8_t *src, intptr_t src_stride, uint8_t *dst, intptr_t dst_stride)
+{
+	__m128i a[8], b[8], c[8];
+	int i;
+
+	for (i = 0; i < 8; i++)
+		a[i] = _mm_loadu_si128((const __m128i *)(src + i * src_stride));
+
+	for (i = 0; i < 4; i++) {
+		b[i * 2] = _mm_unpacklo_epi16(a[i * 2], a[i * 2 + 1]);
+		b[i * 2 + 1] = _mm_unpackhi_epi16(a[i * 2], a[i * 2 + 1]);
+	}
+
+	/* c[0..3]: columns 0-1, 2-3, 4-5, 6-7 of the rows 0-3, c[4..7] of the rows 4-7 */
+	for (i = 0; i < 2; i++) {
+		c[i * 4 + 0] = _mm_unpacklo_epi32(b[i * 4 + 0], b[i * 4 + 2]);
+		c[i * 4 + 1] = _mm_unpackhi_epi32(b[i * 4 + 0], b[i * 4 + 2]);
+		c[i * 4 + 2] = _mm_unpacklo_epi32(b[i * 4 + 1], b[i * 4 + 3]);
+		c[i * 4 + 3] = _mm_unpackhi_epi32(b[i * 4 + 1], b[i * 4 + 3]);
+	}
+
+	for (i = 0; i < 4; i++) {
+		_mm_storeu_si128((__m128i *)(dst + (i * 2) * dst_stride),
+				 _mm_unpacklo_epi64(c[i], c[i + 4]));
+		_mm_storeu_si128((__m128i *)(dst + (i * 2 + 1) * dst_stride),
+				 _mm_unpackhi_epi64(c[i], c[i + 4]));
+	}
+}
+
+static void
+_tbm_rotate_tile32_sse2(const uint8_t *src, intptr_t src_stride, uint8_t *dst, intptr_t dst_stride)
+{
+	__m128i a0 = _mm_loadu_si128((const __m128i *)src);
+	__m128i a1 = _mm_loadu_si128((const __m128i *)(src + src_stride));
+	__m128i a2 = _mm_loadu_si128((const __m128i *)(src + src_stride * 2));
+	__m128i a3 = _mm_loadu_si128((const __m128i *)(src + src_stride * 3));
+	__m128i b0 = _mm_unpacklo_epi32(a0, a1);
+	__m128i b1 = _mm_unpackhi_epi32(a0, a1);
+	__m128i b2 = _mm_unpacklo_epi32(a2, a3);
+	__m128i b3 = _mm_unpackhi_epi32(a2, a3);
+
+	_mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi64(b0, b2));
+	_mm_storeu_si128((__m128i *)(dst + dst_stride), _mm_unpackhi_epi64(b0, b2));
+	_mm_storeu_si128((__m128i *)(dst + dst_stride * 2), _mm_unpacklo_epi64(b1, b3));
+	_mm_storeu_si128((__m128i *)(dst + dst_stride * 3), _mm_unpackhi_epi64(b1, b3));
+}
+
+static inline __m128i
+_tbm_rotate_reverse16_epi16(__m128i v)
+{
+	v = _mm_shufflelo_epi16(v, 0x1b);
+	v = _mm_shufflehi_epi16(v, 0x1b);
+
+	return _mm_shuffle_epi32(v, 0x4e);
+}
+
+static void
+_tbm_rotate_reverse8_sse2(const uint8_t *src, uint8_t *dst, int n)
+{
+	int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + n - i - 16));
+
+		/* swap the bytes of the words, then reverse the words */
+		v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+		_mm_storeu_si128((__m128i *)(dst + i), _tbm_rotate_reverse16_epi16(v));
+	}
+
+	if (i < n)
+		_tbm_rotate_reverse8_c(src, dst + i, n - i);
+}
+
+static void
+_tbm_rotate_reverse16_sse2(const uint8_t *src, uint8_t *dst, int n)
+{
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + (n - i - 8) * 2));
+
+		_mm_storeu_si128((__m128i *)(dst + i * 2), _tbm_rotate_reverse16_epi16(v));
+	}
+
+	if (i < n)
+		_tbm_rotate_reverse16_c(src, dst + i * 2, n - i);
+}
+
+static void
+_tbm_rotate_reverse32_sse2(const uint8_t *src, uint8_t *dst, int n)
+{
+	int i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + (n - i - 4) * 4));
+
+		_mm_storeu_si128((__m128i *)(dst + i * 4), _mm_shuffle_epi32(v, 0x1b));
+	}
+
+	if (i < n)
+		_tbm_rotate_reverse32_c(src, dst + i * 4, n - i);
+}
+
+static const tbm_rotate_kernels rotate_kernels_sse2 = {
+	{ _tbm_rotate_tile8_sse2, _tbm_rotate_reverse8_sse2 },
+	{ _tbm_rotate_tile16_sse2, _tbm_rotate_reverse16_sse2 },
+	{ _tbm_rotate_tile32_sse2, _tbm_rotate_reverse32_sse2 },
+};
+#endif
+
+#ifdef TBM_SIMD_NEON
+static void
+_tbm_rotate_tile8_neon(const uint8_t *src, intptr_t src_stride, uint8_t *dst, intptr_t dst_stride)
+{
+	uint8x8x2_t t0, t1, t2, t3;
+	uint16x4x2_t u0, u1, u2, u3;
+	uint32x2x2_t w0, w1, w2, w3;
+
+	t0 = vtrn_u8(vld1_u8(src), vld1_u8(src + src_stride));
+	t1 = vtrn_u8(vld1_u8(src + src_stride * 2), vld1_u8(src + src_stride * 3));
+	t2 = vtrn_u8(vld1_u8(src + src_stride * 4), vld1_u8(src + src_stride * 5));
+	t3 = vtrn_u8(vld1_u8(src + src_stride * 6), vld1_u8(src + src_stride * 7));
+
+	/* columns 0|4, 2|6, 1|5 and 3|7 of the rows 0-3 and 4-7 */
+	u0 = vtrn_u16(vreinterpret_u16_u8(t0.val[0]), vreinterpret_u16_u8(t1.val[0]));
+	u1 = vtrn_u16(vreinterpret_u16_u8(t0.val[1]), vreinterpret_u16_u8(t1.val[1]));
+	u2 = vtrn_u16(vreinterpret_u16_u8(t2.val[0]), vreinterpret_u16_u8(t3.val[0]));
+	u3 = vtrn_u16(vreinterpret_u16_u8(t2.val[1]), vreinterpret_u16_u8(t3.val[1]));
+
+	w0 = vtrn_u32(vreinterpret_u32_u16(u0.val[0]), vreinterpret_u32_u16(u2.val[0]));
+	w1 = vtrn_u32(vreinterpret_u32_u16(u1.val[0]), vreinterpret_u32_u16(u3.val[0]));
+	w2 = vtrn_u32(vreinterpret_u32_u16(u0.val[1]), vreinterpret_u32_u16(u2.val[1]));
+	w3 = vtrn_u32(vreinterpret_u32_u16(u1.val[1]), vreinterpret_u32_u16(u3.val[1]));
+
+	vst1_u8(dst, vreinterpret_u8_u32(w0.val[0]));
+	vst1_u8(dst + dst_stride, vreinterpret_u8_u32(w1.val[0]));
+	vst1_u8(dst + dst_stride * 2, vreinterpret_u8_u32(w2.val[0]));
+	vst1_u8(dst + dst_stride * 3, vreinterpret_u8_u32(w3.val[0]));
+	vst1_u8(dst + dst_stride * 4, vreinterpret_u8_u32(w0.val[1]));
+	vst1_u8(dst + dst_stride * 5, vreinterpret_u8_u32(w1.val[1]));
+	vst1_u8(dst + dst_stride * 6, vreinterpret_u8_u32(w2.val[1]));
+	vst1_u8(dst + dst_stride * 7, vreinterpret_u8_u32(w3.val[1]));
+}
+
+static void
+_tbm_rotate_tile16_neon(const uint8_t *src, intptr_t src_stride, uint8_t *dst, intptr_t dst_stride)
+{
+	uint16x8x2_t t0, t1, t2, t3;
+	uint32x4x2_t u0, u1, u2, u3;
+
+#define ROW(i)	vld1q_u16((const uint16_t *)(src + src_stride * (i)))
+	t0 = vtrnq_u16(ROW(0), ROW(1));
+	t1 = vtrnq_u16(ROW(2), ROW(3));
+	t2 = vtrnq_u16(ROW(4), ROW(5));
+	t3 = vtrnq_u16(ROW(6), ROW(7));
+#undef ROW
+
+	/* columns 0|4, 2|6, 1|5 and 3|7 of the rows 0-3 and 4-7 */
+	u0 = vtrnq_u32(vreinterpretq_u32_u16(t0.val[0]), vreinterpretq_u32_u16(t1.val[0]));
+	u1 = vtrnq_u32(vreinterpretq_u32_u16(t0.val[1]), vreinterpretq_u32_u16(t1.val[1]));
+	u2 = vtrnq_u32(vreinterpretq_u32_u16(t2.val[0]), vreinterpretq_u32_u16(t3.val[0]));
+	u3 = vtrnq_u32(vreinterpretq_u32_u16(t2.val[1]), vreinterpretq_u32_u16(t3.val[1]));
+
+#define COL(i, a, b, half) \
+	vst1q_u32((uint32_t *)(dst + dst_stride * (i)), \
+		  vcombine_u32(vget_##half##_u32(a), vget_##half##_u32(b)))
+	COL(0, u0.val[0], u2.val[0], low);
+	COL(1, u1.val[0], u3.val[0], low);
+	COL(2, u0.val[1], u2.val[1], low);
+	COL(3, u1.val[1], u3.val[1], low);
+	COL(4, u0.val[0], u2.val[0], high);
+	COL(5, u1.val[0], u3.val[0], high);
+	COL(6, u0.val[1], u2.val[1], high);
+	COL(7, u1.val[1], u3.val[1], high);
+#undef COL
+}
+
+static void
+_tbm_rotate_tile32_neon(const uint8_t *src, intptr_t src_stride, uint8_t *dst, intptr_t dst_stride)
+{
+	uint32x4x2_t t0, t1;
+
+	t0 = vtrnq_u32(vld1q_u32((const uint32_t *)src),
+		       vld1q_u32((const uint32_t *)(src + src_stride)));
+	t1 = vtrnq_u32(vld1q_u32((const uint32_t *)(src + src_stride * 2)),
+		       vld1q_u32((const uint32_t *)(src + src_stride * 3)));
+
+	vst1q_u32((uint32_t *)dst, vcombine_u32(vget_low_u32(t0.val[0]), vget_low_u32(t1.val[0])));
+	vst1q_u32((uint32_t *)(dst + dst_stride), vcombine_u32(vget_low_u32(t0.val[1]), vget_low_u32(t1.val[1])));
+	vst1q_u32((uint32_t *)(dst + dst_stride * 2), vcombine_u32(vget_high_u32(t0.val[0]), vget_high_u32(t1.val[0])));
+	vst1q_u32((uint32_t *)(dst + dst_stride * 3), vcombine_u32(vget_high_u32(t0.val[1]), vget_high_u32(t1.val[1])));
+}
+
+static void
+_tbm_rotate_reverse8_neon(const uint8_t *src, uint8_t *dst, int n)
+{
+	int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		uint8x16_t v = vrev64q_u8(vld1q_u8(src + n - i - 16));
+
+		vst1q_u8(dst + i, vcombine_u8(vget_high_u8(v), vget_low_u8(v)));
+	}
+
+	if (i < n)
+		_tbm_rotate_reverse8_c(src, dst + i, n - i);
+}
+
+static void
+_tbm_rotate_reverse16_neon(const uint8_t *src, uint8_t *dst, int n)
+{
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		uint16x8_t v = vrev64q_u16(vld1q_u16((const uint16_t *)src + n - i - 8));
+
+		vst1q_u16((uint16_t *)dst + i, vcombine_u16(vget_high_u16(v), vget_low_u16(v)));
+	}
+
+	if (i < n)
+		_tbm_rotate_reverse16_c(src, dst + i * 2, n - i);
+}
+
+static void
+_tbm_rotate_reverse32_neon(const uint8_t *src, uint8_t *dst, int n)
+{
+	int i;
+
+	for (i = 0; i + 4 <= n; i += 4) {
+		uint32x4_t v = vrev64q_u32(vld1q_u32((const uint32_t *)src + n - i - 4));
+
+		vst1q_u32((uint32_t *)dst + i, vcombine_u32(vget_high_u32(v), vget_low_u32(v)));
+	}
+
+	if (i < n)
+		_tbm_rotate_reverse32_c(src, dst + i * 4, n - i);
+}
+
+static const tbm_rotate_kernels rotate_kernels_neon = {
+	{ _tbm_rotate_tile8_neon, _tbm_rotate_reverse8_neon },
+	{ _tbm_rotate_tile16_neon, _tbm_rotate_reverse16_neon },
+	{ _tbm_rotate_tile32_neon, _tbm_rotate_reverse32_neon },
+};
+#endif
+
+static const tbm_rotate_kernels *
+_tbm_rotate_get_kernels(void)
+{
+	unsigned int features = _tbm_cpu_get_features();
+
+#ifdef TBM_SIMD_SSE2
+	if (features & TBM_CPU_SSE2)
+		return &rotate_kernels_sse2;
+#endif
+#ifdef TBM_SIMD_NEON
+	if (features & TBM_CPU_NEON)
+		return &rotate_kernels_neon;
+#endif
+
+	return &rotate_kernels_c;
+}
+
+static inline void
+_tbm_rotate_pixel(const uint8_t *src, uint8_t *dst, int cpp)
+{
+	switch (cpp) {
+	case 4:
+		*(uint32_t *)dst = *(const uint32_t *)src;
+		break;
+	case 2:
+		*(uint16_t *)dst = *(const uint16_t *)src;
+		break;
+	default:
+		*dst = *src;
+		break;
+	}
+}
+
+/* dst row j = src column j for the src columns [col, col_end) */
+static void
+_tbm_rotate_transpose(const tbm_rotate_plane *p, int col, int col_end)
+{
+	int tile = TBM_ROTATE_TILE(p->cpp);
+	int block = TBM_ROTATE_BLOCK_SIZE / p->cpp;
+	int bi, bj, i, j;
+
+	/* a strip of dst rows is finished before the next one, so the dst
+	 * cache lines are written in full and the reads are the partial ones
+	 */
+	for (bj = col; bj < col_end; bj += block) {
+		int je = (bj + block < col_end) ? bj + block : col_end;
+		int jt = bj + (je - bj) / tile * tile;
+
+		for (bi = 0; bi < p->src_h; bi += block) {
+			int ie = (bi + block < p->src_h) ? bi + block : p->src_h;
+			int it = bi + (ie - bi) / tile * tile;
+
+			for (i = bi; i < it; i += tile)
+				for (j = bj; j < jt; j += tile)
+					p->k->tile(p->src + i * p->src_stride + j * p->cpp, p->src_stride,
+						   p->dst + j * p->dst_stride + i * p->cpp, p->dst_stride);
+
+			/* the pixels out of the whole tiles */
+			for (i = bi; i < ie; i++)
+				for (j = (i < it) ? jt : bj; j < je; j++)
+					_tbm_rotate_pixel(p->src + i * p->src_stride + j * p->cpp,
+							  p->dst + j * p->dst_stride + i * p->cpp, p->cpp);
+		}
+	}
+}
+
+static void
+_tbm_rotate_band(void *data, int idx)
+{
+	tbm_rotate_job *job = data;
+	int i, row;
+
+	for (i = 0; i < job->num_planes; i++) {
+		tbm_rotate_plane *p = &job->planes[i];
+		int start = (int64_t)p->dst_h * idx / job->num_bands;
+		int end = (int64_t)p->dst_h * (idx + 1) / job->num_bands;
+
+		if (start == end)
+			continue;
+
+		if (job->transpose) {
+			_tbm_rotate_transpose(p, start, end);
+			continue;
+		}
+
+		for (row = start; row < end; row++) {
+			const uint8_t *src = p->src + row * p->src_stride;
+			uint8_t *dst = p->dst + row * p->dst_stride;
+
+			if (job->mirror)
+				p->k->reverse(src, dst, p->src_w);
+			else
+				memcpy(dst, src, p->src_w * p->cpp);
+		}
+	}
+}
+
+static int
+_tbm_rotate_is_supported(const tbm_format_desc_s *desc, int transpose)
+{
+	int i;
+
+	if (desc->format == TBM_FORMAT_NV12MT)
+		return 0;
+
+	for (i = 0; i < desc->num_planes; i++) {
+		if (desc->cpp[i] != 1 && desc->cpp[i] != 2 && desc->cpp[i] != 4)
+			return 0;
+	}
+
+	if (!desc->is_yuv)
+		return 1;
+
+	/* the chroma of packed YUV is shared by 2 pixels of a row, and a
+	 * transposed chroma plane has to be subsampled the same both ways
+	 */
+	if (desc->num_planes < 2)
+		return 0;
+	if (transpose && desc->hsub != desc->vsub)
+		return 0;
+
+	return 1;
+}
+
+int
+tbm_surface_internal_rotate(tbm_surface_h src, tbm_surface_h dst,
+			    tbm_surface_transform_e transform)
+{
+	const tbm_format_desc_s *desc;
+	const tbm_rotate_kernels *kernels;
+	tbm_surface_info_s src_info, dst_info;
+	tbm_surface_rect_s r;
+	tbm_rotate_job job;
+	uint64_t total = 0;
+	int width, height, flip_rows, i;
+
+	TBM_RETURN_VAL_IF_FAIL(src, 0);
+	TBM_RETURN_VAL_IF_FAIL(dst, 0);
+	TBM_RETURN_VAL_IF_FAIL(src != dst, 0);
+	TBM_RETURN_VAL_IF_FAIL(transform >= TBM_SURFACE_TRANSFORM_NORMAL &&
+			       transform <= TBM_SURFACE_TRANSFORM_FLIPPED_270, 0);
+
+	memset(&job, 0, sizeof(job));
+
+	/* the src rows are copied, mirrored or transposed with the src
+	 * (flip_rows 1) or the dst (flip_rows 2) rows taken from the bottom
+	 */
+	switch (transform) {
+	case TBM_SURFACE_TRANSFORM_NORMAL:
+		flip_rows = 0;
+		break;
+	case TBM_SURFACE_TRANSFORM_90:
+		job.transpose = 1;
+		flip_rows = 1;
+		break;
+	case TBM_SURFACE_TRANSFORM_180:
+		job.mirror = 1;
+		flip_rows = 1;
+		break;
+	case TBM_SURFACE_TRANSFORM_270:
+		job.transpose = 1;
+		flip_rows = 2;
+		break;
+	case TBM_SURFACE_TRANSFORM_FLIPPED:
+		job.mirror = 1;
+		flip_rows = 0;
+		break;
+	case TBM_SURFACE_TRANSFORM_FLIPPED_90:
+		job.transpose = 1;
+		flip_rows = 1 | 2;
+		break;
+	case TBM_SURFACE_TRANSFORM_FLIPPED_180:
+		flip_rows = 1;
+		break;
+	default:
+		job.transpose = 1;
+		flip_rows = 0;
+		break;
+	}
+
+	desc = tbm_format_get_desc(tbm_surface_internal_get_format(src));
+	if (!desc || desc->format != tbm_surface_internal_get_format(dst) ||
+	    !_tbm_rotate_is_supported(desc, job.transpose)) {
+		TBM_LOG_E("error: not supported format src(%p) dst(%p)\n", src, dst);
+		return 0;
+	}
+
+	width = tbm_surface_internal_get_width(src);
+	height = tbm_surface_internal_get_height(src);
+
+	/* the whole src, its size has to be on the chroma samples too */
+	r.x = r.y = 0;
+	r.width = width;
+	r.height = height;
+
+	if (!_tbm_format_check_rect(desc, &r, width, height) ||
+	    (job.transpose && (tbm_surface_internal_get_width(dst) != height ||
+			       tbm_surface_internal_get_height(dst) != width)) ||
+	    (!job.transpose && (tbm_surface_internal_get_width(dst) != width ||
+				tbm_surface_internal_get_height(dst) != height)) ||
+	    width % desc->hsub || height % desc->vsub) {
+		TBM_LOG_E("error: invalid size src(%p) %dx%d dst(%p)\n", src, width, height, dst);
+		return 0;
+	}
+
+	if (!tbm_surface_internal_get_info(src, TBM_SURF_OPTION_READ, &src_info, 1)) {
+		TBM_LOG_E("error: fail to map src(%p)\n", src);
+		return 0;
+	}
+
+	if (!tbm_surface_internal_get_info(dst, TBM_SURF_OPTION_WRITE, &dst_info, 1)) {
+		TBM_LOG_E("error: fail to map dst(%p)\n", dst);
+		tbm_surface_internal_unmap(src);
+		return 0;
+	}
+
+	kernels = _tbm_rotate_get_kernels();
+	job.num_planes = desc->num_planes;
+
+	for (i = 0; i < job.num_planes; i++) {
+		tbm_rotate_plane *p = &job.planes[i];
+		tbm_surface_rect_s pr;
+
+		_tbm_format_plane_rect(desc, i, &r, &pr);
+
+		p->cpp = desc->cpp[i];
+		p->k = (p->cpp == 4) ? &kernels->cpp4 : (p->cpp == 2) ? &kernels->cpp2 : &kernels->cpp1;
+		p->src_w = pr.width;
+		p->src_h = pr.height;
+		p->dst_h = job.transpose ? p->src_w : p->src_h;
+		p->src = src_info.planes[i].ptr;
+		p->dst = dst_info.planes[i].ptr;
+		p->src_stride = src_info.planes[i].stride;
+		p->dst_stride = dst_info.planes[i].stride;
+
+		if (flip_rows & 1) {
+			p->src += (p->src_h - 1) * p->src_stride;
+			p->src_stride = -p->src_stride;
+		}
+		if (flip_rows & 2) {
+			p->dst += (p->dst_h - 1) * p->dst_stride;
+			p->dst_stride = -p->dst_stride;
+		}
+
+		total += (uint64_t)p->src_w * p->src_h * p->cpp;
+	}
+
+	job.num_bands = _tbm_worker_get_bands(total);
+
+	_tbm_worker_run(_tbm_rotate_band, &job, job.num_bands);
+
+	tbm_surface_internal_unmap(dst);
+	tbm_surface_internal_unmap(src);
+
+	/* the whole dst is written */
+	if (job.transpose) {
+		r.width = height;
+		r.height = width;
+	}
+	_tbm_surface_internal_add_written_damage(dst, &r);
+
+	TBM_TRACE("src(%p) dst(%p) transform(%d) bands(%d)\n", src, dst, transform, job.num_bands);
+
+	return 1;
+}
@@ -0,0 +1,694 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#include "config.h"
+
+#include <stdint.h>
+#include "tbm_bufmgr_int.h"
+
+#ifdef TBM_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef TBM_SIMD_AVX2
+#include <immintrin.h>
+#endif
+#ifdef TBM_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+/* The planes are scaled as rows of bytes with 1, 2 or 4 interleaved
+ * channels. Sample positions are 16.16 fixed point at the pixel centers
+ * and the bilinear weights are 8-bit, blended as
+ *   (a * (256 - f) + b * f + 128) >> 8
+ * which is exact in 16 bits, so the simd kernels match the C ones.
+ */
+typedef struct {
+	/* vertical bilinear blend of n bytes, 0 < f < 256 */
+	void (*blend_rows)(const uint8_t *a, const uint8_t *b, uint8_t *dst, int n, int f);
+	/* horizontal bilinear of 4 channel pixels, x0 + 1 must be valid */
+	void (*blend_cols32)(const uint8_t *row, const int *x0, const int *fx, uint8_t *dst, int n);
+	/* nearest of 4 channel pixels */
+	void (*gather32)(const uint32_t *row, const int *x, uint32_t *dst, int n);
+	/* acc[i] += src[i] for n bytes */
+	void (*accum_row)(const uint8_t *src, uint32_t *acc, int n);
+} tbm_scale_kernels;
+
+typedef struct {
+	const uint8_t *src;
+	uint8_t *dst;
+	uint32_t src_stride;
+	uint32_t dst_stride;
+	int src_w, src_h;
+	int dst_w, dst_h;
+	int channels;
+
+	/* nearest and box: the first src column/row of a dst pixel and the
+	 * end of it for box, bilinear: the left/top src pixel and its weight
+	 */
+	int *x0, *x1;
+	int *y0, *y1;
+} tbm_scale_plane;
+
+typedef struct {
+	tbm_scale_plane planes[TBM_SURF_PLANE_MAX];
+	int num_planes;
+	int num_bands;
+	tbm_surface_scale_filter_e filter;
+	const tbm_scale_kernels *k;
+	int error;
+} tbm_scale_job;
+
+static void
+_tbm_scale_blend_rows_c(const uint8_t *a, const uint8_t *b, uint8_t *dst, int n, int f)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = (a[i] * (256 - f) + b[i] * f + 128) >> 8;
+}
+
+static void
+_tbm_scale_blend_cols32_c(const uint8_t *row, const int *x0, const int *fx, uint8_t *dst, int n)
+{
+	int i, c;
+
+	for (i = 0; i < n; i++) {
+		const uint8_t *p = row + x0[i] * 4;
+		int f = fx[i];
+
+		for (c = 0; c < 4; c++)
+			dst[c] = (p[c] * (256 - f) + p[c + 4] * f + 128) >> 8;
+		dst += 4;
+	}
+}
+
+static void
+_tbm_scale_gather32_c(const uint32_t *row, const int *x, uint32_t *dst, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = row[x[i]];
+}
+
+static void
+_tbm_scale_accum_row_c(const uint8_t *src, uint32_t *acc, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		acc[i] += src[i];
+}
+
+static const tbm_scale_kernels scale_kernels_c = {
+	_tbm_scale_blend_rows_c,
+	_tbm_scale_blend_cols32_c,
+	_tbm_scale_gather32_c,
+	_tbm_scale_accum_row_c,
+};
+
+#ifdef TBM_SIMD_SSE2
+static void
+_tbm_scale_blend_rows_sse2(const uint8_t *a, const uint8_t *b, uint8_t *dst, int n, int f)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i fa = _mm_set1_epi16(256 - f);
+	const __m128i fb = _mm_set1_epi16(f);
+	const __m128i round = _mm_set1_epi16(128);
+	int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+		__m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+		__m128i lo, hi;
+
+		lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(va, zero), fa),
+				   _mm_mullo_epi16(_mm_unpacklo_epi8(vb, zero), fb));
+		hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(va, zero), fa),
+				   _mm_mullo_epi16(_mm_unpackhi_epi8(vb, zero), fb));
+		lo = _mm_srli_epi16(_mm_add_epi16(lo, round), 8);
+		hi = _mm_srli_epi16(_mm_add_epi16(hi, round), 8);
+
+		_mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(lo, hi));
+	}
+
+	if (i < n)
+		_tbm_scale_blend_rows_c(a + i, b + i, dst + i, n - i, f);
+}
+
+static void
+_tbm_scale_blend_cols32_sse2(const uint8_t *row, const int *x0, const int *fx, uint8_t *dst, int n)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi16(128);
+	int i;
+
+	for (i = 0; i < n; i++) {
+		/* the 2 neighbours in one register, weighted as (256 - f) x 4, f x 4 */
+		__m128i p = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(row + x0[i] * 4)), zero);
+		__m128i w = _mm_unpacklo_epi64(_mm_set1_epi16(256 - fx[i]), _mm_set1_epi16(fx[i]));
+
+		p = _mm_mullo_epi16(p, w);
+		p = _mm_add_epi16(_mm_add_epi16(p, _mm_srli_si128(p, 8)), round);
+		p = _mm_srli_epi16(p, 8);
+
+		*(uint32_t *)(dst + i * 4) = _mm_cvtsi128_si32(_mm_packus_epi16(p, p));
+	}
+}
+
+static void
+_tbm_scale_accum_row_sse2(const uint8_t *src, uint32_t *acc, int n)
+{
+	const __m128i zero = _mm_setzero_si128();
+	int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i lo = _mm_unpacklo_epi8(v, zero);
+		__m128i hi = _mm_unpackhi_epi8(v, zero);
+		__m128i *a = (__m128i *)(acc + i);
+
+		_mm_storeu_si128(a, _mm_add_epi32(_mm_loadu_si128(a), _mm_unpacklo_epi16(lo, zero)));
+		_mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1), _mm_unpackhi_epi16(lo, zero)));
+		_mm_storeu_si128(a + 2, _mm_add_epi32(_mm_loadu_si128(a + 2), _mm_unpacklo_epi16(hi, zero)));
+		_mm_storeu_si128(a + 3, _mm_add_epi32(_mm_loadu_si128(a + 3), _mm_unpackhi_epi16(hi, zero)));
+	}
+
+	if (i < n)
+		_tbm_scale_accum_row_c(src + i, acc + i, n - i);
+}
+
+static const tbm_scale_kernels scale_kernels_sse2 = {
+	_tbm_scale_blend_rows_sse2,
+	_tbm_scale_blend_cols32_sse2,
+	_tbm_scale_gather32_c,
+	_tbm_scale_accum_row_sse2,
+};
+#endif
+
+#ifdef TBM_SIMD_AVX2
+static TBM_TARGET_AVX2 void
+_tbm_scale_blend_rows_avx2(const uint8_t *a, const uint8_t *b, uint8_t *dst, int n, int f)
+{
+	const __m256i fa = _mm256_set1_epi16(256 - f);
+	const __m256i fb = _mm256_set1_epi16(f);
+	const __m256i round = _mm256_set1_epi16(128);
+	int i;
+
+	for (i = 0; i + 32 <= n; i += 32) {
+		__m256i lo, hi;
+
+		lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(a + i))), fa),
+				      _mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(b + i))), fb));
+		hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(a + i + 16))), fa),
+				      _mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(b + i + 16))), fb));
+		lo = _mm256_srli_epi16(_mm256_add_epi16(lo, round), 8);
+		hi = _mm256_srli_epi16(_mm256_add_epi16(hi, round), 8);
+
+		/* packus works within 128-bit lanes */
+		_mm256_storeu_si256((__m256i *)(dst + i),
+				    _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xd8));
+	}
+
+	if (i < n)
+		_tbm_scale_blend_rows_sse2(a + i, b + i, dst + i, n - i, f);
+}
+
+static TBM_TARGET_AVX2 void
+_tbm_scale_gather32_avx2(const uint32_t *row, const int *x, uint32_t *dst, int n)
+{
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m256i idx = _mm256_loadu_si256((const __m256i *)(x + i));
+
+		_mm256_storeu_si256((__m256i *)(dst + i),
+				    _mm256_i32gather_epi32((const int *)row, idx, 4));
+	}
+
+	if (i < n)
+		_tbm_scale_gather32_c(row, x + i, dst + i, n - i);
+}
+
+static TBM_TARGET_AVX2 void
+_tbm_scale_accum_row_avx2(const uint8_t *src, uint32_t *acc, int n)
+{
+	int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+		__m256i *a = (__m256i *)(acc + i);
+
+		_mm256_storeu_si256(a, _mm256_add_epi32(_mm256_loadu_si256(a), _mm256_cvtepu8_epi32(v)));
+		_mm256_storeu_si256(a + 1, _mm256_add_epi32(_mm256_loadu_si256(a + 1),
+							    _mm256_cvtepu8_epi32(_mm_srli_si128(v, 8))));
+	}
+
+	if (i < n)
+		_tbm_scale_accum_row_c(src + i, acc + i, n - i);
+}
+
+static const tbm_scale_kernels scale_kernels_avx2 = {
+	_tbm_scale_blend_rows_avx2,
+	_tbm_scale_blend_cols32_sse2,
+	_tbm_scale_gather32_avx2,
+	_tbm_scale_accum_row_avx2,
+};
+#endif
+
+#ifdef TBM_SIMD_NEON
+static void
+_tbm_scale_blend_rows_neon(const uint8_t *a, const uint8_t *b, uint8_t *dst, int n, int f)
+{
+	const uint8x8_t fa = vdup_n_u8(256 - f);
+	const uint8x8_t fb = vdup_n_u8(f);
+	int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		uint8x16_t va = vld1q_u8(a + i);
+		uint8x16_t vb = vld1q_u8(b + i);
+		uint16x8_t lo, hi;
+
+		lo = vmlal_u8(vmull_u8(vget_low_u8(va), fa), vget_low_u8(vb), fb);
+		hi = vmlal_u8(vmull_u8(vget_high_u8(va), fa), vget_high_u8(vb), fb);
+
+		/* vrshrn adds the 128 */
+		vst1q_u8(dst + i, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+	}
+
+	if (i < n)
+		_tbm_scale_blend_rows_c(a + i, b + i, dst + i, n - i, f);
+}
+
+static void
+_tbm_scale_blend_cols32_neon(const uint8_t *row, const int *x0, const int *fx, uint8_t *dst, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		uint16x8_t p = vmovl_u8(vld1_u8(row + x0[i] * 4));
+		uint16x8_t w = vcombine_u16(vdup_n_u16(256 - fx[i]), vdup_n_u16(fx[i]));
+		uint16x4_t s;
+
+		p = vmulq_u16(p, w);
+		s = vadd_u16(vget_low_u16(p), vget_high_u16(p));
+		s = vshr_n_u16(vadd_u16(s, vdup_n_u16(128)), 8);
+
+		dst[i * 4 + 0] = vget_lane_u16(s, 0);
+		dst[i * 4 + 1] = vget_lane_u16(s, 1);
+		dst[i * 4 + 2] = vget_lane_u16(s, 2);
+		dst[i * 4 + 3] = vget_lane_u16(s, 3);
+	}
+}
+
+static void
+_tbm_scale_accum_row_neon(const uint8_t *src, uint32_t *acc, int n)
+{
+	int i;
+
+	for (i = 0; i + 8 <= n; i += 8) {
+		uint16x8_t v = vmovl_u8(vld1_u8(src + i));
+
+		vst1q_u32(acc + i, vaddw_u16(vld1q_u32(acc + i), vget_low_u16(v)));
+		vst1q_u32(acc + i + 4, vaddw_u16(vld1q_u32(acc + i + 4), vget_high_u16(v)));
+	}
+
+	if (i < n)
+		_tbm_scale_accum_row_c(src + i, acc + i, n - i);
+}
+
+static const tbm_scale_kernels scale_kernels_neon = {
+	_tbm_scale_blend_rows_neon,
+	_tbm_scale_blend_cols32_neon,
+	_tbm_scale_gather32_c,
+	_tbm_scale_accum_row_neon,
+};
+#endif
+
+static const tbm_scale_kernels *
+_tbm_scale_get_kernels(void)
+{
+	unsigned int features = _tbm_cpu_get_features();
+
+#ifdef TBM_SIMD_AVX2
+	if (features & TBM_CPU_AVX2)
+		return &scale_kernels_avx2;
+#endif
+#ifdef TBM_SIMD_SSE2
+	if (features & TBM_CPU_SSE2)
+		return &scale_kernels_sse2;
+#endif
+#ifdef TBM_SIMD_NEON
+	if (features & TBM_CPU_NEON)
+		return &scale_kernels_neon;
+#endif
+
+	return &scale_kernels_c;
+}
+
+/* builds the src sample positions of the dst columns or rows */
+static void
+_tbm_scale_make_table(tbm_surface_scale_filter_e filter, int src_len, int dst_len,
+		      int *t0, int *t1)
+{
+	int i;
+
+	for (i = 0; i < dst_len; i++) {
+		int64_t pos;
+
+		switch (filter) {
+		case TBM_SURFACE_SCALE_FILTER_NEAREST:
+			t0[i] = ((int64_t)(2 * i + 1) * src_len) / (2 * dst_len);
+			if (t0[i] > src_len - 1)
+				t0[i] = src_len - 1;
+			t1[i] = t0[i] + 1;
+			break;
+		case TBM_SURFACE_SCALE_FILTER_BILINEAR:
+			pos = ((int64_t)(2 * i + 1) * src_len << 16) / (2 * dst_len) - 32768;
+			if (pos < 0)
+				pos = 0;
+
+			t0[i] = pos >> 16;
+			t1[i] = (pos >> 8) & 0xff;
+
+			/* the last pixel is the right neighbour with the full weight */
+			if (src_len == 1) {
+				t0[i] = 0;
+				t1[i] = 0;
+			} else if (t0[i] >= src_len - 1) {
+				t0[i] = src_len - 2;
+				t1[i] = 256;
+			}
+			break;
+		default:
+			t0[i] = ((int64_t)i * src_len) / dst_len;
+			t1[i] = ((int64_t)(i + 1) * src_len) / dst_len;
+			if (t1[i] <= t0[i])
+				t1[i] = t0[i] + 1;
+			break;
+		}
+	}
+}
+
+static void
+_tbm_scale_row_nearest(const tbm_scale_kernels *k, const tbm_scale_plane *p,
+		       const uint8_t *src, uint8_t *dst)
+{
+	int i;
+
+	switch (p->channels) {
+	case 4:
+		k->gather32((const uint32_t *)src, p->x0, (uint32_t *)dst, p->dst_w);
+		break;
+	case 2:
+		for (i = 0; i < p->dst_w; i++)
+			((uint16_t *)dst)[i] = ((const uint16_t *)src)[p->x0[i]];
+		break;
+	default:
+		for (i = 0; i < p->dst_w; i++)
+			dst[i] = src[p->x0[i]];
+		break;
+	}
+}
+
+static void
+_tbm_scale_row_bilinear(const tbm_scale_kernels *k, const tbm_scale_plane *p,
+			const uint8_t *src, uint8_t *dst)
+{
+	int ch = p->channels;
+	int i, c;
+
+	if (ch == 4 && p->src_w >= 2) {
+		k->blend_cols32(src, p->x0, p->x1, dst, p->dst_w);
+		return;
+	}
+
+	for (i = 0; i < p->dst_w; i++) {
+		const uint8_t *s = src + p->x0[i] * ch;
+		int f = p->x1[i];
+
+		for (c = 0; c < ch; c++)
+			dst[c] = f ? (s[c] * (256 - f) + s[c + ch] * f + 128) >> 8 : s[c];
+		dst += ch;
+	}
+}
+
+static void
+_tbm_scale_row_box(const tbm_scale_plane *p, const uint32_t *acc, int rows, uint8_t *dst)
+{
+	int ch = p->channels;
+	int i, c, x;
+
+	for (i = 0; i < p->dst_w; i++) {
+		uint32_t n = (uint32_t)(p->x1[i] - p->x0[i]) * rows;
+
+		for (c = 0; c < ch; c++) {
+			uint32_t sum = 0;
+
+			for (x = p->x0[i]; x < p->x1[i]; x++)
+				sum += acc[x * ch + c];
+			dst[c] = (sum + n / 2) / n;
+		}
+		dst += ch;
+	}
+}
+
+static void
+_tbm_scale_band(void *data, int idx)
+{
+	tbm_scale_job *job = data;
+	const tbm_scale_kernels *k = job->k;
+	int i, r, y;
+
+	for (i = 0; i < job->num_planes; i++) {
+		tbm_scale_plane *p = &job->planes[i];
+		int start = (int64_t)p->dst_h * idx / job->num_bands;
+		int end = (int64_t)p->dst_h * (idx + 1) / job->num_bands;
+		int bytes = p->src_w * p->channels;
+		uint8_t *tmp = NULL;
+
+		if (start == end)
+			continue;
+
+		if (job->filter == TBM_SURFACE_SCALE_FILTER_BILINEAR)
+			tmp = calloc(1, bytes);
+		else if (job->filter == TBM_SURFACE_SCALE_FILTER_BOX)
+			tmp = calloc(bytes, sizeof(uint32_t));
+
+		if (job->filter != TBM_SURFACE_SCALE_FILTER_NEAREST && !tmp) {
+			TBM_LOG_E("error: fail to allocate the row buffer\n");
+			job->error = 1;
+			return;
+		}
+
+		for (r = start; r < end; r++) {
+			const uint8_t *src = p->src + p->y0[r] * p->src_stride;
+			uint8_t *dst = p->dst + r * p->dst_stride;
+			int f;
+
+			switch (job->filter) {
+			case TBM_SURFACE_SCALE_FILTER_NEAREST:
+				_tbm_scale_row_nearest(k, p, src, dst);
+				break;
+			case TBM_SURFACE_SCALE_FILTER_BILINEAR:
+				/* blend the 2 src rows first, then the columns */
+				f = p->y1[r];
+				if (f == 256)
+					src += p->src_stride;
+				else if (f) {
+					k->blend_rows(src, src + p->src_stride, tmp, bytes, f);
+					src = tmp;
+				}
+				_tbm_scale_row_bilinear(k, p, src, dst);
+				break;
+			default:
+				memset(tmp, 0, bytes * sizeof(uint32_t));
+				for (y = p->y0[r]; y < p->y1[r]; y++, src += p->src_stride)
+					k->accum_row(src, (uint32_t *)tmp, bytes);
+				_tbm_scale_row_box(p, (uint32_t *)tmp, p->y1[r] - p->y0[r], dst);
+				break;
+			}
+		}
+
+		free(tmp);
+	}
+}
+
+static int
+_tbm_scale_get_channels(tbm_format format, int plane_idx)
+{
+	switch (format) {
+	case TBM_FORMAT_ARGB8888:
+	case TBM_FORMAT_XRGB8888:
+	case TBM_FORMAT_ABGR8888:
+	case TBM_FORMAT_XBGR8888:
+	case TBM_FORMAT_RGBA8888:
+	case TBM_FORMAT_RGBX8888:
+	case TBM_FORMAT_BGRA8888:
+	case TBM_FORMAT_BGRX8888:
+		return 4;
+	case TBM_FORMAT_NV12:
+	case TBM_FORMAT_NV21:
+		return (plane_idx == 0) ? 1 : 2;
+	case TBM_FORMAT_YUV420:
+	case TBM_FORMAT_YVU420:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+static int
+_tbm_scale_check_rect(const tbm_format_desc_s *desc, tbm_surface_h surface,
+		      tbm_surface_rect_s *rect, tbm_surface_rect_s *r)
+{
+	int width = tbm_surface_internal_get_width(surface);
+	int height = tbm_surface_internal_get_height(surface);
+
+	if (rect) {
+		*r = *rect;
+	} else {
+		r->x = r->y = 0;
+		r->width = width;
+		r->height = height;
+	}
+
+	if (!_tbm_format_check_rect(desc, r, width, height)) {
+		TBM_LOG_E("error: invalid rect(%d,%d %dx%d) surface(%p)\n",
+			  r->x, r->y, r->width, r->height, surface);
+		return 0;
+	}
+
+	return 1;
+}
+
+int
+tbm_surface_internal_scale(tbm_surface_h src, tbm_surface_rect_s *src_rect,
+			   tbm_surface_h dst, tbm_surface_rect_s *dst_rect,
+			   tbm_surface_scale_filter_e filter)
+{
+	const tbm_format_desc_s *desc;
+	tbm_surface_info_s src_info, dst_info;
+	tbm_surface_rect_s sr, dr;
+	tbm_scale_job job;
+	uint64_t total = 0;
+	tbm_format format;
+	int i, ret = 0;
+
+	TBM_RETURN_VAL_IF_FAIL(src, 0);
+	TBM_RETURN_VAL_IF_FAIL(dst, 0);
+	TBM_RETURN_VAL_IF_FAIL(src != dst, 0);
+	TBM_RETURN_VAL_IF_FAIL(filter >= TBM_SURFACE_SCALE_FILTER_NEAREST &&
+			       filter <= TBM_SURFACE_SCALE_FILTER_BOX, 0);
+
+	format = tbm_surface_internal_get_format(src);
+	desc = tbm_format_get_desc(format);
+	if (!desc || format != tbm_surface_internal_get_format(dst) ||
+	    !_tbm_scale_get_channels(format, 0)) {
+		TBM_LOG_E("error: not supported format src(%p) dst(%p)\n", src, dst);
+		return 0;
+	}
+
+	if (!_tbm_scale_check_rect(desc, src, src_rect, &sr) ||
+	    !_tbm_scale_check_rect(desc, dst, dst_rect, &dr))
+		return 0;
+
+	if (!tbm_surface_internal_get_info(src, TBM_SURF_OPTION_READ, &src_info, 1)) {
+		TBM_LOG_E("error: fail to map src(%p)\n", src);
+		return 0;
+	}
+
+	if (!tbm_surface_internal_get_info(dst, TBM_SURF_OPTION_WRITE, &dst_info, 1)) {
+		TBM_LOG_E("error: fail to map dst(%p)\n", dst);
+		tbm_surface_internal_unmap(src);
+		return 0;
+	}
+
+	memset(&job, 0, sizeof(job));
+	job.num_planes = desc->num_planes;
+	job.filter = filter;
+	job.k = _tbm_scale_get_kernels();
+
+	for (i = 0; i < job.num_planes; i++) {
+		tbm_scale_plane *p = &job.planes[i];
+		tbm_surface_rect_s spr, dpr;
+
+		_tbm_format_plane_rect(desc, i, &sr, &spr);
+		_tbm_format_plane_rect(desc, i, &dr, &dpr);
+
+		p->channels = _tbm_scale_get_channels(format, i);
+		p->src_w = spr.width;
+		p->src_h = spr.height;
+		p->dst_w = dpr.width;
+		p->dst_h = dpr.height;
+		p->src_stride = src_info.planes[i].stride;
+		p->dst_stride = dst_info.planes[i].stride;
+		p->src = src_info.planes[i].ptr + spr.y * p->src_stride + spr.x * p->channels;
+		p->dst = dst_info.planes[i].ptr + dpr.y * p->dst_stride + dpr.x * p->channels;
+
+		p->x0 = calloc(2 * (p->dst_w + p->dst_h), sizeof(int));
+		if (!p->x0) {
+			TBM_LOG_E("error: fail to allocate the tables\n");
+			goto done;
+		}
+		p->x1 = p->x0 + p->dst_w;
+		p->y0 = p->x1 + p->dst_w;
+		p->y1 = p->y0 + p->dst_h;
+
+		_tbm_scale_make_table(filter, p->src_w, p->dst_w, p->x0, p->x1);
+		_tbm_scale_make_table(filter, p->src_h, p->dst_h, p->y0, p->y1);
+
+		total += (uint64_t)p->src_w * p->src_h * p->channels;
+	}
+
+	job.num_bands = _tbm_worker_get_bands(total);
+
+	_tbm_worker_run(_tbm_scale_band, &job, job.num_bands);
+
+	ret = !job.error;
+
+	TBM_TRACE("src(%p) (%d,%d %dx%d) dst(%p) (%d,%d %dx%d) filter(%d) bands(%d)\n",
+		  src, sr.x, sr.y, sr.width, sr.height,
+		  dst, dr.x, dr.y, dr.width, dr.height, filter, job.num_bands);
+
+done:
+	for (i = 0; i < job.num_planes; i++)
+		free(job.planes[i].x0);
+
+	tbm_surface_internal_unmap(dst);
+	tbm_surface_internal_unmap(src);
+
+	if (ret)
+		_tbm_surface_internal_add_written_damage(dst, &dr);
+
+	return ret;
+}
@@ -0,0 +1,307 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#include "config.h"
+
+#include <stdint.h>
+#include "tbm_bufmgr_int.h"
+
+#ifdef TBM_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#ifdef TBM_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+/* The frames of a y4m stream are I420 without any padding. The planes of
+ * the surface are taken row by row into the frame: the Y rows are copied,
+ * the interleaved chroma of NV12 and NV21 is split, and the packed 4:2:2
+ * formats give their Y to two rows and the average of the chroma of the
+ * two rows to the 4:2:0 planes.
+ */
+
+typedef struct {
+	/* n pairs of uv into u and v */
+	void (*split_uv)(uint8_t *u, uint8_t *v, const uint8_t *uv, int n);
+	/* n pairs of pixels of two YUYV rows, UYVY when uyvy is set */
+	void (*unpack_422)(uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v,
+			   const uint8_t *row0, const uint8_t *row1, int n, int uyvy);
+} tbm_y4m_kernels;
+
+static void
+_tbm_y4m_split_uv_c(uint8_t *u, uint8_t *v, const uint8_t *uv, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++) {
+		u[i] = uv[i * 2];
+		v[i] = uv[i * 2 + 1];
+	}
+}
+
+static void
+_tbm_y4m_unpack_422_c(uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v,
+		      const uint8_t *row0, const uint8_t *row1, int n, int uyvy)
+{
+	int yo = uyvy ? 1 : 0, co = uyvy ? 0 : 1;
+	int i;
+
+	for (i = 0; i < n; i++, row0 += 4, row1 += 4) {
+		y0[i * 2] = row0[yo];
+		y0[i * 2 + 1] = row0[yo + 2];
+		y1[i * 2] = row1[yo];
+		y1[i * 2 + 1] = row1[yo + 2];
+		u[i] = (row0[co] + row1[co] + 1) >> 1;
+		v[i] = (row0[co + 2] + row1[co + 2] + 1) >> 1;
+	}
+}
+
+static const tbm_y4m_kernels y4m_kernels_c = {
+	_tbm_y4m_split_uv_c,
+	_tbm_y4m_unpack_422_c,
+};
+
+#ifdef TBM_SIMD_SSE2
+static void
+_tbm_y4m_split_uv_sse2(uint8_t *u, uint8_t *v, const uint8_t *uv, int n)
+{
+	const __m128i mask = _mm_set1_epi16(0xff);
+	int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i *)(uv + i * 2));
+		__m128i b = _mm_loadu_si128((const __m128i *)(uv + i * 2 + 16));
+
+		_mm_storeu_si128((__m128i *)(u + i),
+				 _mm_packus_epi16(_mm_and_si128(a, mask), _mm_and_si128(b, mask)));
+		_mm_storeu_si128((__m128i *)(v + i),
+				 _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8)));
+	}
+
+	_tbm_y4m_split_uv_c(u + i, v + i, uv + i * 2, n - i);
+}
+
+static void
+_tbm_y4m_unpack_422_sse2(uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v,
+			 const uint8_t *row0, const uint8_t *row1, int n, int uyvy)
+{
+	const __m128i mask = _mm_set1_epi16(0xff);
+	int i;
+
+	/* 8 pairs, 16 pixels, of both rows */
+	for (i = 0; i + 8 <= n; i += 8) {
+		__m128i a0 = _mm_loadu_si128((const __m128i *)(row0 + i * 4));
+		__m128i a1 = _mm_loadu_si128((const __m128i *)(row0 + i * 4 + 16));
+		__m128i b0 = _mm_loadu_si128((const __m128i *)(row1 + i * 4));
+		__m128i b1 = _mm_loadu_si128((const __m128i *)(row1 + i * 4 + 16));
+		__m128i ya0, ya1, yb0, yb1, c0, c1, c;
+
+		if (uyvy) {
+			ya0 = _mm_srli_epi16(a0, 8);
+			ya1 = _mm_srli_epi16(a1, 8);
+			yb0 = _mm_srli_epi16(b0, 8);
+			yb1 = _mm_srli_epi16(b1, 8);
+			c0 = _mm_avg_epu8(_mm_and_si128(a0, mask), _mm_and_si128(b0, mask));
+			c1 = _mm_avg_epu8(_mm_and_si128(a1, mask), _mm_and_si128(b1, mask));
+		} else {
+			ya0 = _mm_and_si128(a0, mask);
+			ya1 = _mm_and_si128(a1, mask);
+			yb0 = _mm_and_si128(b0, mask);
+			yb1 = _mm_and_si128(b1, mask);
+			c0 = _mm_avg_epu8(_mm_srli_epi16(a0, 8), _mm_srli_epi16(b0, 8));
+			c1 = _mm_avg_epu8(_mm_srli_epi16(a1, 8), _mm_srli_epi16(b1, 8));
+		}
+
+		_mm_storeu_si128((__m128i *)(y0 + i * 2), _mm_packus_epi16(ya0, ya1));
+		_mm_storeu_si128((__m128i *)(y1 + i * 2), _mm_packus_epi16(yb0, yb1));
+
+		/* u v u v ... */
+		c = _mm_packus_epi16(c0, c1);
+		_mm_storel_epi64((__m128i *)(u + i),
+				 _mm_packus_epi16(_mm_and_si128(c, mask), _mm_setzero_si128()));
+		_mm_storel_epi64((__m128i *)(v + i),
+				 _mm_packus_epi16(_mm_srli_epi16(c, 8), _mm_setzero_si128()));
+	}
+
+	_tbm_y4m_unpack_422_c(y0 + i * 2, y1 + i * 2, u + i, v + i,
+			      row0 + i * 4, row1 + i * 4, n - i, uyvy);
+}
+
+static const tbm_y4m_kernels y4m_kernels_sse2 = {
+	_tbm_y4m_split_uv_sse2,
+	_tbm_y4m_unpack_422_sse2,
+};
+#endif
+
+#ifdef TBM_SIMD_NEON
+static void
+_tbm_y4m_split_uv_neon(uint8_t *u, uint8_t *v, const uint8_t *uv, int n)
+{
+	int i;
+
+	for (i = 0; i + 16 <= n; i += 16) {
+		uint8x16x2_t c = vld2q_u8(uv + i * 2);
+
+		vst1q_u8(u + i, c.val[0]);
+		vst1q_u8(v + i, c.val[1]);
+	}
+
+	_tbm_y4m_split_uv_c(u + i, v + i, uv + i * 2, n - i);
+}
+
+static void
+_tbm_y4m_unpack_422_neon(uint8_t *y0, uint8_t *y1, uint8_t *u, uint8_t *v,
+			 const uint8_t *row0, const uint8_t *row1, int n, int uyvy)
+{
+	int yo = uyvy ? 1 : 0, co = uyvy ? 0 : 1;
+	int i;
+
+	/* val[] is y0 u y1 v for YUYV and u y0 v y1 for UYVY */
+	for (i = 0; i + 8 <= n; i += 8) {
+		uint8x8x4_t a = vld4_u8(row0 + i * 4);
+		uint8x8x4_t b = vld4_u8(row1 + i * 4);
+		uint8x8x2_t ya = { { a.val[yo], a.val[yo + 2] } };
+		uint8x8x2_t yb = { { b.val[yo], b.val[yo + 2] } };
+
+		vst2_u8(y0 + i * 2, ya);
+		vst2_u8(y1 + i * 2, yb);
+		vst1_u8(u + i, vrhadd_u8(a.val[co], b.val[co]));
+		vst1_u8(v + i, vrhadd_u8(a.val[co + 2], b.val[co + 2]));
+	}
+
+	_tbm_y4m_unpack_422_c(y0 + i * 2, y1 + i * 2, u + i, v + i,
+			      row0 + i * 4, row1 + i * 4, n - i, uyvy);
+}
+
+static const tbm_y4m_kernels y4m_kernels_neon = {
+	_tbm_y4m_split_uv_neon,
+	_tbm_y4m_unpack_422_neon,
+};
+#endif
+
+static const tbm_y4m_kernels *
+_tbm_y4m_get_kernels(void)
+{
+	unsigned int features = _tbm_cpu_get_features();
+
+#ifdef TBM_SIMD_SSE2
+	if (features & TBM_CPU_SSE2)
+		return &y4m_kernels_sse2;
+#endif
+#ifdef TBM_SIMD_NEON
+	if (features & TBM_CPU_NEON)
+		return &y4m_kernels_neon;
+#endif
+
+	(void)features;
+
+	return &y4m_kernels_c;
+}
+
+static void
+_tbm_y4m_copy_plane(uint8_t *dst, const uint8_t *src, int stride, int bytes, int rows)
+{
+	int y;
+
+	if (stride == bytes) {
+		memcpy(dst, src, (size_t)bytes * rows);
+		return;
+	}
+
+	for (y = 0; y < rows; y++)
+		memcpy(dst + (size_t)y * bytes, src + (size_t)y * stride, bytes);
+}
+
+int
+_tbm_surface_internal_y4m_get_frame_size(int width, int height)
+{
+	int cw = (width + 1) / 2, ch = (height + 1) / 2;
+
+	return width * height + cw * ch * 2;
+}
+
+int
+_tbm_surface_internal_y4m_convert(tbm_surface_info_s *info, uint8_t *frame)
+{
+	const tbm_y4m_kernels *k = _tbm_y4m_get_kernels();
+	int w = info->width, h = info->height;
+	int cw = (w + 1) / 2, ch = (h + 1) / 2;
+	uint8_t *dst_y = frame, *dst_u = frame + w * h, *dst_v = dst_u + cw * ch;
+	const uint8_t *row1;
+	int y;
+
+	switch (info->format) {
+	case TBM_FORMAT_YUV420:
+	case TBM_FORMAT_YVU420:
+		_tbm_y4m_copy_plane(dst_y, info->planes[0].ptr, info->planes[0].stride, w, h);
+		if (info->format == TBM_FORMAT_YVU420) {
+			uint8_t *tmp = dst_u;
+
+			dst_u = dst_v;
+			dst_v = tmp;
+		}
+		_tbm_y4m_copy_plane(dst_u, info->planes[1].ptr, info->planes[1].stride, cw, ch);
+		_tbm_y4m_copy_plane(dst_v, info->planes[2].ptr, info->planes[2].stride, cw, ch);
+		break;
+	case TBM_FORMAT_NV12:
+	case TBM_FORMAT_NV21:
+		_tbm_y4m_copy_plane(dst_y, info->planes[0].ptr, info->planes[0].stride, w, h);
+		if (info->format == TBM_FORMAT_NV21) {
+			uint8_t *tmp = dst_u;
+
+			dst_u = dst_v;
+			dst_v = tmp;
+		}
+		for (y = 0; y < ch; y++)
+			k->split_uv(dst_u + y * cw, dst_v + y * cw,
+				    info->planes[1].ptr + y * info->planes[1].stride, cw);
+		break;
+	case TBM_FORMAT_YUYV:
+	case TBM_FORMAT_UYVY:
+		/* an odd width has the Y of the last pair and no more */
+		if (w & 1)
+			return 0;
+		for (y = 0; y < ch; y++) {
+			/* the last odd row pairs with itself */
+			row1 = info->planes[0].ptr + (y * 2 + 1 < h ? y * 2 + 1 : y * 2) * info->planes[0].stride;
+			k->unpack_422(dst_y + y * 2 * w, y * 2 + 1 < h ? dst_y + (y * 2 + 1) * w : dst_y + y * 2 * w,
+				      dst_u + y * cw, dst_v + y * cw,
+				      info->planes[0].ptr + y * 2 * info->planes[0].stride, row1,
+				      cw, info->format == TBM_FORMAT_UYVY);
+		}
+		break;
+	default:
+		return 0;
+	}
+
+	return 1;
+}
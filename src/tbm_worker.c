@@ -0,0 +1,208 @@
+/**************************************************************************
+
+libtbm
+
+Copyright 2014 Samsung Electronics co., Ltd. All Rights Reserved.
+
+Contact: SooChan Lim <sc1.lim@samsung.com>, Sangjin Lee <lsj119@samsung.com>
+Boram Park <boram1288.park@samsung.com>, Changyeon Lee <cyeon.lee@samsung.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a
+copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sub license, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice (including the
+next paragraph) shall be included in all copies or substantial portions
+of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+**************************************************************************/
+
+
+#include "config.h"
+
+#include <signal.h>
+#include "tbm_bufmgr_int.h"
+
+/* A few threads to split cpu heavy work like the copy of a 4K surface
+ * into bands. One job runs at a time and the caller works on it too;
+ * a caller finding the pool busy runs its job by itself.
+ */
+#define TBM_WORKER_MAX	4
+
+/* work of less bytes than this is not worth waking up the workers */
+#define TBM_WORKER_SPLIT_SIZE	(1024 * 1024)
+
+static pthread_once_t tbm_worker_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t tbm_worker_job_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t tbm_worker_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t tbm_worker_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t tbm_worker_done_cond = PTHREAD_COND_INITIALIZER;
+static int tbm_worker_num;
+
+/* protected by tbm_worker_lock */
+static struct {
+	tbm_worker_func func;
+	void *data;
+	int count;
+	int next;		/* the next index to be taken */
+	int pending;	/* the taken or not taken indexes not done yet */
+} tbm_worker_job;
+
+static void *
+_tbm_worker_main(void *arg)
+{
+	tbm_worker_func func;
+	void *data;
+	int idx;
+
+	pthread_mutex_lock(&tbm_worker_lock);
+
+	while (1) {
+		while (tbm_worker_job.next >= tbm_worker_job.count)
+			pthread_cond_wait(&tbm_worker_cond, &tbm_worker_lock);
+
+		idx = tbm_worker_job.next++;
+		func = tbm_worker_job.func;
+		data = tbm_worker_job.data;
+		pthread_mutex_unlock(&tbm_worker_lock);
+
+		func(data, idx);
+
+		pthread_mutex_lock(&tbm_worker_lock);
+		if (--tbm_worker_job.pending == 0)
+			pthread_cond_signal(&tbm_worker_done_cond);
+	}
+
+	return NULL;
+}
+
+/* LCOV_EXCL_START */
+static void
+_tbm_worker_atfork_child(void)
+{
+	/* the threads are gone in the child */
+	pthread_mutex_init(&tbm_worker_job_lock, NULL);
+	pthread_mutex_init(&tbm_worker_lock, NULL);
+	pthread_cond_init(&tbm_worker_cond, NULL);
+	pthread_cond_init(&tbm_worker_done_cond, NULL);
+	tbm_worker_job.next = tbm_worker_job.count = tbm_worker_job.pending = 0;
+	tbm_worker_num = 0;
+}
+/* LCOV_EXCL_STOP */
+
+static void
+_tbm_worker_init(void)
+{
+	sigset_t set, old;
+	pthread_attr_t attr;
+	pthread_t thread;
+	const char *env;
+	long num;
+	int i;
+
+	num = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+
+	/* TBM_WORKERS=0 disables the threads */
+	env = getenv("TBM_WORKERS");
+	if (env)
+		num = strtol(env, NULL, 10);
+
+	if (num > TBM_WORKER_MAX)
+		num = TBM_WORKER_MAX;
+	if (num <= 0)
+		return;
+
+	pthread_atfork(NULL, NULL, _tbm_worker_atfork_child);
+
+	/* the signals of the application are not ours to handle */
+	sigfillset(&set);
+	pthread_sigmask(SIG_SETMASK, &set, &old);
+
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+	for (i = 0; i < num; i++) {
+		if (pthread_create(&thread, &attr, _tbm_worker_main, NULL)) {
+			TBM_LOG_E("fail to create the worker %d\n", i);
+			break;
+		}
+	}
+
+	pthread_attr_destroy(&attr);
+	pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+	tbm_worker_num = i;
+
+	TBM_DBG("%d workers\n", tbm_worker_num);
+}
+
+int
+_tbm_worker_get_count(void)
+{
+	pthread_once(&tbm_worker_once, _tbm_worker_init);
+
+	return tbm_worker_num + 1;
+}
+
+/* the number of bands to split a work of the bytes into */
+int
+_tbm_worker_get_bands(uint64_t bytes)
+{
+	if (bytes < TBM_WORKER_SPLIT_SIZE)
+		return 1;
+
+	return _tbm_worker_get_count();
+}
+
+void
+_tbm_worker_run(tbm_worker_func func, void *data, int count)
+{
+	int idx;
+
+	if (count <= 0)
+		return;
+
+	if (count == 1 || _tbm_worker_get_count() == 1 ||
+	    pthread_mutex_trylock(&tbm_worker_job_lock)) {
+		for (idx = 0; idx < count; idx++)
+			func(data, idx);
+		return;
+	}
+
+	pthread_mutex_lock(&tbm_worker_lock);
+
+	tbm_worker_job.func = func;
+	tbm_worker_job.data = data;
+	tbm_worker_job.count = count;
+	tbm_worker_job.next = 0;
+	tbm_worker_job.pending = count;
+	pthread_cond_broadcast(&tbm_worker_cond);
+
+	while (tbm_worker_job.next < tbm_worker_job.count) {
+		idx = tbm_worker_job.next++;
+		pthread_mutex_unlock(&tbm_worker_lock);
+
+		func(data, idx);
+
+		pthread_mutex_lock(&tbm_worker_lock);
+		tbm_worker_job.pending--;
+	}
+
+	while (tbm_worker_job.pending)
+		pthread_cond_wait(&tbm_worker_done_cond, &tbm_worker_lock);
+
+	pthread_mutex_unlock(&tbm_worker_lock);
+	pthread_mutex_unlock(&tbm_worker_job_lock);
+}
@@ -1572,6 +1572,246 @@ TEST(tbm_bo_import, null_ptr_fail_1)
 	ASSERT_TRUE(actual == expected);
 }
 
+/* _tbm_bo_unmap_multi() */
+
+TEST(_tbm_bo_unmap_multi, work_flow_success_1)
+{
+	struct _tbm_bo bo[2];
+	tbm_bo bos[2] = { &bo[0], &bo[1] };
+	struct _tbm_bufmgr bufmgr;
+	struct _tbm_bufmgr_backend backend;
+	int actual;
+
+	_init_test();
+
+	gBufMgr = &bufmgr;
+	bufmgr.lock_type = LOCK_TRY_NEVER;
+	bufmgr.backend = &backend;
+	backend.bo_unmap = ut_bo_unmap;
+	bo[0].bufmgr = bo[1].bufmgr = &bufmgr;
+	bo[0].map_cnt = 1;
+	bo[1].map_cnt = 2;
+
+	actual = _tbm_bo_unmap_multi(bos, 2);
+
+	ASSERT_EQ(actual, 1);
+	ASSERT_EQ(bo[0].map_cnt, 0);
+	ASSERT_EQ(bo[1].map_cnt, 1);
+}
+
+TEST(_tbm_bo_unmap_multi, null_ptr_fail_1)
+{
+	struct _tbm_bufmgr bufmgr;
+	int actual;
+
+	_init_test();
+
+	gBufMgr = &bufmgr;
+
+	actual = _tbm_bo_unmap_multi(NULL, 1);
+
+	ASSERT_EQ(actual, 0);
+}
+
+/* _tbm_bo_map_multi() */
+
+static int ut_bo_map_count = 0;
+static int ut_bo_map_fail_at = -1;
+static int ut_bo_unmap_count = 0;
+
+static tbm_bo_handle ut_bo_map_nth(tbm_bo bo, int device, int opt)
+{
+	tbm_bo_handle ret;
+
+	if (ut_bo_map_count++ == ut_bo_map_fail_at)
+		ret.ptr = NULL;
+	else
+		ret.ptr = (void *)12;
+
+	return ret;
+}
+
+static int ut_bo_unmap_counted(tbm_bo bo)
+{
+	ut_bo_unmap_count++;
+
+	return 1;
+}
+
+TEST(_tbm_bo_map_multi, work_flow_success_2)
+{
+	struct _tbm_bo bo[3];
+	tbm_bo bos[3] = { &bo[0], &bo[1], &bo[2] };
+	tbm_bo_handle handles[3];
+	struct _tbm_bufmgr bufmgr;
+	struct _tbm_bufmgr_backend backend;
+	int actual;
+
+	_init_test();
+
+	ut_bo_map_count = 0;
+	ut_bo_map_fail_at = 2;
+	ut_bo_unmap_count = 0;
+	gBufMgr = &bufmgr;
+	bufmgr.lock_type = LOCK_TRY_NEVER;
+	bufmgr.backend = &backend;
+	backend.bo_map = ut_bo_map_nth;
+	backend.bo_unmap = ut_bo_unmap_counted;
+	bo[0].bufmgr = bo[1].bufmgr = bo[2].bufmgr = &bufmgr;
+	bo[0].map_cnt = bo[1].map_cnt = bo[2].map_cnt = 0;
+
+	actual = _tbm_bo_map_multi(bos, 3, 1, 1, handles);
+
+	ASSERT_EQ(actual, 0);
+	ASSERT_EQ(tbm_last_error, TBM_BO_ERROR_MAP_FAILED);
+	ASSERT_EQ(ut_bo_unmap_count, 2);
+	ASSERT_EQ(bo[0].map_cnt, 0);
+	ASSERT_EQ(bo[1].map_cnt, 0);
+	ASSERT_TRUE(handles[0].ptr == NULL);
+	ASSERT_TRUE(handles[1].ptr == NULL);
+}
+
+TEST(_tbm_bo_map_multi, work_flow_success_1)
+{
+	struct _tbm_bo bo[2];
+	tbm_bo bos[2] = { &bo[0], &bo[1] };
+	tbm_bo_handle handles[2];
+	struct _tbm_bufmgr bufmgr;
+	struct _tbm_bufmgr_backend backend;
+	int actual;
+
+	_init_test();
+
+	ut_bo_map_count = 0;
+	ut_bo_map_fail_at = -1;
+	gBufMgr = &bufmgr;
+	bufmgr.lock_type = LOCK_TRY_NEVER;
+	bufmgr.backend = &backend;
+	backend.bo_map = ut_bo_map_nth;
+	bo[0].bufmgr = bo[1].bufmgr = &bufmgr;
+	bo[0].map_cnt = 0;
+	bo[1].map_cnt = 3;
+
+	actual = _tbm_bo_map_multi(bos, 2, 1, 1, handles);
+
+	ASSERT_EQ(actual, 1);
+	ASSERT_EQ(ut_bo_map_count, 2);
+	ASSERT_EQ(bo[0].map_cnt, 1);
+	ASSERT_EQ(bo[1].map_cnt, 4);
+	ASSERT_TRUE(handles[0].ptr != NULL);
+	ASSERT_TRUE(handles[1].ptr != NULL);
+}
+
+TEST(_tbm_bo_map_multi, null_ptr_fail_1)
+{
+	struct _tbm_bufmgr bufmgr;
+	tbm_bo_handle handles[1];
+	int actual;
+
+	_init_test();
+
+	gBufMgr = &bufmgr;
+
+	actual = _tbm_bo_map_multi(NULL, 1, 1, 1, handles);
+
+	ASSERT_EQ(actual, 0);
+}
+
+/* _tbm_bo_alloc_multi() */
+
+static int ut_bo_alloc_count = 0;
+static int ut_bo_alloc_fail_at = -1;
+static int ut_bo_free_count = 0;
+
+static void *ut_bo_alloc_nth(tbm_bo bo, int size, int flags)
+{
+	if (ut_bo_alloc_count++ == ut_bo_alloc_fail_at)
+		return NULL;
+
+	return ret_bo;
+}
+
+static void ut_bo_free(tbm_bo bo)
+{
+	ut_bo_free_count++;
+}
+
+TEST(_tbm_bo_alloc_multi, work_flow_success_2)
+{
+	struct _tbm_bufmgr bufmgr;
+	struct _tbm_bufmgr_backend backend;
+	tbm_bo bos[4] = { NULL, };
+	int actual;
+
+	_init_test();
+
+	ut_bo_alloc_count = 0;
+	ut_bo_alloc_fail_at = 2;
+	ut_bo_free_count = 0;
+	gBufMgr = &bufmgr;
+	bufmgr.backend = &backend;
+	bufmgr.bo_cnt = 0;
+	backend.bo_alloc = ut_bo_alloc_nth;
+	backend.bo_free = ut_bo_free;
+	LIST_INITHEAD(&bufmgr.bo_list);
+
+	actual = _tbm_bo_alloc_multi(&bufmgr, 1, 0, 4, bos);
+
+	ASSERT_EQ(actual, 0);
+	ASSERT_EQ(ut_bo_free_count, 2);
+	ASSERT_EQ(bufmgr.bo_cnt, 0);
+	ASSERT_TRUE(LIST_IS_EMPTY(&bufmgr.bo_list));
+	ASSERT_TRUE(bos[0] == NULL);
+	ASSERT_TRUE(bos[1] == NULL);
+}
+
+TEST(_tbm_bo_alloc_multi, work_flow_success_1)
+{
+	int flags = 6;
+	struct _tbm_bufmgr bufmgr;
+	struct _tbm_bufmgr_backend backend;
+	tbm_bo bos[3] = { NULL, };
+	int actual, i;
+
+	_init_test();
+
+	ut_bo_alloc_count = 0;
+	ut_bo_alloc_fail_at = -1;
+	gBufMgr = &bufmgr;
+	bufmgr.backend = &backend;
+	bufmgr.bo_cnt = 0;
+	backend.bo_alloc = ut_bo_alloc_nth;
+	LIST_INITHEAD(&bufmgr.bo_list);
+
+	actual = _tbm_bo_alloc_multi(&bufmgr, 1, flags, 3, bos);
+
+	ASSERT_EQ(actual, 1);
+	ASSERT_EQ(bufmgr.bo_cnt, 3);
+	for (i = 0; i < 3; i++) {
+		ASSERT_TRUE(bos[i] != NULL);
+		ASSERT_EQ(bos[i]->flags, flags);
+		ASSERT_EQ(bos[i]->ref_cnt, 1);
+		ASSERT_TRUE(bos[i]->priv == ret_bo);
+		LIST_DEL(&bos[i]->item_link);
+		free(bos[i]);
+	}
+}
+
+TEST(_tbm_bo_alloc_multi, null_ptr_fail_1)
+{
+	struct _tbm_bufmgr bufmgr;
+	tbm_bo bos[1];
+	int actual;
+
+	_init_test();
+
+	gBufMgr = &bufmgr;
+
+	actual = _tbm_bo_alloc_multi(&bufmgr, 1, 0, 1, NULL);
+
+	ASSERT_EQ(actual, 0);
+}
+
 /* tbm_bo_alloc() */
 
 TEST(tbm_bo_alloc, work_flow_success_3)
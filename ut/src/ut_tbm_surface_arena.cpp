@@ -0,0 +1,357 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics co., Ltd. All Rights Reserved.
+ *
+ * Contact: Konstantin Drabeniuk <k.drabeniuk@samsung.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+**************************************************************************/
+
+
+#include "gtest/gtest.h"
+
+#include "tbm_bufmgr_int.h"
+
+#include "pthread_stubs.h"
+#include "stdlib_stubs.h"
+
+/* HELPER FUNCTIONS */
+
+static struct _tbm_bufmgr ut_bufmgr;
+static struct _tbm_bo ut_bos[8];
+static int ut_bo_sizes[8];
+static struct _tbm_surface ut_surfaces[32];
+static tbm_surface_info_s ut_infos[32];
+static tbm_bo ut_surface_bos[32];
+static int ut_bo_count = 0;
+static int ut_bo_unref_count = 0;
+static int ut_surface_count = 0;
+static int ut_unref_count = 0;
+static int ut_refcnt = 1;
+static int UT_TBM_SURFACE_ARENA_ERROR = 0;
+
+static tbm_bufmgr
+ut_tbm_bufmgr_init(int fd)
+{
+	return &ut_bufmgr;
+}
+
+static void
+ut_tbm_bufmgr_deinit(tbm_bufmgr bufmgr)
+{
+}
+
+static tbm_bo
+ut_tbm_bo_alloc(tbm_bufmgr bufmgr, int size, int flags)
+{
+	ut_bo_sizes[ut_bo_count] = size;
+
+	return &ut_bos[ut_bo_count++];
+}
+
+static void
+ut_tbm_bo_unref(tbm_bo bo)
+{
+	ut_bo_unref_count++;
+}
+
+static int
+ut_tbm_surface_internal_get_layout(tbm_bufmgr bufmgr, int width, int height, int format,
+				   tbm_surface_info_s *info)
+{
+	memset(info, 0, sizeof(tbm_surface_info_s));
+	info->width = width;
+	info->height = height;
+	info->format = format;
+	info->num_planes = 1;
+	info->planes[0].stride = width * 4;
+	info->planes[0].size = info->planes[0].stride * height;
+	info->size = info->planes[0].size;
+
+	return 1;
+}
+
+static tbm_surface_h
+ut_tbm_surface_internal_create_with_bos(tbm_surface_info_s *info, tbm_bo *bos, int num)
+{
+	if (UT_TBM_SURFACE_ARENA_ERROR)
+		return NULL;
+
+	ut_infos[ut_surface_count] = *info;
+	ut_surface_bos[ut_surface_count] = bos[0];
+
+	return &ut_surfaces[ut_surface_count++];
+}
+
+static void
+ut_tbm_surface_internal_unref(tbm_surface_h surface)
+{
+	ut_unref_count++;
+}
+
+static int
+ut_tbm_surface_internal_get_refcnt(tbm_surface_h surface)
+{
+	return ut_refcnt;
+}
+
+#define pthread_mutex_lock ut_pthread_mutex_lock
+#define pthread_mutex_unlock ut_pthread_mutex_unlock
+#define pthread_mutex_init ut_pthread_mutex_init
+#define calloc ut_calloc
+#define free ut_free
+#define tbm_bufmgr_init ut_tbm_bufmgr_init
+#define tbm_bufmgr_deinit ut_tbm_bufmgr_deinit
+#define tbm_bo_alloc ut_tbm_bo_alloc
+#define tbm_bo_unref ut_tbm_bo_unref
+#define _tbm_surface_internal_get_layout ut_tbm_surface_internal_get_layout
+#define tbm_surface_internal_create_with_bos ut_tbm_surface_internal_create_with_bos
+#define tbm_surface_internal_unref ut_tbm_surface_internal_unref
+#define _tbm_surface_internal_get_refcnt ut_tbm_surface_internal_get_refcnt
+
+#include "tbm_surface_arena.c"
+
+static void _init_test()
+{
+	PTHREAD_MUTEX_INIT_ERROR = 0;
+	CALLOC_ERROR = 0;
+	FREE_CALLED = 0;
+	FREE_PTR = NULL;
+	FREE_TESTED_PTR = NULL;
+	free_called_for_tested_ptr = 0;
+	free_call_count = 0;
+	UT_TBM_SURFACE_ARENA_ERROR = 0;
+	ut_bo_count = 0;
+	ut_bo_unref_count = 0;
+	ut_surface_count = 0;
+	ut_unref_count = 0;
+	ut_refcnt = 1;
+}
+
+/* tbm_surface_arena_reset() */
+
+TEST(tbm_surface_arena_reset, work_flow_success_2)
+{
+	tbm_surface_arena_h arena;
+	tbm_surface_arena_stats_s stats;
+
+	_init_test();
+
+	arena = tbm_surface_arena_create(64 * 1024, 0);
+	tbm_surface_arena_alloc(arena, 32, 32, TBM_FORMAT_ARGB8888);
+
+	/* still referenced by the caller, its range is held */
+	ut_refcnt = 2;
+	tbm_surface_arena_reset(arena);
+	ASSERT_EQ(ut_unref_count, 0);
+
+	tbm_surface_arena_get_stats(arena, &stats);
+	ASSERT_EQ(stats.num_surfaces, 1);
+	ASSERT_EQ(stats.used_size, 4096);
+
+	tbm_surface_arena_alloc(arena, 16, 16, TBM_FORMAT_ARGB8888);
+	ASSERT_TRUE(ut_surface_bos[1] == &ut_bos[0]);
+	ASSERT_EQ(ut_infos[1].planes[0].offset, 4096);
+
+	/* released, the next frame starts at the beginning again */
+	ut_refcnt = 1;
+	tbm_surface_arena_reset(arena);
+	ASSERT_EQ(ut_unref_count, 2);
+
+	tbm_surface_arena_alloc(arena, 16, 16, TBM_FORMAT_ARGB8888);
+	ASSERT_EQ(ut_infos[2].planes[0].offset, 0);
+
+	tbm_surface_arena_destroy(arena);
+	ASSERT_EQ(ut_unref_count, 3);
+}
+
+TEST(tbm_surface_arena_reset, work_flow_success_1)
+{
+	tbm_surface_arena_h arena;
+	tbm_surface_arena_stats_s stats;
+
+	_init_test();
+
+	arena = tbm_surface_arena_create(64 * 1024, 0);
+	tbm_surface_arena_alloc(arena, 64, 64, TBM_FORMAT_ARGB8888);
+	tbm_surface_arena_alloc(arena, 32, 32, TBM_FORMAT_ARGB8888);
+
+	tbm_surface_arena_reset(arena);
+	ASSERT_EQ(ut_unref_count, 2);
+
+	tbm_surface_arena_get_stats(arena, &stats);
+	ASSERT_EQ(stats.num_surfaces, 0);
+	ASSERT_EQ(stats.used_size, 0);
+	ASSERT_EQ(stats.peak_size, 16384 + 4096);
+	ASSERT_EQ(stats.resets, 1);
+
+	/* the next frame starts at the beginning of the first bo */
+	tbm_surface_arena_alloc(arena, 16, 16, TBM_FORMAT_ARGB8888);
+	ASSERT_EQ(ut_bo_count, 2);
+	ASSERT_TRUE(ut_surface_bos[2] == &ut_bos[0]);
+	ASSERT_EQ(ut_infos[2].planes[0].offset, 0);
+
+	tbm_surface_arena_destroy(arena);
+	ASSERT_EQ(ut_unref_count, 3);
+	ASSERT_EQ(ut_bo_unref_count, 2);
+}
+
+/* tbm_surface_arena_alloc() */
+
+TEST(tbm_surface_arena_alloc, work_flow_success_3)
+{
+	tbm_surface_arena_h arena;
+	int i;
+
+	_init_test();
+
+	/* more surfaces than the first array of the arena */
+	arena = tbm_surface_arena_create(64 * 1024, 0);
+	for (i = 0; i < 20; i++)
+		ASSERT_TRUE(tbm_surface_arena_alloc(arena, 8, 8, TBM_FORMAT_ARGB8888) != NULL);
+
+	ASSERT_EQ(ut_infos[19].planes[0].offset, 19 * 256);
+
+	tbm_surface_arena_reset(arena);
+	ASSERT_EQ(ut_unref_count, 20);
+
+	tbm_surface_arena_destroy(arena);
+}
+
+TEST(tbm_surface_arena_alloc, work_flow_success_2)
+{
+	tbm_surface_arena_h arena;
+	tbm_surface_arena_stats_s stats;
+
+	_init_test();
+
+	/* four bos of 16K */
+	arena = tbm_surface_arena_create(64 * 1024, 0);
+	tbm_surface_arena_alloc(arena, 32, 64, TBM_FORMAT_ARGB8888);
+	tbm_surface_arena_alloc(arena, 32, 64, TBM_FORMAT_ARGB8888);
+	ASSERT_EQ(ut_bo_count, 1);
+	ASSERT_EQ(ut_bo_sizes[0], 16384);
+
+	/* the rest of the first bo is too small */
+	tbm_surface_arena_alloc(arena, 32, 64, TBM_FORMAT_ARGB8888);
+	ASSERT_EQ(ut_bo_count, 2);
+	ASSERT_TRUE(ut_surface_bos[2] == &ut_bos[1]);
+	ASSERT_EQ(ut_infos[2].planes[0].offset, 0);
+
+	/* a surface bigger than a bo takes a bo of its own size */
+	tbm_surface_arena_alloc(arena, 128, 64, TBM_FORMAT_ARGB8888);
+	ASSERT_EQ(ut_bo_count, 3);
+	ASSERT_EQ(ut_bo_sizes[2], 32768);
+
+	tbm_surface_arena_get_stats(arena, &stats);
+	ASSERT_EQ(stats.num_bos, 3);
+	ASSERT_EQ(stats.bo_size, 65536);
+
+	/* the budget is used up */
+	ASSERT_TRUE(tbm_surface_arena_alloc(arena, 32, 64, TBM_FORMAT_ARGB8888) == NULL);
+
+	tbm_surface_arena_destroy(arena);
+}
+
+TEST(tbm_surface_arena_alloc, work_flow_success_1)
+{
+	tbm_surface_arena_h arena;
+	tbm_surface_arena_stats_s stats;
+
+	_init_test();
+
+	arena = tbm_surface_arena_create(64 * 1024, 0);
+	tbm_surface_arena_alloc(arena, 16, 16, TBM_FORMAT_ARGB8888);
+	tbm_surface_arena_alloc(arena, 4, 4, TBM_FORMAT_ARGB8888);
+	tbm_surface_arena_alloc(arena, 16, 16, TBM_FORMAT_ARGB8888);
+
+	ASSERT_EQ(ut_bo_count, 1);
+	ASSERT_EQ(ut_infos[0].planes[0].offset, 0);
+	ASSERT_EQ(ut_infos[1].planes[0].offset, 1024);
+	ASSERT_EQ(ut_infos[2].planes[0].offset, 1024 + 256);
+
+	tbm_surface_arena_get_stats(arena, &stats);
+	ASSERT_EQ(stats.num_surfaces, 3);
+	ASSERT_EQ(stats.used_size, 1024 + 256 + 1024);
+	ASSERT_EQ(stats.allocs, 3);
+
+	tbm_surface_arena_destroy(arena);
+}
+
+TEST(tbm_surface_arena_alloc, null_ptr_fail_2)
+{
+	tbm_surface_arena_h arena;
+	tbm_surface_arena_stats_s stats;
+
+	_init_test();
+
+	arena = tbm_surface_arena_create(64 * 1024, 0);
+	UT_TBM_SURFACE_ARENA_ERROR = 1;
+
+	ASSERT_TRUE(tbm_surface_arena_alloc(arena, 16, 16, TBM_FORMAT_ARGB8888) == NULL);
+
+	/* the range is given back */
+	UT_TBM_SURFACE_ARENA_ERROR = 0;
+	tbm_surface_arena_alloc(arena, 16, 16, TBM_FORMAT_ARGB8888);
+	ASSERT_EQ(ut_infos[0].planes[0].offset, 0);
+
+	tbm_surface_arena_get_stats(arena, &stats);
+	ASSERT_EQ(stats.failures, 1);
+	ASSERT_EQ(stats.num_surfaces, 1);
+
+	tbm_surface_arena_destroy(arena);
+}
+
+TEST(tbm_surface_arena_alloc, null_ptr_fail_1)
+{
+	_init_test();
+
+	ASSERT_TRUE(tbm_surface_arena_alloc(NULL, 16, 16, TBM_FORMAT_ARGB8888) == NULL);
+}
+
+/* tbm_surface_arena_create() */
+
+TEST(tbm_surface_arena_create, work_flow_success_1)
+{
+	tbm_surface_arena_h arena;
+
+	_init_test();
+
+	arena = tbm_surface_arena_create(1000 * 1000, 0);
+
+	ASSERT_TRUE(arena != NULL);
+	ASSERT_EQ(arena->bo_size, 253952);
+
+	tbm_surface_arena_destroy(arena);
+}
+
+TEST(tbm_surface_arena_create, null_ptr_fail_1)
+{
+	tbm_surface_arena_h arena;
+
+	_init_test();
+	CALLOC_ERROR = 1;
+
+	arena = tbm_surface_arena_create(64 * 1024, 0);
+
+	ASSERT_TRUE(arena == NULL);
+}
@@ -0,0 +1,403 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics co., Ltd. All Rights Reserved.
+ *
+ * Contact: Konstantin Drabeniuk <k.drabeniuk@samsung.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+**************************************************************************/
+
+
+#include "gtest/gtest.h"
+
+#include "tbm_bufmgr_int.h"
+
+#include "pthread_stubs.h"
+#include "stdlib_stubs.h"
+
+/* HELPER FUNCTIONS */
+
+static struct _tbm_bufmgr ut_bufmgr;
+static struct _tbm_bo ut_bos[8];
+static struct _tbm_surface ut_surfaces[8];
+static tbm_surface_info_s ut_infos[8];
+static tbm_data_free ut_free_funcs[8];
+static void *ut_datas[8];
+static int ut_bo_count = 0;
+static int ut_bo_unref_count = 0;
+static int ut_surface_count = 0;
+static int ut_deinit_count = 0;
+static int UT_TBM_SURFACE_ATLAS_ERROR = 0;
+
+static int
+ut_tbm_surface_internal_get_layout(tbm_bufmgr bufmgr, int width, int height, int format,
+				   tbm_surface_info_s *info)
+{
+	memset(info, 0, sizeof(tbm_surface_info_s));
+	info->width = width;
+	info->height = height;
+	info->format = format;
+	info->num_planes = 1;
+	info->planes[0].stride = width * 4;
+	info->planes[0].size = info->planes[0].stride * height;
+	info->size = info->planes[0].size;
+
+	return 1;
+}
+
+static tbm_bufmgr
+ut_tbm_bufmgr_init(int fd)
+{
+	return &ut_bufmgr;
+}
+
+static void
+ut_tbm_bufmgr_deinit(tbm_bufmgr bufmgr)
+{
+	ut_deinit_count++;
+}
+
+static tbm_bo
+ut_tbm_bo_alloc(tbm_bufmgr bufmgr, int size, int flags)
+{
+	if (UT_TBM_SURFACE_ATLAS_ERROR)
+		return NULL;
+
+	return &ut_bos[ut_bo_count++];
+}
+
+static void
+ut_tbm_bo_unref(tbm_bo bo)
+{
+	ut_bo_unref_count++;
+}
+
+static tbm_surface_h
+ut_tbm_surface_internal_create_with_bos(tbm_surface_info_s *info, tbm_bo *bos, int num)
+{
+	ut_infos[ut_surface_count] = *info;
+
+	return &ut_surfaces[ut_surface_count++];
+}
+
+static int
+ut_tbm_surface_internal_add_user_data(tbm_surface_h surface, unsigned long key,
+				      tbm_data_free data_free_func)
+{
+	ut_free_funcs[surface - ut_surfaces] = data_free_func;
+
+	return 1;
+}
+
+static int
+ut_tbm_surface_internal_set_user_data(tbm_surface_h surface, unsigned long key, void *data)
+{
+	ut_datas[surface - ut_surfaces] = data;
+
+	return 1;
+}
+
+static void
+ut_tbm_surface_internal_unref(tbm_surface_h surface)
+{
+}
+
+/* what tbm_surface_destroy() does with the user data */
+static void
+_ut_destroy(tbm_surface_h surface)
+{
+	ut_free_funcs[surface - ut_surfaces](ut_datas[surface - ut_surfaces]);
+}
+
+#define pthread_mutex_lock ut_pthread_mutex_lock
+#define pthread_mutex_unlock ut_pthread_mutex_unlock
+#define pthread_mutex_init ut_pthread_mutex_init
+#define calloc ut_calloc
+#define free ut_free
+#define tbm_bufmgr_init ut_tbm_bufmgr_init
+#define tbm_bufmgr_deinit ut_tbm_bufmgr_deinit
+#define tbm_bo_alloc ut_tbm_bo_alloc
+#define tbm_bo_unref ut_tbm_bo_unref
+#define tbm_surface_internal_create_with_bos ut_tbm_surface_internal_create_with_bos
+#define tbm_surface_internal_add_user_data ut_tbm_surface_internal_add_user_data
+#define tbm_surface_internal_set_user_data ut_tbm_surface_internal_set_user_data
+#define tbm_surface_internal_unref ut_tbm_surface_internal_unref
+#define _tbm_surface_internal_get_layout ut_tbm_surface_internal_get_layout
+
+#include "tbm_surface_atlas.c"
+
+static void _init_test()
+{
+	PTHREAD_MUTEX_INIT_ERROR = 0;
+	CALLOC_ERROR = 0;
+	FREE_CALLED = 0;
+	FREE_PTR = NULL;
+	FREE_TESTED_PTR = NULL;
+	free_called_for_tested_ptr = 0;
+	free_call_count = 0;
+	UT_TBM_SURFACE_ATLAS_ERROR = 0;
+	ut_bo_count = 0;
+	ut_bo_unref_count = 0;
+	ut_surface_count = 0;
+	ut_deinit_count = 0;
+}
+
+/* tbm_surface_atlas_get_stats() */
+
+TEST(tbm_surface_atlas_get_stats, work_flow_success_1)
+{
+	tbm_surface_atlas_h atlas;
+	tbm_surface_atlas_stats_s stats;
+
+	_init_test();
+
+	atlas = tbm_surface_atlas_create(4096, 0);
+	tbm_surface_atlas_alloc(atlas, 16, 16, TBM_FORMAT_ARGB8888);
+	tbm_surface_atlas_alloc(atlas, 8, 8, TBM_FORMAT_ARGB8888);
+
+	ASSERT_EQ(tbm_surface_atlas_get_stats(atlas, &stats), 1);
+	ASSERT_EQ(stats.num_bos, 1);
+	ASSERT_EQ(stats.bo_size, 4096);
+	ASSERT_EQ(stats.num_surfaces, 2);
+	ASSERT_EQ(stats.used_size, 1024 + 256);
+	ASSERT_EQ(stats.largest_free, 4096 - 1024 - 256);
+	ASSERT_EQ(stats.allocs, 2);
+	ASSERT_EQ(stats.failures, 0);
+
+	_ut_destroy(&ut_surfaces[0]);
+	_ut_destroy(&ut_surfaces[1]);
+	tbm_surface_atlas_destroy(atlas);
+}
+
+TEST(tbm_surface_atlas_get_stats, null_ptr_fail_1)
+{
+	tbm_surface_atlas_stats_s stats;
+
+	_init_test();
+
+	ASSERT_EQ(tbm_surface_atlas_get_stats(NULL, &stats), 0);
+}
+
+/* tbm_surface_atlas_compact() */
+
+TEST(tbm_surface_atlas_compact, work_flow_success_1)
+{
+	tbm_surface_atlas_h atlas;
+	tbm_surface_atlas_stats_s stats;
+
+	_init_test();
+
+	/* a bo for each surface */
+	atlas = tbm_surface_atlas_create(1024, 0);
+	tbm_surface_atlas_alloc(atlas, 16, 16, TBM_FORMAT_ARGB8888);
+	tbm_surface_atlas_alloc(atlas, 16, 16, TBM_FORMAT_ARGB8888);
+	tbm_surface_atlas_alloc(atlas, 16, 16, TBM_FORMAT_ARGB8888);
+	_ut_destroy(&ut_surfaces[0]);
+	_ut_destroy(&ut_surfaces[2]);
+
+	ASSERT_EQ(tbm_surface_atlas_compact(atlas), 2);
+	ASSERT_EQ(ut_bo_unref_count, 2);
+
+	tbm_surface_atlas_get_stats(atlas, &stats);
+	ASSERT_EQ(stats.num_bos, 1);
+	ASSERT_EQ(stats.num_surfaces, 1);
+	ASSERT_EQ(stats.compacted, 2);
+
+	ASSERT_EQ(tbm_surface_atlas_compact(atlas), 0);
+
+	_ut_destroy(&ut_surfaces[1]);
+	tbm_surface_atlas_destroy(atlas);
+}
+
+/* tbm_surface_atlas_alloc() */
+
+TEST(tbm_surface_atlas_alloc, work_flow_success_4)
+{
+	tbm_surface_atlas_h atlas;
+
+	_init_test();
+
+	atlas = tbm_surface_atlas_create(4096, 0);
+	tbm_surface_atlas_alloc(atlas, 16, 16, TBM_FORMAT_ARGB8888);
+
+	/* the surfaces alive outlive the atlas and its bufmgr */
+	tbm_surface_atlas_destroy(atlas);
+	ASSERT_EQ(ut_bo_unref_count, 1);
+	ASSERT_EQ(ut_deinit_count, 0);
+
+	_ut_destroy(&ut_surfaces[0]);
+	ASSERT_EQ(ut_deinit_count, 1);
+}
+
+TEST(tbm_surface_atlas_alloc, work_flow_success_3)
+{
+	tbm_surface_atlas_h atlas;
+	tbm_surface_atlas_stats_s stats;
+
+	_init_test();
+
+	atlas = tbm_surface_atlas_create(4096, 0);
+	tbm_surface_atlas_alloc(atlas, 16, 16, TBM_FORMAT_ARGB8888);
+	tbm_surface_atlas_alloc(atlas, 16, 16, TBM_FORMAT_ARGB8888);
+	tbm_surface_atlas_alloc(atlas, 16, 16, TBM_FORMAT_ARGB8888);
+
+	/* the free ranges are merged back into the whole bo */
+	_ut_destroy(&ut_surfaces[0]);
+	_ut_destroy(&ut_surfaces[2]);
+	_ut_destroy(&ut_surfaces[1]);
+	tbm_surface_atlas_get_stats(atlas, &stats);
+
+	ASSERT_EQ(stats.num_surfaces, 0);
+	ASSERT_EQ(stats.used_size, 0);
+	ASSERT_EQ(stats.largest_free, 4096);
+
+	tbm_surface_atlas_destroy(atlas);
+	ASSERT_EQ(ut_deinit_count, 1);
+}
+
+TEST(tbm_surface_atlas_alloc, work_flow_success_2)
+{
+	tbm_surface_atlas_h atlas;
+	tbm_surface_atlas_stats_s stats;
+
+	_init_test();
+
+	atlas = tbm_surface_atlas_create(2048, 0);
+	tbm_surface_atlas_alloc(atlas, 16, 16, TBM_FORMAT_ARGB8888);
+	tbm_surface_atlas_alloc(atlas, 16, 16, TBM_FORMAT_ARGB8888);
+
+	/* the first bo is full */
+	tbm_surface_atlas_alloc(atlas, 8, 8, TBM_FORMAT_ARGB8888);
+	ASSERT_EQ(ut_bo_count, 2);
+
+	/* the fullest bo which has room takes the surface, not the second one */
+	_ut_destroy(&ut_surfaces[0]);
+	tbm_surface_atlas_alloc(atlas, 8, 8, TBM_FORMAT_ARGB8888);
+	ASSERT_EQ(ut_infos[3].planes[0].offset, 0);
+
+	tbm_surface_atlas_get_stats(atlas, &stats);
+	ASSERT_EQ(stats.num_bos, 2);
+	ASSERT_EQ(stats.num_surfaces, 3);
+
+	_ut_destroy(&ut_surfaces[1]);
+	_ut_destroy(&ut_surfaces[2]);
+	_ut_destroy(&ut_surfaces[3]);
+	tbm_surface_atlas_destroy(atlas);
+}
+
+TEST(tbm_surface_atlas_alloc, work_flow_success_1)
+{
+	tbm_surface_atlas_h atlas;
+
+	_init_test();
+
+	atlas = tbm_surface_atlas_create(4096, 0);
+	tbm_surface_atlas_alloc(atlas, 16, 16, TBM_FORMAT_ARGB8888);
+	tbm_surface_atlas_alloc(atlas, 4, 4, TBM_FORMAT_ARGB8888);
+	tbm_surface_atlas_alloc(atlas, 16, 16, TBM_FORMAT_ARGB8888);
+
+	ASSERT_EQ(ut_bo_count, 1);
+	ASSERT_EQ(ut_infos[0].planes[0].offset, 0);
+	ASSERT_EQ(ut_infos[1].planes[0].offset, 1024);
+	ASSERT_EQ(ut_infos[2].planes[0].offset, 1024 + 256);
+	ASSERT_EQ(ut_infos[2].planes[0].stride, 64);
+
+	/* the range is used again */
+	_ut_destroy(&ut_surfaces[1]);
+	tbm_surface_atlas_alloc(atlas, 8, 8, TBM_FORMAT_ARGB8888);
+	ASSERT_EQ(ut_infos[3].planes[0].offset, 1024);
+
+	_ut_destroy(&ut_surfaces[0]);
+	_ut_destroy(&ut_surfaces[2]);
+	_ut_destroy(&ut_surfaces[3]);
+	tbm_surface_atlas_destroy(atlas);
+}
+
+TEST(tbm_surface_atlas_alloc, null_ptr_fail_3)
+{
+	tbm_surface_atlas_h atlas;
+	tbm_surface_atlas_stats_s stats;
+
+	_init_test();
+
+	atlas = tbm_surface_atlas_create(4096, 0);
+	UT_TBM_SURFACE_ATLAS_ERROR = 1;
+
+	ASSERT_TRUE(tbm_surface_atlas_alloc(atlas, 16, 16, TBM_FORMAT_ARGB8888) == NULL);
+
+	tbm_surface_atlas_get_stats(atlas, &stats);
+	ASSERT_EQ(stats.failures, 1);
+	ASSERT_EQ(stats.num_bos, 0);
+
+	tbm_surface_atlas_destroy(atlas);
+}
+
+TEST(tbm_surface_atlas_alloc, null_ptr_fail_2)
+{
+	tbm_surface_atlas_h atlas;
+
+	_init_test();
+
+	/* bigger than a shared bo */
+	atlas = tbm_surface_atlas_create(1024, 0);
+
+	ASSERT_TRUE(tbm_surface_atlas_alloc(atlas, 32, 32, TBM_FORMAT_ARGB8888) == NULL);
+	ASSERT_EQ(ut_bo_count, 0);
+
+	tbm_surface_atlas_destroy(atlas);
+}
+
+TEST(tbm_surface_atlas_alloc, null_ptr_fail_1)
+{
+	_init_test();
+
+	ASSERT_TRUE(tbm_surface_atlas_alloc(NULL, 16, 16, TBM_FORMAT_ARGB8888) == NULL);
+}
+
+/* tbm_surface_atlas_create() */
+
+TEST(tbm_surface_atlas_create, work_flow_success_1)
+{
+	tbm_surface_atlas_h atlas;
+
+	_init_test();
+
+	atlas = tbm_surface_atlas_create(1000, 0);
+
+	ASSERT_TRUE(atlas != NULL);
+	ASSERT_EQ(atlas->bo_size, 1024);
+
+	tbm_surface_atlas_destroy(atlas);
+	ASSERT_EQ(ut_deinit_count, 1);
+}
+
+TEST(tbm_surface_atlas_create, null_ptr_fail_1)
+{
+	tbm_surface_atlas_h atlas;
+
+	_init_test();
+	CALLOC_ERROR = 1;
+
+	atlas = tbm_surface_atlas_create(4096, 0);
+
+	ASSERT_TRUE(atlas == NULL);
+}
@@ -0,0 +1,448 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics co., Ltd. All Rights Reserved.
+ *
+ * Contact: Konstantin Drabeniuk <k.drabeniuk@samsung.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+**************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "tbm_bufmgr_int.h"
+
+#include "pthread_stubs.h"
+#include "stdlib_stubs.h"
+
+/* HELPER FUNCTIONS */
+
+static int
+ut__tbm_surface_internal_get_damage_bounds(tbm_surface_h surface, tbm_surface_rect_s *bounds)
+{
+	if (!surface->num_damage)
+		return 0;
+
+	/* the tests damage one rect */
+	*bounds = surface->damage[0];
+
+	return 1;
+}
+
+#include "tbm_surface_stubs.h"
+
+#define pthread_mutex_lock ut_pthread_mutex_lock
+#define pthread_mutex_unlock ut_pthread_mutex_unlock
+#define pthread_mutex_init ut_pthread_mutex_init
+#define _tbm_surface_internal_get_damage_bounds ut__tbm_surface_internal_get_damage_bounds
+
+#include "tbm_cpu.c"
+#include "tbm_surface_convert.c"
+
+static void _init_test()
+{
+	CALLOC_ERROR = 0;
+	FREE_CALLED = 0;
+	UT_TBM_SURFACE_MAP_ERROR = 0;
+	ut_unmap_count = 0;
+}
+
+/* a surface of w x h on top of buf, laid out like the backends do */
+static void
+_ut_convert_setup(struct _tbm_surface *surf, tbm_format format, int w, int h,
+		  unsigned char *buf)
+{
+	tbm_surface_info_s *info = &surf->info;
+	int cw = (w + 1) / 2, ch = (h + 1) / 2;
+
+	memset(surf, 0, sizeof(*surf));
+	info->width = w;
+	info->height = h;
+	info->format = format;
+
+	switch (format) {
+	case TBM_FORMAT_NV12:
+	case TBM_FORMAT_NV21:
+		info->num_planes = 2;
+		info->planes[0].stride = w + 3;
+		info->planes[1].stride = cw * 2 + 5;
+		info->planes[0].ptr = buf;
+		info->planes[1].ptr = buf + info->planes[0].stride * h;
+		break;
+	case TBM_FORMAT_YUV420:
+	case TBM_FORMAT_YVU420:
+		info->num_planes = 3;
+		info->planes[0].stride = w + 3;
+		info->planes[1].stride = cw + 1;
+		info->planes[2].stride = cw + 7;
+		info->planes[0].ptr = buf;
+		info->planes[1].ptr = buf + info->planes[0].stride * h;
+		info->planes[2].ptr = info->planes[1].ptr + info->planes[1].stride * ch;
+		break;
+	case TBM_FORMAT_YUYV:
+	case TBM_FORMAT_UYVY:
+		info->num_planes = 1;
+		info->planes[0].stride = cw * 4 + 2;
+		info->planes[0].ptr = buf;
+		break;
+	default:
+		info->num_planes = 1;
+		info->planes[0].stride = w * 4 + 8;
+		info->planes[0].ptr = buf;
+		break;
+	}
+}
+
+static int
+_ut_kernels_compare(const tbm_convert_kernels *k)
+{
+	static uint8_t src[4][512], ref[4][512], out[4][512];
+	unsigned int ci;
+	int w;
+
+	for (ci = 0; ci < NUM_CONVERT_COEFS; ci++) {
+		const tbm_convert_coef *c = &convert_coefs[ci];
+
+		for (w = 1; w <= 100; w++) {
+			_ut_fill(src[0], sizeof(src), w * 7 + ci);
+			memset(ref, 0, sizeof(ref));
+			memset(out, 0, sizeof(out));
+
+			convert_kernels_c.yuv_to_argb(src[0], src[1], src[2], ref[0], w, c);
+			k->yuv_to_argb(src[0], src[1], src[2], out[0], w, c);
+			if (memcmp(ref[0], out[0], w * 4))
+				return 0;
+
+			convert_kernels_c.argb_to_y(src[0], ref[1], w, c);
+			k->argb_to_y(src[0], out[1], w, c);
+			if (memcmp(ref[1], out[1], w))
+				return 0;
+
+			convert_kernels_c.argb_to_uv(src[0], src[1], ref[2], ref[3], w, c);
+			k->argb_to_uv(src[0], src[1], out[2], out[3], w, c);
+			if (memcmp(ref[2], out[2], (w + 1) / 2) || memcmp(ref[3], out[3], (w + 1) / 2))
+				return 0;
+
+			convert_kernels_c.split(src[0], ref[0], ref[1], w);
+			k->split(src[0], out[0], out[1], w);
+			if (memcmp(ref[0], out[0], w) || memcmp(ref[1], out[1], w))
+				return 0;
+
+			convert_kernels_c.merge(src[0], src[1], ref[2], w);
+			k->merge(src[0], src[1], out[2], w);
+			if (memcmp(ref[2], out[2], w * 2))
+				return 0;
+		}
+	}
+
+	return 1;
+}
+
+/* the planes of out are the ones of ref in the rect, 0 out of it */
+static int
+_ut_damage_check(struct _tbm_surface *ref, struct _tbm_surface *out, tbm_surface_rect_s *r)
+{
+	const tbm_format_desc_s *desc = tbm_format_get_desc(ref->info.format);
+	int i, row, col;
+
+	for (i = 0; i < (int)ref->info.num_planes; i++) {
+		int hsub = i ? desc->hsub : 1, vsub = i ? desc->vsub : 1;
+		int rows = (ref->info.height + vsub - 1) / vsub;
+		int bytes = (ref->info.width + hsub - 1) / hsub * desc->cpp[i];
+
+		for (row = 0; row < rows; row++) {
+			unsigned char *a = ref->info.planes[i].ptr + row * ref->info.planes[i].stride;
+			unsigned char *b = out->info.planes[i].ptr + row * out->info.planes[i].stride;
+
+			for (col = 0; col < bytes; col++) {
+				int in = row >= r->y / vsub && row < (r->y + r->height) / vsub &&
+					 col >= r->x / hsub * desc->cpp[i] &&
+					 col < (r->x + r->width) / hsub * desc->cpp[i];
+
+				if (b[col] != (in ? a[col] : 0))
+					return 0;
+			}
+		}
+	}
+
+	return 1;
+}
+
+/* tbm_surface_internal_convert() */
+
+TEST(tbm_surface_internal_convert, work_flow_success_3)
+{
+	static const tbm_format formats[] = {
+		TBM_FORMAT_NV12, TBM_FORMAT_YUV420, TBM_FORMAT_YUYV,
+	};
+	static unsigned char argb[8192], ref[8192], out[8192];
+	struct _tbm_surface src, rsurf, osurf;
+	tbm_surface_rect_s damage = { 5, 3, 10, 4 }, aligned = { 4, 2, 12, 6 };
+	unsigned int f;
+	int ret;
+
+	_init_test();
+
+	/* only the damage of src, grown to the chroma samples, is converted */
+	for (f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+		_ut_convert_setup(&src, TBM_FORMAT_ARGB8888, 20, 9, argb);
+		_ut_convert_setup(&rsurf, formats[f], 20, 9, ref);
+		_ut_convert_setup(&osurf, formats[f], 20, 9, out);
+		_ut_fill(argb, sizeof(argb), f);
+		memset(out, 0, sizeof(out));
+
+		ret = tbm_surface_internal_convert(&src, &rsurf);
+		ASSERT_EQ(ret, 1);
+
+		src.damage[0] = damage;
+		src.num_damage = 1;
+		ret = tbm_surface_internal_convert(&src, &osurf);
+		ASSERT_EQ(ret, 1);
+		ASSERT_EQ(_ut_damage_check(&rsurf, &osurf, &aligned), 1);
+		ASSERT_EQ(osurf.num_damage, 1);
+		ASSERT_EQ(osurf.damage[0].width, 12);
+
+		/* and back */
+		memset(argb, 0, sizeof(argb));
+		_ut_convert_setup(&rsurf, TBM_FORMAT_ARGB8888, 20, 9, ref);
+		osurf.num_damage = 0;
+		ret = tbm_surface_internal_convert(&osurf, &rsurf);
+		ASSERT_EQ(ret, 1);
+		osurf.damage[0] = damage;
+		osurf.num_damage = 1;
+		ret = tbm_surface_internal_convert(&osurf, &src);
+		ASSERT_EQ(ret, 1);
+		ASSERT_EQ(_ut_damage_check(&rsurf, &src, &aligned), 1);
+	}
+}
+
+TEST(tbm_surface_internal_convert, work_flow_success_2)
+{
+	static unsigned char yuv[4096], argb[4096];
+	struct _tbm_surface src, dst;
+	uint32_t *pixel;
+	int ret;
+
+	_init_test();
+
+	_ut_convert_setup(&src, TBM_FORMAT_NV12, 20, 4, yuv);
+	_ut_convert_setup(&dst, TBM_FORMAT_ARGB8888, 20, 4, argb);
+	/* limited range black */
+	memset(yuv, 16, src.info.planes[0].stride * 4);
+	memset(src.info.planes[1].ptr, 128, src.info.planes[1].stride * 2);
+
+	ret = tbm_surface_internal_convert(&src, &dst);
+
+	ASSERT_EQ(ret, 1);
+	pixel = (uint32_t *)(argb + dst.info.planes[0].stride * 3);
+	ASSERT_EQ(pixel[0], 0xff000000);
+	ASSERT_EQ(pixel[19], 0xff000000);
+	ASSERT_EQ(ut_unmap_count, 2);
+}
+
+TEST(tbm_surface_internal_convert, work_flow_success_1)
+{
+	static unsigned char yuv[4096], argb[4096];
+	struct _tbm_surface src, dst;
+	uint32_t *pixel;
+	int ret;
+
+	_init_test();
+
+	_ut_convert_setup(&src, TBM_FORMAT_YUYV, 34, 3, yuv);
+	_ut_convert_setup(&dst, TBM_FORMAT_XRGB8888, 34, 3, argb);
+	/* limited range white */
+	memset(yuv, 128, sizeof(yuv));
+	for (int i = 0; i < src.info.planes[0].stride * 3; i += 2)
+		yuv[i] = 235;
+
+	ret = tbm_surface_internal_convert(&src, &dst);
+
+	ASSERT_EQ(ret, 1);
+	pixel = (uint32_t *)(argb + dst.info.planes[0].stride * 2);
+	ASSERT_EQ(pixel[0], 0xffffffff);
+	ASSERT_EQ(pixel[33], 0xffffffff);
+}
+
+TEST(tbm_surface_internal_convert, null_ptr_fail_1)
+{
+	struct _tbm_surface surface;
+	int ret;
+
+	_init_test();
+
+	ret = tbm_surface_internal_convert(NULL, &surface);
+	ASSERT_EQ(ret, 0);
+
+	ret = tbm_surface_internal_convert(&surface, NULL);
+	ASSERT_EQ(ret, 0);
+}
+
+/* tbm_surface_internal_convert_with_colorspace() */
+
+TEST(tbm_surface_internal_convert_with_colorspace, work_flow_success_4)
+{
+	static unsigned char argb[4096], yuv[4096];
+	struct _tbm_surface src, dst;
+	int ret;
+
+	_init_test();
+
+	_ut_convert_setup(&src, TBM_FORMAT_ARGB8888, 16, 4, argb);
+	_ut_convert_setup(&dst, TBM_FORMAT_NV12, 16, 4, yuv);
+	UT_TBM_SURFACE_MAP_ERROR = 1;
+
+	ret = tbm_surface_internal_convert_with_colorspace(&src, &dst,
+							   TBM_SURFACE_COLORSPACE_BT709_LIMITED);
+
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(ut_unmap_count, 0);
+}
+
+TEST(tbm_surface_internal_convert_with_colorspace, work_flow_success_3)
+{
+	static unsigned char buf1[4096], buf2[4096];
+	struct _tbm_surface src, dst;
+	int ret;
+
+	_init_test();
+
+	/* yuv to yuv and different sizes are not supported */
+	_ut_convert_setup(&src, TBM_FORMAT_NV12, 16, 4, buf1);
+	_ut_convert_setup(&dst, TBM_FORMAT_YUV420, 16, 4, buf2);
+	ret = tbm_surface_internal_convert_with_colorspace(&src, &dst,
+							   TBM_SURFACE_COLORSPACE_BT601_FULL);
+	ASSERT_EQ(ret, 0);
+
+	_ut_convert_setup(&dst, TBM_FORMAT_ARGB8888, 16, 2, buf2);
+	ret = tbm_surface_internal_convert_with_colorspace(&src, &dst,
+							   TBM_SURFACE_COLORSPACE_BT601_FULL);
+	ASSERT_EQ(ret, 0);
+
+	_ut_convert_setup(&dst, TBM_FORMAT_ARGB8888, 16, 4, buf2);
+	ret = tbm_surface_internal_convert_with_colorspace(&src, &dst,
+							   (tbm_surface_colorspace_e)NUM_CONVERT_COEFS);
+	ASSERT_EQ(ret, 0);
+}
+
+TEST(tbm_surface_internal_convert_with_colorspace, work_flow_success_2)
+{
+	static const tbm_format formats[] = {
+		TBM_FORMAT_NV12, TBM_FORMAT_NV21, TBM_FORMAT_YUV420,
+		TBM_FORMAT_YVU420, TBM_FORMAT_YUYV, TBM_FORMAT_UYVY,
+	};
+	static unsigned char argb[16384], yuv[16384], out[16384];
+	struct _tbm_surface rgb_surf, yuv_surf, out_surf;
+	unsigned int i;
+	int x, y, ret;
+
+	_init_test();
+
+	/* gray survives the full range round trip exactly, odd sizes included */
+	for (i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+		_ut_convert_setup(&rgb_surf, TBM_FORMAT_ARGB8888, 37, 5, argb);
+		_ut_convert_setup(&yuv_surf, formats[i], 37, 5, yuv);
+		_ut_convert_setup(&out_surf, TBM_FORMAT_ARGB8888, 37, 5, out);
+
+		for (y = 0; y < 5; y++) {
+			uint32_t *line = (uint32_t *)(argb + y * rgb_surf.info.planes[0].stride);
+
+			for (x = 0; x < 37; x++)
+				line[x] = 0xff000000 | ((y * 37 + x) * 0x010101);
+		}
+
+		ret = tbm_surface_internal_convert_with_colorspace(&rgb_surf, &yuv_surf,
+								   TBM_SURFACE_COLORSPACE_BT601_FULL);
+		ASSERT_EQ(ret, 1);
+
+		ret = tbm_surface_internal_convert_with_colorspace(&yuv_surf, &out_surf,
+								   TBM_SURFACE_COLORSPACE_BT601_FULL);
+		ASSERT_EQ(ret, 1);
+
+		for (y = 0; y < 5; y++) {
+			ASSERT_EQ(memcmp(argb + y * rgb_surf.info.planes[0].stride,
+					 out + y * out_surf.info.planes[0].stride, 37 * 4), 0);
+		}
+	}
+}
+
+TEST(tbm_surface_internal_convert_with_colorspace, work_flow_success_1)
+{
+	static unsigned char argb[4096], yuv[4096];
+	struct _tbm_surface src, dst;
+	int ret;
+
+	_init_test();
+
+	/* pure red in BT.709 limited range */
+	_ut_convert_setup(&src, TBM_FORMAT_ARGB8888, 2, 2, argb);
+	_ut_convert_setup(&dst, TBM_FORMAT_YUV420, 2, 2, yuv);
+	((uint32_t *)argb)[0] = ((uint32_t *)argb)[1] = 0xffff0000;
+	((uint32_t *)(argb + src.info.planes[0].stride))[0] = 0xffff0000;
+	((uint32_t *)(argb + src.info.planes[0].stride))[1] = 0xffff0000;
+
+	ret = tbm_surface_internal_convert_with_colorspace(&src, &dst,
+							   TBM_SURFACE_COLORSPACE_BT709_LIMITED);
+
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(dst.info.planes[0].ptr[0], 63);
+	ASSERT_EQ(dst.info.planes[1].ptr[0], 102);
+	ASSERT_EQ(dst.info.planes[2].ptr[0], 240);
+}
+
+TEST(tbm_surface_internal_convert_with_colorspace, null_ptr_fail_1)
+{
+	struct _tbm_surface surface;
+	int ret;
+
+	_init_test();
+
+	ret = tbm_surface_internal_convert_with_colorspace(NULL, NULL,
+							   TBM_SURFACE_COLORSPACE_BT601_LIMITED);
+	ASSERT_EQ(ret, 0);
+
+	ret = tbm_surface_internal_convert_with_colorspace(&surface, &surface,
+							   TBM_SURFACE_COLORSPACE_BT601_LIMITED);
+	ASSERT_EQ(ret, 0);
+}
+
+/* simd kernels */
+
+TEST(tbm_surface_convert_kernels, work_flow_success_1)
+{
+	unsigned int features = _tbm_cpu_get_features();
+
+	_init_test();
+
+	ASSERT_EQ(_ut_kernels_compare(&convert_kernels_c), 1);
+#ifdef TBM_SIMD_SSE2
+	if (features & TBM_CPU_SSE2)
+		ASSERT_EQ(_ut_kernels_compare(&convert_kernels_sse2), 1);
+#endif
+#ifdef TBM_SIMD_AVX2
+	if (features & TBM_CPU_AVX2)
+		ASSERT_EQ(_ut_kernels_compare(&convert_kernels_avx2), 1);
+#endif
+#ifdef TBM_SIMD_NEON
+	if (features & TBM_CPU_NEON)
+		ASSERT_EQ(_ut_kernels_compare(&convert_kernels_neon), 1);
+#endif
+}
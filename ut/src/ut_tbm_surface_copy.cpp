@@ -0,0 +1,336 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics co., Ltd. All Rights Reserved.
+ *
+ * Contact: Konstantin Drabeniuk <k.drabeniuk@samsung.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+**************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "tbm_bufmgr_int.h"
+
+#include "stdlib_stubs.h"
+
+/* HELPER FUNCTIONS */
+
+static int ut_bo_flags = 0;
+static struct _tbm_bo ut_bo;
+
+static int
+ut_tbm_surface_internal_get_plane_bo_idx(tbm_surface_h surface, int plane_idx)
+{
+	return 0;
+}
+
+static tbm_bo
+ut_tbm_surface_internal_get_bo(tbm_surface_h surface, int bo_idx)
+{
+	return &ut_bo;
+}
+
+static int
+ut_tbm_bo_get_flags(tbm_bo bo)
+{
+	return ut_bo_flags;
+}
+
+#include "tbm_surface_stubs.h"
+
+#define tbm_surface_internal_get_plane_bo_idx ut_tbm_surface_internal_get_plane_bo_idx
+#define tbm_surface_internal_get_bo ut_tbm_surface_internal_get_bo
+#define tbm_bo_get_flags ut_tbm_bo_get_flags
+
+#include "tbm_worker.c"
+#include "tbm_surface_copy.c"
+
+static void _init_test()
+{
+	UT_TBM_SURFACE_MAP_ERROR = 0;
+	ut_unmap_count = 0;
+	ut_bo_flags = 0;
+}
+
+static int
+_ut_rows_equal(tbm_surface_info_s *a, tbm_surface_info_s *b, int plane,
+	       int x, int y, int w, int h)
+{
+	int row;
+
+	for (row = y; row < y + h; row++) {
+		if (memcmp(a->planes[plane].ptr + row * a->planes[plane].stride + x,
+			   b->planes[plane].ptr + row * b->planes[plane].stride + x, w))
+			return 0;
+	}
+
+	return 1;
+}
+
+static int ut_worker_hits[64];
+
+static void
+_ut_worker_func(void *data, int idx)
+{
+	__atomic_add_fetch(&ut_worker_hits[idx], 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch((int *)data, idx, __ATOMIC_RELAXED);
+}
+
+/* tbm_surface_internal_copy() */
+
+TEST(tbm_surface_internal_copy, work_flow_success_7)
+{
+	struct _tbm_surface src, dst;
+	tbm_surface_rect_s rect = { 2, 2, 4, 2 }, damage = { 0, 0, 2, 2 };
+	unsigned char sbuf[1024], dbuf[1024];
+	int ret;
+
+	_init_test();
+
+	_ut_surface_setup(&src, TBM_FORMAT_NV12, 16, 8, 0, sbuf);
+	_ut_surface_setup(&dst, TBM_FORMAT_NV12, 16, 8, 0, dbuf);
+
+	/* a dst without damage stays dirty as a whole */
+	ret = tbm_surface_internal_copy(&src, &dst, &rect);
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(dst.num_damage, 0);
+
+	/* the copied rect is added to the damage of dst */
+	dst.damage[0] = damage;
+	dst.num_damage = 1;
+	ret = tbm_surface_internal_copy(&src, &dst, &rect);
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(dst.num_damage, 2);
+	ASSERT_EQ(memcmp(&dst.damage[1], &rect, sizeof(rect)), 0);
+
+	/* the whole src is copied and added */
+	dst.num_damage = 1;
+	ret = tbm_surface_internal_copy(&src, &dst, NULL);
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(dst.num_damage, 2);
+	ASSERT_EQ(dst.damage[1].width, 16);
+	ASSERT_EQ(dst.damage[1].height, 8);
+}
+
+TEST(tbm_surface_internal_copy, work_flow_success_6)
+{
+	struct _tbm_surface src, dst;
+	tbm_surface_rect_s damage[2] = { { 3, 1, 2, 2 }, { 10, 6, 5, 2 } };
+	unsigned char sbuf[1024], dbuf[1024], zero[1024];
+	int ret;
+
+	_init_test();
+
+	/* only the damage of src, grown to the chroma subsampling, is copied */
+	_ut_surface_setup(&src, TBM_FORMAT_NV12, 16, 8, 0, sbuf);
+	_ut_surface_setup(&dst, TBM_FORMAT_NV12, 16, 8, 0, dbuf);
+	_ut_fill(sbuf, src.info.size, 9);
+	memset(dbuf, 0, sizeof(dbuf));
+	memset(zero, 0, sizeof(zero));
+	memcpy(src.damage, damage, sizeof(damage));
+	src.num_damage = 2;
+
+	ret = tbm_surface_internal_copy(&src, &dst, NULL);
+
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(_ut_rows_equal(&src.info, &dst.info, 0, 2, 0, 4, 4), 1);
+	ASSERT_EQ(_ut_rows_equal(&src.info, &dst.info, 0, 10, 6, 6, 2), 1);
+	ASSERT_EQ(_ut_rows_equal(&src.info, &dst.info, 1, 2, 0, 4, 2), 1);
+	ASSERT_EQ(_ut_rows_equal(&src.info, &dst.info, 1, 10, 3, 6, 1), 1);
+	ASSERT_EQ(memcmp(dbuf, zero, 2), 0);
+	ASSERT_EQ(memcmp(dbuf + 16 * 4, zero, 16 * 2), 0);
+	ASSERT_EQ(memcmp(dbuf + 16 * 8 + 16 * 2, zero, 16), 0);
+
+	/* and dst is damaged there */
+	ASSERT_EQ(dst.num_damage, 2);
+	ASSERT_EQ(dst.damage[0].x, 2);
+	ASSERT_EQ(dst.damage[0].y, 0);
+	ASSERT_EQ(dst.damage[0].width, 4);
+	ASSERT_EQ(dst.damage[0].height, 4);
+	ASSERT_EQ(dst.damage[1].x, 10);
+	ASSERT_EQ(dst.damage[1].width, 6);
+}
+
+TEST(tbm_surface_internal_copy, work_flow_success_5)
+{
+	struct _tbm_surface src, dst;
+	tbm_surface_rect_s rect = { 1, 0, 4, 4 };
+	unsigned char sbuf[1024], dbuf[1024];
+	int ret;
+
+	_init_test();
+
+	/* x of YUYV must be even, chroma is shared by 2 pixels */
+	_ut_surface_setup(&src, TBM_FORMAT_YUYV, 8, 4, 0, sbuf);
+	_ut_surface_setup(&dst, TBM_FORMAT_YUYV, 8, 4, 0, dbuf);
+
+	ret = tbm_surface_internal_copy(&src, &dst, &rect);
+	ASSERT_EQ(ret, 0);
+
+	rect.x = 6;
+	ret = tbm_surface_internal_copy(&src, &dst, &rect);
+	ASSERT_EQ(ret, 0);
+
+	_ut_surface_setup(&dst, TBM_FORMAT_UYVY, 8, 4, 0, dbuf);
+	ret = tbm_surface_internal_copy(&src, &dst, NULL);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(ut_unmap_count, 0);
+}
+
+TEST(tbm_surface_internal_copy, work_flow_success_4)
+{
+	struct _tbm_surface src, dst;
+	unsigned char sbuf[1024], dbuf[1024];
+	int ret;
+
+	_init_test();
+
+	_ut_surface_setup(&src, TBM_FORMAT_ARGB8888, 8, 4, 0, sbuf);
+	_ut_surface_setup(&dst, TBM_FORMAT_ARGB8888, 8, 4, 0, dbuf);
+	UT_TBM_SURFACE_MAP_ERROR = 1;
+
+	ret = tbm_surface_internal_copy(&src, &dst, NULL);
+
+	ASSERT_EQ(ret, 0);
+}
+
+TEST(tbm_surface_internal_copy, work_flow_success_3)
+{
+	static unsigned char sbuf[1920 * 1080 * 4 + 4096], dbuf[1920 * 1080 * 4 + 4096];
+	struct _tbm_surface src, dst;
+	int ret;
+
+	_init_test();
+
+	/* big enough to be split among the workers, with and without streaming */
+	_ut_surface_setup(&src, TBM_FORMAT_ARGB8888, 1000, 1000, 0, sbuf);
+	_ut_surface_setup(&dst, TBM_FORMAT_ARGB8888, 1000, 1000, 0, dbuf);
+	_ut_fill(sbuf, src.info.size, 3);
+
+	ret = tbm_surface_internal_copy(&src, &dst, NULL);
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(memcmp(sbuf, dbuf, src.info.size), 0);
+
+	_ut_surface_setup(&dst, TBM_FORMAT_ARGB8888, 1000, 1000, 12, dbuf + 3);
+	ut_bo_flags = TBM_BO_WC;
+
+	ret = tbm_surface_internal_copy(&src, &dst, NULL);
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(_ut_rows_equal(&src.info, &dst.info, 0, 0, 0, 4000, 1000), 1);
+}
+
+TEST(tbm_surface_internal_copy, work_flow_success_2)
+{
+	struct _tbm_surface src, dst;
+	tbm_surface_rect_s rect = { 2, 2, 5, 3 };
+	unsigned char sbuf[4096], dbuf[4096], orig[4096];
+	int ret;
+
+	_init_test();
+
+	_ut_surface_setup(&src, TBM_FORMAT_YUV420, 16, 8, 0, sbuf);
+	_ut_surface_setup(&dst, TBM_FORMAT_YUV420, 12, 10, 3, dbuf);
+	_ut_fill(sbuf, src.info.size, 1);
+	_ut_fill(dbuf, dst.info.size, 2);
+	memcpy(orig, dbuf, dst.info.size);
+
+	ret = tbm_surface_internal_copy(&src, &dst, &rect);
+
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(_ut_rows_equal(&src.info, &dst.info, 0, 2, 2, 5, 3), 1);
+	/* the chroma of rows 2..4 and columns 2..6 */
+	ASSERT_EQ(_ut_rows_equal(&src.info, &dst.info, 1, 1, 1, 3, 2), 1);
+	ASSERT_EQ(_ut_rows_equal(&src.info, &dst.info, 2, 1, 1, 3, 2), 1);
+	/* nothing outside of the rect */
+	ASSERT_EQ(dbuf[2 * dst.info.planes[0].stride + 1], orig[2 * dst.info.planes[0].stride + 1]);
+	ASSERT_EQ(dbuf[2 * dst.info.planes[0].stride + 7], orig[2 * dst.info.planes[0].stride + 7]);
+	ASSERT_EQ(dst.info.planes[1].ptr[0], orig[dst.info.planes[1].ptr - dbuf]);
+	ASSERT_EQ(ut_unmap_count, 2);
+}
+
+TEST(tbm_surface_internal_copy, work_flow_success_1)
+{
+	struct _tbm_surface src, dst;
+	unsigned char sbuf[4096], dbuf[4096];
+	int ret;
+
+	_init_test();
+
+	_ut_surface_setup(&src, TBM_FORMAT_NV12, 30, 10, 0, sbuf);
+	_ut_surface_setup(&dst, TBM_FORMAT_NV12, 30, 10, 17, dbuf);
+	_ut_fill(sbuf, src.info.size, 1);
+
+	ret = tbm_surface_internal_copy(&src, &dst, NULL);
+
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(_ut_rows_equal(&src.info, &dst.info, 0, 0, 0, 30, 10), 1);
+	ASSERT_EQ(_ut_rows_equal(&src.info, &dst.info, 1, 0, 0, 30, 5), 1);
+}
+
+TEST(tbm_surface_internal_copy, null_ptr_fail_1)
+{
+	struct _tbm_surface surface;
+	int ret;
+
+	_init_test();
+
+	ret = tbm_surface_internal_copy(NULL, &surface, NULL);
+	ASSERT_EQ(ret, 0);
+
+	ret = tbm_surface_internal_copy(&surface, NULL, NULL);
+	ASSERT_EQ(ret, 0);
+
+	ret = tbm_surface_internal_copy(&surface, &surface, NULL);
+	ASSERT_EQ(ret, 0);
+}
+
+/* _tbm_worker_run() */
+
+TEST(_tbm_worker_run, work_flow_success_1)
+{
+	int sum = 0, i, round;
+
+	_init_test();
+
+	for (round = 0; round < 20; round++) {
+		memset(ut_worker_hits, 0, sizeof(ut_worker_hits));
+		sum = 0;
+
+		_tbm_worker_run(_ut_worker_func, &sum, 64);
+
+		ASSERT_EQ(sum, 64 * 63 / 2);
+		for (i = 0; i < 64; i++)
+			ASSERT_EQ(ut_worker_hits[i], 1);
+	}
+
+	ASSERT_GE(_tbm_worker_get_count(), 1);
+}
+
+/* _tbm_worker_get_bands() */
+
+TEST(_tbm_worker_get_bands, work_flow_success_1)
+{
+	/* small works run on the caller alone */
+	ASSERT_EQ(_tbm_worker_get_bands(0), 1);
+	ASSERT_EQ(_tbm_worker_get_bands(TBM_WORKER_SPLIT_SIZE - 1), 1);
+	ASSERT_EQ(_tbm_worker_get_bands(TBM_WORKER_SPLIT_SIZE), _tbm_worker_get_count());
+}
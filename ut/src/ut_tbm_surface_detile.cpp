@@ -0,0 +1,264 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics co., Ltd. All Rights Reserved.
+ *
+ * Contact: Konstantin Drabeniuk <k.drabeniuk@samsung.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+**************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "tbm_surface_stubs.h"
+
+#include "tbm_surface_detile.c"
+
+static void _init_test()
+{
+	UT_TBM_SURFACE_MAP_ERROR = 0;
+	ut_unmap_count = 0;
+}
+
+static unsigned char ut_tiled[1920 * 1088 * 2];
+static unsigned char ut_linear[1920 * 1088 * 2];
+static unsigned char ut_out[1920 * 1088 * 2];
+
+/* w x h NV12MT on top of ut_tiled and NV12 with the stride w + pad on top of ut_out */
+static void
+_ut_detile_setup(struct _tbm_surface *tiled, struct _tbm_surface *linear, int w, int h, int pad)
+{
+	int x_tiles = (w + 127) / 128 * 2;
+	int i;
+
+	memset(tiled, 0, sizeof(*tiled));
+	tiled->info.width = w;
+	tiled->info.height = h;
+	tiled->info.format = TBM_FORMAT_NV12MT;
+	tiled->info.num_planes = 2;
+	tiled->info.planes[0].ptr = ut_tiled;
+	tiled->info.planes[0].size = x_tiles * ((h + 31) / 32) * 2048;
+	tiled->info.planes[1].ptr = ut_tiled + tiled->info.planes[0].size;
+	tiled->info.planes[1].size = x_tiles * (((h + 1) / 2 + 31) / 32) * 2048;
+	for (i = 0; i < 2; i++)
+		tiled->info.planes[i].stride = x_tiles * 64;
+	tiled->info.size = tiled->info.planes[0].size + tiled->info.planes[1].size;
+
+	memset(linear, 0, sizeof(*linear));
+	linear->info.width = w;
+	linear->info.height = h;
+	linear->info.format = TBM_FORMAT_NV12;
+	linear->info.num_planes = 2;
+	linear->info.planes[0].ptr = ut_out;
+	linear->info.planes[0].stride = w + pad;
+	linear->info.planes[1].ptr = ut_out + (w + pad) * h;
+	linear->info.planes[1].stride = w + pad;
+}
+
+/* tiles a random NV12 of w x h held in ut_linear with the stride w */
+static void
+_ut_tile(struct _tbm_surface *tiled)
+{
+	int w = tiled->info.width, h = tiled->info.height;
+	int x_tiles = (w + 127) / 128 * 2;
+	int i, x, y, row;
+
+	_ut_fill(ut_linear, w * (h + (h + 1) / 2), w + h);
+	memset(ut_tiled, 0, sizeof(ut_tiled));
+
+	for (i = 0; i < 2; i++) {
+		int ph = i ? (h + 1) / 2 : h;
+		int y_tiles = (ph + 31) / 32;
+		unsigned char *src = ut_linear + (i ? w * h : 0);
+
+		for (y = 0; y < y_tiles; y++) {
+			for (x = 0; x < x_tiles; x++) {
+				unsigned char *tile = tiled->info.planes[i].ptr +
+					_tbm_detile_get_index(x, y, x_tiles, y_tiles) * 2048;
+
+				for (row = 0; row < 32 && y * 32 + row < ph; row++) {
+					int bytes = w - x * 64;
+
+					if (bytes <= 0)
+						break;
+					memcpy(tile + row * 64, src + (y * 32 + row) * w + x * 64,
+					       bytes > 64 ? 64 : bytes);
+				}
+			}
+		}
+	}
+}
+
+static int
+_ut_linear_check(struct _tbm_surface *linear)
+{
+	tbm_surface_info_s *info = &linear->info;
+	int w = info->width, h = info->height;
+	int row;
+
+	for (row = 0; row < h; row++)
+		if (memcmp(info->planes[0].ptr + row * info->planes[0].stride, ut_linear + row * w, w))
+			return 0;
+
+	for (row = 0; row < (h + 1) / 2; row++)
+		if (memcmp(info->planes[1].ptr + row * info->planes[1].stride,
+			   ut_linear + w * h + row * w, w))
+			return 0;
+
+	return 1;
+}
+
+/* tbm_surface_internal_detile() */
+
+TEST(tbm_surface_internal_detile, work_flow_success_4)
+{
+	struct _tbm_surface tiled, linear;
+	int ret;
+
+	_init_test();
+
+	_ut_detile_setup(&tiled, &linear, 128, 64, 0);
+
+	ret = tbm_surface_internal_detile(&linear, &tiled);
+	ASSERT_EQ(ret, 0);
+
+	linear.info.width = 64;
+	ret = tbm_surface_internal_detile(&tiled, &linear);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(ut_unmap_count, 0);
+
+	/* the UV tiles are missing */
+	linear.info.width = 128;
+	tiled.info.planes[1].size = 2048;
+	ret = tbm_surface_internal_detile(&tiled, &linear);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(ut_unmap_count, 2);
+
+	UT_TBM_SURFACE_MAP_ERROR = 1;
+	ret = tbm_surface_internal_detile(&tiled, &linear);
+	ASSERT_EQ(ret, 0);
+}
+
+TEST(tbm_surface_internal_detile, work_flow_success_3)
+{
+	struct _tbm_surface tiled, linear;
+	int ret;
+
+	_init_test();
+
+	/* big enough to be split among the workers */
+	_ut_detile_setup(&tiled, &linear, 1920, 1080, 0);
+	_ut_tile(&tiled);
+
+	ret = tbm_surface_internal_detile(&tiled, &linear);
+
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(_ut_linear_check(&linear), 1);
+}
+
+TEST(tbm_surface_internal_detile, work_flow_success_2)
+{
+	struct _tbm_surface tiled, linear;
+	int ret;
+
+	_init_test();
+
+	/* partial tiles at the right and the bottom, an odd number of tile rows */
+	_ut_detile_setup(&tiled, &linear, 200, 90, 7);
+	_ut_tile(&tiled);
+	memset(ut_out, 0xaa, sizeof(ut_out));
+
+	ret = tbm_surface_internal_detile(&tiled, &linear);
+
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(_ut_linear_check(&linear), 1);
+	/* the padding of the rows is not touched */
+	ASSERT_EQ(ut_out[200], 0xaa);
+	ASSERT_EQ(linear.info.planes[1].ptr[44 * 207 + 206], 0xaa);
+}
+
+TEST(tbm_surface_internal_detile, work_flow_success_1)
+{
+	/* the tiles of 256x64 in the memory, a Z and a flipped Z */
+	static const int y_tiles[2][4] = { { 0, 1, 6, 7 }, { 2, 3, 4, 5 } };
+	struct _tbm_surface tiled, linear;
+	int ret, i, x, y;
+
+	_init_test();
+
+	_ut_detile_setup(&tiled, &linear, 256, 64, 0);
+	for (i = 0; i < 8; i++)
+		memset(tiled.info.planes[0].ptr + i * 2048, i, 2048);
+	/* a single row of UV tiles is linear */
+	for (i = 0; i < 4; i++)
+		memset(tiled.info.planes[1].ptr + i * 2048, 100 + i, 2048);
+
+	ret = tbm_surface_internal_detile(&tiled, &linear);
+
+	ASSERT_EQ(ret, 1);
+	for (y = 0; y < 2; y++)
+		for (x = 0; x < 4; x++)
+			ASSERT_EQ(ut_out[(y * 32 + 5) * 256 + x * 64 + 3], y_tiles[y][x]);
+	for (x = 0; x < 4; x++)
+		ASSERT_EQ(linear.info.planes[1].ptr[31 * 256 + x * 64], 100 + x);
+	ASSERT_EQ(ut_unmap_count, 2);
+}
+
+TEST(tbm_surface_internal_detile, null_ptr_fail_1)
+{
+	struct _tbm_surface surface;
+	int ret;
+
+	_init_test();
+
+	ret = tbm_surface_internal_detile(NULL, &surface);
+	ASSERT_EQ(ret, 0);
+
+	ret = tbm_surface_internal_detile(&surface, NULL);
+	ASSERT_EQ(ret, 0);
+
+	ret = tbm_surface_internal_detile(&surface, &surface);
+	ASSERT_EQ(ret, 0);
+}
+
+/* _tbm_surface_internal_detile_nv12mt() */
+
+TEST(_tbm_surface_internal_detile_nv12mt, null_ptr_fail_1)
+{
+	struct _tbm_surface tiled, linear;
+	int ret;
+
+	_init_test();
+
+	_ut_detile_setup(&tiled, &linear, 128, 64, 0);
+
+	ret = _tbm_surface_internal_detile_nv12mt(NULL, ut_out, 128, ut_out, 128);
+	ASSERT_EQ(ret, 0);
+
+	ret = _tbm_surface_internal_detile_nv12mt(&tiled.info, NULL, 128, ut_out, 128);
+	ASSERT_EQ(ret, 0);
+
+	ret = _tbm_surface_internal_detile_nv12mt(&tiled.info, ut_out, 64, ut_out, 128);
+	ASSERT_EQ(ret, 0);
+
+	ret = _tbm_surface_internal_detile_nv12mt(&linear.info, ut_out, 128, ut_out, 128);
+	ASSERT_EQ(ret, 0);
+}
@@ -0,0 +1,842 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics co., Ltd. All Rights Reserved.
+ *
+ * Contact: Konstantin Drabeniuk <k.drabeniuk@samsung.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+**************************************************************************/
+
+
+#include "gtest/gtest.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "tbm_bufmgr_int.h"
+
+#include "stdlib_stubs.h"
+
+#define UT_STREAM_FILE "/tmp/ut_tbm_surface_dump.tbmd"
+#define UT_Y4M_FILE "/tmp/ut_tbm_surface_dump.y4m"
+
+/* a fourcc without a format desc */
+#define UT_TBM_FORMAT_UNKNOWN 0x31545542
+
+/* HELPER FUNCTIONS */
+static int UT_TBM_SURFACE_COPY_ERROR = 0;
+static int ut_copy_count = 0;
+static int ut_detile_count = 0;
+static int ut_png_count = 0;
+static int ut_raw_count = 0;
+static int ut_destroy_count = 0;
+static int ut_unref_count = 0;
+/* the surfaces of _tbm_surface_internal_get_surfaces */
+static tbm_surface_h ut_surfaces[4];
+static int ut_num_surfaces = 0;
+/* the first byte of the data of the png files */
+static unsigned char ut_png_first[16];
+/* while it is set, the writer waits in the file writers */
+static int ut_writer_blocked = 0;
+static pthread_mutex_t ut_writer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ut_writer_cond = PTHREAD_COND_INITIALIZER;
+
+/* the planes of a w x h surface on top of buf with some padding at the end of the rows */
+static void
+_ut_surface_layout(tbm_surface_info_s *info, tbm_format format, int w, int h, int pad,
+		   unsigned char *buf)
+{
+	const tbm_format_desc_s *desc = tbm_format_get_desc(format);
+	unsigned char *ptr = buf;
+	int i;
+
+	memset(info, 0, sizeof(*info));
+	info->width = w;
+	info->height = h;
+	info->format = format;
+	if (!desc)
+		return;
+
+	info->num_planes = desc->num_planes;
+	for (i = 0; i < desc->num_planes; i++) {
+		int hsub = i ? desc->hsub : 1, vsub = i ? desc->vsub : 1;
+
+		info->planes[i].stride = (w + hsub - 1) / hsub * desc->cpp[i] + pad;
+		info->planes[i].size = info->planes[i].stride * ((h + vsub - 1) / vsub);
+		info->planes[i].ptr = ptr;
+		if (ptr)
+			ptr += info->planes[i].size;
+	}
+	info->size = ptr - buf;
+}
+
+static tbm_format
+ut_tbm_surface_internal_get_format(tbm_surface_h surface)
+{
+	return surface->info.format;
+}
+
+static unsigned int
+ut_tbm_surface_internal_get_width(tbm_surface_h surface)
+{
+	return surface->info.width;
+}
+
+static unsigned int
+ut_tbm_surface_internal_get_height(tbm_surface_h surface)
+{
+	return surface->info.height;
+}
+
+static tbm_surface_h
+ut_tbm_surface_internal_create_with_flags(int width, int height, int format, int flags)
+{
+	struct _tbm_surface *surf = (struct _tbm_surface *)calloc(1, sizeof(struct _tbm_surface));
+
+	/* the size of the planes first */
+	_ut_surface_layout(&surf->info, format, width, height, 0, NULL);
+	_ut_surface_layout(&surf->info, format, width, height, 0,
+			   (unsigned char *)calloc(1, surf->info.planes[0].size * 3 + 1));
+
+	return surf;
+}
+
+static void
+ut_tbm_surface_destroy(tbm_surface_h surface)
+{
+	ut_destroy_count++;
+	free(surface->info.planes[0].ptr);
+	free(surface);
+}
+
+static int
+ut_tbm_surface_internal_copy(tbm_surface_h src, tbm_surface_h dst, tbm_surface_rect_s *rect)
+{
+	if (UT_TBM_SURFACE_COPY_ERROR)
+		return 0;
+
+	ut_copy_count++;
+
+	if (src->info.planes[0].ptr) {
+		int i;
+
+		for (i = 0; i < (int)src->info.num_planes; i++)
+			memcpy(dst->info.planes[i].ptr, src->info.planes[i].ptr, src->info.planes[i].size);
+	}
+
+	return 1;
+}
+
+static int
+ut_tbm_surface_internal_detile(tbm_surface_h src, tbm_surface_h dst)
+{
+	ut_detile_count++;
+
+	return 1;
+}
+
+static int
+ut_tbm_surface_map(tbm_surface_h surface, int opt, tbm_surface_info_s *info)
+{
+	*info = surface->info;
+
+	return TBM_SURFACE_ERROR_NONE;
+}
+
+static int
+ut_tbm_surface_unmap(tbm_surface_h surface)
+{
+	return TBM_SURFACE_ERROR_NONE;
+}
+
+static void
+_ut_writer_wait(void)
+{
+	pthread_mutex_lock(&ut_writer_lock);
+	while (ut_writer_blocked)
+		pthread_cond_wait(&ut_writer_cond, &ut_writer_lock);
+	pthread_mutex_unlock(&ut_writer_lock);
+}
+
+static void
+_ut_writer_release(void)
+{
+	pthread_mutex_lock(&ut_writer_lock);
+	ut_writer_blocked = 0;
+	pthread_cond_broadcast(&ut_writer_cond);
+	pthread_mutex_unlock(&ut_writer_lock);
+}
+
+static void
+ut__tbm_surface_internal_dump_file_png(const char *file, const void *data, int width, int height)
+{
+	int n;
+
+	_ut_writer_wait();
+	n = __atomic_fetch_add(&ut_png_count, 1, __ATOMIC_SEQ_CST);
+	if (n < (int)sizeof(ut_png_first))
+		ut_png_first[n] = *(const unsigned char *)data;
+}
+
+static void
+ut__tbm_surface_internal_dump_file_raw(const char *file, void *data1, int size1,
+				       void *data2, int size2, void *data3, int size3)
+{
+	_ut_writer_wait();
+	__atomic_add_fetch(&ut_raw_count, 1, __ATOMIC_SEQ_CST);
+}
+
+static int
+ut__tbm_surface_internal_dump_file(const char *file, tbm_surface_info_s *info)
+{
+	const tbm_format_desc_s *desc = tbm_format_get_desc(info->format);
+
+	if (!desc)
+		return 0;
+
+	if (desc->is_yuv)
+		ut__tbm_surface_internal_dump_file_raw(file, info->planes[0].ptr, info->planes[0].size,
+						       NULL, 0, NULL, 0);
+	else
+		ut__tbm_surface_internal_dump_file_png(file, info->planes[0].ptr, info->width,
+						       info->height);
+
+	return 1;
+}
+
+static tbm_surface_h *
+ut__tbm_surface_internal_get_surfaces(int *num)
+{
+	tbm_surface_h *surfaces;
+
+	*num = 0;
+	if (!ut_num_surfaces)
+		return NULL;
+
+	surfaces = (tbm_surface_h *)calloc(ut_num_surfaces, sizeof(tbm_surface_h));
+	memcpy(surfaces, ut_surfaces, ut_num_surfaces * sizeof(tbm_surface_h));
+	*num = ut_num_surfaces;
+
+	return surfaces;
+}
+
+static void
+ut_tbm_surface_internal_unref(tbm_surface_h surface)
+{
+	ut_unref_count++;
+}
+
+#define calloc ut_calloc
+#define free ut_free
+#define tbm_surface_internal_get_format ut_tbm_surface_internal_get_format
+#define tbm_surface_internal_get_width ut_tbm_surface_internal_get_width
+#define tbm_surface_internal_get_height ut_tbm_surface_internal_get_height
+#define tbm_surface_internal_create_with_flags ut_tbm_surface_internal_create_with_flags
+#define tbm_surface_destroy ut_tbm_surface_destroy
+#define tbm_surface_internal_copy ut_tbm_surface_internal_copy
+#define tbm_surface_internal_detile ut_tbm_surface_internal_detile
+#define tbm_surface_map ut_tbm_surface_map
+#define tbm_surface_unmap ut_tbm_surface_unmap
+#define _tbm_surface_internal_dump_file_png ut__tbm_surface_internal_dump_file_png
+#define _tbm_surface_internal_dump_file_raw ut__tbm_surface_internal_dump_file_raw
+#define _tbm_surface_internal_dump_file ut__tbm_surface_internal_dump_file
+#define _tbm_surface_internal_get_surfaces ut__tbm_surface_internal_get_surfaces
+#define tbm_surface_internal_unref ut_tbm_surface_internal_unref
+
+#include "tbm_lz4.c"
+#include "tbm_surface_dump.c"
+
+static void _init_test()
+{
+	UT_TBM_SURFACE_COPY_ERROR = 0;
+	CALLOC_ERROR = 0;
+	ut_copy_count = 0;
+	ut_detile_count = 0;
+	ut_png_count = 0;
+	ut_raw_count = 0;
+	ut_destroy_count = 0;
+	ut_unref_count = 0;
+	ut_num_surfaces = 0;
+	ut_writer_blocked = 0;
+}
+
+static void
+_ut_surface_setup(struct _tbm_surface *surf, tbm_format format, int w, int h)
+{
+	memset(surf, 0, sizeof(*surf));
+	surf->info.width = w;
+	surf->info.height = h;
+	surf->info.format = format;
+}
+
+static void
+_ut_fill(unsigned char *buf, int size, unsigned int seed)
+{
+	int i;
+
+	for (i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+		buf[i] = seed >> 16;
+	}
+}
+
+/* waits until the writer gives back the staging surface of the frames */
+static void
+_ut_wait_written(unsigned int written)
+{
+	tbm_surface_dump_stats_s stats;
+
+	do {
+		usleep(1000);
+		tbm_surface_internal_dump_async_get_stats(&stats);
+	} while (stats.written < written);
+}
+
+/* tbm_surface_internal_dump_async_start() */
+
+TEST(tbm_surface_internal_dump_async_start, work_flow_success_2)
+{
+	tbm_surface_dump_stats_s stats;
+
+	_init_test();
+
+	ASSERT_EQ(1, tbm_surface_internal_dump_async_start("/tmp", 2));
+	/* already running */
+	ASSERT_EQ(0, tbm_surface_internal_dump_async_start("/tmp", 2));
+
+	ASSERT_EQ(1, tbm_surface_internal_dump_async_get_stats(&stats));
+	ASSERT_EQ(0, stats.queued);
+	ASSERT_EQ(0, stats.dropped);
+
+	tbm_surface_internal_dump_async_end();
+
+	ASSERT_EQ(0, tbm_surface_internal_dump_async_get_stats(&stats));
+}
+
+TEST(tbm_surface_internal_dump_async_start, work_flow_success_1)
+{
+	_init_test();
+
+	CALLOC_ERROR = 1;
+	ASSERT_EQ(0, tbm_surface_internal_dump_async_start("/tmp", 2));
+	CALLOC_ERROR = 0;
+
+	/* ending a dump which isn't running does nothing */
+	tbm_surface_internal_dump_async_end();
+}
+
+TEST(tbm_surface_internal_dump_async_start, null_ptr_fail_1)
+{
+	_init_test();
+
+	ASSERT_EQ(0, tbm_surface_internal_dump_async_start(NULL, 2));
+	ASSERT_EQ(0, tbm_surface_internal_dump_async_start("/tmp", 0));
+	ASSERT_EQ(0, tbm_surface_internal_dump_async_get_stats(NULL));
+}
+
+/* _tbm_surface_internal_dump_async_buffer() */
+
+TEST(_tbm_surface_internal_dump_async_buffer, work_flow_success_5)
+{
+	struct _tbm_surface surf;
+
+	_init_test();
+
+	ASSERT_EQ(1, tbm_surface_internal_dump_async_start("/tmp", 1));
+
+	/* any format of a desc is written */
+	_ut_surface_setup(&surf, TBM_FORMAT_RGB565, 30, 20);
+	ASSERT_EQ(1, _tbm_surface_internal_dump_async_buffer(&surf, NULL, "test"));
+	_ut_wait_written(1);
+
+	_ut_surface_setup(&surf, TBM_FORMAT_YUV444, 30, 20);
+	ASSERT_EQ(1, _tbm_surface_internal_dump_async_buffer(&surf, NULL, "test"));
+
+	tbm_surface_internal_dump_async_end();
+
+	ASSERT_EQ(1, ut_png_count);
+	ASSERT_EQ(1, ut_raw_count);
+}
+
+TEST(_tbm_surface_internal_dump_async_buffer, work_flow_success_4)
+{
+	struct _tbm_surface surf;
+
+	_init_test();
+
+	_ut_surface_setup(&surf, TBM_FORMAT_ARGB8888, 64, 32);
+
+	/* not running, the synchronous dump does it */
+	ASSERT_EQ(0, _tbm_surface_internal_dump_async_buffer(&surf, NULL, "test"));
+}
+
+TEST(_tbm_surface_internal_dump_async_buffer, work_flow_success_3)
+{
+	tbm_surface_dump_stats_s stats;
+	struct _tbm_surface surf;
+
+	_init_test();
+
+	_ut_surface_setup(&surf, UT_TBM_FORMAT_UNKNOWN, 64, 32);
+	ASSERT_EQ(1, tbm_surface_internal_dump_async_start("/tmp", 2));
+
+	ASSERT_EQ(1, _tbm_surface_internal_dump_async_buffer(&surf, NULL, "test"));
+
+	UT_TBM_SURFACE_COPY_ERROR = 1;
+	_ut_surface_setup(&surf, TBM_FORMAT_ARGB8888, 64, 32);
+	ASSERT_EQ(1, _tbm_surface_internal_dump_async_buffer(&surf, NULL, "test"));
+
+	ASSERT_EQ(1, tbm_surface_internal_dump_async_get_stats(&stats));
+	ASSERT_EQ(0, stats.queued);
+	ASSERT_EQ(2, stats.failed);
+
+	tbm_surface_internal_dump_async_end();
+
+	ASSERT_EQ(0, ut_png_count);
+	ASSERT_EQ(0, ut_raw_count);
+}
+
+TEST(_tbm_surface_internal_dump_async_buffer, work_flow_success_2)
+{
+	tbm_surface_dump_stats_s stats;
+	struct _tbm_surface surf;
+
+	_init_test();
+
+	ASSERT_EQ(1, tbm_surface_internal_dump_async_start("/tmp", 1));
+
+	/* the writer holds the only staging surface */
+	ut_writer_blocked = 1;
+	_ut_surface_setup(&surf, TBM_FORMAT_ARGB8888, 64, 32);
+	ASSERT_EQ(1, _tbm_surface_internal_dump_async_buffer(&surf, NULL, "test"));
+	ASSERT_EQ(1, _tbm_surface_internal_dump_async_buffer(&surf, NULL, "test"));
+
+	ASSERT_EQ(1, tbm_surface_internal_dump_async_get_stats(&stats));
+	ASSERT_EQ(1, stats.queued);
+	ASSERT_EQ(1, stats.dropped);
+	ASSERT_EQ(0, stats.written);
+
+	_ut_writer_release();
+	tbm_surface_internal_dump_async_end();
+
+	ASSERT_EQ(1, ut_copy_count);
+	ASSERT_EQ(1, ut_png_count);
+	ASSERT_EQ(1, ut_destroy_count);
+}
+
+TEST(_tbm_surface_internal_dump_async_buffer, work_flow_success_1)
+{
+	struct _tbm_surface surf;
+
+	_init_test();
+
+	ASSERT_EQ(1, tbm_surface_internal_dump_async_start("/tmp", 1));
+
+	_ut_surface_setup(&surf, TBM_FORMAT_NV12, 64, 32);
+	ASSERT_EQ(1, _tbm_surface_internal_dump_async_buffer(&surf, NULL, "test"));
+	_ut_wait_written(1);
+
+	/* the tiled frame is written as NV12, on the same staging surface */
+	_ut_surface_setup(&surf, TBM_FORMAT_NV12MT, 64, 32);
+	ASSERT_EQ(1, _tbm_surface_internal_dump_async_buffer(&surf, NULL, "test"));
+
+	tbm_surface_internal_dump_async_end();
+
+	ASSERT_EQ(1, ut_copy_count);
+	ASSERT_EQ(1, ut_detile_count);
+	ASSERT_EQ(2, ut_raw_count);
+	ASSERT_EQ(1, ut_destroy_count);
+}
+
+/* tbm_surface_internal_dump_async_start_with_mode() */
+
+TEST(tbm_surface_internal_dump_async_start_with_mode, work_flow_success_1)
+{
+	unsigned char buf[2][64 * 32 * 4], out[64 * 32 * 4];
+	struct _tbm_surface surf[2], osurf;
+	tbm_surface_queue_h queue = (tbm_surface_queue_h)0x1234;
+	tbm_surface_dump_stream_h stream;
+	tbm_surface_dump_frame_s frame;
+	int i;
+
+	_init_test();
+
+	ASSERT_EQ(1, tbm_surface_internal_dump_async_start_with_mode(UT_STREAM_FILE, 1,
+								     TBM_SURFACE_DUMP_MODE_STREAM));
+
+	_ut_fill(buf[0], sizeof(buf[0]), 1);
+	_ut_fill(buf[1], sizeof(buf[1]), 2);
+	memset(surf, 0, sizeof(surf));
+	_ut_surface_layout(&surf[0].info, TBM_FORMAT_NV12, 64, 32, 0, buf[0]);
+	_ut_surface_layout(&surf[1].info, TBM_FORMAT_RGB565, 30, 20, 0, buf[1]);
+
+	ASSERT_EQ(1, _tbm_surface_internal_dump_async_buffer(&surf[0], NULL, "enqueue"));
+	_ut_wait_written(1);
+	/* any format goes to the stream */
+	ASSERT_EQ(1, _tbm_surface_internal_dump_async_buffer(&surf[1], queue, "acquire"));
+
+	tbm_surface_internal_dump_async_end();
+
+	ASSERT_EQ(0, ut_png_count + ut_raw_count);
+
+	stream = tbm_surface_internal_dump_stream_open(UT_STREAM_FILE);
+	ASSERT_TRUE(stream != NULL);
+	ASSERT_EQ(2, tbm_surface_internal_dump_stream_get_num_frames(stream));
+
+	for (i = 0; i < 2; i++) {
+		ASSERT_EQ(1, tbm_surface_internal_dump_stream_get_frame(stream, i, &frame));
+		ASSERT_EQ(surf[i].info.format, frame.format);
+		ASSERT_EQ(surf[i].info.width, frame.width);
+		ASSERT_EQ(surf[i].info.num_planes, frame.num_planes);
+		ASSERT_EQ((uint64_t)(uintptr_t)&surf[i], frame.surface_id);
+		ASSERT_EQ(0, frame.offsets[0] % sysconf(_SC_PAGESIZE));
+
+		/* into other strides */
+		_ut_surface_layout(&osurf.info, surf[i].info.format, surf[i].info.width,
+				   surf[i].info.height, 8, out);
+		ASSERT_EQ(1, tbm_surface_internal_dump_stream_read_frame(stream, i, &osurf));
+		ASSERT_EQ(0, memcmp(osurf.info.planes[0].ptr + osurf.info.planes[0].stride * 3,
+				    surf[i].info.planes[0].ptr + surf[i].info.planes[0].stride * 3,
+				    surf[i].info.planes[0].stride));
+	}
+	ASSERT_EQ((uint64_t)(uintptr_t)queue, frame.queue_id);
+	ASSERT_STREQ("acquire", frame.type);
+
+	/* not the format of the frame */
+	_ut_surface_layout(&osurf.info, TBM_FORMAT_NV21, 64, 32, 0, out);
+	ASSERT_EQ(0, tbm_surface_internal_dump_stream_read_frame(stream, 0, &osurf));
+	ASSERT_EQ(0, tbm_surface_internal_dump_stream_get_frame(stream, 2, &frame));
+
+	tbm_surface_internal_dump_stream_close(stream);
+
+	/* the writer died in the last frame, no index */
+	ASSERT_EQ(0, truncate(UT_STREAM_FILE, frame.offsets[0] + 100));
+	stream = tbm_surface_internal_dump_stream_open(UT_STREAM_FILE);
+	ASSERT_TRUE(stream != NULL);
+	ASSERT_EQ(1, tbm_surface_internal_dump_stream_get_num_frames(stream));
+	tbm_surface_internal_dump_stream_close(stream);
+
+	unlink(UT_STREAM_FILE);
+}
+
+TEST(tbm_surface_internal_dump_async_start_with_mode, work_flow_success_2)
+{
+	static const char header[] = "YUV4MPEG2 W64 H32 F30:1 Ip A1:1 C420jpeg\nFRAME\n";
+	unsigned char buf[64 * 32 * 2], file[sizeof(header) + 64 * 32 * 3 / 2 + 16];
+	tbm_surface_dump_stats_s stats;
+	struct _tbm_surface surf;
+	FILE *fp;
+	size_t len;
+
+	_init_test();
+
+	ASSERT_EQ(1, tbm_surface_internal_dump_async_start_with_mode(UT_Y4M_FILE, 1,
+								     TBM_SURFACE_DUMP_MODE_Y4M));
+
+	_ut_fill(buf, sizeof(buf), 3);
+	memset(&surf, 0, sizeof(surf));
+	_ut_surface_layout(&surf.info, TBM_FORMAT_NV12, 64, 32, 0, buf);
+	ASSERT_EQ(1, _tbm_surface_internal_dump_async_buffer(&surf, NULL, "enqueue"));
+	_ut_wait_written(1);
+
+	/* another size */
+	_ut_surface_layout(&surf.info, TBM_FORMAT_NV12, 32, 32, 0, buf);
+	ASSERT_EQ(1, _tbm_surface_internal_dump_async_buffer(&surf, NULL, "enqueue"));
+
+	/* not yuv */
+	_ut_surface_layout(&surf.info, TBM_FORMAT_ARGB8888, 64, 32, 0, buf);
+	ASSERT_EQ(1, _tbm_surface_internal_dump_async_buffer(&surf, NULL, "enqueue"));
+
+	/* the size is checked by the writer */
+	do {
+		usleep(1000);
+		tbm_surface_internal_dump_async_get_stats(&stats);
+	} while (stats.written + stats.failed < 3);
+	tbm_surface_internal_dump_async_end();
+
+	ASSERT_EQ(1, stats.written);
+	ASSERT_EQ(2, stats.failed);
+
+	fp = fopen(UT_Y4M_FILE, "rb");
+	ASSERT_TRUE(fp != NULL);
+	len = fread(file, 1, sizeof(file), fp);
+	fclose(fp);
+	unlink(UT_Y4M_FILE);
+
+	ASSERT_EQ(sizeof(header) - 1 + 64 * 32 * 3 / 2, len);
+	ASSERT_EQ(0, memcmp(header, file, sizeof(header) - 1));
+	ASSERT_EQ(0, memcmp(buf, file + sizeof(header) - 1, 64 * 32));
+}
+
+TEST(tbm_surface_internal_dump_async_start_with_mode, work_flow_success_3)
+{
+	unsigned char buf[64 * 32 * 4], out[64 * 32 * 4];
+	struct _tbm_surface surf, osurf;
+	tbm_surface_dump_stream_h stream;
+	tbm_surface_dump_frame_s frame;
+
+	_init_test();
+
+	ASSERT_EQ(1, tbm_surface_internal_dump_async_start_with_mode(UT_STREAM_FILE, 1,
+								     TBM_SURFACE_DUMP_MODE_STREAM));
+	/* written by a device of smaller pages */
+	g_dump_async->align = 64;
+
+	_ut_fill(buf, sizeof(buf), 3);
+	memset(&surf, 0, sizeof(surf));
+	_ut_surface_layout(&surf.info, TBM_FORMAT_NV12, 64, 32, 0, buf);
+
+	ASSERT_EQ(1, _tbm_surface_internal_dump_async_buffer(&surf, NULL, "enqueue"));
+
+	tbm_surface_internal_dump_async_end();
+
+	stream = tbm_surface_internal_dump_stream_open(UT_STREAM_FILE);
+	ASSERT_TRUE(stream != NULL);
+	ASSERT_EQ(1, tbm_surface_internal_dump_stream_get_frame(stream, 0, &frame));
+	ASSERT_NE(0, frame.offsets[0] % sysconf(_SC_PAGESIZE));
+
+	memset(&osurf, 0, sizeof(osurf));
+	_ut_surface_layout(&osurf.info, TBM_FORMAT_NV12, 64, 32, 0, out);
+	ASSERT_EQ(1, tbm_surface_internal_dump_stream_read_frame(stream, 0, &osurf));
+	ASSERT_EQ(0, memcmp(out, buf, osurf.info.size));
+
+	tbm_surface_internal_dump_stream_close(stream);
+
+	unlink(UT_STREAM_FILE);
+}
+
+TEST(tbm_surface_internal_dump_async_start_with_mode, null_ptr_fail_1)
+{
+	_init_test();
+
+	ASSERT_EQ(0, tbm_surface_internal_dump_async_start_with_mode("/tmp", 1,
+								     (tbm_surface_dump_mode_e)-1));
+	ASSERT_EQ(0, tbm_surface_internal_dump_async_start_with_mode("/nonexistent/ut.tbmd", 1,
+								     TBM_SURFACE_DUMP_MODE_STREAM));
+	ASSERT_TRUE(tbm_surface_internal_dump_stream_open("/nonexistent/ut.tbmd") == NULL);
+	ASSERT_TRUE(tbm_surface_internal_dump_stream_open(NULL) == NULL);
+	ASSERT_EQ(0, tbm_surface_internal_dump_stream_get_num_frames(NULL));
+}
+
+/* _tbm_lz4_compress() */
+
+TEST(_tbm_lz4_compress, work_flow_success_2)
+{
+	static const int sizes[] = { 0, 1, 12, 13, 17, 100, 4096, 70000 };
+	static unsigned char src[70000], comp[70000 + 70000 / 255 + 16], out[70000];
+	static uint32_t table[1 << TBM_LZ4_HASH_LOG];
+	unsigned int i, kind;
+	int size, len, j;
+
+	for (kind = 0; kind < 3; kind++) {
+		/* noise, rows which repeat, runs of one byte */
+		_ut_fill(src, sizeof(src), kind);
+		for (j = 0; j < (int)sizeof(src) && kind; j++)
+			src[j] = (kind == 1) ? (j % 777) & 0xfe : (j / 300) & 0xff;
+
+		for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+			size = sizes[i];
+
+			len = _tbm_lz4_compress(src, size, comp, sizeof(comp), table);
+			ASSERT_GT(len, 0);
+			ASSERT_LE(len, _tbm_lz4_compress_bound(size));
+			if (kind && size >= 4096)
+				ASSERT_LT(len, size / 4);
+
+			memset(out, 0xaa, sizeof(out));
+			ASSERT_EQ(1, _tbm_lz4_decompress(comp, len, out, size));
+			ASSERT_EQ(0, memcmp(src, out, size));
+
+			/* another size or a cut stream */
+			if (size) {
+				ASSERT_EQ(0, _tbm_lz4_decompress(comp, len, out, size - 1));
+				ASSERT_EQ(0, _tbm_lz4_decompress(comp, len - 1, out, size));
+			}
+		}
+	}
+}
+
+TEST(_tbm_lz4_compress, work_flow_success_1)
+{
+	unsigned char src[64], comp[64];
+	uint32_t table[1 << TBM_LZ4_HASH_LOG];
+
+	_ut_fill(src, sizeof(src), 1);
+
+	/* less than the bound */
+	ASSERT_EQ(0, _tbm_lz4_compress(src, sizeof(src), comp, sizeof(comp), table));
+}
+
+/* tbm_surface_internal_dump_ring_start() */
+
+TEST(tbm_surface_internal_dump_ring_start, work_flow_success_2)
+{
+	static unsigned char buf[5][64 * 32 * 4];
+	static unsigned char comp[64 * 32 * 4 + 64 * 32 * 4 / 255 + 16];
+	uint32_t table[1 << TBM_LZ4_HASH_LOG];
+	struct _tbm_surface surf;
+	int i, len;
+
+	_init_test();
+
+	/* noise, all the frames compress to the same size */
+	for (i = 0; i < 5; i++) {
+		_ut_fill(buf[i], sizeof(buf[i]), i + 10);
+		buf[i][0] = i;
+	}
+	len = _tbm_lz4_compress(buf[0], sizeof(buf[0]), comp, sizeof(comp), table);
+
+	/* room for three frames */
+	ASSERT_EQ(1, tbm_surface_internal_dump_ring_start("/tmp", len * 3 + len / 2));
+	ASSERT_EQ(0, tbm_surface_internal_dump_ring_start("/tmp", len));
+
+	for (i = 0; i < 5; i++) {
+		memset(&surf, 0, sizeof(surf));
+		_ut_surface_layout(&surf.info, TBM_FORMAT_ARGB8888, 64, 32, 0, buf[i]);
+		ASSERT_EQ(1, _tbm_surface_internal_dump_ring_buffer(&surf, "test"));
+	}
+
+	ASSERT_EQ(3, g_dump_ring->evicted + 1);
+	ASSERT_EQ(0, ut_png_count);
+
+	ASSERT_EQ(1, _tbm_surface_internal_dump_ring_end());
+
+	/* the last three, the oldest first */
+	ASSERT_EQ(3, ut_png_count);
+	ASSERT_EQ(2, ut_png_first[0]);
+	ASSERT_EQ(3, ut_png_first[1]);
+	ASSERT_EQ(4, ut_png_first[2]);
+
+	ASSERT_EQ(0, _tbm_surface_internal_dump_ring_end());
+	ASSERT_EQ(0, _tbm_surface_internal_dump_ring_buffer(&surf, "test"));
+}
+
+TEST(tbm_surface_internal_dump_ring_start, work_flow_success_1)
+{
+	static unsigned char buf[64 * 32 * 4];
+	struct _tbm_surface surf;
+
+	_init_test();
+
+	_ut_fill(buf, sizeof(buf), 1);
+
+	ASSERT_EQ(1, tbm_surface_internal_dump_ring_start("/tmp", 1024));
+
+	/* too big for the ring */
+	memset(&surf, 0, sizeof(surf));
+	_ut_surface_layout(&surf.info, TBM_FORMAT_ARGB8888, 64, 32, 0, buf);
+	ASSERT_EQ(1, _tbm_surface_internal_dump_ring_buffer(&surf, "test"));
+	ASSERT_EQ(1, g_dump_ring->dropped);
+
+	/* not dumped */
+	_ut_surface_layout(&surf.info, UT_TBM_FORMAT_UNKNOWN, 16, 16, 0, buf);
+	ASSERT_EQ(1, _tbm_surface_internal_dump_ring_buffer(&surf, "test"));
+
+	/* small ones */
+	_ut_surface_layout(&surf.info, TBM_FORMAT_NV12, 16, 16, 0, buf);
+	ASSERT_EQ(1, _tbm_surface_internal_dump_ring_buffer(&surf, "test"));
+	ASSERT_EQ(1, _tbm_surface_internal_dump_ring_shm_buffer(buf, 8, 8, 32, "test"));
+
+	/* the frames were put into the ring, one scratch was used for all */
+	ASSERT_EQ(0, g_dump_ring->in_flight);
+	ASSERT_FALSE(LIST_IS_EMPTY(&g_dump_ring->scratch_list));
+	ASSERT_TRUE(g_dump_ring->scratch_list.next->next == &g_dump_ring->scratch_list);
+
+	ASSERT_EQ(1, _tbm_surface_internal_dump_ring_end());
+
+	ASSERT_EQ(1, ut_raw_count);
+	ASSERT_EQ(1, ut_png_count);
+}
+
+TEST(tbm_surface_internal_dump_ring_start, null_ptr_fail_1)
+{
+	_init_test();
+
+	ASSERT_EQ(0, tbm_surface_internal_dump_ring_start(NULL, 1024));
+	ASSERT_EQ(0, tbm_surface_internal_dump_ring_start("/tmp", 0));
+
+	CALLOC_ERROR = 1;
+	ASSERT_EQ(0, tbm_surface_internal_dump_ring_start("/tmp", 1024));
+	CALLOC_ERROR = 0;
+}
+
+/* _tbm_surface_internal_dump_all() */
+
+TEST(_tbm_surface_internal_dump_all, work_flow_success_2)
+{
+	static unsigned char argb[16 * 16 * 4], nv12[16 * 24], rgb[16 * 16 * 2];
+	const tbm_format unknown = 0x20202020;
+	struct _tbm_surface surf[4];
+
+	_init_test();
+
+	memset(argb, 0x5a, sizeof(argb));
+
+	_ut_surface_layout(&surf[0].info, TBM_FORMAT_ARGB8888, 16, 16, 0, argb);
+	_ut_surface_layout(&surf[1].info, TBM_FORMAT_NV12, 16, 16, 0, nv12);
+	_ut_surface_layout(&surf[2].info, unknown, 16, 16, 0, rgb);
+	_ut_surface_layout(&surf[3].info, TBM_FORMAT_XRGB8888, 16, 16, 0, argb);
+	ut_surfaces[0] = &surf[0];
+	ut_surfaces[1] = &surf[1];
+	ut_surfaces[2] = &surf[2];
+	ut_surfaces[3] = &surf[3];
+	ut_num_surfaces = 4;
+
+	ASSERT_EQ(1, _tbm_surface_internal_dump_all("/tmp"));
+
+	/* the unknown one is skipped, all of them are unrefed */
+	ASSERT_EQ(2, ut_png_count);
+	ASSERT_EQ(1, ut_raw_count);
+	ASSERT_EQ(0x5a, ut_png_first[0]);
+	ASSERT_EQ(0x5a, ut_png_first[1]);
+	ASSERT_EQ(4, ut_unref_count);
+}
+
+TEST(_tbm_surface_internal_dump_all, work_flow_success_1)
+{
+	static unsigned char argb[16 * 16 * 4];
+	struct _tbm_surface surf;
+
+	_init_test();
+
+	/* no surface */
+	ASSERT_EQ(0, _tbm_surface_internal_dump_all("/tmp"));
+
+	/* no memory for the copy */
+	_ut_surface_layout(&surf.info, TBM_FORMAT_ARGB8888, 16, 16, 0, argb);
+	ut_surfaces[0] = &surf;
+	ut_num_surfaces = 1;
+
+	CALLOC_ERROR = 1;
+	ASSERT_EQ(1, _tbm_surface_internal_dump_all("/tmp"));
+	CALLOC_ERROR = 0;
+
+	ASSERT_EQ(0, ut_png_count);
+	ASSERT_EQ(1, ut_unref_count);
+}
+
+TEST(_tbm_surface_internal_dump_all, null_ptr_fail_1)
+{
+	_init_test();
+
+	ASSERT_EQ(0, _tbm_surface_internal_dump_all(NULL));
+}
@@ -0,0 +1,324 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics co., Ltd. All Rights Reserved.
+ *
+ * Contact: Konstantin Drabeniuk <k.drabeniuk@samsung.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+**************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "tbm_bufmgr_int.h"
+
+#include "stdlib_stubs.h"
+
+/* HELPER FUNCTIONS */
+static int ut_backend_fill = 0;
+static int ut_plane_is_wc = 0;
+
+static int
+ut__tbm_surface_internal_fill_by_backend(tbm_surface_h surface, tbm_surface_rect_s *rect,
+					 uint32_t color)
+{
+	return ut_backend_fill;
+}
+
+static int
+ut__tbm_surface_internal_plane_is_wc(tbm_surface_h surface, int plane_idx)
+{
+	return ut_plane_is_wc;
+}
+
+#include "tbm_surface_stubs.h"
+
+#define _tbm_surface_internal_fill_by_backend ut__tbm_surface_internal_fill_by_backend
+#define _tbm_surface_internal_plane_is_wc ut__tbm_surface_internal_plane_is_wc
+
+#include "tbm_surface_fill.c"
+
+static void _init_test()
+{
+	UT_TBM_SURFACE_MAP_ERROR = 0;
+	ut_unmap_count = 0;
+	ut_backend_fill = 0;
+	ut_plane_is_wc = 0;
+}
+
+/* every pixel of the rect of the plane is the pixel, the others are 0xaa */
+static int
+_ut_plane_check(tbm_surface_info_s *info, int plane, int cpp, int x, int y, int w, int h,
+		const unsigned char *pixel)
+{
+	int row, col, rows = info->planes[plane].size / info->planes[plane].stride;
+
+	for (row = 0; row < rows; row++) {
+		unsigned char *p = info->planes[plane].ptr + row * info->planes[plane].stride;
+
+		for (col = 0; col < (int)info->planes[plane].stride; col++) {
+			int in = row >= y && row < y + h && col >= x * cpp && col < (x + w) * cpp;
+
+			if (p[col] != (in ? pixel[col % cpp] : 0xaa))
+				return 0;
+		}
+	}
+
+	return 1;
+}
+
+/* tbm_surface_internal_fill() */
+
+TEST(tbm_surface_internal_fill, work_flow_success_7)
+{
+	struct _tbm_surface surface;
+	tbm_surface_rect_s rect = { 2, 1, 4, 2 }, damage = { 0, 0, 1, 1 };
+	unsigned char buf[4096];
+	int ret;
+
+	_init_test();
+
+	/* a surface without damage stays dirty as a whole */
+	_ut_surface_setup(&surface, TBM_FORMAT_ARGB8888, 8, 4, 0, buf);
+	ret = tbm_surface_internal_fill(&surface, &rect, 0);
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(surface.num_damage, 0);
+
+	/* the filled rect is added to the damage */
+	surface.damage[0] = damage;
+	surface.num_damage = 1;
+	ret = tbm_surface_internal_fill(&surface, &rect, 0);
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(surface.num_damage, 2);
+	ASSERT_EQ(memcmp(&surface.damage[1], &rect, sizeof(rect)), 0);
+
+	/* by the backend too */
+	ut_backend_fill = 1;
+	surface.num_damage = 1;
+	ret = tbm_surface_internal_fill(&surface, &rect, 0);
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(surface.num_damage, 2);
+}
+
+TEST(tbm_surface_internal_fill, work_flow_success_6)
+{
+	struct _tbm_surface surface;
+	tbm_surface_rect_s rect = { 1, 0, 4, 4 };
+	unsigned char buf[4096];
+	int ret;
+
+	_init_test();
+
+	/* x of NV12 must be even */
+	_ut_surface_setup(&surface, TBM_FORMAT_NV12, 8, 4, 0, buf);
+	ret = tbm_surface_internal_fill(&surface, &rect, 0);
+	ASSERT_EQ(ret, 0);
+
+	rect.x = 6;
+	ret = tbm_surface_internal_fill(&surface, &rect, 0);
+	ASSERT_EQ(ret, 0);
+
+	_ut_surface_setup(&surface, TBM_FORMAT_NV12MT, 8, 4, 0, buf);
+	ret = tbm_surface_internal_fill(&surface, NULL, 0);
+	ASSERT_EQ(ret, 0);
+
+	_ut_surface_setup(&surface, TBM_FORMAT_ARGB8888, 8, 4, 0, buf);
+	UT_TBM_SURFACE_MAP_ERROR = 1;
+	ret = tbm_surface_internal_fill(&surface, NULL, 0);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(ut_unmap_count, 0);
+}
+
+TEST(tbm_surface_internal_fill, work_flow_success_5)
+{
+	struct _tbm_surface surface;
+	unsigned char buf[4096];
+	int ret;
+
+	_init_test();
+
+	/* the backend fills, the surface isn't mapped */
+	_ut_surface_setup(&surface, TBM_FORMAT_ARGB8888, 8, 4, 0, buf);
+	memset(buf, 0xaa, sizeof(buf));
+	ut_backend_fill = 1;
+
+	ret = tbm_surface_internal_fill(&surface, NULL, 0xff000000);
+
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(buf[0], 0xaa);
+	ASSERT_EQ(ut_unmap_count, 0);
+}
+
+TEST(tbm_surface_internal_fill, work_flow_success_4)
+{
+	static unsigned char buf[1000 * 1000 * 4 + 4096];
+	static const unsigned char pixel[4] = { 0x33, 0x22, 0x11, 0x80 };
+	struct _tbm_surface surface;
+	int ret;
+
+	_init_test();
+
+	/* big enough to be split among the workers and streamed, the rows
+	 * not aligned to the vectors
+	 */
+	_ut_surface_setup(&surface, TBM_FORMAT_ARGB8888, 999, 1000, 0, buf + 3);
+	memset(buf, 0xaa, sizeof(buf));
+
+	ret = tbm_surface_internal_fill(&surface, NULL, 0x80112233);
+
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(_ut_plane_check(&surface.info, 0, 4, 0, 0, 999, 1000, pixel), 1);
+	ASSERT_EQ(buf[2], 0xaa);
+	ASSERT_EQ(buf[3 + surface.info.size], 0xaa);
+}
+
+TEST(tbm_surface_internal_fill, work_flow_success_3)
+{
+	struct _tbm_surface surface;
+	static const unsigned char yuyv[4] = { 16, 128, 16, 128 };
+	static const unsigned char rgb888[3] = { 0x03, 0x02, 0x01 };
+	static const unsigned char rgb565[2] = { 0x1f, 0xf8 };
+	unsigned char buf[16384];
+	tbm_surface_rect_s rect = { 2, 1, 60, 3 };
+	int ret;
+
+	_init_test();
+
+	_ut_surface_setup(&surface, TBM_FORMAT_YUYV, 64, 4, 6, buf);
+	memset(buf, 0xaa, sizeof(buf));
+	ret = tbm_surface_internal_fill(&surface, &rect, 0xff000000);
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(_ut_plane_check(&surface.info, 0, 4, 1, 1, 30, 3, yuyv), 1);
+
+	/* the pattern of 3 bytes goes on across the vectors */
+	_ut_surface_setup(&surface, TBM_FORMAT_RGB888, 100, 4, 1, buf);
+	memset(buf, 0xaa, sizeof(buf));
+	ret = tbm_surface_internal_fill(&surface, &rect, 0xff010203);
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(_ut_plane_check(&surface.info, 0, 3, 2, 1, 60, 3, rgb888), 1);
+
+	_ut_surface_setup(&surface, TBM_FORMAT_RGB565, 64, 4, 0, buf);
+	memset(buf, 0xaa, sizeof(buf));
+	ret = tbm_surface_internal_fill(&surface, &rect, 0xffff00ff);
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(_ut_plane_check(&surface.info, 0, 2, 2, 1, 60, 3, rgb565), 1);
+}
+
+TEST(tbm_surface_internal_fill, work_flow_success_2)
+{
+	struct _tbm_surface surface;
+	/* BT.601 limited white */
+	static const unsigned char y[1] = { 235 }, u[1] = { 128 }, v[1] = { 128 };
+	unsigned char buf[16384];
+	tbm_surface_rect_s rect = { 4, 2, 70, 6 };
+	int ret;
+
+	_init_test();
+
+	_ut_surface_setup(&surface, TBM_FORMAT_YVU420, 80, 10, 3, buf);
+	memset(buf, 0xaa, sizeof(buf));
+
+	ret = tbm_surface_internal_fill(&surface, &rect, 0xffffffff);
+
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(_ut_plane_check(&surface.info, 0, 1, 4, 2, 70, 6, y), 1);
+	ASSERT_EQ(_ut_plane_check(&surface.info, 1, 1, 2, 1, 35, 3, v), 1);
+	ASSERT_EQ(_ut_plane_check(&surface.info, 2, 1, 2, 1, 35, 3, u), 1);
+	ASSERT_EQ(ut_unmap_count, 1);
+}
+
+TEST(tbm_surface_internal_fill, work_flow_success_1)
+{
+	struct _tbm_surface surface;
+	/* BT.601 limited red */
+	static const unsigned char y[1] = { 82 }, uv[2] = { 90, 240 };
+	unsigned char buf[16384];
+	int ret;
+
+	_init_test();
+
+	_ut_surface_setup(&surface, TBM_FORMAT_NV12, 100, 20, 0, buf);
+	memset(buf, 0xaa, sizeof(buf));
+	ut_plane_is_wc = 1;
+
+	ret = tbm_surface_internal_fill(&surface, NULL, 0xffff0000);
+
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(_ut_plane_check(&surface.info, 0, 1, 0, 0, 100, 20, y), 1);
+	ASSERT_EQ(_ut_plane_check(&surface.info, 1, 2, 0, 0, 50, 10, uv), 1);
+}
+
+TEST(tbm_surface_internal_fill, null_ptr_fail_1)
+{
+	int ret;
+
+	_init_test();
+
+	ret = tbm_surface_internal_fill(NULL, NULL, 0);
+	ASSERT_EQ(ret, 0);
+}
+
+/* simd kernels */
+
+TEST(tbm_surface_fill_kernels, work_flow_success_1)
+{
+	static const tbm_fill_row_func funcs[] = {
+		_tbm_fill_row_c,
+#ifdef TBM_SIMD_SSE2
+		_tbm_fill_row_sse2,
+#endif
+#ifdef TBM_SIMD_AVX2
+		_tbm_fill_row_avx2,
+#endif
+#ifdef TBM_SIMD_NEON
+		_tbm_fill_row_neon,
+#endif
+	};
+	unsigned int features = _tbm_cpu_get_features();
+	unsigned char pattern[TBM_FILL_PERIOD * 4], ref[600], out[600];
+	unsigned int f;
+	int i, offset, size, stream;
+
+	_init_test();
+
+	for (i = 0; i < (int)sizeof(pattern); i++)
+		pattern[i] = (i % 3) * 50 + 1;
+
+	for (f = 0; f < sizeof(funcs) / sizeof(funcs[0]); f++) {
+#ifdef TBM_SIMD_AVX2
+		if (funcs[f] == _tbm_fill_row_avx2 && !(features & TBM_CPU_AVX2))
+			continue;
+#endif
+		for (offset = 0; offset < 40; offset += 3) {
+			for (size = 0; size < 500; size += 7) {
+				for (stream = 0; stream < 2; stream++) {
+					memset(out, 0, sizeof(out));
+					memset(ref, 0, sizeof(ref));
+					for (i = 0; i < size; i++)
+						ref[offset + i] = pattern[i % 3];
+
+					funcs[f](out + offset, pattern, size, stream);
+					ASSERT_EQ(memcmp(ref, out, sizeof(out)), 0);
+				}
+			}
+		}
+	}
+}
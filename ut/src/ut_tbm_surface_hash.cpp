@@ -0,0 +1,396 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics co., Ltd. All Rights Reserved.
+ *
+ * Contact: Konstantin Drabeniuk <k.drabeniuk@samsung.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+**************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "tbm_bufmgr_int.h"
+
+#include "stdlib_stubs.h"
+
+/* HELPER FUNCTIONS */
+static int UT_TBM_SURFACE_USER_DATA_ERROR = 0;
+/* the user data of the one surface of a test */
+static void *ut_user_data = NULL;
+static int ut_user_data_added = 0;
+
+static int
+ut_tbm_surface_internal_add_user_data(tbm_surface_h surface, unsigned long key,
+				      tbm_data_free data_free_func)
+{
+	if (UT_TBM_SURFACE_USER_DATA_ERROR)
+		return 0;
+
+	ut_user_data_added = 1;
+
+	return 1;
+}
+
+static int
+ut_tbm_surface_internal_set_user_data(tbm_surface_h surface, unsigned long key, void *data)
+{
+	free(ut_user_data);
+	ut_user_data = data;
+
+	return 1;
+}
+
+static int
+ut_tbm_surface_internal_get_user_data(tbm_surface_h surface, unsigned long key, void **data)
+{
+	if (!ut_user_data_added)
+		return 0;
+
+	*data = ut_user_data;
+
+	return 1;
+}
+
+#include "tbm_surface_stubs.h"
+
+#define tbm_surface_internal_add_user_data ut_tbm_surface_internal_add_user_data
+#define tbm_surface_internal_set_user_data ut_tbm_surface_internal_set_user_data
+#define tbm_surface_internal_get_user_data ut_tbm_surface_internal_get_user_data
+
+#include "tbm_surface_hash.c"
+
+static void _init_test()
+{
+	UT_TBM_SURFACE_MAP_ERROR = 0;
+	UT_TBM_SURFACE_USER_DATA_ERROR = 0;
+	ut_unmap_count = 0;
+	free(ut_user_data);
+	ut_user_data = NULL;
+	ut_user_data_added = 0;
+}
+
+/* the visible bytes of the planes of src into dst */
+static void
+_ut_copy_visible(struct _tbm_surface *dst, struct _tbm_surface *src)
+{
+	const tbm_format_desc_s *desc = tbm_format_get_desc(src->info.format);
+	int i, row;
+
+	for (i = 0; i < desc->num_planes; i++) {
+		int hsub = i ? desc->hsub : 1, vsub = i ? desc->vsub : 1;
+		int bytes = (src->info.width + hsub - 1) / hsub * desc->cpp[i];
+		int rows = (src->info.height + vsub - 1) / vsub;
+
+		for (row = 0; row < rows; row++)
+			memcpy(dst->info.planes[i].ptr + row * dst->info.planes[i].stride,
+			       src->info.planes[i].ptr + row * src->info.planes[i].stride, bytes);
+	}
+}
+
+/* tbm_surface_internal_hash() */
+
+TEST(tbm_surface_internal_hash, work_flow_success_4)
+{
+	struct _tbm_surface surface;
+	tbm_surface_rect_s rect = { 1, 0, 4, 4 };
+	unsigned char buf[4096];
+	uint64_t hash;
+	int ret;
+
+	_init_test();
+
+	/* x of NV12 must be even */
+	_ut_surface_setup(&surface, TBM_FORMAT_NV12, 8, 4, 0, buf);
+	ret = tbm_surface_internal_hash(&surface, &rect, &hash);
+	ASSERT_EQ(ret, 0);
+
+	rect.x = 6;
+	ret = tbm_surface_internal_hash(&surface, &rect, &hash);
+	ASSERT_EQ(ret, 0);
+
+	_ut_surface_setup(&surface, TBM_FORMAT_NV12MT, 8, 4, 0, buf);
+	ret = tbm_surface_internal_hash(&surface, NULL, &hash);
+	ASSERT_EQ(ret, 0);
+
+	_ut_surface_setup(&surface, TBM_FORMAT_ARGB8888, 8, 4, 0, buf);
+	UT_TBM_SURFACE_MAP_ERROR = 1;
+	ret = tbm_surface_internal_hash(&surface, NULL, &hash);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(ut_unmap_count, 0);
+}
+
+TEST(tbm_surface_internal_hash, work_flow_success_3)
+{
+	static unsigned char buf1[8192], buf2[8192];
+	struct _tbm_surface s1, s2;
+	tbm_surface_rect_s rect = { 4, 2, 20, 10 };
+	uint64_t h1, h2;
+	int ret;
+
+	_init_test();
+
+	/* the same area in different surfaces */
+	_ut_surface_setup(&s1, TBM_FORMAT_YUV420, 40, 20, 0, buf1);
+	_ut_surface_setup(&s2, TBM_FORMAT_YUV420, 40, 20, 0, buf2);
+	_ut_fill(buf1, sizeof(buf1), 1);
+	_ut_fill(buf2, sizeof(buf2), 2);
+	_ut_copy_visible(&s2, &s1);
+	/* out of the rect */
+	buf2[0] ^= 1;
+	s2.info.planes[2].ptr[s2.info.planes[2].stride * 9] ^= 1;
+
+	ret = tbm_surface_internal_hash(&s1, &rect, &h1);
+	ASSERT_EQ(ret, 1);
+	ret = tbm_surface_internal_hash(&s2, &rect, &h2);
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(h1, h2);
+
+	/* in the rect of a chroma plane */
+	s2.info.planes[1].ptr[s2.info.planes[1].stride * 3 + 5] ^= 1;
+	ret = tbm_surface_internal_hash(&s2, &rect, &h2);
+	ASSERT_EQ(ret, 1);
+	ASSERT_NE(h1, h2);
+}
+
+TEST(tbm_surface_internal_hash, work_flow_success_2)
+{
+	static unsigned char buf1[1920 * 100 * 4], buf2[1920 * 100 * 4];
+	struct _tbm_surface s1, s2;
+	uint64_t h1, h2;
+	int ret;
+
+	_init_test();
+
+	/* the stride padding isn't hashed */
+	_ut_surface_setup(&s1, TBM_FORMAT_ARGB8888, 1003, 97, 0, buf1);
+	_ut_surface_setup(&s2, TBM_FORMAT_ARGB8888, 1003, 97, 84, buf2);
+	_ut_fill(buf1, sizeof(buf1), 3);
+	_ut_fill(buf2, sizeof(buf2), 4);
+	_ut_copy_visible(&s2, &s1);
+
+	ret = tbm_surface_internal_hash(&s1, NULL, &h1);
+	ASSERT_EQ(ret, 1);
+	ret = tbm_surface_internal_hash(&s2, NULL, &h2);
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(h1, h2);
+	ASSERT_EQ(ut_unmap_count, 2);
+
+	/* but every visible byte is */
+	s2.info.planes[0].ptr[s2.info.planes[0].stride * 50 + 1003 * 4 - 1] ^= 0x80;
+	ret = tbm_surface_internal_hash(&s2, NULL, &h2);
+	ASSERT_EQ(ret, 1);
+	ASSERT_NE(h1, h2);
+}
+
+TEST(tbm_surface_internal_hash, work_flow_success_1)
+{
+	static unsigned char buf[4096];
+	struct _tbm_surface surface;
+	uint64_t h1, h2;
+	int ret;
+
+	_init_test();
+
+	/* the same bytes of another size */
+	_ut_surface_setup(&surface, TBM_FORMAT_RGB565, 16, 8, 0, buf);
+	_ut_fill(buf, sizeof(buf), 5);
+	ret = tbm_surface_internal_hash(&surface, NULL, &h1);
+	ASSERT_EQ(ret, 1);
+
+	_ut_surface_setup(&surface, TBM_FORMAT_RGB565, 8, 16, 0, buf);
+	ret = tbm_surface_internal_hash(&surface, NULL, &h2);
+	ASSERT_EQ(ret, 1);
+	ASSERT_NE(h1, h2);
+}
+
+TEST(tbm_surface_internal_hash, null_ptr_fail_1)
+{
+	struct _tbm_surface surface;
+	uint64_t hash;
+	int ret;
+
+	_init_test();
+
+	ret = tbm_surface_internal_hash(NULL, NULL, &hash);
+	ASSERT_EQ(ret, 0);
+
+	ret = tbm_surface_internal_hash(&surface, NULL, NULL);
+	ASSERT_EQ(ret, 0);
+}
+
+/* tbm_surface_internal_hash_incremental() */
+
+TEST(tbm_surface_internal_hash_incremental, work_flow_success_3)
+{
+	struct _tbm_surface surface;
+	unsigned char buf[4096];
+	uint64_t hash;
+	int ret;
+
+	_init_test();
+
+	_ut_surface_setup(&surface, TBM_FORMAT_ARGB8888, 8, 4, 0, buf);
+	UT_TBM_SURFACE_USER_DATA_ERROR = 1;
+	ret = tbm_surface_internal_hash_incremental(&surface, &hash);
+	ASSERT_EQ(ret, 0);
+
+	_init_test();
+	UT_TBM_SURFACE_MAP_ERROR = 1;
+	ret = tbm_surface_internal_hash_incremental(&surface, &hash);
+	ASSERT_EQ(ret, 0);
+
+	_init_test();
+	CALLOC_ERROR = 1;
+	ret = tbm_surface_internal_hash_incremental(&surface, &hash);
+	CALLOC_ERROR = 0;
+	ASSERT_EQ(ret, 0);
+}
+
+TEST(tbm_surface_internal_hash_incremental, work_flow_success_2)
+{
+	static unsigned char buf[1920 * 1080 * 4];
+	struct _tbm_surface surface;
+	uint64_t h1, h2, h3;
+	int ret;
+
+	_init_test();
+
+	/* only the damaged tiles are hashed again */
+	_ut_surface_setup(&surface, TBM_FORMAT_ARGB8888, 1000, 1000, 16, buf);
+	_ut_fill(buf, sizeof(buf), 6);
+
+	ret = tbm_surface_internal_hash_incremental(&surface, &h1);
+	ASSERT_EQ(ret, 1);
+
+	buf[surface.info.planes[0].stride * 500 + 500 * 4] ^= 1;
+	surface.damage[0].x = 0;
+	surface.damage[0].y = 0;
+	surface.damage[0].width = 10;
+	surface.damage[0].height = 10;
+	surface.num_damage = 1;
+
+	/* the changed tile isn't damaged */
+	ret = tbm_surface_internal_hash_incremental(&surface, &h2);
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(h1, h2);
+
+	surface.damage[0].x = 499;
+	surface.damage[0].y = 450;
+	surface.damage[0].width = 2;
+	surface.damage[0].height = 100;
+	ret = tbm_surface_internal_hash_incremental(&surface, &h2);
+	ASSERT_EQ(ret, 1);
+	ASSERT_NE(h1, h2);
+
+	/* the same as hashing the whole surface */
+	surface.num_damage = 0;
+	ret = tbm_surface_internal_hash_incremental(&surface, &h3);
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(h2, h3);
+}
+
+TEST(tbm_surface_internal_hash_incremental, work_flow_success_1)
+{
+	static unsigned char buf[8192];
+	struct _tbm_surface surface;
+	uint64_t h1, h2;
+	int ret;
+
+	_init_test();
+
+	_ut_surface_setup(&surface, TBM_FORMAT_NV12, 70, 66, 2, buf);
+	_ut_fill(buf, sizeof(buf), 7);
+
+	ret = tbm_surface_internal_hash_incremental(&surface, &h1);
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(ut_unmap_count, 1);
+
+	/* the tiles are made again for a new size */
+	_ut_surface_setup(&surface, TBM_FORMAT_NV12, 66, 70, 2, buf);
+	ret = tbm_surface_internal_hash_incremental(&surface, &h2);
+	ASSERT_EQ(ret, 1);
+	ASSERT_NE(h1, h2);
+	ASSERT_EQ(((tbm_hash_tiles *)ut_user_data)->tiles_x, 2);
+}
+
+TEST(tbm_surface_internal_hash_incremental, null_ptr_fail_1)
+{
+	struct _tbm_surface surface;
+	uint64_t hash;
+	int ret;
+
+	_init_test();
+
+	ret = tbm_surface_internal_hash_incremental(NULL, &hash);
+	ASSERT_EQ(ret, 0);
+
+	ret = tbm_surface_internal_hash_incremental(&surface, NULL);
+	ASSERT_EQ(ret, 0);
+}
+
+/* simd kernels */
+
+TEST(tbm_surface_hash_kernels, work_flow_success_1)
+{
+	static const tbm_hash_kernels *kernels[] = {
+#ifdef TBM_SIMD_SSE2
+		&hash_kernels_sse2,
+#endif
+#ifdef TBM_SIMD_AVX2
+		&hash_kernels_avx2,
+#endif
+#ifdef TBM_SIMD_NEON
+		&hash_kernels_neon,
+#endif
+		NULL,
+	};
+	unsigned int features = _tbm_cpu_get_features();
+	unsigned char data[TBM_HASH_STRIPE * TBM_HASH_BLOCK];
+	uint64_t ref[TBM_HASH_LANES], out[TBM_HASH_LANES];
+	unsigned int k;
+	int n, key;
+
+	_init_test();
+
+	_ut_fill(data, sizeof(data), 8);
+
+	for (k = 0; kernels[k]; k++) {
+#ifdef TBM_SIMD_AVX2
+		if (kernels[k] == &hash_kernels_avx2 && !(features & TBM_CPU_AVX2))
+			continue;
+#endif
+		for (n = 1; n <= TBM_HASH_BLOCK; n++) {
+			for (key = 0; key + n <= TBM_HASH_BLOCK; key += 5) {
+				_ut_fill((unsigned char *)ref, sizeof(ref), n * 31 + key);
+				memcpy(out, ref, sizeof(out));
+
+				_tbm_hash_accumulate_c(ref, data, hash_secret + key, n);
+				kernels[k]->accumulate(out, data, hash_secret + key, n);
+				ASSERT_EQ(memcmp(ref, out, sizeof(out)), 0);
+
+				_tbm_hash_scramble_c(ref, hash_secret + TBM_HASH_BLOCK);
+				kernels[k]->scramble(out, hash_secret + TBM_HASH_BLOCK);
+				ASSERT_EQ(memcmp(ref, out, sizeof(out)), 0);
+			}
+		}
+	}
+}
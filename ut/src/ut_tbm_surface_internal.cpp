@@ -28,6 +28,8 @@
 
 #include "gtest/gtest.h"
 
+#include <sys/stat.h>
+
 #include "tbm_bufmgr_int.h"
 
 #include "pthread_stubs.h"
@@ -49,12 +51,56 @@ static tbm_bufmgr ut_tbm_bufmgr_init(int fd)
 
 static void ut_tbm_bufmgr_deinit(tbm_bufmgr bufmgr) {}
 
+static int ut_surface_supported_format_count = 0;
+
+/* a format of the backend only, without a desc */
+#define UT_TBM_FORMAT_BACKEND	0x31545542
+
 static int ut_surface_supported_format(uint32_t **formats, uint32_t *num)
 {
+	ut_surface_supported_format_count++;
+
 	if (UT_TBM_SURFACE_INTERNAL_ERROR) {
 		return 0;
 	}
 
+	*formats = (uint32_t *)calloc(3, sizeof(uint32_t));
+	(*formats)[0] = TBM_FORMAT_ARGB8888;
+	(*formats)[1] = TBM_FORMAT_NV12;
+	(*formats)[2] = UT_TBM_FORMAT_BACKEND;
+	*num = 3;
+
+	return 1;
+}
+
+/* the number of the mutexes held, the backend hooks are called with none */
+static int ut_mutex_held = 0;
+
+static int ut_mutex_lock(pthread_mutex_t *mutex)
+{
+	ut_mutex_held++;
+
+	return 0;
+}
+
+static int ut_mutex_unlock(pthread_mutex_t *mutex)
+{
+	ut_mutex_held--;
+
+	return 0;
+}
+
+static int ut_surface_fill_x;
+static uint32_t ut_surface_fill_color;
+static int ut_surface_fill_mutex_held;
+
+static int ut_surface_fill(tbm_surface_h surface, int x, int y, int width, int height,
+			   uint32_t color)
+{
+	ut_surface_fill_x = x;
+	ut_surface_fill_color = color;
+	ut_surface_fill_mutex_held = ut_mutex_held;
+
 	return 1;
 }
 
@@ -69,13 +115,47 @@ static int ut_tbm_bo_unmap(tbm_bo bo)
 	ut_tbm_bo_unmap_count++;
 }
 
+static int ut__tbm_bo_map_multi(tbm_bo *bos, int num, int device, int opt,
+				 tbm_bo_handle *bo_handles)
+{
+	return 1;
+}
+
+static int ut__tbm_bo_unmap_multi(tbm_bo *bos, int num)
+{
+	ut_tbm_bo_unmap_count += num;
+
+	return 1;
+}
+
 static void ut_tbm_data_free(void *user_data)
 {
 	ut_tbm_data_free_called = 1;
 }
 
-#define pthread_mutex_lock ut_pthread_mutex_lock
-#define pthread_mutex_unlock ut_pthread_mutex_unlock
+static int ut_tbm_bo_refcnt = 0;
+
+static tbm_bo ut_tbm_bo_ref(tbm_bo bo)
+{
+	ut_tbm_bo_refcnt++;
+
+	return bo;
+}
+
+static void ut_tbm_bo_unref(tbm_bo bo)
+{
+	ut_tbm_bo_refcnt--;
+}
+
+static int ut__tbm_bo_set_surface(tbm_bo bo, tbm_surface_h surface)
+{
+	bo->surface = surface;
+
+	return 1;
+}
+
+#define pthread_mutex_lock ut_mutex_lock
+#define pthread_mutex_unlock ut_mutex_unlock
 #define pthread_mutex_init ut_pthread_mutex_init
 #define calloc ut_calloc
 #define free ut_free
@@ -83,6 +163,11 @@ static void ut_tbm_data_free(void *user_data)
 #define tbm_bufmgr_deinit ut_tbm_bufmgr_deinit
 #define tbm_bo_get_handle ut_tbm_bo_get_handle
 #define tbm_bo_unmap ut_tbm_bo_unmap
+#define _tbm_bo_map_multi ut__tbm_bo_map_multi
+#define _tbm_bo_unmap_multi ut__tbm_bo_unmap_multi
+#define tbm_bo_ref ut_tbm_bo_ref
+#define tbm_bo_unref ut_tbm_bo_unref
+#define _tbm_bo_set_surface ut__tbm_bo_set_surface
 
 #include "tbm_surface_internal.c"
 
@@ -100,6 +185,9 @@ static void _init_test()
 	UT_TBM_SURFACE_INTERNAL_ERROR = 0;
 	ut_tbm_bo_unmap_count = 0;
 	ut_tbm_data_free_called = 0;
+	ut_surface_supported_format_count = 0;
+	ut_mutex_held = 0;
+	memset(g_surface_geometry, 0, sizeof(g_surface_geometry));
 }
 
 /* tbm_surface_internal_delete_user_data() */
@@ -590,6 +678,262 @@ TEST(tbm_surface_internal_set_debug_pid, work_flow_success_1)
 	ASSERT_EQ(pid, surface.debug_pid);
 }
 
+/* _tbm_surface_internal_fill_by_backend() */
+
+TEST(_tbm_surface_internal_fill_by_backend, work_flow_success_2)
+{
+	int actual = 0;
+	struct _tbm_surface surface;
+	struct _tbm_bufmgr bufmgr;
+	struct _tbm_bufmgr_backend backend;
+	tbm_surface_rect_s rect = { 2, 4, 8, 8 };
+
+	_init_test();
+
+	memset(&backend, 0, sizeof(backend));
+	backend.surface_fill = ut_surface_fill;
+	bufmgr.backend = &backend;
+	surface.bufmgr = &bufmgr;
+	g_surface_bufmgr = &bufmgr;
+	LIST_INITHEAD(&bufmgr.surf_list);
+	LIST_ADD(&surface.item_link, &bufmgr.surf_list);
+
+	ut_surface_fill_mutex_held = -1;
+
+	actual = _tbm_surface_internal_fill_by_backend(&surface, &rect, 0xff000000);
+
+	ASSERT_EQ(actual, 1);
+	ASSERT_EQ(ut_surface_fill_x, 2);
+	ASSERT_EQ(ut_surface_fill_color, 0xff000000);
+
+	/* the hook may call back into libtbm */
+	ASSERT_EQ(ut_surface_fill_mutex_held, 0);
+}
+
+TEST(_tbm_surface_internal_fill_by_backend, work_flow_success_1)
+{
+	int actual = 1;
+	struct _tbm_surface surface;
+	struct _tbm_bufmgr bufmgr;
+	struct _tbm_bufmgr_backend backend;
+	tbm_surface_rect_s rect = { 0, 0, 8, 8 };
+
+	_init_test();
+
+	/* no hook, the cpu fills */
+	memset(&backend, 0, sizeof(backend));
+	bufmgr.backend = &backend;
+	surface.bufmgr = &bufmgr;
+	g_surface_bufmgr = &bufmgr;
+	LIST_INITHEAD(&bufmgr.surf_list);
+	LIST_ADD(&surface.item_link, &bufmgr.surf_list);
+
+	actual = _tbm_surface_internal_fill_by_backend(&surface, &rect, 0);
+
+	ASSERT_EQ(actual, 0);
+}
+
+TEST(_tbm_surface_internal_fill_by_backend, null_ptr_fail_1)
+{
+	int actual = 1;
+	struct _tbm_surface surface;
+	struct _tbm_bufmgr bufmgr;
+	tbm_surface_rect_s rect = { 0, 0, 8, 8 };
+
+	_init_test();
+
+	g_surface_bufmgr = &bufmgr;
+	LIST_INITHEAD(&bufmgr.surf_list);
+
+	actual = _tbm_surface_internal_fill_by_backend(&surface, &rect, 0);
+
+	ASSERT_EQ(actual, 0);
+}
+
+/* tbm_surface_internal_add_damage() */
+
+TEST(tbm_surface_internal_add_damage, work_flow_success_3)
+{
+	int actual = 0, i;
+	struct _tbm_surface surface;
+	struct _tbm_bufmgr bufmgr;
+	tbm_surface_rect_s rect;
+
+	_init_test();
+
+	memset(&surface, 0, sizeof(surface));
+	surface.info.width = 1000;
+	surface.info.height = 1000;
+	g_surface_bufmgr = &bufmgr;
+	LIST_INITHEAD(&bufmgr.surf_list);
+	LIST_ADD(&surface.item_link, &bufmgr.surf_list);
+
+	/* the overflowing rects are merged, the region stays bounded */
+	for (i = 0; i < TBM_SURFACE_DAMAGE_MAX + 4; i++) {
+		rect.x = i * 50;
+		rect.y = i * 50;
+		rect.width = 10;
+		rect.height = 10;
+		actual = tbm_surface_internal_add_damage(&surface, &rect);
+		ASSERT_EQ(actual, 1);
+	}
+
+	ASSERT_EQ(surface.num_damage, TBM_SURFACE_DAMAGE_MAX);
+
+	/* a rect covering all of them replaces them */
+	rect.x = 0;
+	rect.y = 0;
+	rect.width = 700;
+	rect.height = 700;
+	actual = tbm_surface_internal_add_damage(&surface, &rect);
+	ASSERT_EQ(actual, 1);
+	ASSERT_EQ(surface.num_damage, 1);
+}
+
+TEST(tbm_surface_internal_add_damage, work_flow_success_2)
+{
+	int actual = 0;
+	struct _tbm_surface surface;
+	struct _tbm_bufmgr bufmgr;
+	tbm_surface_rect_s rect = { -10, 90, 50, 50 };
+
+	_init_test();
+
+	memset(&surface, 0, sizeof(surface));
+	surface.info.width = 100;
+	surface.info.height = 100;
+	g_surface_bufmgr = &bufmgr;
+	LIST_INITHEAD(&bufmgr.surf_list);
+	LIST_ADD(&surface.item_link, &bufmgr.surf_list);
+
+	/* clipped to the surface */
+	actual = tbm_surface_internal_add_damage(&surface, &rect);
+
+	ASSERT_EQ(actual, 1);
+	ASSERT_EQ(surface.num_damage, 1);
+	ASSERT_EQ(surface.damage[0].x, 0);
+	ASSERT_EQ(surface.damage[0].y, 90);
+	ASSERT_EQ(surface.damage[0].width, 40);
+	ASSERT_EQ(surface.damage[0].height, 10);
+
+	/* out of the surface */
+	rect.x = 100;
+	actual = tbm_surface_internal_add_damage(&surface, &rect);
+	ASSERT_EQ(actual, 1);
+	ASSERT_EQ(surface.num_damage, 1);
+
+	/* inside the damage already */
+	rect.x = 5;
+	rect.y = 92;
+	rect.width = 5;
+	rect.height = 5;
+	actual = tbm_surface_internal_add_damage(&surface, &rect);
+	ASSERT_EQ(actual, 1);
+	ASSERT_EQ(surface.num_damage, 1);
+}
+
+TEST(tbm_surface_internal_add_damage, work_flow_success_1)
+{
+	int actual = 0;
+	struct _tbm_surface surface;
+	struct _tbm_bufmgr bufmgr;
+	tbm_surface_rect_s bounds;
+
+	_init_test();
+
+	memset(&surface, 0, sizeof(surface));
+	surface.info.width = 100;
+	surface.info.height = 50;
+	g_surface_bufmgr = &bufmgr;
+	LIST_INITHEAD(&bufmgr.surf_list);
+	LIST_ADD(&surface.item_link, &bufmgr.surf_list);
+
+	actual = _tbm_surface_internal_get_damage_bounds(&surface, &bounds);
+	ASSERT_EQ(actual, 0);
+
+	actual = tbm_surface_internal_add_damage(&surface, NULL);
+
+	ASSERT_EQ(actual, 1);
+	actual = _tbm_surface_internal_get_damage_bounds(&surface, &bounds);
+	ASSERT_EQ(actual, 1);
+	ASSERT_EQ(bounds.width, 100);
+	ASSERT_EQ(bounds.height, 50);
+}
+
+TEST(tbm_surface_internal_add_damage, null_ptr_fail_1)
+{
+	int actual = 1;
+	struct _tbm_surface surface;
+	struct _tbm_bufmgr bufmgr;
+
+	_init_test();
+
+	g_surface_bufmgr = &bufmgr;
+	LIST_INITHEAD(&bufmgr.surf_list);
+
+	actual = tbm_surface_internal_add_damage(&surface, NULL);
+
+	ASSERT_EQ(actual, 0);
+}
+
+/* tbm_surface_internal_get_damage() */
+
+TEST(tbm_surface_internal_get_damage, work_flow_success_1)
+{
+	int actual = 0, num = 0;
+	struct _tbm_surface surface;
+	struct _tbm_bufmgr bufmgr;
+	tbm_surface_rect_s rects[TBM_SURFACE_DAMAGE_MAX];
+	tbm_surface_rect_s rect1 = { 0, 0, 10, 10 }, rect2 = { 20, 20, 10, 10 };
+
+	_init_test();
+
+	memset(&surface, 0, sizeof(surface));
+	surface.info.width = 100;
+	surface.info.height = 100;
+	g_surface_bufmgr = &bufmgr;
+	LIST_INITHEAD(&bufmgr.surf_list);
+	LIST_ADD(&surface.item_link, &bufmgr.surf_list);
+
+	tbm_surface_internal_add_damage(&surface, &rect1);
+	tbm_surface_internal_add_damage(&surface, &rect2);
+
+	actual = tbm_surface_internal_get_damage(&surface, rects, &num);
+
+	ASSERT_EQ(actual, 1);
+	ASSERT_EQ(num, 2);
+	ASSERT_EQ(rects[1].x, 20);
+
+	actual = tbm_surface_internal_clear_damage(&surface);
+	ASSERT_EQ(actual, 1);
+	actual = tbm_surface_internal_get_damage(&surface, NULL, &num);
+	ASSERT_EQ(actual, 1);
+	ASSERT_EQ(num, 0);
+}
+
+TEST(tbm_surface_internal_get_damage, null_ptr_fail_1)
+{
+	int actual = 1, num;
+	struct _tbm_surface surface;
+	struct _tbm_bufmgr bufmgr;
+
+	_init_test();
+
+	g_surface_bufmgr = &bufmgr;
+	LIST_INITHEAD(&bufmgr.surf_list);
+	LIST_ADD(&surface.item_link, &bufmgr.surf_list);
+
+	actual = tbm_surface_internal_get_damage(&surface, NULL, NULL);
+	ASSERT_EQ(actual, 0);
+
+	actual = tbm_surface_internal_clear_damage(NULL);
+	ASSERT_EQ(actual, 0);
+
+	LIST_INITHEAD(&bufmgr.surf_list);
+	actual = tbm_surface_internal_get_damage(&surface, NULL, &num);
+	ASSERT_EQ(actual, 0);
+}
+
 /* tbm_surface_internal_get_plane_bo_idx() */
 
 TEST(tbm_surface_internal_get_plane_bo_idx, work_flow_success_3)
@@ -761,6 +1105,29 @@ TEST(tbm_surface_internal_get_height, null_ptr_fail_1)
 
 /* tbm_surface_internal_get_width() */
 
+TEST(tbm_surface_internal_get_width, work_flow_success_3)
+{
+	unsigned int actual = 1;
+	int expected_width = 1024;
+	struct _tbm_surface surface;
+
+	_init_test();
+
+	/* the published geometry is enough, the surf_list is not consulted */
+	memset(&surface, 0, sizeof(surface));
+	surface.info.width = expected_width;
+	_tbm_surface_internal_geometry_add(&surface);
+
+	actual = tbm_surface_internal_get_width(&surface);
+	ASSERT_EQ(actual, expected_width);
+
+	/* a destroyed handle isn't found, though its memory is unchanged */
+	_tbm_surface_internal_geometry_remove(&surface);
+
+	actual = tbm_surface_internal_get_width(&surface);
+	ASSERT_EQ(actual, 0);
+}
+
 TEST(tbm_surface_internal_get_width, work_flow_success_2)
 {
 	unsigned int actual = 1;
@@ -1136,6 +1503,23 @@ TEST(tbm_surface_internal_get_bo, null_ptr_fail_1)
 
 /* tbm_surface_internal_get_num_bos() */
 
+TEST(tbm_surface_internal_get_num_bos, work_flow_success_2)
+{
+	int actual_num = 0;
+	int expected_num = 2;
+	struct _tbm_surface surface;
+
+	_init_test();
+
+	memset(&surface, 0, sizeof(surface));
+	surface.num_bos = expected_num;
+	_tbm_surface_internal_geometry_add(&surface);
+
+	actual_num = tbm_surface_internal_get_num_bos(&surface);
+
+	ASSERT_EQ(actual_num, expected_num);
+}
+
 TEST(tbm_surface_internal_get_num_bos, work_flow_success_1)
 {
 	int actual_num = 0;
@@ -1259,6 +1643,119 @@ TEST(tbm_surface_internal_destroy, work_flow_success_1)
 	ASSERT_EQ(expected_refcnt, surface.refcnt);
 }
 
+/* _tbm_format_plane_rect() */
+
+TEST(_tbm_format_plane_rect, work_flow_success_1)
+{
+	const tbm_format_desc_s *desc = tbm_format_get_desc(TBM_FORMAT_NV12);
+	tbm_surface_rect_s rect = { 2, 4, 5, 3 }, pr;
+
+	_init_test();
+
+	_tbm_format_plane_rect(desc, 0, &rect, &pr);
+	ASSERT_EQ(pr.x, 2);
+	ASSERT_EQ(pr.y, 4);
+	ASSERT_EQ(pr.width, 5);
+	ASSERT_EQ(pr.height, 3);
+
+	/* the partial chroma samples at the end are included */
+	_tbm_format_plane_rect(desc, 1, &rect, &pr);
+	ASSERT_EQ(pr.x, 1);
+	ASSERT_EQ(pr.y, 2);
+	ASSERT_EQ(pr.width, 3);
+	ASSERT_EQ(pr.height, 2);
+}
+
+/* _tbm_format_check_rect() */
+
+TEST(_tbm_format_check_rect, work_flow_success_1)
+{
+	const tbm_format_desc_s *desc = tbm_format_get_desc(TBM_FORMAT_NV12);
+	tbm_surface_rect_s rect = { 2, 4, 5, 3 };
+
+	_init_test();
+
+	ASSERT_EQ(_tbm_format_check_rect(desc, &rect, 8, 8), 1);
+
+	/* a chroma sample cut in half */
+	rect.x = 1;
+	ASSERT_EQ(_tbm_format_check_rect(desc, &rect, 8, 8), 0);
+	rect.x = 2;
+	rect.y = 3;
+	ASSERT_EQ(_tbm_format_check_rect(desc, &rect, 8, 8), 0);
+
+	/* out of the surface or empty */
+	rect.y = 4;
+	ASSERT_EQ(_tbm_format_check_rect(desc, &rect, 6, 8), 0);
+	rect.width = 0;
+	ASSERT_EQ(_tbm_format_check_rect(desc, &rect, 8, 8), 0);
+	rect.width = 5;
+	rect.x = -2;
+	ASSERT_EQ(_tbm_format_check_rect(desc, &rect, 8, 8), 0);
+}
+
+/* tbm_format_get_desc() */
+
+TEST(tbm_format_get_desc, work_flow_success_3)
+{
+	const tbm_format_desc_s *desc;
+	unsigned int i;
+
+	_init_test();
+
+	for (i = 0; i < TBM_FORMAT_DESC_NUM; i++) {
+		desc = tbm_format_get_desc(tbm_format_descs[i].format);
+		ASSERT_TRUE(desc == &tbm_format_descs[i]);
+	}
+}
+
+TEST(tbm_format_get_desc, work_flow_success_2)
+{
+	const tbm_format_desc_s *desc;
+
+	_init_test();
+
+	desc = tbm_format_get_desc(TBM_FORMAT_ARGB8888);
+
+	ASSERT_TRUE(desc != NULL);
+	ASSERT_EQ(desc->num_planes, 1);
+	ASSERT_EQ(desc->cpp[0], 4);
+	ASSERT_EQ(desc->has_alpha, 1);
+	ASSERT_EQ(desc->is_yuv, 0);
+	ASSERT_STREQ(desc->name, "TBM_FORMAT_ARGB8888");
+}
+
+TEST(tbm_format_get_desc, work_flow_success_1)
+{
+	const tbm_format_desc_s *desc;
+
+	_init_test();
+
+	desc = tbm_format_get_desc(TBM_FORMAT_NV12);
+
+	ASSERT_TRUE(desc != NULL);
+	ASSERT_EQ(desc->bpp, 12);
+	ASSERT_EQ(desc->num_planes, 2);
+	ASSERT_EQ(desc->hsub, 2);
+	ASSERT_EQ(desc->vsub, 2);
+	ASSERT_EQ(desc->cpp[1], 2);
+	ASSERT_EQ(desc->is_yuv, 1);
+}
+
+TEST(tbm_format_get_desc, null_ptr_fail_1)
+{
+	const tbm_format_desc_s *desc;
+
+	_init_test();
+
+	desc = tbm_format_get_desc(0);
+
+	ASSERT_TRUE(desc == NULL);
+	ASSERT_EQ(tbm_surface_internal_get_bpp(0), 0);
+	ASSERT_EQ(tbm_surface_internal_get_num_planes(0), 0);
+	ASSERT_STREQ(_tbm_surface_internal_format_to_str(0), "unknwon");
+}
+
 /* tbm_surface_internal_get_bpp() */
 
 TEST(tbm_surface_internal_get_bpp, work_flow_success_59)
@@ -2810,8 +3307,113 @@ TEST(tbm_surface_internal_get_num_planes, work_flow_success_1)
 	ASSERT_EQ(ret, expected_ret);
 }
 
+/* tbm_surface_internal_is_format_supported() */
+
+TEST(tbm_surface_internal_is_format_supported, work_flow_success_1)
+{
+	struct _tbm_bufmgr bufmgr;
+	struct _tbm_bufmgr_backend backend;
+
+	_init_test();
+
+	memset(&bufmgr, 0, sizeof(bufmgr));
+	g_surface_bufmgr = &bufmgr;
+	bufmgr.backend = &backend;
+	backend.surface_supported_format = ut_surface_supported_format;
+
+	ASSERT_EQ(tbm_surface_internal_is_format_supported(TBM_FORMAT_ARGB8888), 1);
+	ASSERT_EQ(tbm_surface_internal_is_format_supported(TBM_FORMAT_NV12), 1);
+	ASSERT_EQ(tbm_surface_internal_is_format_supported(UT_TBM_FORMAT_BACKEND), 1);
+	ASSERT_EQ(tbm_surface_internal_is_format_supported(TBM_FORMAT_YUV420), 0);
+	ASSERT_EQ(tbm_surface_internal_is_format_supported(0), 0);
+
+	/* the backend is asked once */
+	ASSERT_EQ(ut_surface_supported_format_count, 1);
+
+	free(bufmgr.formats);
+}
+
+TEST(tbm_surface_internal_is_format_supported, null_ptr_fail_1)
+{
+	struct _tbm_bufmgr bufmgr;
+	struct _tbm_bufmgr_backend backend;
+
+	_init_test();
+
+	memset(&bufmgr, 0, sizeof(bufmgr));
+	g_surface_bufmgr = &bufmgr;
+	bufmgr.backend = &backend;
+	backend.surface_supported_format = NULL;
+
+	ASSERT_EQ(tbm_surface_internal_is_format_supported(TBM_FORMAT_ARGB8888), 0);
+}
+
+/* tbm_surface_internal_get_supported_formats() */
+
+TEST(tbm_surface_internal_get_supported_formats, work_flow_success_1)
+{
+	struct _tbm_bufmgr bufmgr;
+	struct _tbm_bufmgr_backend backend;
+	uint32_t formats[2] = { 0, 0 }, num = 0;
+
+	_init_test();
+
+	memset(&bufmgr, 0, sizeof(bufmgr));
+	g_surface_bufmgr = &bufmgr;
+	bufmgr.backend = &backend;
+	backend.surface_supported_format = ut_surface_supported_format;
+
+	ASSERT_EQ(tbm_surface_internal_get_supported_formats(NULL, 0, &num), 1);
+	ASSERT_EQ(num, 3);
+
+	/* only the room of the caller is filled */
+	ASSERT_EQ(tbm_surface_internal_get_supported_formats(formats, 2, &num), 1);
+	ASSERT_EQ(num, 3);
+	ASSERT_EQ(formats[0], TBM_FORMAT_ARGB8888);
+	ASSERT_EQ(formats[1], TBM_FORMAT_NV12);
+
+	ASSERT_EQ(ut_surface_supported_format_count, 1);
+
+	free(bufmgr.formats);
+}
+
+TEST(tbm_surface_internal_get_supported_formats, null_ptr_fail_1)
+{
+	_init_test();
+
+	ASSERT_EQ(tbm_surface_internal_get_supported_formats(NULL, 0, NULL), 0);
+}
+
 /* tbm_surface_internal_query_supported_formats() */
 
+TEST(tbm_surface_internal_query_supported_formats, work_flow_success_4)
+{
+	struct _tbm_bufmgr bufmgr;
+	struct _tbm_bufmgr_backend backend;
+	uint32_t *formats1, *formats2, num;
+
+	_init_test();
+
+	memset(&bufmgr, 0, sizeof(bufmgr));
+	g_surface_bufmgr = &bufmgr;
+	bufmgr.backend = &backend;
+	backend.surface_supported_format = ut_surface_supported_format;
+
+	ASSERT_EQ(tbm_surface_internal_query_supported_formats(&formats1, &num), 1);
+	ASSERT_EQ(tbm_surface_internal_query_supported_formats(&formats2, &num), 1);
+
+	/* a copy of the cache for each caller */
+	ASSERT_EQ(ut_surface_supported_format_count, 1);
+	ASSERT_TRUE(formats1 != formats2);
+	ASSERT_TRUE(formats1 != bufmgr.formats);
+	ASSERT_EQ(num, 3);
+	ASSERT_EQ(formats2[2], UT_TBM_FORMAT_BACKEND);
+
+	free(formats1);
+	free(formats2);
+	free(bufmgr.formats);
+}
+
 TEST(tbm_surface_internal_query_supported_formats, work_flow_success_3)
 {
 	int ret = 0;
@@ -2822,14 +3424,18 @@ TEST(tbm_surface_internal_query_supported_formats, work_flow_success_3)
 
 	_init_test();
 
+	memset(&bufmgr, 0, sizeof(bufmgr));
 	g_surface_bufmgr = &bufmgr;
 	bufmgr.backend = &backend;
 	ut_ret_bufmgr.backend = &backend;
 	backend.surface_supported_format = ut_surface_supported_format;
 
-	ret = tbm_surface_internal_query_supported_formats(&formats, num);
+	ret = tbm_surface_internal_query_supported_formats(&formats, &num);
 
 	ASSERT_EQ(ret, expecte_ret);
+
+	free(formats);
+	free(bufmgr.formats);
 }
 
 TEST(tbm_surface_internal_query_supported_formats, work_flow_success_2)
@@ -2842,13 +3448,14 @@ TEST(tbm_surface_internal_query_supported_formats, work_flow_success_2)
 
 	_init_test();
 
+	memset(&bufmgr, 0, sizeof(bufmgr));
 	g_surface_bufmgr = &bufmgr;
 	bufmgr.backend = &backend;
 	ut_ret_bufmgr.backend = &backend;
 	backend.surface_supported_format = ut_surface_supported_format;
 	UT_TBM_SURFACE_INTERNAL_ERROR = 1;
 
-	ret = tbm_surface_internal_query_supported_formats(&formats, num);
+	ret = tbm_surface_internal_query_supported_formats(&formats, &num);
 
 	ASSERT_EQ(ret, expecte_ret);
 }
@@ -2863,12 +3470,309 @@ TEST(tbm_surface_internal_query_supported_formats, work_flow_success_1)
 
 	_init_test();
 
+	memset(&bufmgr, 0, sizeof(bufmgr));
 	g_surface_bufmgr = &bufmgr;
 	bufmgr.backend = &backend;
 	ut_ret_bufmgr.backend = &backend;
 	backend.surface_supported_format = NULL;
 
-	ret = tbm_surface_internal_query_supported_formats(&formats, num);
+	ret = tbm_surface_internal_query_supported_formats(&formats, &num);
 
 	ASSERT_EQ(ret, expecte_ret);
 }
+
+/* _tbm_surface_internal_dump_file() */
+
+TEST(_tbm_surface_internal_dump_file, work_flow_success_2)
+{
+	static unsigned char buf[32 * 16 * 2];
+	const char *file = "/tmp/ut_tbm_surface_internal.yuv";
+	tbm_surface_info_s info;
+	struct stat st;
+
+	_init_test();
+
+	/* NV12 16x15 in rows of 32 bytes, without the padding */
+	memset(&info, 0, sizeof(info));
+	info.width = 16;
+	info.height = 15;
+	info.format = TBM_FORMAT_NV12;
+	info.num_planes = 2;
+	info.planes[0].ptr = buf;
+	info.planes[0].stride = 32;
+	info.planes[1].ptr = buf + 32 * 15;
+	info.planes[1].stride = 32;
+
+	ASSERT_EQ(1, _tbm_surface_internal_dump_file(file, &info));
+	ASSERT_EQ(0, stat(file, &st));
+	ASSERT_EQ(16 * 15 + 16 * 8, st.st_size);
+
+	/* YUYV of an odd width keeps the last macro pixel */
+	info.width = 5;
+	info.format = TBM_FORMAT_YUYV;
+	info.num_planes = 1;
+	info.planes[0].stride = 12;
+
+	ASSERT_EQ(1, _tbm_surface_internal_dump_file(file, &info));
+	ASSERT_EQ(0, stat(file, &st));
+	ASSERT_EQ(12 * 15, st.st_size);
+
+	unlink(file);
+}
+
+TEST(_tbm_surface_internal_dump_file, work_flow_success_1)
+{
+	tbm_surface_info_s info;
+
+	_init_test();
+
+	memset(&info, 0, sizeof(info));
+	info.width = 16;
+	info.height = 16;
+
+	/* the tiles and an unknown format */
+	info.format = TBM_FORMAT_NV12MT;
+	ASSERT_EQ(0, _tbm_surface_internal_dump_file("/tmp/ut.yuv", &info));
+	info.format = 0x20202020;
+	ASSERT_EQ(0, _tbm_surface_internal_dump_file("/tmp/ut.yuv", &info));
+}
+
+TEST(_tbm_surface_internal_dump_file, null_ptr_fail_1)
+{
+	tbm_surface_info_s info;
+
+	_init_test();
+
+	ASSERT_EQ(0, _tbm_surface_internal_dump_file(NULL, &info));
+	ASSERT_EQ(0, _tbm_surface_internal_dump_file("/tmp/ut.yuv", NULL));
+}
+
+/* tbm_surface_internal_create_view() */
+
+static tbm_surface_h
+_ut_create_nv12(tbm_bo bo, int width, int height, int stride)
+{
+	tbm_surface_info_s info;
+
+	/* destroying the last surface walks it */
+	LIST_INITHEAD(&ut_ret_bufmgr.debug_key_list);
+
+	memset(&info, 0, sizeof(info));
+	info.width = width;
+	info.height = height;
+	info.format = TBM_FORMAT_NV12;
+	info.bpp = 12;
+	info.num_planes = 2;
+	info.planes[0].stride = stride;
+	info.planes[0].size = stride * height;
+	info.planes[1].offset = stride * height;
+	info.planes[1].stride = stride;
+	info.planes[1].size = stride * height / 2;
+
+	return tbm_surface_internal_create_with_bos(&info, &bo, 1);
+}
+
+TEST(tbm_surface_internal_create_view, work_flow_success_3)
+{
+	struct _tbm_bo bo;
+	tbm_surface_h parent, view, inner;
+
+	_init_test();
+
+	memset(&bo, 0, sizeof(bo));
+	ut_tbm_bo_refcnt = 0;
+
+	parent = _ut_create_nv12(&bo, 64, 32, 128);
+	ASSERT_TRUE(parent != NULL);
+
+	/* the rows start at (16, 8) and (8, 4) of the chroma, same strides */
+	view = tbm_surface_internal_create_view(parent, 16, 8, 32, 16);
+	ASSERT_TRUE(view != NULL);
+	ASSERT_EQ(32, view->info.width);
+	ASSERT_EQ(16, view->info.height);
+	ASSERT_EQ(8 * 128 + 16, view->info.planes[0].offset);
+	ASSERT_EQ(128, view->info.planes[0].stride);
+	ASSERT_EQ(128 * 15 + 32, view->info.planes[0].size);
+	ASSERT_EQ(128 * 32 + 4 * 128 + 16, view->info.planes[1].offset);
+	ASSERT_EQ(128 * 7 + 32, view->info.planes[1].size);
+	ASSERT_EQ(parent->bos[0], view->bos[0]);
+	ASSERT_EQ(2, parent->refcnt);
+	ASSERT_EQ(2, ut_tbm_bo_refcnt);
+
+	/* the bo stays with the parent */
+	ASSERT_EQ(parent, bo.surface);
+
+	/* a view of the view */
+	inner = tbm_surface_internal_create_view(view, 2, 2, 4, 4);
+	ASSERT_TRUE(inner != NULL);
+	ASSERT_EQ(10 * 128 + 18, inner->info.planes[0].offset);
+	ASSERT_EQ(128 * 32 + 5 * 128 + 18, inner->info.planes[1].offset);
+
+	tbm_surface_internal_destroy(view);
+	tbm_surface_internal_destroy(parent);
+	ASSERT_EQ(1, _tbm_surface_internal_is_valid(parent));
+	ASSERT_EQ(parent, bo.surface);
+
+	/* the last one takes the others */
+	tbm_surface_internal_destroy(inner);
+	ASSERT_EQ(0, ut_tbm_bo_refcnt);
+	ASSERT_TRUE(g_surface_bufmgr == NULL);
+}
+
+TEST(tbm_surface_internal_create_view, work_flow_success_2)
+{
+	struct _tbm_bo bo;
+	tbm_surface_h parent, view;
+
+	_init_test();
+
+	memset(&bo, 0, sizeof(bo));
+
+	parent = _ut_create_nv12(&bo, 64, 32, 64);
+	ASSERT_TRUE(parent != NULL);
+
+	/* the whole parent */
+	view = tbm_surface_internal_create_view(parent, 0, 0, 64, 32);
+	ASSERT_TRUE(view != NULL);
+	ASSERT_EQ(0, view->info.planes[0].offset);
+	ASSERT_EQ(64 * 32, view->info.planes[0].size);
+	ASSERT_EQ(64 * 32, view->info.planes[1].offset);
+	ASSERT_EQ(64 * 16, view->info.planes[1].size);
+
+	tbm_surface_internal_destroy(view);
+	ASSERT_EQ(1, parent->refcnt);
+
+	tbm_surface_internal_destroy(parent);
+}
+
+TEST(tbm_surface_internal_create_view, work_flow_success_1)
+{
+	struct _tbm_bo bo;
+	tbm_surface_h parent;
+
+	_init_test();
+
+	memset(&bo, 0, sizeof(bo));
+
+	parent = _ut_create_nv12(&bo, 64, 32, 64);
+	ASSERT_TRUE(parent != NULL);
+
+	/* off the chroma samples */
+	ASSERT_TRUE(tbm_surface_internal_create_view(parent, 1, 0, 8, 8) == NULL);
+	ASSERT_TRUE(tbm_surface_internal_create_view(parent, 0, 3, 8, 8) == NULL);
+
+	/* out of the parent */
+	ASSERT_TRUE(tbm_surface_internal_create_view(parent, 32, 0, 34, 8) == NULL);
+	ASSERT_TRUE(tbm_surface_internal_create_view(parent, 0, 16, 8, 18) == NULL);
+
+	/* tiles */
+	parent->info.format = TBM_FORMAT_NV12MT;
+	ASSERT_TRUE(tbm_surface_internal_create_view(parent, 0, 0, 8, 8) == NULL);
+	parent->info.format = TBM_FORMAT_NV12;
+
+	/* no memory */
+	CALLOC_ERROR = 1;
+	ASSERT_TRUE(tbm_surface_internal_create_view(parent, 0, 0, 8, 8) == NULL);
+	CALLOC_ERROR = 0;
+
+	ASSERT_EQ(1, parent->refcnt);
+
+	tbm_surface_internal_destroy(parent);
+}
+
+TEST(tbm_surface_internal_create_view, null_ptr_fail_1)
+{
+	_init_test();
+
+	ASSERT_TRUE(tbm_surface_internal_create_view(NULL, 0, 0, 8, 8) == NULL);
+}
+
+/* _tbm_surface_internal_get_layout() */
+
+static int
+ut_surface_get_plane_data_nv12(int width, int height, tbm_format format, int plane_idx,
+			       uint32_t *size, uint32_t *offset, uint32_t *pitch, int *bo_idx)
+{
+	*pitch = width;
+	*size = plane_idx ? width * height / 2 : width * height;
+	*offset = plane_idx ? width * height : 0;
+	*bo_idx = 0;
+
+	return 1;
+}
+
+static int ut_surface_get_layout_count;
+
+static int
+ut_surface_get_layout_nv12(int width, int height, tbm_format format,
+			   tbm_surface_layout_s *layout)
+{
+	ut_surface_get_layout_count++;
+
+	layout->pitch[0] = layout->pitch[1] = width;
+	layout->size[0] = width * height;
+	layout->size[1] = width * height / 2;
+	layout->offset[1] = width * height;
+
+	return 1;
+}
+
+TEST(_tbm_surface_internal_get_layout, work_flow_success_2)
+{
+	struct _tbm_bufmgr bufmgr;
+	struct _tbm_bufmgr_backend backend;
+	tbm_surface_info_s info;
+
+	_init_test();
+
+	memset(&backend, 0, sizeof(backend));
+	bufmgr.backend = &backend;
+	backend.surface_get_layout = ut_surface_get_layout_nv12;
+	backend.surface_get_plane_data = ut_surface_get_plane_data_nv12;
+	ut_surface_get_layout_count = 0;
+
+	/* all the planes in one call, the per-plane hook is not used */
+	ASSERT_EQ(_tbm_surface_internal_get_layout(&bufmgr, 64, 32, TBM_FORMAT_NV12, &info), 1);
+	ASSERT_EQ(ut_surface_get_layout_count, 1);
+	ASSERT_EQ(info.num_planes, 2);
+	ASSERT_EQ(info.planes[1].offset, 64 * 32);
+	ASSERT_EQ(info.planes[1].size, 64 * 32 / 2);
+	ASSERT_EQ(info.planes[1].stride, 64);
+	ASSERT_EQ(info.size, 64 * 32 * 3 / 2);
+}
+
+TEST(_tbm_surface_internal_get_layout, work_flow_success_1)
+{
+	struct _tbm_bufmgr bufmgr;
+	struct _tbm_bufmgr_backend backend;
+	tbm_surface_info_s info;
+
+	_init_test();
+
+	memset(&backend, 0, sizeof(backend));
+	bufmgr.backend = &backend;
+	backend.surface_get_plane_data = ut_surface_get_plane_data_nv12;
+
+	ASSERT_EQ(_tbm_surface_internal_get_layout(&bufmgr, 64, 32, TBM_FORMAT_NV12, &info), 1);
+	ASSERT_EQ(info.num_planes, 2);
+	ASSERT_EQ(info.bpp, 12);
+	ASSERT_EQ(info.planes[1].offset, 64 * 32);
+	ASSERT_EQ(info.planes[1].stride, 64);
+	ASSERT_EQ(info.size, 64 * 32 * 3 / 2);
+}
+
+TEST(_tbm_surface_internal_get_layout, null_ptr_fail_1)
+{
+	struct _tbm_bufmgr bufmgr;
+	struct _tbm_bufmgr_backend backend;
+	tbm_surface_info_s info;
+
+	_init_test();
+
+	memset(&backend, 0, sizeof(backend));
+	bufmgr.backend = &backend;
+	backend.surface_get_plane_data = NULL;
+
+	ASSERT_EQ(_tbm_surface_internal_get_layout(&bufmgr, 64, 32, TBM_FORMAT_NV12, &info), 0);
+	ASSERT_EQ(_tbm_surface_internal_get_layout(NULL, 64, 32, TBM_FORMAT_NV12, &info), 0);
+}
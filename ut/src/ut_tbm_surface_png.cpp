@@ -0,0 +1,361 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics co., Ltd. All Rights Reserved.
+ *
+ * Contact: Konstantin Drabeniuk <k.drabeniuk@samsung.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+**************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include <png.h>
+
+#include "tbm_bufmgr_int.h"
+
+#include "stdlib_stubs.h"
+
+#define UT_PNG_FILE "/tmp/ut_tbm_surface_png.png"
+
+/* HELPER FUNCTIONS */
+static int ut_worker_count = 1;
+
+static int
+ut__tbm_worker_get_bands(uint64_t bytes)
+{
+	return ut_worker_count;
+}
+
+#include "tbm_surface_stubs.h"
+
+#define _tbm_worker_get_bands ut__tbm_worker_get_bands
+
+#include "tbm_surface_png.c"
+
+static void _init_test()
+{
+	CALLOC_ERROR = 0;
+	ut_worker_count = 1;
+	tbm_surface_internal_dump_set_png_compression(-1, TBM_SURFACE_PNG_FILTER_DEFAULT);
+}
+
+/* smooth enough for the filters to matter, noisy enough for a real deflate */
+static void
+_ut_fill_image(unsigned char *buf, int width, int height)
+{
+	int x, y;
+
+	_ut_fill(buf, width * height * 4, 5);
+	for (y = 0; y < height; y++) {
+		for (x = 0; x < width; x++) {
+			unsigned char *p = buf + (y * width + x) * 4;
+
+			p[0] = (p[0] & 0x7) + x;
+			p[1] = (p[1] & 0x3) + y;
+		}
+	}
+}
+
+/* reads back the file written from the BGRA data and compares it */
+static int
+_ut_png_check(const unsigned char *data, int width, int height)
+{
+	png_image image;
+	unsigned char *out;
+	int ret;
+
+	memset(&image, 0, sizeof(image));
+	image.version = PNG_IMAGE_VERSION;
+
+	if (!png_image_begin_read_from_file(&image, UT_PNG_FILE))
+		return 0;
+
+	if ((int)image.width != width || (int)image.height != height) {
+		png_image_free(&image);
+		return 0;
+	}
+
+	image.format = PNG_FORMAT_BGRA;
+	out = (unsigned char *)malloc(PNG_IMAGE_SIZE(image));
+	if (!png_image_finish_read(&image, NULL, out, 0, NULL)) {
+		png_image_free(&image);
+		::free(out);
+		return 0;
+	}
+
+	ret = !memcmp(out, data, width * height * 4);
+	::free(out);
+
+	return ret;
+}
+
+/* _tbm_surface_internal_dump_file_png() */
+
+TEST(_tbm_surface_internal_dump_file_png, work_flow_success_3)
+{
+	static const tbm_surface_png_filter_e filters[] = {
+		TBM_SURFACE_PNG_FILTER_NONE,
+		TBM_SURFACE_PNG_FILTER_SUB,
+		TBM_SURFACE_PNG_FILTER_UP,
+	};
+	int width = 1030, height = 1021, i;
+	unsigned char *data = (unsigned char *)malloc(width * height * 4);
+
+	_init_test();
+
+	_ut_fill_image(data, width, height);
+
+	/* cut in strips compressed on their own */
+	ut_worker_count = 4;
+	for (i = 0; i < (int)(sizeof(filters) / sizeof(filters[0])); i++) {
+		ASSERT_EQ(1, tbm_surface_internal_dump_set_png_compression(1, filters[i]));
+		_tbm_surface_internal_dump_file_png(UT_PNG_FILE, data, width, height);
+		ASSERT_EQ(1, _ut_png_check(data, width, height)) << "filter " << filters[i];
+	}
+
+	/* the strips fail, libpng writes the rows */
+	CALLOC_ERROR = 1;
+	_tbm_surface_internal_dump_file_png(UT_PNG_FILE, data, width, height);
+	CALLOC_ERROR = 0;
+	ASSERT_EQ(1, _ut_png_check(data, width, height));
+
+	::free(data);
+	unlink(UT_PNG_FILE);
+}
+
+TEST(_tbm_surface_internal_dump_file_png, work_flow_success_2)
+{
+	int width = 67, height = 33, level, filter;
+	unsigned char data[67 * 33 * 4];
+
+	_init_test();
+
+	_ut_fill_image(data, width, height);
+
+	for (level = -1; level <= 9; level += 5) {
+		for (filter = TBM_SURFACE_PNG_FILTER_DEFAULT; filter <= TBM_SURFACE_PNG_FILTER_PAETH; filter++) {
+			ASSERT_EQ(1, tbm_surface_internal_dump_set_png_compression(level,
+										   (tbm_surface_png_filter_e)filter));
+			_tbm_surface_internal_dump_file_png(UT_PNG_FILE, data, width, height);
+			ASSERT_EQ(1, _ut_png_check(data, width, height));
+		}
+	}
+
+	unlink(UT_PNG_FILE);
+}
+
+TEST(_tbm_surface_internal_dump_file_png, work_flow_success_1)
+{
+	unsigned char data[4 * 4];
+
+	_init_test();
+
+	_ut_fill(data, sizeof(data), 1);
+
+	/* a directory which doesn't exist */
+	_tbm_surface_internal_dump_file_png("/nonexistent/ut.png", data, 2, 2);
+
+	_tbm_surface_internal_dump_file_png(UT_PNG_FILE, data, 2, 2);
+	ASSERT_EQ(1, _ut_png_check(data, 2, 2));
+
+	unlink(UT_PNG_FILE);
+}
+
+/* reads back the file as RGBA */
+static int
+_ut_png_read(unsigned char *out, int width, int height)
+{
+	png_image image;
+
+	memset(&image, 0, sizeof(image));
+	image.version = PNG_IMAGE_VERSION;
+
+	if (!png_image_begin_read_from_file(&image, UT_PNG_FILE))
+		return 0;
+
+	if ((int)image.width != width || (int)image.height != height) {
+		png_image_free(&image);
+		return 0;
+	}
+
+	image.format = PNG_FORMAT_RGBA;
+
+	return png_image_finish_read(&image, NULL, out, 0, NULL);
+}
+
+/* _tbm_surface_internal_dump_file_png_format() */
+
+TEST(_tbm_surface_internal_dump_file_png_format, work_flow_success_3)
+{
+	/* one pixel of every format, its RGBA */
+	static const struct {
+		tbm_format format;
+		uint32_t pixel;
+		unsigned char rgba[4];
+	} tests[] = {
+		{ TBM_FORMAT_C8,          0x80,       { 0x80, 0x80, 0x80, 0xff } },
+		{ TBM_FORMAT_RGB332,      0xe3,       { 0xff, 0x00, 0xff, 0xff } },
+		{ TBM_FORMAT_BGR233,      0xc7,       { 0xff, 0x00, 0xff, 0xff } },
+		{ TBM_FORMAT_ARGB4444,    0x8f0a,     { 0xff, 0x00, 0xaa, 0x88 } },
+		{ TBM_FORMAT_RGBA4444,    0xf0a8,     { 0xff, 0x00, 0xaa, 0x88 } },
+		{ TBM_FORMAT_XRGB1555,    0x7c00,     { 0xff, 0x00, 0x00, 0xff } },
+		{ TBM_FORMAT_ARGB1555,    0x001f,     { 0x00, 0x00, 0xff, 0x00 } },
+		{ TBM_FORMAT_RGBA5551,    0x07c1,     { 0x00, 0xff, 0x00, 0xff } },
+		{ TBM_FORMAT_RGB565,      0xf800,     { 0xff, 0x00, 0x00, 0xff } },
+		{ TBM_FORMAT_BGR565,      0x07e0,     { 0x00, 0xff, 0x00, 0xff } },
+		{ TBM_FORMAT_RGB888,      0x123456,   { 0x12, 0x34, 0x56, 0xff } },
+		{ TBM_FORMAT_BGR888,      0x123456,   { 0x56, 0x34, 0x12, 0xff } },
+		{ TBM_FORMAT_ARGB8888,    0x80123456, { 0x12, 0x34, 0x56, 0x80 } },
+		{ TBM_FORMAT_XRGB8888,    0x00123456, { 0x12, 0x34, 0x56, 0xff } },
+		{ TBM_FORMAT_ABGR8888,    0x80123456, { 0x56, 0x34, 0x12, 0x80 } },
+		{ TBM_FORMAT_RGBA8888,    0x12345680, { 0x12, 0x34, 0x56, 0x80 } },
+		{ TBM_FORMAT_BGRX8888,    0x12345600, { 0x56, 0x34, 0x12, 0xff } },
+		{ TBM_FORMAT_ARGB2101010, 0xbff00000, { 0xff, 0x00, 0x00, 0xaa } },
+		{ TBM_FORMAT_RGBX1010102, 0x00000ffc, { 0x00, 0x00, 0xff, 0xff } },
+	};
+	const tbm_png_pixel *pixel;
+	unsigned char data[3 * 2 * 4], out[3 * 2 * 4];
+	unsigned int i;
+	int j, k;
+
+	_init_test();
+
+	for (i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+		pixel = _tbm_png_get_pixel(tests[i].format);
+		ASSERT_TRUE(pixel != NULL);
+
+		/* 3x2 of the pixel, rows of 12 bytes */
+		memset(data, 0, sizeof(data));
+		for (j = 0; j < 6; j++) {
+			for (k = 0; k < pixel->bytes; k++)
+				data[(j / 3) * 12 + (j % 3) * pixel->bytes + k] = tests[i].pixel >> (k * 8);
+		}
+
+		ASSERT_EQ(1, _tbm_surface_internal_dump_file_png_format(UT_PNG_FILE, data, 3, 2, 12,
+									 tests[i].format));
+		ASSERT_EQ(1, _ut_png_read(out, 3, 2));
+		for (j = 0; j < 6; j++)
+			ASSERT_EQ(0, memcmp(out + j * 4, tests[i].rgba, 4)) << "format " << i;
+	}
+
+	unlink(UT_PNG_FILE);
+}
+
+TEST(_tbm_surface_internal_dump_file_png_format, work_flow_success_2)
+{
+	int width = 33, height = 17, stride = 40 * 4, y;
+	unsigned char data[40 * 4 * 17], packed[33 * 17 * 4];
+
+	_init_test();
+
+	/* only the width of the rows is written */
+	_ut_fill(data, sizeof(data), 7);
+	for (y = 0; y < height; y++)
+		memcpy(packed + y * width * 4, data + y * stride, width * 4);
+
+	ASSERT_EQ(1, _tbm_surface_internal_dump_file_png_format(UT_PNG_FILE, data, width, height,
+								 stride, TBM_FORMAT_ARGB8888));
+	ASSERT_EQ(1, _ut_png_check(packed, width, height));
+
+	unlink(UT_PNG_FILE);
+}
+
+TEST(_tbm_surface_internal_dump_file_png_format, work_flow_success_1)
+{
+	unsigned char data[4 * 4];
+
+	_init_test();
+
+	/* not a packed RGB format */
+	ASSERT_EQ(0, _tbm_surface_internal_dump_file_png_format(UT_PNG_FILE, data, 2, 2, 8,
+								 TBM_FORMAT_NV12));
+	ASSERT_EQ(0, _tbm_surface_internal_dump_file_png_format("/nonexistent/ut.png", data, 2, 2, 8,
+								 TBM_FORMAT_ARGB8888));
+}
+
+/* tbm_surface_internal_dump_set_png_compression() */
+
+TEST(tbm_surface_internal_dump_set_png_compression, work_flow_success_1)
+{
+	_init_test();
+
+	ASSERT_EQ(1, tbm_surface_internal_dump_set_png_compression(0, TBM_SURFACE_PNG_FILTER_NONE));
+	ASSERT_EQ(0, png_level);
+	ASSERT_EQ(TBM_SURFACE_PNG_FILTER_NONE, png_filter);
+
+	ASSERT_EQ(0, tbm_surface_internal_dump_set_png_compression(10, TBM_SURFACE_PNG_FILTER_NONE));
+	ASSERT_EQ(0, tbm_surface_internal_dump_set_png_compression(-2, TBM_SURFACE_PNG_FILTER_NONE));
+	ASSERT_EQ(0, tbm_surface_internal_dump_set_png_compression(1, (tbm_surface_png_filter_e)-1));
+	ASSERT_EQ(0, png_level);
+}
+
+/* simd kernels */
+
+TEST(tbm_surface_png_kernels, work_flow_success_1)
+{
+	static const tbm_png_swizzle_func kernels[] = {
+		_tbm_png_swizzle_c,
+#ifdef TBM_SIMD_SSE2
+		_tbm_png_swizzle_sse2,
+#endif
+#ifdef TBM_SIMD_AVX2
+		_tbm_png_swizzle_avx2,
+#endif
+#ifdef TBM_SIMD_NEON
+		_tbm_png_swizzle_neon,
+#endif
+		NULL,
+	};
+	unsigned int features = _tbm_cpu_get_features();
+	unsigned char src[67 * 4], ref[67 * 4], out[67 * 4];
+	const tbm_png_pixel *pixel;
+	unsigned int i, k;
+	int n;
+
+	_init_test();
+
+	_ut_fill(src, sizeof(src), 3);
+
+	/* the swizzles of every format they take against the unpacking */
+	for (i = 0; i < sizeof(tbm_png_pixels) / sizeof(tbm_png_pixels[0]); i++) {
+		pixel = &tbm_png_pixels[i];
+		if (_tbm_png_get_swizzle(pixel) == _tbm_png_unpack_c)
+			continue;
+
+		for (k = 0; kernels[k]; k++) {
+#ifdef TBM_SIMD_AVX2
+			if (kernels[k] == _tbm_png_swizzle_avx2 && !(features & TBM_CPU_AVX2))
+				continue;
+#endif
+			for (n = 0; n <= 67; n++) {
+				memset(ref, 0, sizeof(ref));
+				memset(out, 0, sizeof(out));
+
+				_tbm_png_unpack_c(ref, src, n, pixel);
+				kernels[k](out, src, n, pixel);
+				ASSERT_EQ(memcmp(ref, out, sizeof(out)), 0) << "format " << i;
+			}
+		}
+	}
+
+	(void)features;
+}
@@ -0,0 +1,322 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics co., Ltd. All Rights Reserved.
+ *
+ * Contact: Konstantin Drabeniuk <k.drabeniuk@samsung.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+**************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "tbm_bufmgr_int.h"
+
+#include "pthread_stubs.h"
+#include "stdlib_stubs.h"
+
+/* HELPER FUNCTIONS */
+
+static struct _tbm_surface ut_surfaces[8];
+static int ut_surface_count = 0;
+static int ut_unref_count = 0;
+static int ut_refcnt = 1;
+static int UT_TBM_SURFACE_POOL_ERROR = 0;
+
+static tbm_surface_h
+ut_tbm_surface_internal_create_with_flags(int width, int height,
+					   int format, int flags)
+{
+	if (UT_TBM_SURFACE_POOL_ERROR)
+		return NULL;
+
+	return &ut_surfaces[ut_surface_count++];
+}
+
+static void
+ut_tbm_surface_internal_unref(tbm_surface_h surface)
+{
+	ut_unref_count++;
+}
+
+static unsigned int
+ut_tbm_surface_internal_get_size(tbm_surface_h surface)
+{
+	return 100;
+}
+
+static int
+ut_tbm_surface_internal_get_refcnt(tbm_surface_h surface)
+{
+	return ut_refcnt;
+}
+
+#define pthread_mutex_lock ut_pthread_mutex_lock
+#define pthread_mutex_unlock ut_pthread_mutex_unlock
+#define pthread_mutex_init ut_pthread_mutex_init
+#define calloc ut_calloc
+#define free ut_free
+#define tbm_surface_internal_create_with_flags ut_tbm_surface_internal_create_with_flags
+#define tbm_surface_internal_unref ut_tbm_surface_internal_unref
+#define tbm_surface_internal_get_size ut_tbm_surface_internal_get_size
+#define _tbm_surface_internal_get_refcnt ut_tbm_surface_internal_get_refcnt
+
+#include "tbm_surface_pool.c"
+
+static void _init_test()
+{
+	PTHREAD_MUTEX_INIT_ERROR = 0;
+	CALLOC_ERROR = 0;
+	FREE_CALLED = 0;
+	FREE_PTR = NULL;
+	FREE_TESTED_PTR = NULL;
+	free_called_for_tested_ptr = 0;
+	free_call_count = 0;
+	UT_TBM_SURFACE_POOL_ERROR = 0;
+	ut_surface_count = 0;
+	ut_unref_count = 0;
+	ut_refcnt = 1;
+}
+
+/* tbm_surface_pool_flush() */
+
+TEST(tbm_surface_pool_flush, work_flow_success_1)
+{
+	tbm_surface_pool_h pool;
+	tbm_surface_pool_stats_s stats;
+	tbm_surface_h surface1, surface2;
+
+	_init_test();
+
+	pool = tbm_surface_pool_create(0, 0);
+	surface1 = tbm_surface_pool_acquire(pool, 64, 64, TBM_FORMAT_ARGB8888, 0);
+	surface2 = tbm_surface_pool_acquire(pool, 32, 32, TBM_FORMAT_ARGB8888, 0);
+	tbm_surface_pool_release(pool, surface1);
+	tbm_surface_pool_release(pool, surface2);
+
+	tbm_surface_pool_flush(pool);
+	tbm_surface_pool_get_stats(pool, &stats);
+
+	ASSERT_EQ(ut_unref_count, 2);
+	ASSERT_EQ(stats.num_cached, 0);
+	ASSERT_EQ(stats.cached_size, 0);
+	ASSERT_EQ(stats.evictions, 2);
+
+	tbm_surface_pool_destroy(pool);
+}
+
+/* tbm_surface_pool_release() */
+
+TEST(tbm_surface_pool_release, work_flow_success_3)
+{
+	tbm_surface_pool_h pool;
+	tbm_surface_pool_stats_s stats;
+	tbm_surface_h surface;
+
+	_init_test();
+
+	pool = tbm_surface_pool_create(0, 0);
+	surface = tbm_surface_pool_acquire(pool, 64, 64, TBM_FORMAT_ARGB8888, 0);
+
+	/* still referenced by somebody else */
+	ut_refcnt = 2;
+	tbm_surface_pool_release(pool, surface);
+	tbm_surface_pool_get_stats(pool, &stats);
+
+	ASSERT_EQ(ut_unref_count, 1);
+	ASSERT_EQ(stats.num_cached, 0);
+	ASSERT_EQ(stats.num_acquired, 0);
+
+	tbm_surface_pool_destroy(pool);
+}
+
+TEST(tbm_surface_pool_release, work_flow_success_2)
+{
+	tbm_surface_pool_h pool;
+	tbm_surface_pool_stats_s stats;
+	tbm_surface_h surface1, surface2, surface3;
+
+	_init_test();
+
+	/* room for two surfaces of 100 bytes */
+	pool = tbm_surface_pool_create(250, 0);
+	surface1 = tbm_surface_pool_acquire(pool, 16, 16, TBM_FORMAT_ARGB8888, 0);
+	surface2 = tbm_surface_pool_acquire(pool, 32, 32, TBM_FORMAT_ARGB8888, 0);
+	surface3 = tbm_surface_pool_acquire(pool, 64, 64, TBM_FORMAT_ARGB8888, 0);
+	tbm_surface_pool_release(pool, surface1);
+	tbm_surface_pool_release(pool, surface2);
+	tbm_surface_pool_release(pool, surface3);
+	tbm_surface_pool_get_stats(pool, &stats);
+
+	ASSERT_EQ(ut_unref_count, 1);
+	ASSERT_EQ(stats.evictions, 1);
+	ASSERT_EQ(stats.num_cached, 2);
+	ASSERT_EQ(stats.cached_size, 200);
+
+	/* the least recently released one is gone */
+	ASSERT_TRUE(tbm_surface_pool_acquire(pool, 16, 16, TBM_FORMAT_ARGB8888, 0) != surface1);
+	ASSERT_TRUE(tbm_surface_pool_acquire(pool, 32, 32, TBM_FORMAT_ARGB8888, 0) == surface2);
+
+	tbm_surface_pool_destroy(pool);
+}
+
+TEST(tbm_surface_pool_release, work_flow_success_1)
+{
+	tbm_surface_pool_h pool;
+	tbm_surface_pool_stats_s stats;
+	tbm_surface_h surface;
+
+	_init_test();
+
+	pool = tbm_surface_pool_create(0, 1);
+	surface = tbm_surface_pool_acquire(pool, 64, 64, TBM_FORMAT_ARGB8888, 0);
+	tbm_surface_pool_release(pool, surface);
+	tbm_surface_pool_get_stats(pool, &stats);
+
+	ASSERT_EQ(ut_unref_count, 0);
+	ASSERT_EQ(stats.num_cached, 1);
+	ASSERT_EQ(stats.cached_size, 100);
+	ASSERT_EQ(stats.num_acquired, 0);
+
+	tbm_surface_pool_destroy(pool);
+}
+
+TEST(tbm_surface_pool_release, null_ptr_fail_1)
+{
+	tbm_surface_pool_h pool;
+	tbm_surface_pool_stats_s stats;
+
+	_init_test();
+
+	pool = tbm_surface_pool_create(0, 0);
+
+	/* not acquired from the pool */
+	tbm_surface_pool_release(pool, &ut_surfaces[0]);
+	tbm_surface_pool_get_stats(pool, &stats);
+
+	ASSERT_EQ(ut_unref_count, 0);
+	ASSERT_EQ(stats.num_cached, 0);
+
+	tbm_surface_pool_destroy(pool);
+}
+
+/* tbm_surface_pool_acquire() */
+
+TEST(tbm_surface_pool_acquire, work_flow_success_2)
+{
+	tbm_surface_pool_h pool;
+	tbm_surface_pool_stats_s stats;
+	tbm_surface_h surface1, surface2;
+
+	_init_test();
+
+	pool = tbm_surface_pool_create(0, 0);
+	surface1 = tbm_surface_pool_acquire(pool, 64, 64, TBM_FORMAT_ARGB8888, 0);
+	tbm_surface_pool_release(pool, surface1);
+
+	/* different flags must not be served by the cached surface */
+	surface2 = tbm_surface_pool_acquire(pool, 64, 64, TBM_FORMAT_ARGB8888, TBM_BO_SCANOUT);
+	tbm_surface_pool_get_stats(pool, &stats);
+
+	ASSERT_TRUE(surface1 != surface2);
+	ASSERT_EQ(stats.hits, 0);
+	ASSERT_EQ(stats.misses, 2);
+
+	tbm_surface_pool_destroy(pool);
+}
+
+TEST(tbm_surface_pool_acquire, work_flow_success_1)
+{
+	tbm_surface_pool_h pool;
+	tbm_surface_pool_stats_s stats;
+	tbm_surface_h surface1, surface2;
+
+	_init_test();
+
+	pool = tbm_surface_pool_create(0, 0);
+	surface1 = tbm_surface_pool_acquire(pool, 64, 64, TBM_FORMAT_ARGB8888, 0);
+	tbm_surface_pool_release(pool, surface1);
+	surface2 = tbm_surface_pool_acquire(pool, 64, 64, TBM_FORMAT_ARGB8888, 0);
+	tbm_surface_pool_get_stats(pool, &stats);
+
+	ASSERT_TRUE(surface1 == surface2);
+	ASSERT_EQ(ut_surface_count, 1);
+	ASSERT_EQ(stats.hits, 1);
+	ASSERT_EQ(stats.misses, 1);
+	ASSERT_EQ(stats.num_acquired, 1);
+
+	tbm_surface_pool_destroy(pool);
+}
+
+TEST(tbm_surface_pool_acquire, null_ptr_fail_2)
+{
+	tbm_surface_pool_h pool;
+	tbm_surface_h surface;
+
+	_init_test();
+
+	pool = tbm_surface_pool_create(0, 0);
+	UT_TBM_SURFACE_POOL_ERROR = 1;
+
+	surface = tbm_surface_pool_acquire(pool, 64, 64, TBM_FORMAT_ARGB8888, 0);
+
+	ASSERT_TRUE(surface == NULL);
+
+	tbm_surface_pool_destroy(pool);
+}
+
+TEST(tbm_surface_pool_acquire, null_ptr_fail_1)
+{
+	tbm_surface_h surface;
+
+	_init_test();
+
+	surface = tbm_surface_pool_acquire(NULL, 64, 64, TBM_FORMAT_ARGB8888, 0);
+
+	ASSERT_TRUE(surface == NULL);
+}
+
+/* tbm_surface_pool_create() */
+
+TEST(tbm_surface_pool_create, work_flow_success_1)
+{
+	tbm_surface_pool_h pool;
+
+	_init_test();
+
+	pool = tbm_surface_pool_create(0, 0);
+
+	ASSERT_TRUE(pool != NULL);
+
+	tbm_surface_pool_destroy(pool);
+}
+
+TEST(tbm_surface_pool_create, null_ptr_fail_1)
+{
+	tbm_surface_pool_h pool;
+
+	_init_test();
+	CALLOC_ERROR = 1;
+
+	pool = tbm_surface_pool_create(0, 0);
+
+	ASSERT_TRUE(pool == NULL);
+}
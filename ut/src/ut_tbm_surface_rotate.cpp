@@ -0,0 +1,260 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics co., Ltd. All Rights Reserved.
+ *
+ * Contact: Konstantin Drabeniuk <k.drabeniuk@samsung.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+**************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "tbm_surface_stubs.h"
+
+#include "tbm_surface_rotate.c"
+
+static void _init_test()
+{
+	UT_TBM_SURFACE_MAP_ERROR = 0;
+	CALLOC_ERROR = 0;
+	ut_unmap_count = 0;
+}
+
+/* the src pixel of each dst pixel, one by one */
+static int
+_ut_rotate_check(tbm_surface_info_s *src, tbm_surface_info_s *dst, int plane, int cpp,
+		 int w, int h, tbm_surface_transform_e transform)
+{
+	int dw = (transform & 1) ? h : w, dh = (transform & 1) ? w : h;
+	int dx, dy, sx, sy;
+
+	for (dy = 0; dy < dh; dy++) {
+		for (dx = 0; dx < dw; dx++) {
+			switch (transform) {
+			case TBM_SURFACE_TRANSFORM_NORMAL: sx = dx; sy = dy; break;
+			case TBM_SURFACE_TRANSFORM_90: sx = dy; sy = h - 1 - dx; break;
+			case TBM_SURFACE_TRANSFORM_180: sx = w - 1 - dx; sy = h - 1 - dy; break;
+			case TBM_SURFACE_TRANSFORM_270: sx = w - 1 - dy; sy = dx; break;
+			case TBM_SURFACE_TRANSFORM_FLIPPED: sx = w - 1 - dx; sy = dy; break;
+			case TBM_SURFACE_TRANSFORM_FLIPPED_90: sx = w - 1 - dy; sy = h - 1 - dx; break;
+			case TBM_SURFACE_TRANSFORM_FLIPPED_180: sx = dx; sy = h - 1 - dy; break;
+			default: sx = dy; sy = dx; break;
+			}
+
+			if (memcmp(_ut_pixel(dst, plane, dx, dy, cpp), _ut_pixel(src, plane, sx, sy, cpp), cpp))
+				return 0;
+		}
+	}
+
+	return 1;
+}
+
+static int
+_ut_kernel_compare(const tbm_rotate_kernel *k, const tbm_rotate_kernel *ref, int cpp)
+{
+	static uint8_t src[64 * 64], out[64 * 64], expect[64 * 64];
+	int n;
+
+	_ut_fill(src, sizeof(src), cpp);
+	memset(out, 0, sizeof(out));
+	memset(expect, 0, sizeof(expect));
+
+	/* a tile in the middle of the buffers, walked from the bottom */
+	ref->tile(src + 32 * 64, -64, expect + 32 * 64, -64);
+	k->tile(src + 32 * 64, -64, out + 32 * 64, -64);
+	if (memcmp(expect, out, sizeof(out)))
+		return 0;
+
+	for (n = 1; n <= 100; n++) {
+		ref->reverse(src, expect, n);
+		k->reverse(src, out, n);
+		if (memcmp(expect, out, n * cpp))
+			return 0;
+	}
+
+	return 1;
+}
+
+/* tbm_surface_internal_rotate() */
+
+TEST(tbm_surface_internal_rotate, work_flow_success_5)
+{
+	struct _tbm_surface src, dst;
+	unsigned char sbuf[4096], dbuf[4096];
+	int ret;
+
+	_init_test();
+
+	_ut_surface_setup(&src, TBM_FORMAT_YUYV, 8, 4, 0, sbuf);
+	_ut_surface_setup(&dst, TBM_FORMAT_YUYV, 8, 4, 0, dbuf);
+	ret = tbm_surface_internal_rotate(&src, &dst, TBM_SURFACE_TRANSFORM_180);
+	ASSERT_EQ(ret, 0);
+
+	/* the chroma of NV16 can't be transposed */
+	_ut_surface_setup(&src, TBM_FORMAT_NV16, 8, 4, 0, sbuf);
+	_ut_surface_setup(&dst, TBM_FORMAT_NV16, 4, 8, 0, dbuf);
+	ret = tbm_surface_internal_rotate(&src, &dst, TBM_SURFACE_TRANSFORM_90);
+	ASSERT_EQ(ret, 0);
+
+	_ut_surface_setup(&src, TBM_FORMAT_ARGB8888, 8, 4, 0, sbuf);
+	_ut_surface_setup(&dst, TBM_FORMAT_ARGB8888, 8, 4, 0, dbuf);
+	ret = tbm_surface_internal_rotate(&src, &dst, TBM_SURFACE_TRANSFORM_90);
+	ASSERT_EQ(ret, 0);
+
+	_ut_surface_setup(&src, TBM_FORMAT_NV12, 7, 4, 0, sbuf);
+	_ut_surface_setup(&dst, TBM_FORMAT_NV12, 7, 4, 0, dbuf);
+	ret = tbm_surface_internal_rotate(&src, &dst, TBM_SURFACE_TRANSFORM_180);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(ut_unmap_count, 0);
+
+	_ut_surface_setup(&src, TBM_FORMAT_ARGB8888, 8, 4, 0, sbuf);
+	UT_TBM_SURFACE_MAP_ERROR = 1;
+	ret = tbm_surface_internal_rotate(&src, &dst, TBM_SURFACE_TRANSFORM_180);
+	ASSERT_EQ(ret, 0);
+}
+
+TEST(tbm_surface_internal_rotate, work_flow_success_4)
+{
+	static unsigned char sbuf[1024 * 1024 * 4], dbuf[1024 * 1024 * 4];
+	struct _tbm_surface src, dst;
+	int ret;
+
+	_init_test();
+
+	/* big enough to be split among the workers */
+	_ut_surface_setup(&src, TBM_FORMAT_ARGB8888, 1024, 1000, 0, sbuf);
+	_ut_surface_setup(&dst, TBM_FORMAT_ARGB8888, 1000, 1024, 0, dbuf);
+	_ut_fill(sbuf, src.info.size, 4);
+
+	ret = tbm_surface_internal_rotate(&src, &dst, TBM_SURFACE_TRANSFORM_270);
+
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(_ut_rotate_check(&src.info, &dst.info, 0, 4, 1024, 1000,
+				   TBM_SURFACE_TRANSFORM_270), 1);
+}
+
+TEST(tbm_surface_internal_rotate, work_flow_success_3)
+{
+	struct _tbm_surface src, dst;
+	unsigned char sbuf[16384], dbuf[16384];
+	int ret, t;
+
+	_init_test();
+
+	for (t = TBM_SURFACE_TRANSFORM_NORMAL; t <= TBM_SURFACE_TRANSFORM_FLIPPED_270; t++) {
+		_ut_surface_setup(&src, TBM_FORMAT_YUV420, 74, 38, 3, sbuf);
+		_ut_surface_setup(&dst, TBM_FORMAT_YUV420, (t & 1) ? 38 : 74, (t & 1) ? 74 : 38, 5, dbuf);
+		_ut_fill(sbuf, src.info.size, t);
+
+		ret = tbm_surface_internal_rotate(&src, &dst, (tbm_surface_transform_e)t);
+
+		ASSERT_EQ(ret, 1);
+		ASSERT_EQ(_ut_rotate_check(&src.info, &dst.info, 0, 1, 74, 38, (tbm_surface_transform_e)t), 1);
+		ASSERT_EQ(_ut_rotate_check(&src.info, &dst.info, 1, 1, 37, 19, (tbm_surface_transform_e)t), 1);
+		ASSERT_EQ(_ut_rotate_check(&src.info, &dst.info, 2, 1, 37, 19, (tbm_surface_transform_e)t), 1);
+	}
+}
+
+TEST(tbm_surface_internal_rotate, work_flow_success_2)
+{
+	struct _tbm_surface src, dst;
+	unsigned char sbuf[16384], dbuf[16384];
+	int ret, t;
+
+	_init_test();
+
+	for (t = TBM_SURFACE_TRANSFORM_NORMAL; t <= TBM_SURFACE_TRANSFORM_FLIPPED_270; t++) {
+		_ut_surface_setup(&src, TBM_FORMAT_NV12, 70, 36, 0, sbuf);
+		_ut_surface_setup(&dst, TBM_FORMAT_NV12, (t & 1) ? 36 : 70, (t & 1) ? 70 : 36, 6, dbuf);
+		_ut_fill(sbuf, src.info.size, t);
+
+		ret = tbm_surface_internal_rotate(&src, &dst, (tbm_surface_transform_e)t);
+
+		ASSERT_EQ(ret, 1);
+		ASSERT_EQ(_ut_rotate_check(&src.info, &dst.info, 0, 1, 70, 36, (tbm_surface_transform_e)t), 1);
+		ASSERT_EQ(_ut_rotate_check(&src.info, &dst.info, 1, 2, 35, 18, (tbm_surface_transform_e)t), 1);
+	}
+}
+
+TEST(tbm_surface_internal_rotate, work_flow_success_1)
+{
+	struct _tbm_surface src, dst;
+	unsigned char sbuf[32768], dbuf[32768];
+	int ret, t;
+
+	_init_test();
+
+	/* crosses the blocks, with pixels out of the whole tiles */
+	for (t = TBM_SURFACE_TRANSFORM_NORMAL; t <= TBM_SURFACE_TRANSFORM_FLIPPED_270; t++) {
+		_ut_surface_setup(&src, TBM_FORMAT_ARGB8888, 67, 29, 4, sbuf);
+		_ut_surface_setup(&dst, TBM_FORMAT_ARGB8888, (t & 1) ? 29 : 67, (t & 1) ? 67 : 29, 0, dbuf);
+		_ut_fill(sbuf, src.info.size, t);
+
+		ret = tbm_surface_internal_rotate(&src, &dst, (tbm_surface_transform_e)t);
+
+		ASSERT_EQ(ret, 1);
+		ASSERT_EQ(_ut_rotate_check(&src.info, &dst.info, 0, 4, 67, 29, (tbm_surface_transform_e)t), 1);
+	}
+	ASSERT_EQ(ut_unmap_count, 16);
+}
+
+TEST(tbm_surface_internal_rotate, null_ptr_fail_1)
+{
+	struct _tbm_surface surface;
+	int ret;
+
+	_init_test();
+
+	ret = tbm_surface_internal_rotate(NULL, &surface, TBM_SURFACE_TRANSFORM_90);
+	ASSERT_EQ(ret, 0);
+
+	ret = tbm_surface_internal_rotate(&surface, NULL, TBM_SURFACE_TRANSFORM_90);
+	ASSERT_EQ(ret, 0);
+
+	ret = tbm_surface_internal_rotate(&surface, &surface, TBM_SURFACE_TRANSFORM_90);
+	ASSERT_EQ(ret, 0);
+}
+
+/* simd kernels */
+
+TEST(tbm_surface_rotate_kernels, work_flow_success_1)
+{
+	unsigned int features = _tbm_cpu_get_features();
+	const tbm_rotate_kernels *k = NULL;
+
+	_init_test();
+
+#ifdef TBM_SIMD_SSE2
+	if (features & TBM_CPU_SSE2)
+		k = &rotate_kernels_sse2;
+#endif
+#ifdef TBM_SIMD_NEON
+	if (features & TBM_CPU_NEON)
+		k = &rotate_kernels_neon;
+#endif
+	if (!k)
+		return;
+
+	ASSERT_EQ(_ut_kernel_compare(&k->cpp1, &rotate_kernels_c.cpp1, 1), 1);
+	ASSERT_EQ(_ut_kernel_compare(&k->cpp2, &rotate_kernels_c.cpp2, 2), 1);
+	ASSERT_EQ(_ut_kernel_compare(&k->cpp4, &rotate_kernels_c.cpp4, 4), 1);
+}
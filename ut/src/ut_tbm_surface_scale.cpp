@@ -0,0 +1,314 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics co., Ltd. All Rights Reserved.
+ *
+ * Contact: Konstantin Drabeniuk <k.drabeniuk@samsung.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+**************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "tbm_surface_stubs.h"
+
+#include "tbm_surface_scale.c"
+
+static void _init_test()
+{
+	UT_TBM_SURFACE_MAP_ERROR = 0;
+	CALLOC_ERROR = 0;
+	ut_unmap_count = 0;
+}
+
+/* the plain average of the src pixels under each dst pixel */
+static int
+_ut_box_check(tbm_surface_info_s *src, tbm_surface_info_s *dst, int plane, int cpp,
+	      int sw, int sh, int dw, int dh)
+{
+	int x, y, sx, sy, c;
+
+	for (y = 0; y < dh; y++) {
+		int y0 = y * sh / dh, y1 = (y + 1) * sh / dh;
+
+		for (x = 0; x < dw; x++) {
+			int x0 = x * sw / dw, x1 = (x + 1) * sw / dw;
+			int n = (x1 - x0) * (y1 - y0);
+
+			for (c = 0; c < cpp; c++) {
+				int sum = 0;
+
+				for (sy = y0; sy < y1; sy++)
+					for (sx = x0; sx < x1; sx++)
+						sum += _ut_pixel(src, plane, sx, sy, cpp)[c];
+
+				if (_ut_pixel(dst, plane, x, y, cpp)[c] != (sum + n / 2) / n)
+					return 0;
+			}
+		}
+	}
+
+	return 1;
+}
+
+static int
+_ut_kernels_compare(const tbm_scale_kernels *k)
+{
+	static uint8_t src[2][512], ref[512], out[512];
+	static uint32_t ref32[512], out32[512];
+	int x0[100], fx[100];
+	int n, i;
+
+	for (n = 1; n <= 100; n++) {
+		_ut_fill(src[0], sizeof(src), n);
+
+		for (i = 0; i < n; i++) {
+			x0[i] = (src[1][i] * 100 / 256) % (100 - 1);
+			fx[i] = src[1][i + 100] % 257;
+		}
+
+		scale_kernels_c.blend_rows(src[0], src[1], ref, n * 4, n * 2 + 1);
+		k->blend_rows(src[0], src[1], out, n * 4, n * 2 + 1);
+		if (memcmp(ref, out, n * 4))
+			return 0;
+
+		scale_kernels_c.blend_cols32(src[0], x0, fx, ref, n);
+		k->blend_cols32(src[0], x0, fx, out, n);
+		if (memcmp(ref, out, n * 4))
+			return 0;
+
+		scale_kernels_c.gather32((const uint32_t *)src[0], x0, ref32, n);
+		k->gather32((const uint32_t *)src[0], x0, out32, n);
+		if (memcmp(ref32, out32, n * 4))
+			return 0;
+
+		for (i = 0; i < n; i++)
+			ref32[i] = out32[i] = src[1][i] * 1000;
+		scale_kernels_c.accum_row(src[0], ref32, n);
+		k->accum_row(src[0], out32, n);
+		if (memcmp(ref32, out32, n * 4))
+			return 0;
+	}
+
+	return 1;
+}
+
+/* tbm_surface_internal_scale() */
+
+TEST(tbm_surface_internal_scale, work_flow_success_6)
+{
+	struct _tbm_surface src, dst;
+	tbm_surface_rect_s rect = { 4, 4, 8, 8 }, odd = { 1, 0, 4, 4 };
+	unsigned char sbuf[4096], dbuf[4096];
+	int ret;
+
+	_init_test();
+
+	_ut_surface_setup(&src, TBM_FORMAT_YUYV, 8, 8, 0, sbuf);
+	_ut_surface_setup(&dst, TBM_FORMAT_YUYV, 4, 4, 0, dbuf);
+	ret = tbm_surface_internal_scale(&src, NULL, &dst, NULL, TBM_SURFACE_SCALE_FILTER_BOX);
+	ASSERT_EQ(ret, 0);
+
+	_ut_surface_setup(&src, TBM_FORMAT_ARGB8888, 8, 8, 0, sbuf);
+	_ut_surface_setup(&dst, TBM_FORMAT_NV12, 4, 4, 0, dbuf);
+	ret = tbm_surface_internal_scale(&src, NULL, &dst, NULL, TBM_SURFACE_SCALE_FILTER_BOX);
+	ASSERT_EQ(ret, 0);
+
+	/* x of NV12 must be even */
+	_ut_surface_setup(&src, TBM_FORMAT_NV12, 8, 8, 0, sbuf);
+	ret = tbm_surface_internal_scale(&src, &odd, &dst, NULL, TBM_SURFACE_SCALE_FILTER_BOX);
+	ASSERT_EQ(ret, 0);
+
+	/* the rect is out of the src surface */
+	_ut_surface_setup(&src, TBM_FORMAT_ARGB8888, 8, 8, 0, sbuf);
+	_ut_surface_setup(&dst, TBM_FORMAT_ARGB8888, 4, 4, 0, dbuf);
+	ret = tbm_surface_internal_scale(&src, &rect, &dst, NULL, TBM_SURFACE_SCALE_FILTER_BOX);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(ut_unmap_count, 0);
+
+	UT_TBM_SURFACE_MAP_ERROR = 1;
+	ret = tbm_surface_internal_scale(&src, NULL, &dst, NULL, TBM_SURFACE_SCALE_FILTER_BOX);
+	ASSERT_EQ(ret, 0);
+
+	UT_TBM_SURFACE_MAP_ERROR = 0;
+	CALLOC_ERROR = 1;
+	ret = tbm_surface_internal_scale(&src, NULL, &dst, NULL, TBM_SURFACE_SCALE_FILTER_BOX);
+	ASSERT_EQ(ret, 0);
+	ASSERT_EQ(ut_unmap_count, 2);
+}
+
+TEST(tbm_surface_internal_scale, work_flow_success_5)
+{
+	static unsigned char sbuf[1024 * 1024 * 4], dbuf[100 * 100 * 4];
+	struct _tbm_surface src, dst;
+	int ret;
+
+	_init_test();
+
+	/* big enough to be split among the workers */
+	_ut_surface_setup(&src, TBM_FORMAT_ARGB8888, 1024, 1024, 0, sbuf);
+	_ut_surface_setup(&dst, TBM_FORMAT_ARGB8888, 100, 100, 0, dbuf);
+	_ut_fill(sbuf, src.info.size, 5);
+
+	ret = tbm_surface_internal_scale(&src, NULL, &dst, NULL, TBM_SURFACE_SCALE_FILTER_BOX);
+
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(_ut_box_check(&src.info, &dst.info, 0, 4, 1024, 1024, 100, 100), 1);
+}
+
+TEST(tbm_surface_internal_scale, work_flow_success_4)
+{
+	struct _tbm_surface src, dst;
+	unsigned char sbuf[8192], dbuf[4096];
+	int ret;
+
+	_init_test();
+
+	/* the chroma planes are scaled on their own */
+	_ut_surface_setup(&src, TBM_FORMAT_NV12, 30, 20, 5, sbuf);
+	_ut_surface_setup(&dst, TBM_FORMAT_NV12, 10, 6, 0, dbuf);
+	_ut_fill(sbuf, src.info.size, 4);
+
+	ret = tbm_surface_internal_scale(&src, NULL, &dst, NULL, TBM_SURFACE_SCALE_FILTER_BOX);
+
+	ASSERT_EQ(ret, 1);
+	ASSERT_EQ(_ut_box_check(&src.info, &dst.info, 0, 1, 30, 20, 10, 6), 1);
+	ASSERT_EQ(_ut_box_check(&src.info, &dst.info, 1, 2, 15, 10, 5, 3), 1);
+}
+
+TEST(tbm_surface_internal_scale, work_flow_success_3)
+{
+	struct _tbm_surface src, dst;
+	tbm_surface_rect_s src_rect = { 2, 2, 4, 4 };
+	tbm_surface_rect_s dst_rect = { 0, 4, 8, 8 };
+	unsigned char sbuf[4096], dbuf[4096];
+	int ret, x, y;
+
+	_init_test();
+
+	_ut_surface_setup(&src, TBM_FORMAT_YUV420, 8, 8, 3, sbuf);
+	_ut_surface_setup(&dst, TBM_FORMAT_YUV420, 8, 12, 0, dbuf);
+	_ut_fill(sbuf, src.info.size, 3);
+	memset(dbuf, 0, sizeof(dbuf));
+
+	ret = tbm_surface_internal_scale(&src, &src_rect, &dst, &dst_rect,
+					 TBM_SURFACE_SCALE_FILTER_NEAREST);
+
+	ASSERT_EQ(ret, 1);
+	for (y = 0; y < 8; y++)
+		for (x = 0; x < 8; x++)
+			ASSERT_EQ(*_ut_pixel(&dst.info, 0, x, y + 4, 1),
+				  *_ut_pixel(&src.info, 0, x / 2 + 2, y / 2 + 2, 1));
+	for (y = 0; y < 4; y++)
+		for (x = 0; x < 4; x++)
+			ASSERT_EQ(*_ut_pixel(&dst.info, 2, x, y + 2, 1),
+				  *_ut_pixel(&src.info, 2, x / 2 + 1, y / 2 + 1, 1));
+	/* nothing outside of the rect */
+	ASSERT_EQ(*_ut_pixel(&dst.info, 0, 7, 3, 1), 0);
+}
+
+TEST(tbm_surface_internal_scale, work_flow_success_2)
+{
+	struct _tbm_surface src, dst;
+	unsigned char sbuf[4096], dbuf[4096];
+	int ret, x;
+
+	_init_test();
+
+	/* 1 to 4, between the centers of 2 pixels */
+	_ut_surface_setup(&src, TBM_FORMAT_ARGB8888, 2, 1, 0, sbuf);
+	_ut_surface_setup(&dst, TBM_FORMAT_ARGB8888, 4, 2, 0, dbuf);
+	memset(sbuf, 0, 4);
+	memset(sbuf + 4, 200, 4);
+
+	ret = tbm_surface_internal_scale(&src, NULL, &dst, NULL, TBM_SURFACE_SCALE_FILTER_BILINEAR);
+
+	ASSERT_EQ(ret, 1);
+	for (x = 0; x < 4; x++) {
+		ASSERT_EQ(_ut_pixel(&dst.info, 0, 0, 0, 4)[x], 0);
+		ASSERT_EQ(_ut_pixel(&dst.info, 0, 1, 0, 4)[x], 50);
+		ASSERT_EQ(_ut_pixel(&dst.info, 0, 2, 1, 4)[x], 150);
+		ASSERT_EQ(_ut_pixel(&dst.info, 0, 3, 1, 4)[x], 200);
+	}
+}
+
+TEST(tbm_surface_internal_scale, work_flow_success_1)
+{
+	struct _tbm_surface src, dst;
+	unsigned char sbuf[8192], dbuf[8192];
+	int ret, i;
+
+	_init_test();
+
+	/* the same size is a copy with any filter */
+	_ut_surface_setup(&src, TBM_FORMAT_ARGB8888, 13, 7, 4, sbuf);
+	_ut_surface_setup(&dst, TBM_FORMAT_ARGB8888, 13, 7, 0, dbuf);
+	_ut_fill(sbuf, src.info.size, 1);
+
+	for (i = TBM_SURFACE_SCALE_FILTER_NEAREST; i <= TBM_SURFACE_SCALE_FILTER_BOX; i++) {
+		memset(dbuf, 0, sizeof(dbuf));
+
+		ret = tbm_surface_internal_scale(&src, NULL, &dst, NULL, (tbm_surface_scale_filter_e)i);
+
+		ASSERT_EQ(ret, 1);
+		ASSERT_EQ(_ut_box_check(&src.info, &dst.info, 0, 4, 13, 7, 13, 7), 1);
+	}
+}
+
+TEST(tbm_surface_internal_scale, null_ptr_fail_1)
+{
+	struct _tbm_surface surface;
+	int ret;
+
+	_init_test();
+
+	ret = tbm_surface_internal_scale(NULL, NULL, &surface, NULL, TBM_SURFACE_SCALE_FILTER_BOX);
+	ASSERT_EQ(ret, 0);
+
+	ret = tbm_surface_internal_scale(&surface, NULL, NULL, NULL, TBM_SURFACE_SCALE_FILTER_BOX);
+	ASSERT_EQ(ret, 0);
+
+	ret = tbm_surface_internal_scale(&surface, NULL, &surface, NULL, TBM_SURFACE_SCALE_FILTER_BOX);
+	ASSERT_EQ(ret, 0);
+}
+
+/* simd kernels */
+
+TEST(tbm_surface_scale_kernels, work_flow_success_1)
+{
+	unsigned int features = _tbm_cpu_get_features();
+
+	_init_test();
+
+	ASSERT_EQ(_ut_kernels_compare(&scale_kernels_c), 1);
+#ifdef TBM_SIMD_SSE2
+	if (features & TBM_CPU_SSE2)
+		ASSERT_EQ(_ut_kernels_compare(&scale_kernels_sse2), 1);
+#endif
+#ifdef TBM_SIMD_AVX2
+	if (features & TBM_CPU_AVX2)
+		ASSERT_EQ(_ut_kernels_compare(&scale_kernels_avx2), 1);
+#endif
+#ifdef TBM_SIMD_NEON
+	if (features & TBM_CPU_NEON)
+		ASSERT_EQ(_ut_kernels_compare(&scale_kernels_neon), 1);
+#endif
+}
@@ -0,0 +1,216 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics co., Ltd. All Rights Reserved.
+ *
+ * Contact: Konstantin Drabeniuk <k.drabeniuk@samsung.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+**************************************************************************/
+
+
+#include "gtest/gtest.h"
+
+#include "tbm_bufmgr_int.h"
+
+#include "tbm_surface_y4m.c"
+
+/* HELPER FUNCTIONS */
+static void
+_ut_fill(unsigned char *buf, int size, unsigned int seed)
+{
+	int i;
+
+	for (i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+		buf[i] = seed >> 16;
+	}
+}
+
+/* the planes of a w x h surface on top of buf with some padding at the end of the rows */
+static void
+_ut_info_setup(tbm_surface_info_s *info, tbm_format format, int w, int h, int pad,
+	       unsigned char *buf)
+{
+	const tbm_format_desc_s *desc = tbm_format_get_desc(format);
+	unsigned char *ptr = buf;
+	int i;
+
+	memset(info, 0, sizeof(*info));
+	info->width = w;
+	info->height = h;
+	info->format = format;
+	info->num_planes = desc->num_planes;
+
+	for (i = 0; i < desc->num_planes; i++) {
+		int hsub = i ? desc->hsub : 1, vsub = i ? desc->vsub : 1;
+
+		info->planes[i].stride = (w + hsub - 1) / hsub * desc->cpp[i] + pad;
+		info->planes[i].size = info->planes[i].stride * ((h + vsub - 1) / vsub);
+		info->planes[i].ptr = ptr;
+		ptr += info->planes[i].size;
+	}
+	info->size = ptr - buf;
+}
+
+/* the Y, U and V of the pixel x, y read one by one */
+static void
+_ut_get_yuv(tbm_surface_info_s *info, int x, int y, int *py, int *pu, int *pv)
+{
+	unsigned char *p;
+
+	switch (info->format) {
+	case TBM_FORMAT_YUV420:
+	case TBM_FORMAT_YVU420:
+		*py = info->planes[0].ptr[y * info->planes[0].stride + x];
+		*pu = info->planes[1].ptr[y / 2 * info->planes[1].stride + x / 2];
+		*pv = info->planes[2].ptr[y / 2 * info->planes[2].stride + x / 2];
+		if (info->format == TBM_FORMAT_YVU420) {
+			int t = *pu;
+
+			*pu = *pv;
+			*pv = t;
+		}
+		break;
+	case TBM_FORMAT_NV12:
+	case TBM_FORMAT_NV21:
+		*py = info->planes[0].ptr[y * info->planes[0].stride + x];
+		p = info->planes[1].ptr + y / 2 * info->planes[1].stride + x / 2 * 2;
+		*pu = p[info->format == TBM_FORMAT_NV21];
+		*pv = p[info->format != TBM_FORMAT_NV21];
+		break;
+	default:
+		p = info->planes[0].ptr + y * info->planes[0].stride + x / 2 * 4;
+		if (info->format == TBM_FORMAT_UYVY) {
+			*py = p[1 + (x & 1) * 2];
+			*pu = p[0];
+			*pv = p[2];
+		} else {
+			*py = p[(x & 1) * 2];
+			*pu = p[1];
+			*pv = p[3];
+		}
+		break;
+	}
+}
+
+/* _tbm_surface_internal_y4m_convert() */
+
+TEST(_tbm_surface_internal_y4m_convert, work_flow_success_2)
+{
+	static const tbm_format formats[] = {
+		TBM_FORMAT_YUV420, TBM_FORMAT_YVU420, TBM_FORMAT_NV12, TBM_FORMAT_NV21,
+		TBM_FORMAT_YUYV, TBM_FORMAT_UYVY,
+	};
+	static const int sizes[][2] = { { 64, 32 }, { 38, 21 }, { 2, 1 } };
+	unsigned char buf[64 * 32 * 4 + 1024], frame[64 * 32 * 2];
+	tbm_surface_info_s info;
+	unsigned int f, s;
+	int x, y;
+
+	for (f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+		for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+			int w = sizes[s][0], h = sizes[s][1];
+			int cw = (w + 1) / 2, ch = (h + 1) / 2;
+			unsigned char *fu = frame + w * h, *fv = fu + cw * ch;
+
+			_ut_fill(buf, sizeof(buf), f * 7 + s);
+			_ut_info_setup(&info, formats[f], w, h, 6, buf);
+			memset(frame, 0, sizeof(frame));
+
+			ASSERT_EQ(1, _tbm_surface_internal_y4m_convert(&info, frame));
+			ASSERT_EQ(w * h + cw * ch * 2, _tbm_surface_internal_y4m_get_frame_size(w, h));
+
+			for (y = 0; y < h; y++) {
+				for (x = 0; x < w; x++) {
+					int py, pu, pv;
+
+					_ut_get_yuv(&info, x, y, &py, &pu, &pv);
+					ASSERT_EQ(py, frame[y * w + x]) << formats[f] << " " << x << "," << y;
+
+					/* the 4:2:2 chroma is the average of the rows */
+					if ((y & 1) || (x & 1))
+						continue;
+					if (formats[f] == TBM_FORMAT_YUYV || formats[f] == TBM_FORMAT_UYVY) {
+						int py1, pu1, pv1;
+
+						_ut_get_yuv(&info, x, y + 1 < h ? y + 1 : y, &py1, &pu1, &pv1);
+						pu = (pu + pu1 + 1) >> 1;
+						pv = (pv + pv1 + 1) >> 1;
+					}
+					ASSERT_EQ(pu, fu[y / 2 * cw + x / 2]);
+					ASSERT_EQ(pv, fv[y / 2 * cw + x / 2]);
+				}
+			}
+		}
+	}
+}
+
+TEST(_tbm_surface_internal_y4m_convert, work_flow_success_1)
+{
+	unsigned char buf[64 * 32 * 4], frame[64 * 32 * 2];
+	tbm_surface_info_s info;
+
+	_ut_info_setup(&info, TBM_FORMAT_ARGB8888, 16, 16, 0, buf);
+	ASSERT_EQ(0, _tbm_surface_internal_y4m_convert(&info, frame));
+
+	/* a packed 4:2:2 row has pairs of pixels */
+	_ut_info_setup(&info, TBM_FORMAT_YUYV, 15, 16, 0, buf);
+	ASSERT_EQ(0, _tbm_surface_internal_y4m_convert(&info, frame));
+}
+
+/* simd kernels */
+
+TEST(tbm_surface_y4m_kernels, work_flow_success_1)
+{
+	static const tbm_y4m_kernels *kernels[] = {
+#ifdef TBM_SIMD_SSE2
+		&y4m_kernels_sse2,
+#endif
+#ifdef TBM_SIMD_NEON
+		&y4m_kernels_neon,
+#endif
+		NULL,
+	};
+	unsigned char src[2][37 * 4], ref[4][74], out[4][74];
+	unsigned int k;
+	int n, uyvy;
+
+	_ut_fill(src[0], sizeof(src), 4);
+
+	for (k = 0; kernels[k]; k++) {
+		for (n = 0; n <= 37; n++) {
+			memset(ref, 0, sizeof(ref));
+			memset(out, 0, sizeof(out));
+			_tbm_y4m_split_uv_c(ref[0], ref[1], src[0], n);
+			kernels[k]->split_uv(out[0], out[1], src[0], n);
+			ASSERT_EQ(0, memcmp(ref, out, sizeof(out)));
+
+			for (uyvy = 0; uyvy < 2; uyvy++) {
+				memset(ref, 0, sizeof(ref));
+				memset(out, 0, sizeof(out));
+				_tbm_y4m_unpack_422_c(ref[0], ref[1], ref[2], ref[3], src[0], src[1], n, uyvy);
+				kernels[k]->unpack_422(out[0], out[1], out[2], out[3], src[0], src[1], n, uyvy);
+				ASSERT_EQ(0, memcmp(ref, out, sizeof(out)));
+			}
+		}
+	}
+}
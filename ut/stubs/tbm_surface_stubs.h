@@ -0,0 +1,162 @@
+/**************************************************************************
+ *
+ * Copyright 2016 Samsung Electronics co., Ltd. All Rights Reserved.
+ *
+ * Contact: Konstantin Drabeniuk <k.drabeniuk@samsung.com>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+**************************************************************************/
+
+#ifndef _TBM_SURFACE_STUBS_H
+#define _TBM_SURFACE_STUBS_H
+
+/* The surface getters of the ops which work on the mapped planes, ex) the
+ * copy or the scale, and the fixture of their tests. A test surface is a
+ * struct _tbm_surface made by _ut_surface_setup() on top of a buffer, the
+ * getters read its info and the map fails with UT_TBM_SURFACE_MAP_ERROR.
+ * A test includes this after its own stubs and before the tested .c file.
+ */
+
+#include "tbm_bufmgr_int.h"
+
+#include "stdlib_stubs.h"
+
+static int ut_unmap_count = 0;
+static int UT_TBM_SURFACE_MAP_ERROR = 0;
+
+static tbm_format
+ut_tbm_surface_internal_get_format(tbm_surface_h surface)
+{
+	return surface->info.format;
+}
+
+static unsigned int
+ut_tbm_surface_internal_get_width(tbm_surface_h surface)
+{
+	return surface->info.width;
+}
+
+static unsigned int
+ut_tbm_surface_internal_get_height(tbm_surface_h surface)
+{
+	return surface->info.height;
+}
+
+static int
+ut_tbm_surface_internal_get_info(tbm_surface_h surface, int opt,
+				 tbm_surface_info_s *info, int map)
+{
+	if (UT_TBM_SURFACE_MAP_ERROR)
+		return 0;
+
+	*info = surface->info;
+
+	return 1;
+}
+
+static void
+ut_tbm_surface_internal_unmap(tbm_surface_h surface)
+{
+	ut_unmap_count++;
+}
+
+static int
+ut_tbm_surface_internal_get_damage(tbm_surface_h surface, tbm_surface_rect_s *rects, int *num)
+{
+	*num = surface->num_damage;
+	memcpy(rects, surface->damage, sizeof(tbm_surface_rect_s) * surface->num_damage);
+
+	return 1;
+}
+
+static int
+ut_tbm_surface_internal_add_damage(tbm_surface_h surface, tbm_surface_rect_s *rect)
+{
+	surface->damage[surface->num_damage++] = *rect;
+
+	return 1;
+}
+
+static void
+ut__tbm_surface_internal_add_written_damage(tbm_surface_h surface, tbm_surface_rect_s *rect)
+{
+	if (surface->num_damage)
+		surface->damage[surface->num_damage++] = *rect;
+}
+
+/* a surface of w x h on top of buf with some padding at the end of the rows */
+static void
+_ut_surface_setup(struct _tbm_surface *surf, tbm_format format, int w, int h,
+		  int pad, unsigned char *buf)
+{
+	const tbm_format_desc_s *desc = tbm_format_get_desc(format);
+	tbm_surface_info_s *info = &surf->info;
+	unsigned char *ptr = buf;
+	int i;
+
+	memset(surf, 0, sizeof(*surf));
+	info->width = w;
+	info->height = h;
+	info->format = format;
+	info->num_planes = desc->num_planes;
+
+	for (i = 0; i < desc->num_planes; i++) {
+		int hsub = i ? desc->hsub : 1, vsub = i ? desc->vsub : 1;
+
+		info->planes[i].stride = (w + hsub - 1) / hsub * desc->cpp[i] + pad;
+		info->planes[i].size = info->planes[i].stride * ((h + vsub - 1) / vsub);
+		info->planes[i].ptr = ptr;
+		ptr += info->planes[i].size;
+	}
+	info->size = ptr - buf;
+}
+
+/* reproducible noise */
+static void
+_ut_fill(unsigned char *buf, int size, unsigned int seed)
+{
+	int i;
+
+	for (i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+		buf[i] = seed >> 16;
+	}
+}
+
+static unsigned char *
+_ut_pixel(tbm_surface_info_s *info, int plane, int x, int y, int cpp)
+{
+	return info->planes[plane].ptr + y * info->planes[plane].stride + x * cpp;
+}
+
+#define calloc ut_calloc
+#define free ut_free
+#define tbm_surface_internal_get_format ut_tbm_surface_internal_get_format
+#define tbm_surface_internal_get_width ut_tbm_surface_internal_get_width
+#define tbm_surface_internal_get_height ut_tbm_surface_internal_get_height
+#define tbm_surface_internal_get_info ut_tbm_surface_internal_get_info
+#define tbm_surface_internal_unmap ut_tbm_surface_internal_unmap
+#define tbm_surface_internal_get_damage ut_tbm_surface_internal_get_damage
+#define tbm_surface_internal_add_damage ut_tbm_surface_internal_add_damage
+#define _tbm_surface_internal_add_written_damage ut__tbm_surface_internal_add_written_damage
+
+#endif /* _TBM_SURFACE_STUBS_H */